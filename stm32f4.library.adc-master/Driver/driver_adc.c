@@ -1,94 +1,309 @@
 #include "driver_adc.h"
 
+/*两个采样块的半字数*/
+#define ADC_BUF_SIZE (2 * ADC_BLOCK_FRAMES * ADC_FRAME_SIZE)
+
+/*TIM2的时钟，APB1时钟42MHz的2倍*/
+#define ADC_TIMER_CLOCK 84000000
+
+/*采样块满的次数和ADC溢出的次数*/
+volatile u32 adc_blocks = 0;
+volatile u32 adc_overruns = 0;
+
+/*DMA循环写入的两个采样块，定义为字数组保证按字对齐，滤波器按字读取两个采样*/
+static u32 adc_buf[ADC_BUF_SIZE / 2];
+
+/*第n个采样块的起始地址*/
+#define ADC_BLOCK(n) ((const u16 *) adc_buf + (n) * (ADC_BUF_SIZE / 2))
+
+/*最近写满的采样块，开始时指向还没有写入的第二块(全为0)*/
+static const u16 *volatile adc_last = ADC_BLOCK(1);
+
+/*采样块满时调用的函数*/
+static void (*block_handler)(const u16 *block, u16 frames) = 0;
+
 /**
  * @Description ADC初始化函数
- * @note PA6 ADC12_IN6 PA6是ADC1和ADC2的通道6
+ * @note PA6 ADC12_IN6 PA6是ADC1和ADC2的通道6，由ADC2转换
+ * @note PF7 ADC3_IN5 只能由ADC3转换
+ * @note 温度传感器ADC1_IN16，Vrefint ADC1_IN17 只能由ADC1转换
  */
 void Adc_Init(void)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
 	ADC_CommonInitTypeDef ADC_CommonInitStructure;
 	ADC_InitTypeDef ADC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseInitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
 
 	/*第一步：使能外设时钟*/
-	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA, ENABLE);
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC2, ENABLE);
+	RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA | RCC_AHB1Periph_GPIOF | RCC_AHB1Periph_DMA2, ENABLE);
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC1 | RCC_APB2Periph_ADC2 | RCC_APB2Periph_ADC3, ENABLE);
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
 
-	/*第二步：初始化ADC2的通道6对应的I/O口，配置为模拟输入，不带上下拉*/
+	/*第二步：初始化PA6和PF7，配置为模拟输入，不带上下拉*/
 	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_6;
 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AN;
 	GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_NOPULL;
 	GPIO_Init(GPIOA, &GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_7;
+	GPIO_Init(GPIOF, &GPIO_InitStructure);
+
+	/*第三步：ADC复位操作，同时复位三个ADC*/
+	RCC_APB2PeriphResetCmd(RCC_APB2Periph_ADC, ENABLE);
+	RCC_APB2PeriphResetCmd(RCC_APB2Periph_ADC, DISABLE);
+
+	/*第四步：配置DMA2数据流0通道0，从ADC公共数据寄存器循环读取到两个采样块*/
+	DMA_DeInit(DMA2_Stream0);
+	DMA_InitStructure.DMA_Channel = DMA_Channel_0;
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (u32) &ADC->CDR;
+	DMA_InitStructure.DMA_Memory0BaseAddr = (u32) adc_buf;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+	DMA_InitStructure.DMA_BufferSize = ADC_BUF_SIZE;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	/*循环模式，写满第二块后回到第一块*/
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+	DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_HalfFull;
+	DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+	DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+	DMA_Init(DMA2_Stream0, &DMA_InitStructure);
 
-	/*第三步：ADC复位操作，其实就是先关再开*/
-	RCC_APB2PeriphResetCmd(RCC_APB2Periph_ADC2, ENABLE);
-	RCC_APB2PeriphResetCmd(RCC_APB2Periph_ADC2, DISABLE);
+	/*传输一半(第一块满)和传输完成(第二块满)时中断*/
+	DMA_ITConfig(DMA2_Stream0, DMA_IT_HT | DMA_IT_TC, ENABLE);
+	NVIC_InitStructure.NVIC_IRQChannel = DMA2_Stream0_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+	DMA_Cmd(DMA2_Stream0, ENABLE);
 
-	/*第四步：设置通用的ADC配置*/
-	/*配置ADC模式为独立模式*/
-	ADC_CommonInitStructure.ADC_Mode = ADC_Mode_Independent;
-	/*配置ADC采样时间延迟为5个时钟*/
+	/*第五步：设置通用的ADC配置*/
+	/*配置ADC模式为三重规则同时模式*/
+	ADC_CommonInitStructure.ADC_Mode = ADC_TripleMode_RegSimult;
 	ADC_CommonInitStructure.ADC_TwoSamplingDelay = ADC_TwoSamplingDelay_5Cycles;
-	/*配置ADC不使用DMA*/
-	ADC_CommonInitStructure.ADC_DMAAccessMode = ADC_DMAAccessMode_Disabled;
-	/*配置ADC时钟为APB2时钟4分频*/
+	/*配置DMA模式1，每次DMA请求依次传输ADC1、ADC2、ADC3的一个结果*/
+	ADC_CommonInitStructure.ADC_DMAAccessMode = ADC_DMAAccessMode_1;
+	/*配置ADC时钟为APB2时钟4分频，即21MHz*/
 	ADC_CommonInitStructure.ADC_Prescaler = ADC_Prescaler_Div4;
 	ADC_CommonInit(&ADC_CommonInitStructure);
 
-	/*第五步：设置专用的ADC配置*/
+	/*第六步：设置专用的ADC配置*/
 	/*设置ADC分辨率为12位*/
 	ADC_InitStructure.ADC_Resolution = ADC_Resolution_12b;
-	/*设置ADC为非扫描模式*/
-	ADC_InitStructure.ADC_ScanConvMode = DISABLE;
-	/*设置ADC关闭连续转换*/
+	/*设置ADC为扫描模式，每次触发转换规则组的两个序号*/
+	ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+	/*设置ADC关闭连续转换，由定时器控制采样率*/
 	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
-	/*设置ADC禁止外部触发，用软件触发*/
-	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_None;
 	/*设置ADC数据对齐方式为右对齐*/
 	ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
-	/*设置ADC只转换规则序列1*/
-	ADC_InitStructure.ADC_NbrOfConversion = 1;
+	ADC_InitStructure.ADC_NbrOfConversion = 2;
+	/*ADC1为主ADC，由TIM2的TRGO上升沿触发*/
+	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_Rising;
+	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T2_TRGO;
+	ADC_Init(ADC1, &ADC_InitStructure);
+	/*ADC2和ADC3为从ADC，跟随ADC1同时转换*/
+	ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_None;
 	ADC_Init(ADC2, &ADC_InitStructure);
+	ADC_Init(ADC3, &ADC_InitStructure);
 
-	/*第六步：开启ADC*/
+	/*第七步：设置规则组通道，同一序号的采样时间必须相同，温度传感器要求大于10us，都使用480个周期*/
+	ADC_RegularChannelConfig(ADC1, ADC_Channel_16, 1, ADC_SampleTime_480Cycles);
+	ADC_RegularChannelConfig(ADC1, ADC_Channel_17, 2, ADC_SampleTime_480Cycles);
+	ADC_RegularChannelConfig(ADC2, ADC_Channel_6, 1, ADC_SampleTime_480Cycles);
+	ADC_RegularChannelConfig(ADC2, ADC_Channel_6, 2, ADC_SampleTime_480Cycles);
+	ADC_RegularChannelConfig(ADC3, ADC_Channel_5, 1, ADC_SampleTime_480Cycles);
+	ADC_RegularChannelConfig(ADC3, ADC_Channel_5, 2, ADC_SampleTime_480Cycles);
+	ADC_TempSensorVrefintCmd(ENABLE);
+
+	/*第八步：开启DMA请求和溢出中断，开启ADC*/
+	ADC_MultiModeDMARequestAfterLastTransferCmd(ENABLE);
+	ADC_ITConfig(ADC1, ADC_IT_OVR, ENABLE);
+	ADC_ITConfig(ADC2, ADC_IT_OVR, ENABLE);
+	ADC_ITConfig(ADC3, ADC_IT_OVR, ENABLE);
+	NVIC_InitStructure.NVIC_IRQChannel = ADC_IRQn;
+	NVIC_Init(&NVIC_InitStructure);
+	ADC_Cmd(ADC1, ENABLE);
 	ADC_Cmd(ADC2, ENABLE);
+	ADC_Cmd(ADC3, ENABLE);
+
+	/*第九步：配置TIM2，每次更新事件通过TRGO触发一帧转换*/
+	TIM_TimeBaseInitStructure.TIM_Period = ADC_TIMER_CLOCK / ADC_SAMPLE_RATE - 1;
+	TIM_TimeBaseInitStructure.TIM_Prescaler = 0;
+	TIM_TimeBaseInitStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInitStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIM_TimeBaseInit(TIM2, &TIM_TimeBaseInitStructure);
+	TIM_SelectOutputTrigger(TIM2, TIM_TRGOSource_Update);
+	TIM_Cmd(TIM2, ENABLE);
+}
+
+/**
+ * @Description 设置采样率，可以在采样过程中修改
+ * @param rate 每秒的帧数，1 ~ ADC_SAMPLE_RATE_MAX
+ */
+void Adc_SetSampleRate(u32 rate)
+{
+	if (rate == 0)
+	{
+		rate = 1;
+	}
+	if (rate > ADC_SAMPLE_RATE_MAX)
+	{
+		rate = ADC_SAMPLE_RATE_MAX;
+	}
+
+	/*TIM2为32位定时器，计数器清零避免新的重装载值小于当前计数值时要等计数器溢出*/
+	TIM_SetAutoreload(TIM2, ADC_TIMER_CLOCK / rate - 1);
+	TIM_SetCounter(TIM2, 0);
 }
 
 /**
- * @Description 获取ADC的转换后的值
+ * @Description 设置采样块满时调用的函数
+ * @param handler 在DMA中断中调用，参数为写满的采样块和帧数，为0时不调用
+ * @note 采样块在下一个块写满之前(ADC_BLOCK_FRAMES帧的时间)保持不变，处理时间较长时应复制出来或通知任务处理
+ */
+void Adc_SetBlockHandler(void (*handler)(const u16 *block, u16 frames))
+{
+	block_handler = handler;
+}
+
+/**
+ * @Description 获取通道在帧内的位置
  * @param ch 通道编号
- * @return 通道ch的转换结果
+ * @return 帧内的位置，不是扫描的通道返回ADC_FRAME_SIZE
  */
-u16 Adc_GetValue(u8 ch)
+static u8 Adc_ChannelIndex(u8 ch)
 {
-	/*设置指定ADC的规则组通道，一个序列，采样时间*/
-	/*ADC通道,480个周期,提高采样时间可以提高精确度*/
-	ADC_RegularChannelConfig(ADC2, ch, 1, ADC_SampleTime_480Cycles);
+	switch (ch)
+	{
+	case ADC_Channel_16:
+		return ADC_INDEX_TEMP;
+	case ADC_Channel_6:
+		return ADC_INDEX_PA6;
+	case ADC_Channel_5:
+		return ADC_INDEX_PF7;
+	case ADC_Channel_17:
+		return ADC_INDEX_VREF;
+	default:
+		return ADC_FRAME_SIZE;
+	}
+}
 
-	/*使能指定的ADC的软件转换启动功能*/
-	ADC_SoftwareStartConv(ADC2);
+/**
+ * @Description 获取最近一次的转换值，不再等待转换
+ * @param ch 通道编号：ADC_Channel_5(PF7) ADC_Channel_6(PA6) ADC_Channel_16(温度) ADC_Channel_17(Vrefint)
+ * @return 最近写满的采样块中最后一帧的结果，不是扫描的通道返回0
+ */
+u16 Adc_GetValue(u8 ch)
+{
+	u8 index = Adc_ChannelIndex(ch);
 
-	/*等待转换结束*/
-	while (!ADC_GetFlagStatus(ADC2, ADC_FLAG_EOC));
+	if (index == ADC_FRAME_SIZE)
+	{
+		return 0;
+	}
 
-	/*返回最近一次ADC规则组的转换结果*/
-	return ADC_GetConversionValue(ADC2);
+	return adc_last[(ADC_BLOCK_FRAMES - 1) * ADC_FRAME_SIZE + index];
 }
 
 /**
- * @Description 获取ADC通道ch的转换值(转换times次，最后取平均值)
+ * @Description 获取ADC通道ch的转换值(最近转换的times帧取平均值)，不再逐次转换和延时
  * @param ch 通道编号
- * @param times 获取次数
- * @return 通道ch的times次转换结果平均值
+ * @param times 帧数，最多ADC_BLOCK_FRAMES
+ * @return 通道ch的times帧转换结果平均值，PA6和PF7每帧转换两次，一起平均
  */
 u16 Adc_GetAverageValue(u8 ch, u8 times)
 {
+	const u16 *block = adc_last;
+	u8 index = Adc_ChannelIndex(ch);
 	u32 sum = 0;
+	u8 count = 0;
 	u8 t;
-	for (t = 0; t < times; t++)
+
+	if (index == ADC_FRAME_SIZE || times == 0)
+	{
+		return 0;
+	}
+	if (times > ADC_BLOCK_FRAMES)
+	{
+		times = ADC_BLOCK_FRAMES;
+	}
+
+	for (t = ADC_BLOCK_FRAMES - times; t < ADC_BLOCK_FRAMES; t++)
+	{
+		sum += block[t * ADC_FRAME_SIZE + index];
+		count++;
+
+		/*PA6和PF7在第二个序号上还有一次结果*/
+		if (index == ADC_INDEX_PA6 || index == ADC_INDEX_PF7)
+		{
+			sum += block[t * ADC_FRAME_SIZE + index + 3];
+			count++;
+		}
+	}
+	return sum / count;
+}
+
+/**
+ * @Description DMA2数据流0中断服务函数，一个采样块写满时调用
+ */
+void DMA2_Stream0_IRQHandler(void)
+{
+	const u16 *block = 0;
+
+	/*传输一半，第一块写满，DMA正在写第二块*/
+	if (DMA_GetITStatus(DMA2_Stream0, DMA_IT_HTIF0) != RESET)
+	{
+		DMA_ClearITPendingBit(DMA2_Stream0, DMA_IT_HTIF0);
+		block = ADC_BLOCK(0);
+	}
+
+	/*传输完成，第二块写满，DMA回到第一块*/
+	if (DMA_GetITStatus(DMA2_Stream0, DMA_IT_TCIF0) != RESET)
 	{
-		sum += Adc_GetValue(ch);
-		delay_ms(5);
+		DMA_ClearITPendingBit(DMA2_Stream0, DMA_IT_TCIF0);
+		block = ADC_BLOCK(1);
 	}
-	return sum / times;
+
+	if (block != 0)
+	{
+		adc_last = block;
+		adc_blocks++;
+		if (block_handler != 0)
+		{
+			block_handler(block, ADC_BLOCK_FRAMES);
+		}
+	}
+}
+
+/**
+ * @Description ADC中断服务函数，DMA来不及读取结果时ADC溢出并停止转换，重新开始DMA传输
+ */
+void ADC_IRQHandler(void)
+{
+	if (ADC_GetITStatus(ADC1, ADC_IT_OVR) == RESET && ADC_GetITStatus(ADC2, ADC_IT_OVR) == RESET
+	    && ADC_GetITStatus(ADC3, ADC_IT_OVR) == RESET)
+	{
+		return;
+	}
+	adc_overruns++;
+
+	/*停止DMA，从第一块的开头重新写入，保证帧内的顺序不错位*/
+	DMA_Cmd(DMA2_Stream0, DISABLE);
+	while (DMA_GetCmdStatus(DMA2_Stream0) != DISABLE);
+	DMA_ClearFlag(DMA2_Stream0, DMA_FLAG_HTIF0 | DMA_FLAG_TCIF0 | DMA_FLAG_TEIF0 | DMA_FLAG_DMEIF0 | DMA_FLAG_FEIF0);
+	DMA_SetCurrDataCounter(DMA2_Stream0, ADC_BUF_SIZE);
+	DMA_Cmd(DMA2_Stream0, ENABLE);
+
+	/*重新开启DMA请求，清除溢出标志后下一次触发从第一个序号开始转换*/
+	ADC_MultiModeDMARequestAfterLastTransferCmd(DISABLE);
+	ADC_MultiModeDMARequestAfterLastTransferCmd(ENABLE);
+	ADC_ClearITPendingBit(ADC1, ADC_IT_OVR);
+	ADC_ClearITPendingBit(ADC2, ADC_IT_OVR);
+	ADC_ClearITPendingBit(ADC3, ADC_IT_OVR);
 }
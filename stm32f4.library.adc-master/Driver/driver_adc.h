@@ -5,13 +5,49 @@
 #include "explore_system.h"
 #include "explore_systick.h"
 
-/*ADC初始化函数*/
+/**
+ * ADC1、ADC2、ADC3工作在三重规则同时模式，由TIM2的更新事件触发，每次触发依次转换规则组的两个序号，
+ * 三个ADC同时转换各自序号上的通道，DMA2数据流0按ADC1、ADC2、ADC3的顺序把结果循环写入两个采样块，
+ * 一个块写满时在DMA中断中调用Adc_SetBlockHandler()设置的函数，CPU处理这一块的同时DMA写入另一块。
+ * 温度传感器和Vrefint只能由ADC1转换，PF7只能由ADC3转换，所以使用三个ADC同时转换，
+ * PA6和PF7在两个序号上各转换一次。
+ */
+
+/*每帧的采样个数，帧内依次为：温度传感器 PA6 PF7 Vrefint PA6 PF7*/
+#define ADC_FRAME_SIZE 6
+
+/*帧内各通道的位置*/
+#define ADC_INDEX_TEMP 0
+#define ADC_INDEX_PA6 1
+#define ADC_INDEX_PF7 2
+#define ADC_INDEX_VREF 3
+
+/*每个采样块的帧数，两个块共占用 2 * ADC_BLOCK_FRAMES * ADC_FRAME_SIZE 个半字*/
+#define ADC_BLOCK_FRAMES 32
+
+/*默认采样率，单位为帧/秒*/
+#define ADC_SAMPLE_RATE 1000
+
+/*最高采样率，ADC时钟21MHz，温度传感器要求采样时间大于10us，每个序号480+12个周期，每帧约46.9us*/
+#define ADC_SAMPLE_RATE_MAX 20000
+
+/*采样块满的次数和ADC溢出(DMA来不及读取)的次数*/
+extern volatile u32 adc_blocks;
+extern volatile u32 adc_overruns;
+
+/*ADC初始化函数，以默认采样率开始采样*/
 void Adc_Init(void);
 
-/*获取ADC的转换后的值*/
+/*设置采样率*/
+void Adc_SetSampleRate(u32 rate);
+
+/*设置采样块满时调用的函数*/
+void Adc_SetBlockHandler(void (*handler)(const u16 *block, u16 frames));
+
+/*获取最近一次的转换值*/
 u16 Adc_GetValue(u8 ch);
 
-/*获取ADC通道ch的转换值(转换times次，最后取平均值)*/
+/*获取ADC通道ch的转换值(最近转换的times帧取平均值)*/
 u16 Adc_GetAverageValue(u8 ch, u8 times);
 
 #endif /*__DRIVER_ADC_H_*/
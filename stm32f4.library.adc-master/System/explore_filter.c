@@ -0,0 +1,268 @@
+#include "explore_filter.h"
+#if FILTER_BENCH
+#include "explore_systick.h"
+#include "stdio.h"
+#endif
+
+/*第一级累加函数：把FILTER_PRESUM帧每个通道的和加到第一个积分器*/
+typedef void (*FILTER_PresumFunc)(const u32 *frames, u8 words, u32 *integ);
+
+/**
+ * @Description 初始化滤波器
+ * @param filter 滤波器
+ * @param words 每帧的字数，1 ~ FILTER_LANES_MAX / 2
+ * @param ratio 抽取比，FILTER_RATIO_MIN ~ FILTER_RATIO_MAX之间2的幂
+ * @param order CIC阶数，1 ~ FILTER_ORDER_MAX
+ * @param median 1:先做3点中值滤波 0:不做
+ * @param output 每次输出时调用，参数为各通道16位满量程的结果和通道数，可以为0
+ * @return 0:成功 1:参数错误
+ */
+u8 Filter_Init(FILTER_TypeDef *filter, u8 words, u16 ratio, u8 order, u8 median, void (*output)(const u16 *value, u8 lanes))
+{
+	u8 i, j, bits;
+
+	if (words == 0 || words > FILTER_LANES_MAX / 2 || order == 0 || order > FILTER_ORDER_MAX)
+	{
+		return 1;
+	}
+	if (ratio < FILTER_RATIO_MIN || ratio > FILTER_RATIO_MAX || (ratio & (ratio - 1)) != 0)
+	{
+		return 1;
+	}
+
+	filter->words = words;
+	filter->order = order;
+	filter->median = median;
+	filter->ratio = ratio;
+	filter->decim = ratio / FILTER_PRESUM;
+	filter->count = 0;
+	filter->output = output;
+
+	/*CIC增益为FILTER_PRESUM * decim^order，12位输入先放大到15位，再右移到16位*/
+	for (bits = 0; (1 << bits) < filter->decim; bits++);
+	filter->shift = order * bits - 1;
+
+	for (i = 0; i < FILTER_LANES_MAX; i++)
+	{
+		filter->history[0][i] = 0;
+		filter->history[1][i] = 0;
+		filter->value[i] = 0;
+		for (j = 0; j < FILTER_ORDER_MAX; j++)
+		{
+			filter->integ[j][i] = 0;
+			filter->comb[j][i] = 0;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @Description 第一级累加，每个字的两个通道用__UADD16同时累加，再用__SMLAD分别加到32位积分器
+ * @note 通道的和不超过8 * 4095，作为有符号16位数也是正数，__SMLAD乘以0或1后就是原值
+ */
+static void Filter_PresumSimd(const u32 *frames, u8 words, u32 *integ)
+{
+	u32 acc[FILTER_LANES_MAX / 2];
+	u8 f, w;
+
+	for (w = 0; w < words; w++)
+	{
+		acc[w] = 0;
+	}
+	for (f = 0; f < FILTER_PRESUM; f++)
+	{
+		for (w = 0; w < words; w++)
+		{
+			acc[w] = __UADD16(acc[w], *frames++);
+		}
+	}
+
+	for (w = 0; w < words; w++)
+	{
+		integ[2 * w] = __SMLAD(acc[w], 0x00000001, integ[2 * w]);
+		integ[2 * w + 1] = __SMLAD(acc[w], 0x00010000, integ[2 * w + 1]);
+	}
+}
+
+/**
+ * @Description 第一级累加，普通的C代码，与Filter_PresumSimd()的结果完全相同
+ */
+static void Filter_PresumScalar(const u32 *frames, u8 words, u32 *integ)
+{
+	const u16 *sample = (const u16 *) frames;
+	u8 f, l;
+
+	for (f = 0; f < FILTER_PRESUM; f++)
+	{
+		for (l = 0; l < 2 * words; l++)
+		{
+			integ[l] += *sample++;
+		}
+	}
+}
+
+/**
+ * @Description 3点中值
+ */
+static u16 Filter_Median3(u16 a, u16 b, u16 c)
+{
+	if (a > b)
+	{
+		if (b > c)
+		{
+			return b;
+		}
+		return (a > c) ? c : a;
+	}
+	if (a > c)
+	{
+		return a;
+	}
+	return (b > c) ? c : b;
+}
+
+/**
+ * @Description 对FILTER_PRESUM帧做中值滤波，结果比输入晚一帧
+ * @param src 输入帧
+ * @param dst 输出帧，与输入的格式相同
+ */
+static void Filter_Median(FILTER_TypeDef *filter, const u16 *src, u16 *dst)
+{
+	u8 lanes = 2 * filter->words;
+	u8 f, l;
+
+	for (f = 0; f < FILTER_PRESUM; f++)
+	{
+		for (l = 0; l < lanes; l++)
+		{
+			*dst++ = Filter_Median3(filter->history[0][l], filter->history[1][l], *src);
+			filter->history[0][l] = filter->history[1][l];
+			filter->history[1][l] = *src++;
+		}
+	}
+}
+
+/**
+ * @Description 处理一个采样块，第二级每累加decim次输出一次
+ */
+static void Filter_Run(FILTER_TypeDef *filter, const u16 *block, u16 frames, FILTER_PresumFunc presum)
+{
+	u32 median[FILTER_PRESUM * FILTER_LANES_MAX / 2];
+	const u32 *src = (const u32 *) block;
+	u8 lanes = 2 * filter->words;
+	u32 x, y;
+	u16 b;
+	u8 k, l;
+
+	for (b = 0; b < frames / FILTER_PRESUM; b++)
+	{
+		if (filter->median)
+		{
+			Filter_Median(filter, (const u16 *) src, (u16 *) median);
+			presum(median, filter->words, filter->integ[0]);
+		}
+		else
+		{
+			presum(src, filter->words, filter->integ[0]);
+		}
+		src += FILTER_PRESUM * filter->words;
+
+		/*其余的积分器，32位溢出不影响结果*/
+		for (k = 1; k < filter->order; k++)
+		{
+			for (l = 0; l < lanes; l++)
+			{
+				filter->integ[k][l] += filter->integ[k - 1][l];
+			}
+		}
+
+		if (++filter->count < filter->decim)
+		{
+			continue;
+		}
+		filter->count = 0;
+
+		/*梳状滤波器，只在输出时计算*/
+		for (l = 0; l < lanes; l++)
+		{
+			x = filter->integ[filter->order - 1][l];
+			for (k = 0; k < filter->order; k++)
+			{
+				y = x - filter->comb[k][l];
+				filter->comb[k][l] = x;
+				x = y;
+			}
+			if (filter->shift > 0)
+			{
+				x = (x + (1 << (filter->shift - 1))) >> filter->shift;
+			}
+			filter->value[l] = (x > 0xFFFF) ? 0xFFFF : x;
+		}
+
+		if (filter->output != 0)
+		{
+			filter->output(filter->value, lanes);
+		}
+	}
+}
+
+/**
+ * @Description 处理一个采样块，可以连续处理DMA的两个采样块
+ * @param filter 滤波器
+ * @param block 采样块，必须按字对齐
+ * @param frames 帧数，必须为FILTER_PRESUM的倍数
+ */
+void Filter_Process(FILTER_TypeDef *filter, const u16 *block, u16 frames)
+{
+#if FILTER_SIMD
+	Filter_Run(filter, block, frames, Filter_PresumSimd);
+#else
+	Filter_Run(filter, block, frames, Filter_PresumScalar);
+#endif
+}
+
+#if FILTER_BENCH
+/**
+ * @Description 用同一个采样块比较SIMD和普通C代码的处理耗时，检查两者结果相同，结果通过串口输出
+ * @param block 采样块，必须按字对齐
+ * @param frames 帧数，必须为FILTER_PRESUM的倍数
+ * @param words 每帧的字数
+ * @note 使用DWT周期计数器计时，分别测试各阶CIC、有无中值滤波时每个采样的周期数
+ */
+void Filter_Benchmark(const u16 *block, u16 frames, u8 words)
+{
+	static FILTER_TypeDef simd, scalar;
+	u32 start, simd_cycles, scalar_cycles, samples = frames * 2 * words;
+	u8 order, median, l, same;
+
+	for (median = 0; median < 2; median++)
+	{
+		for (order = 1; order <= FILTER_ORDER_MAX; order++)
+		{
+			Filter_Init(&simd, words, FILTER_RATIO_MIN, order, median, 0);
+			Filter_Init(&scalar, words, FILTER_RATIO_MIN, order, median, 0);
+
+			start = SYSTICK_CYCCNT();
+			Filter_Run(&simd, block, frames, Filter_PresumSimd);
+			simd_cycles = SYSTICK_CYCCNT() - start;
+
+			start = SYSTICK_CYCCNT();
+			Filter_Run(&scalar, block, frames, Filter_PresumScalar);
+			scalar_cycles = SYSTICK_CYCCNT() - start;
+
+			same = 1;
+			for (l = 0; l < 2 * words; l++)
+			{
+				if (simd.value[l] != scalar.value[l])
+				{
+					same = 0;
+				}
+			}
+
+			printf("filter order %u median %u: simd %u.%02u, c %u.%02u cycles/sample, %s\r\n", order, median,
+			       simd_cycles / samples, simd_cycles * 100 / samples % 100,
+			       scalar_cycles / samples, scalar_cycles * 100 / samples % 100, same ? "same" : "DIFFERENT");
+		}
+	}
+}
+#endif
@@ -0,0 +1,61 @@
+#ifndef __EXPLORE_FILTER_H_
+#define __EXPLORE_FILTER_H_
+
+#include "stm32f4xx.h"
+
+/**
+ * 过采样抽取滤波器，输入为DMA采样块中交错存放的12位采样，每帧words个字，每个字两个采样(下面称为通道)。
+ * 第一级每FILTER_PRESUM帧用__UADD16把每个字的两个通道同时累加，再用__SMLAD累加到32位积分器，
+ * 第二级为order阶CIC滤波器，抽取比为ratio / FILTER_PRESUM，order为1时整体就是ratio点平均。
+ * 输出统一放大到16位满量程(12位结果左移4位)，有效位数约为12 + log2(ratio) / 2，16倍为14位，256倍为16位。
+ * 可选在第一级之前对每个通道做3点中值滤波，去除单个的尖峰。
+ */
+
+/*每帧最多的通道数*/
+#define FILTER_LANES_MAX 8
+
+/*CIC的最高阶数，256倍抽取时第二级积分器为15 + 3 * 5 = 30位，不会超过32位*/
+#define FILTER_ORDER_MAX 3
+
+/*第一级每次累加的帧数，8 * 4095 < 32768，__SMLAD按有符号16位计算也不会出错*/
+#define FILTER_PRESUM 8
+
+/*抽取比的范围，必须为2的幂*/
+#define FILTER_RATIO_MIN 16
+#define FILTER_RATIO_MAX 256
+
+/*1:第一级使用Cortex-M4的SIMD指令 0:使用普通的C代码*/
+#define FILTER_SIMD 1
+
+/*1:编译耗时测试函数Filter_Benchmark() 0:不编译*/
+#define FILTER_BENCH 0
+
+/*滤波器控制块*/
+typedef struct
+{
+	u8 words;						/*每帧的字数，通道数为2 * words*/
+	u8 order;						/*CIC阶数*/
+	u8 median;						/*1:先做3点中值滤波*/
+	u8 shift;						/*输出放大到16位时右移的位数*/
+	u16 ratio;						/*总的抽取比*/
+	u16 decim;						/*第二级的抽取比*/
+	u16 count;						/*第二级已经输入的个数*/
+	u16 history[2][FILTER_LANES_MAX];			/*中值滤波的前两帧*/
+	u32 integ[FILTER_ORDER_MAX][FILTER_LANES_MAX];		/*积分器*/
+	u32 comb[FILTER_ORDER_MAX][FILTER_LANES_MAX];		/*梳状滤波器上一次的输入*/
+	u16 value[FILTER_LANES_MAX];				/*最近一次的输出*/
+	void (*output)(const u16 *value, u8 lanes);		/*每次输出时调用*/
+} FILTER_TypeDef;
+
+/*初始化滤波器*/
+u8 Filter_Init(FILTER_TypeDef *filter, u8 words, u16 ratio, u8 order, u8 median, void (*output)(const u16 *value, u8 lanes));
+
+/*处理一个采样块*/
+void Filter_Process(FILTER_TypeDef *filter, const u16 *block, u16 frames);
+
+#if FILTER_BENCH
+/*测试每个采样的处理周期数*/
+void Filter_Benchmark(const u16 *block, u16 frames, u8 words);
+#endif
+
+#endif /*__EXPLORE_FILTER_H_*/
@@ -0,0 +1,201 @@
+#include "explore_sched.h"
+#include "stdio.h"
+
+/*任务表，编号越小优先级越高*/
+static SCHED_TaskTypeDef tasks[SCHED_TASK_MAX];
+static u8 task_num = 0;
+
+/*调度器时间，单位ms，在滴答中断中加1*/
+static volatile u32 sched_time = 0;
+
+/*统计的起始时间和这段时间内空闲的周期数*/
+static u32 stat_start = 0;
+static u32 stat_idle = 0;
+
+/*CPU时间统计函数*/
+static void (*account_hook)(u8 id, u32 cycles) = 0;
+
+/**
+ * @Description 滴答中断中调用，使周期到达的任务就绪
+ */
+static void Sched_Tick(void)
+{
+	SCHED_TaskTypeDef *task;
+	u8 i;
+
+	sched_time++;
+
+	for (i = 0; i < task_num; i++)
+	{
+		task = &tasks[i];
+		if (task->period != 0 && (s32) (sched_time - task->next) >= 0)
+		{
+			task->next += task->period;
+			Sched_SetEvent(i, SCHED_EVENT_TIMER);
+		}
+	}
+}
+
+/**
+ * @Description 初始化调度器，使用滴答中断作为周期任务的时钟，要先调用Systick_Init()
+ */
+void Sched_Init(void)
+{
+	task_num = 0;
+	stat_start = SYSTICK_CYCCNT();
+	stat_idle = 0;
+	Systick_SetTickHandler(Sched_Tick);
+}
+
+/**
+ * @Description 添加任务，先添加的任务优先级高
+ * @param name 任务名称，用于输出统计结果
+ * @param func 任务函数，执行完要立即返回
+ * @param period 周期，单位ms，0表示只由Sched_SetEvent()触发
+ * @param deadline 从就绪到开始执行的最长允许时间，单位us，0表示不检查
+ * @return 任务编号，任务表满时返回SCHED_TASK_MAX
+ */
+u8 Sched_AddTask(const char *name, void (*func)(u32 events), u32 period, u32 deadline)
+{
+	SCHED_TaskTypeDef *task;
+
+	if (task_num >= SCHED_TASK_MAX)
+	{
+		return SCHED_TASK_MAX;
+	}
+
+	task = &tasks[task_num];
+	task->name = name;
+	task->func = func;
+	task->period = period;
+	task->deadline = deadline;
+	task->next = sched_time + period;
+	task->events = 0;
+	task->runs = 0;
+	task->busy = 0;
+	task->busy_max = 0;
+	task->latency_max = 0;
+	task->misses = 0;
+
+	/*滴答中断只检查编号小于task_num的任务，填好任务控制块之后再加1*/
+	return task_num++;
+}
+
+/**
+ * @Description 设置任务的事件，使任务就绪，可以在中断中调用
+ * @param id 任务编号
+ * @param events 事件，多次设置的事件在任务执行时一起处理
+ */
+void Sched_SetEvent(u8 id, u32 events)
+{
+	SCHED_TaskTypeDef *task = &tasks[id];
+	u32 primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (task->events == 0)
+	{
+		task->ready = SYSTICK_CYCCNT();
+	}
+	task->events |= events;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @Description 设置每个任务执行完后调用的CPU时间统计函数
+ * @param hook 统计函数，参数为任务编号和这次执行的周期数，为0时不调用
+ */
+void Sched_SetAccountHook(void (*hook)(u8 id, u32 cycles))
+{
+	account_hook = hook;
+}
+
+/**
+ * @Description 开始调度，每次执行优先级最高的就绪任务，不会返回
+ */
+void Sched_Run(void)
+{
+	SCHED_TaskTypeDef *task;
+	u32 events, start, latency, idle;
+	u8 i;
+
+	idle = SYSTICK_CYCCNT();
+	while (1)
+	{
+		for (i = 0; i < task_num; i++)
+		{
+			if (tasks[i].events != 0)
+			{
+				break;
+			}
+		}
+		if (i == task_num)
+		{
+			SCHED_IDLE();
+			continue;
+		}
+
+		task = &tasks[i];
+
+		/*取出事件，执行期间新设置的事件在下一次执行时处理*/
+		__disable_irq();
+		events = task->events;
+		task->events = 0;
+		start = SYSTICK_CYCCNT();
+		latency = start - task->ready;
+		__enable_irq();
+
+		stat_idle += start - idle;
+		if (latency > task->latency_max)
+		{
+			task->latency_max = latency;
+		}
+		if (task->deadline != 0 && latency > task->deadline * (SystemCoreClock / 1000000))
+		{
+			task->misses++;
+		}
+
+		task->func(events);
+
+		idle = SYSTICK_CYCCNT();
+		task->runs++;
+		task->busy += idle - start;
+		if (idle - start > task->busy_max)
+		{
+			task->busy_max = idle - start;
+		}
+		if (account_hook != 0)
+		{
+			account_hook(i, idle - start);
+		}
+	}
+}
+
+/**
+ * @Description 通过串口输出每个任务的统计结果，然后清零，可以作为一个周期任务调用
+ * @note 统计间隔不能超过周期计数器溢出的时间(168MHz时约25秒)
+ */
+void Sched_Report(void)
+{
+	SCHED_TaskTypeDef *task;
+	u32 fac_us = SystemCoreClock / 1000000;
+	u32 total = SYSTICK_CYCCNT() - stat_start;
+	u8 i;
+
+	printf("task      runs   cpu%%  max(us)  latency(us)  misses\r\n");
+	for (i = 0; i < task_num; i++)
+	{
+		task = &tasks[i];
+		printf("%-8s %5u %6u %8u %12u %7u\r\n", task->name, task->runs, (u32) ((uint64_t) task->busy * 100 / total),
+		       task->busy_max / fac_us, task->latency_max / fac_us, task->misses);
+
+		task->runs = 0;
+		task->busy = 0;
+		task->busy_max = 0;
+		task->latency_max = 0;
+		task->misses = 0;
+	}
+	printf("idle %u%%\r\n", (u32) ((uint64_t) stat_idle * 100 / total));
+
+	stat_start = SYSTICK_CYCCNT();
+	stat_idle = 0;
+}
@@ -0,0 +1,61 @@
+#ifndef __EXPLORE_SCHED_H_
+#define __EXPLORE_SCHED_H_
+
+#include "stm32f4xx.h"
+#include "explore_systick.h"
+
+/**
+ * 协作式调度器，任务按添加的先后顺序排定优先级，每次从优先级最高的就绪任务开始执行，
+ * 任务必须执行完立即返回(不能调用delay_ms等待)，任务之间不会互相打断。
+ * 周期任务由1kHz滴答中断就绪，事件任务由Sched_SetEvent()就绪，可以在中断中调用。
+ * 调度器记录每个任务的执行次数、CPU时间、从就绪到开始执行的最长延迟和超过期限的次数。
+ */
+
+/*最多的任务个数*/
+#define SCHED_TASK_MAX 8
+
+/*没有就绪任务时在空闲循环中执行，主机上测试时定义为让模拟时间前进到下一个中断的函数*/
+/*芯片睡眠时DWT周期计数器停止计数，时间基准会变慢，所以默认不用__WFI()*/
+#ifndef SCHED_IDLE
+#define SCHED_IDLE()
+#endif
+
+/*周期到达时传给任务的事件，其余的位由Sched_SetEvent()设置*/
+#define SCHED_EVENT_TIMER 0x80000000
+
+/*任务控制块*/
+typedef struct
+{
+	const char *name;
+	void (*func)(u32 events);		/*任务函数，参数为这次执行要处理的事件*/
+	u32 period;				/*周期，单位ms，0表示只由事件触发*/
+	u32 deadline;				/*从就绪到开始执行的最长允许时间，单位us，0表示不检查*/
+	u32 next;				/*下一次周期到达的时间*/
+	volatile u32 events;			/*等待处理的事件，不为0表示就绪*/
+	volatile u32 ready;			/*就绪时周期计数器的值*/
+	u32 runs;				/*执行次数*/
+	u32 busy;				/*执行的周期数*/
+	u32 busy_max;				/*一次执行的最长周期数*/
+	u32 latency_max;			/*从就绪到开始执行的最长周期数*/
+	u32 misses;				/*超过期限的次数*/
+} SCHED_TaskTypeDef;
+
+/*初始化调度器*/
+void Sched_Init(void);
+
+/*添加任务，返回任务编号*/
+u8 Sched_AddTask(const char *name, void (*func)(u32 events), u32 period, u32 deadline);
+
+/*设置任务的事件，使任务就绪*/
+void Sched_SetEvent(u8 id, u32 events);
+
+/*设置每个任务执行完后调用的CPU时间统计函数*/
+void Sched_SetAccountHook(void (*hook)(u8 id, u32 cycles));
+
+/*开始调度，不会返回*/
+void Sched_Run(void);
+
+/*通过串口输出统计结果并清零*/
+void Sched_Report(void);
+
+#endif /*__EXPLORE_SCHED_H_*/
@@ -2,16 +2,152 @@
 #include "explore_system.h"
 #include "explore_systick.h"
 #include "explore_usart.h"
+#include "explore_sched.h"
+#include "explore_filter.h"
 #include "driver_led.h"
 #include "driver_lcd.h"
 #include "driver_adc.h"
 
-int main(void)
+/*每次显示的平均帧数*/
+#define ADC_AVERAGE_TIMES 21
+
+/*采样块任务编号和待处理的采样块*/
+u8 block_task;
+const u16 *adc_block;
+
+/*两次显示之间PA6的最小值和最大值，用于显示噪声*/
+u16 pa6_min = 0xFFFF;
+u16 pa6_max = 0;
+
+/*256倍过采样的滤波器和最近一次的16位结果*/
+FILTER_TypeDef adc_filter;
+u16 adc_filtered[ADC_FRAME_SIZE];
+
+/**
+ * @Description 滤波器每次输出时调用，保存各通道16位满量程的结果
+ */
+void Adc_Filtered(const u16 *value, u8 lanes)
+{
+	u8 l;
+
+	for (l = 0; l < lanes; l++)
+	{
+		adc_filtered[l] = value[l];
+	}
+}
+
+/**
+ * @Description 采样块满时在DMA中断中调用，通知采样块任务处理
+ */
+void Adc_BlockReady(const u16 *block, u16 frames)
+{
+	adc_block = block;
+	Sched_SetEvent(block_task, 1);
+}
+
+/**
+ * @Description 采样块任务，过采样滤波并统计PA6的最小值和最大值，要在下一个块写满之前完成
+ */
+void Task_Block(u32 events)
+{
+	const u16 *block = adc_block;
+	u16 value;
+	u8 t;
+#if FILTER_BENCH
+	static u8 bench = 0;
+
+	/*用第一个采样块测试一次滤波器的耗时*/
+	if (bench == 0)
+	{
+		bench = 1;
+		Filter_Benchmark(block, ADC_BLOCK_FRAMES, ADC_FRAME_SIZE / 2);
+	}
+#endif
+
+	Filter_Process(&adc_filter, block, ADC_BLOCK_FRAMES);
+
+	for (t = 0; t < ADC_BLOCK_FRAMES; t++)
+	{
+		value = block[t * ADC_FRAME_SIZE + ADC_INDEX_PA6];
+		if (value < pa6_min)
+		{
+			pa6_min = value;
+		}
+		if (value > pa6_max)
+		{
+			pa6_max = value;
+		}
+	}
+}
+
+/**
+ * @Description 显示任务，每250ms显示各通道最近的平均值，不再等待ADC转换
+ */
+void Task_Display(u32 events)
 {
 	u16 adcx;
 	float temp;
 	u8 length;
 
+	adcx = Adc_GetAverageValue(ADC_Channel_6, ADC_AVERAGE_TIMES);
+
+	/*显示ADC采样后的原始值*/
+	LCD_Fill(186, 100, 480, 130, BACK_COLOR);
+	LCD_ShowInt(198, 100, adcx, 24);
+
+	/*获取计算后的带小数的实际电压值*/
+	temp = (float) adcx * (3.3 / 4096);
+
+	LCD_Fill(186, 130, 480, 160, BACK_COLOR);
+	length = LCD_ShowFloat(198, 130, temp, 24);
+	LCD_ShowChar(198 + length * 12, 130, 'V', 24, DRAW_DIRECT);
+
+	/*显示PA6在这段时间内的峰峰值*/
+	LCD_Fill(186, 160, 480, 190, BACK_COLOR);
+	LCD_ShowInt(198, 160, pa6_max - pa6_min, 24);
+	pa6_min = 0xFFFF;
+	pa6_max = 0;
+
+	/*显示PF7的电压值*/
+	temp = (float) Adc_GetAverageValue(ADC_Channel_5, ADC_BLOCK_FRAMES) * (3.3 / 4096);
+	LCD_Fill(186, 190, 480, 220, BACK_COLOR);
+	length = LCD_ShowFloat(198, 190, temp, 24);
+	LCD_ShowChar(198 + length * 12, 190, 'V', 24, DRAW_DIRECT);
+
+	/*根据公式计算出CPU温度值*/
+	temp = (float) Adc_GetAverageValue(ADC_Channel_16, ADC_BLOCK_FRAMES) * (3.3 / 4096);
+	temp = ((temp - 0.76) * 1000.0 / 2.5) + 25.0;
+	LCD_Fill(186, 220, 480, 250, BACK_COLOR);
+	length = LCD_ShowFloat(198, 220, temp, 24);
+	LCD_ShowChar(198 + length * 12, 220, 'C', 24, DRAW_DIRECT);
+
+	/*显示PA6过采样后的16位结果，两个序号的结果再平均*/
+	LCD_Fill(186, 250, 480, 280, BACK_COLOR);
+	LCD_ShowInt(198, 250, (adc_filtered[ADC_INDEX_PA6] + adc_filtered[ADC_INDEX_PA6 + 3] + 1) / 2, 24);
+}
+
+/**
+ * @Description LED任务，每250ms闪烁LED0，提示系统正在运行
+ */
+void Task_Led(u32 events)
+{
+	LED0 = !LED0;
+}
+
+/**
+ * @Description 统计任务，每5秒通过串口输出各任务的CPU时间和延迟，以及ADC实际的采样率
+ */
+void Task_Report(u32 events)
+{
+	static u32 blocks = 0;
+
+	Sched_Report();
+	printf("adc %u frames/s, overruns %u\r\n", (adc_blocks - blocks) * ADC_BLOCK_FRAMES / 5, adc_overruns);
+	blocks = adc_blocks;
+}
+
+int main(void)
+{
 	NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
 	Systick_Init(168);
 	Usart_Init(115200);
@@ -28,26 +164,23 @@ int main(void)
 	POINT_COLOR = BLUE;
 	LCD_ShowString(30, 100, 450, 30, 24, "ADC2_CH6_VAL:");
 	LCD_ShowString(30, 130, 450, 30, 24, "ADC2_CH6_VOL:");
+	LCD_ShowString(30, 160, 450, 30, 24, "ADC2_CH6_P-P:");
+	LCD_ShowString(30, 190, 450, 30, 24, "ADC3_CH5_VOL:");
+	LCD_ShowString(30, 220, 450, 30, 24, "Temperature:");
+	LCD_ShowString(30, 250, 450, 30, 24, "ADC2_CH6_16B:");
 
-	while (1)
-	{
-		/*获取通道6的转换值，21次取平均*/
-		adcx = Adc_GetAverageValue(ADC_Channel_6, 21);
-
-		/*显示ADC采样后的原始值*/
-		LCD_Fill(186, 100, 480, 130, BACK_COLOR);
-		LCD_ShowInt(198, 100, adcx, 24);
+	/*每帧3个字，256倍过采样，2阶CIC，先去除尖峰*/
+	Filter_Init(&adc_filter, ADC_FRAME_SIZE / 2, 256, 2, 1, Adc_Filtered);
 
-		/*获取计算后的带小数的实际电压值*/
-		temp = (float) adcx * (3.3 / 4096);
+	/*添加的顺序就是优先级，采样块要在下一块写满之前处理完，期限为一块的时间*/
+	Sched_Init();
+	block_task = Sched_AddTask("block", Task_Block, 0, ADC_BLOCK_FRAMES * 1000000 / ADC_SAMPLE_RATE);
+	Sched_AddTask("display", Task_Display, 250, 0);
+	Sched_AddTask("led", Task_Led, 250, 0);
+	Sched_AddTask("report", Task_Report, 5000, 0);
 
-		/*显示转化后的电压值*/
-		LCD_Fill(186, 130, 480, 160, BACK_COLOR);
-		length = LCD_ShowFloat(198, 130, temp, 24);
-		LCD_ShowChar(198 + length * 12, 130, 'V', 24, DRAW_DIRECT);
+	/*ADC由定时器触发，DMA写满一块时通知采样块任务*/
+	Adc_SetBlockHandler(Adc_BlockReady);
 
-		LED0 = !LED0;
-
-		delay_ms(250);
-	}
+	Sched_Run();
 }
@@ -11,6 +11,11 @@ u16 USART_RX_STA = 0;
 /*接收缓冲数组,最大接收USART_REC_LEN个字节*/
 u8 USART_RX_BUF[USART_REC_LEN];
 
+/*发送缓冲，fputc()写入，串口发送中断逐字节发出，tx_head == tx_tail时为空*/
+static u8 tx_buf[USART_TX_LEN];
+static volatile u16 tx_head = 0;
+static volatile u16 tx_tail = 0;
+
 /**
  * @Description 初始化I/O串口2
  * @param bound 波特率
@@ -67,7 +72,23 @@ void Usart_Init(u32 bound)
 }
 
 /**
- * @Description 串口2中断服务函数，每有接收一个字节，申请一次中断，中断函数里面接收，直到接收到换行停止接收
+ * @Description 把发送缓冲中最早的一个字节写入数据寄存器，缓冲空时关闭发送中断
+ * @note 在串口中断中或关中断时调用
+ */
+static void Usart_SendNext(void)
+{
+	if(tx_tail == tx_head)
+	{
+		USART_ITConfig(USART2, USART_IT_TXE, DISABLE);
+		return;
+	}
+	USART_SendData(USART2, tx_buf[tx_tail]);
+	tx_tail = (tx_tail + 1) % USART_TX_LEN;
+}
+
+/**
+ * @Description 串口2中断服务函数，每有接收一个字节，申请一次中断，中断函数里面接收，直到接收到换行停止接收；
+ *              发送数据寄存器空时发出发送缓冲中的下一个字节
  */
 void USART2_IRQHandler(void)
 {
@@ -125,6 +146,12 @@ void USART2_IRQHandler(void)
 			}
 		}
 	}
+
+	/*发送数据寄存器空，发出发送缓冲中的下一个字节*/
+	if(USART_GetITStatus(USART2, USART_IT_TXE) != RESET)
+	{
+		Usart_SendNext();
+	}
 }
 
 /*加入以下代码,支持printf函数，而不需要选择use MicroLIB*/
@@ -147,16 +174,40 @@ void _sys_exit(int x)
 }
 
 /**
- * @Description 重定义fputc函数
+ * @Description 重定义fputc函数，字符写入发送缓冲后立即返回，由串口发送中断发出
+ * @note 缓冲满时直接等待数据寄存器空并发出最早的字节，在中断中(如定时器中断里printf)或关中断时调用也不会死等
  */
 int fputc(int ch, FILE *f)
 {
-	/*循环发送,直到发送完毕*/
-	while((USART2->SR & 0X40) == 0)
-		;
+	u32 primask = __get_PRIMASK();
+	u16 next;
 
-	/*装载要发送的数据*/
-	USART2->DR = (u8) ch;
+	__disable_irq();
+	next = (tx_head + 1) % USART_TX_LEN;
+	while(next == tx_tail)
+	{
+		if(USART_GetFlagStatus(USART2, USART_FLAG_TXE) != RESET)
+		{
+			Usart_SendNext();
+		}
+
+		/*等待期间允许其他中断执行*/
+		__set_PRIMASK(primask);
+		__disable_irq();
+	}
+	tx_buf[tx_head] = (u8) ch;
+	tx_head = next;
+	USART_ITConfig(USART2, USART_IT_TXE, ENABLE);
+	__set_PRIMASK(primask);
 
 	return ch;
 }
+
+/**
+ * @Description 等待发送缓冲中的数据全部发出，如进入低功耗或复位之前
+ */
+void Usart_Flush(void)
+{
+	while(USART_GetFlagStatus(USART2, USART_FLAG_TC) == RESET || tx_tail != tx_head)
+		;
+}
@@ -3,16 +3,37 @@
 
 #include "stm32f4xx.h"
 
-/*初始化延时函数*/
+/*滴答中断频率，单位Hz*/
+#define SYSTICK_RATE 1000
+
+/*时间基准为DWT周期计数器，滴答定时器只产生1kHz中断并把周期计数器扩展为64位*/
+/*延时不修改滴答定时器，可以在中断中调用；主机上测试时可以把SYSTICK_CYCCNT()定义为模拟的计数器*/
+#ifndef SYSTICK_CYCCNT
+#define SYSTICK_CYCCNT() (DWT->CYCCNT)
+#endif
+
+/*初始化周期计数器和滴答中断*/
 void Systick_Init(u8 SYSCLK);
 
-/*延时nus微秒，最大延时798915us*/
+/*设置滴答中断中调用的处理函数*/
+void Systick_SetTickHandler(void (*handler)(void));
+
+/*上电以来的周期数*/
+uint64_t cycles(void);
+
+/*上电以来的微秒数，约71分钟溢出一次*/
+u32 micros(void);
+
+/*上电以来的毫秒数，约49天溢出一次*/
+u32 millis(void);
+
+/*延时nus微秒*/
 void delay_us(u32 nus);
 
-/*延时nms毫秒，最大延时65536ms*/
+/*延时nms毫秒，最大延时65535ms*/
 void delay_ms(u16 nms);
 
-/*延时nms毫秒，最大延时798ms*/
+/*同delay_ms，保留用于兼容*/
 void delay_xms(u16 nms);
 
 #endif
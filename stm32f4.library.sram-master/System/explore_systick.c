@@ -1,76 +1,131 @@
 #include "explore_systick.h"
 
-/*保存延时1us/1ms滴答定时器的计数个数*/
-static u8 fac_us = 0;
-static u16 fac_ms = 0;
+/*保存1us的周期数，即系统时钟(单位为Mhz)*/
+static u32 fac_us = 0;
+
+/*64位周期数的高32位和上次滴答中断时周期计数器的值*/
+static volatile u32 cyc_high = 0;
+static volatile u32 cyc_last = 0;
+
+/*滴答中断中调用的处理函数*/
+static void (*tick_handler)(void) = 0;
 
 /**
- * @Description 初始化延时函数
+ * @Description 初始化DWT周期计数器和滴答定时器，滴答定时器使用系统时钟，每1ms中断一次
  * @param system_clock 系统时钟(单位为Mhz)
  */
 void Systick_Init(u8 system_clock)
 {
-	/*设置滴答定时器的时钟为系统时钟的8分频*/
-	SysTick_CLKSourceConfig(SysTick_CLKSource_HCLK_Div8);
+	fac_us = system_clock;
 
-	/*系统时钟为system_clock，滴答定时器的时钟为((system_clock * 10^6) / 8) */
-	/*可以算出，一个计数值的时间是 (8 / (system_clock * 10^6)) */
-	/*那么定时1us的计数值就是 ((10^-6 * (system_clock * 10^6))/ 8) = (system_clock / 8) */
-	fac_us = system_clock / 8;
+	/*开启DWT周期计数器，周期计数器约每2^32 / (system_clock * 10^6)秒溢出一次*/
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	cyc_last = SYSTICK_CYCCNT();
 
-	/*定时1ms的计数值肯定就是1us的100倍了*/
-	fac_ms = (u16) fac_us * 1000;
+	/*滴答中断为最低优先级，只要在周期计数器溢出前执行过一次，64位周期数就是连续的*/
+	SysTick_Config(fac_us * 1000000 / SYSTICK_RATE);
 }
 
 /**
- * @Description 延时nus微秒
- * @param nus 延时时间 nus <= 798915us(最大值即2^24 / fac_us@fac_us = 21)
+ * @Description 设置滴答中断中调用的处理函数
+ * @param handler 处理函数，为0时不调用
  */
-void delay_us(u32 nus)
+void Systick_SetTickHandler(void (*handler)(void))
 {
-	/*记录读取的滴答定时器控制寄存器CTRL数据的临时变量*/
-	u32 temp;
+	tick_handler = handler;
+}
+
+/**
+ * @Description 滴答中断服务函数，记录周期计数器的溢出
+ */
+void SysTick_Handler(void)
+{
+	u32 now;
+
+	/*高32位和上次的值一起更新，被其他中断打断时cycles()不会重复计入溢出*/
+	__disable_irq();
+	now = SYSTICK_CYCCNT();
+	if (now < cyc_last)
+	{
+		cyc_high++;
+	}
+	cyc_last = now;
+	__enable_irq();
 
-	/*设置定时器的重装载值为 nus * fac_us*/
-	/*根据定时的时间给滴答定时器加载重装载值*/
-	SysTick->LOAD = nus * fac_us;
+	if (tick_handler != 0)
+	{
+		tick_handler();
+	}
+}
 
-	/*设置滴答定时器的计数值为0，清空滴答定时器*/
-	SysTick->VAL = 0x00;
+/**
+ * @Description 读取上电以来的周期数，可以在中断中调用
+ * @return 64位周期数
+ */
+uint64_t cycles(void)
+{
+	u32 primask = __get_PRIMASK();
+	u32 high, now;
 
-	/*开启滴答定时器，此刻滴答定时器已经默默的在后台开始计时了*/
-	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	__disable_irq();
+	now = SYSTICK_CYCCNT();
+	high = cyc_high;
 
-	/*持续的读取滴答定时器COUNTFLAG(CTRL的位16)，判断定时是否到达*/
-	/*定时器没有到达之前程序一直停在这个死循环里面*/
-	do
+	/*在更高优先级的中断中或关中断时，周期计数器溢出后滴答中断可能还没有执行*/
+	if (now < cyc_last)
 	{
-		temp = SysTick->CTRL;
-	} while((temp & 0x01) && !(temp & (1 << 16)));
+		high++;
+	}
+	__set_PRIMASK(primask);
+
+	return ((uint64_t) high << 32) | now;
+}
+
+/**
+ * @Description 读取上电以来的微秒数
+ */
+u32 micros(void)
+{
+	return (u32) (cycles() / fac_us);
+}
 
-	/*关闭滴答定时器*/
-	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+/**
+ * @Description 读取上电以来的毫秒数
+ */
+u32 millis(void)
+{
+	return (u32) (cycles() / (fac_us * 1000));
+}
+
+/**
+ * @Description 延时nus微秒，只读取周期计数器，可以在中断中调用，也可以被中断中的延时打断
+ * @param nus 延时时间
+ */
+void delay_us(u32 nus)
+{
+	u32 start = SYSTICK_CYCCNT();
+	u32 n;
 
-	/*设置滴答定时器的计数值为0，清空滴答定时器*/
-	SysTick->VAL = 0x00;
+	/*每次最多等待1秒，周期数不会超过32位*/
+	while (nus > 0)
+	{
+		n = (nus > 1000000) ? 1000000 : nus;
+		while (SYSTICK_CYCCNT() - start < n * fac_us)
+		{
+		}
+		start += n * fac_us;
+		nus -= n;
+	}
 }
 
 /**
  * @Description 延时nms毫秒
- * @param nus 延时时间 nms <= 798ms 算法同上一个函数
+ * @param nus 延时时间 nms<=65535
  */
 void delay_xms(u16 nms)
 {
-	u32 temp;
-	SysTick->LOAD = (u32) nms * fac_ms;
-	SysTick->VAL = 0x00;
-	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
-	do
-	{
-		temp = SysTick->CTRL;
-	} while((temp & 0x01) && !(temp & (1 << 16)));
-	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
-	SysTick->VAL = 0X00;
+	delay_us((u32) nms * 1000);
 }
 
 /**
@@ -79,19 +134,5 @@ void delay_xms(u16 nms)
  */
 void delay_ms(u16 nms)
 {
-	/*这个函数其实就是将nms分解开来，分解成为多个 540ms * repeat + remain */
-	/*然后分别延时，因为上面的延时函数组最多只可以延时798ms*/
-	u8 repeat = nms / 540;
-	u16 remain = nms % 540;
-
-	while(repeat)
-	{
-		delay_xms(540);
-		repeat--;
-	}
-
-	if(remain)
-	{
-		delay_xms(remain);
-	}
+	delay_us((u32) nms * 1000);
 }
@@ -46,11 +46,6 @@ void PendSV_Handler(void)
 	
 }
 
-void SysTick_Handler(void)
-{
-  
-}
-
 void PPP_IRQHandler(void)
 {
 	
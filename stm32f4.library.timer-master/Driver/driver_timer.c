@@ -51,7 +51,7 @@ void TIM3_IRQHandler(void)
 		/*每0.5秒 DS1翻转*/
 		DS1 = !DS1;
 
-		/*利用串口时间戳观察时间间隔*/
+		/*利用串口时间戳观察时间间隔，printf只写入发送缓冲，不会在中断中等待串口发送*/
 		printf("DS1 *************************   \r\n");
 	}
 	/*清除中断标志位*/
@@ -8,6 +8,9 @@
 /*定义最大接收字节数*/
 #define USART_REC_LEN 200
 
+/*定义发送缓冲的字节数，printf()的输出先写入发送缓冲，由串口发送中断发出*/
+#define USART_TX_LEN 256
+
 /*接收缓冲，最大 USART_REC_LEN 个字节，末字节为换行符*/
 extern u8 USART_RX_BUF[USART_REC_LEN];
 
@@ -17,4 +20,7 @@ extern u16 USART_RX_STA;
 /*串口2初始化函数*/
 void Usart_Init(u32 bound);
 
+/*等待发送缓冲中的数据全部发出*/
+void Usart_Flush(void);
+
 #endif /*__EXPLORE_USART_H_*/
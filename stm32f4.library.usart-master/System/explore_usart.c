@@ -11,6 +11,14 @@ u16 USART_RX_STA = 0;
 /*接收缓冲数组,最大接收USART_REC_LEN个字节*/
 u8 USART_RX_BUF[USART_REC_LEN];
 
+/*发送缓冲，fputc()写入，串口发送中断逐字节发出，tx_head == tx_tail时为空*/
+static u8 tx_buf[USART_TX_LEN];
+static volatile u16 tx_head = 0;
+static volatile u16 tx_tail = 0;
+
+/*接收完一行时在中断中调用的函数*/
+static void (*line_handler)(void) = 0;
+
 /**
  * @Description 初始化I/O串口1
  * @param bound 波特率
@@ -68,7 +76,32 @@ void Usart_Init(u32 bound)
 }
 
 /**
- * @Description 串口1中断服务函数，每有接收一个字节，申请一次中断，中断函数里面接收，直到接收到换行停止接收
+ * @Description 设置接收完一行时调用的函数，用于通知调度器，不用再在主循环中查询USART_RX_STA
+ * @param handler 在串口中断中调用，为0时不调用
+ */
+void Usart_SetLineHandler(void (*handler)(void))
+{
+	line_handler = handler;
+}
+
+/**
+ * @Description 把发送缓冲中最早的一个字节写入数据寄存器，缓冲空时关闭发送中断
+ * @note 在串口中断中或关中断时调用
+ */
+static void Usart_SendNext(void)
+{
+	if (tx_tail == tx_head)
+	{
+		USART_ITConfig(USART1, USART_IT_TXE, DISABLE);
+		return;
+	}
+	USART_SendData(USART1, tx_buf[tx_tail]);
+	tx_tail = (tx_tail + 1) % USART_TX_LEN;
+}
+
+/**
+ * @Description 串口1中断服务函数，每有接收一个字节，申请一次中断，中断函数里面接收，直到接收到换行停止接收；
+ *              发送数据寄存器空时发出发送缓冲中的下一个字节
  */
 void USART1_IRQHandler(void)
 {
@@ -97,6 +130,11 @@ void USART1_IRQHandler(void)
 				{
 					/*如果再接收到0x0a，就把USART_RX_STA中接收完成标志置位，表示接收完成了*/
 					USART_RX_STA |= 0x8000;
+
+					if (line_handler != 0)
+					{
+						line_handler();
+					}
 				}
 			}
 			else
@@ -126,6 +164,12 @@ void USART1_IRQHandler(void)
 			}
 		}
 	}
+
+	/*发送数据寄存器空，发出发送缓冲中的下一个字节*/
+	if (USART_GetITStatus(USART1, USART_IT_TXE) != RESET)
+	{
+		Usart_SendNext();
+	}
 }
 
 /*加入以下代码,支持printf函数，而不需要选择use MicroLIB*/
@@ -148,15 +192,40 @@ void _sys_exit(int x)
 }
 
 /**
- * @Description 重定义fputc函数
+ * @Description 重定义fputc函数，字符写入发送缓冲后立即返回，由串口发送中断发出
+ * @note 缓冲满时直接等待数据寄存器空并发出最早的字节，在中断中(如定时器中断里printf)或关中断时调用也不会死等
  */
 int fputc(int ch, FILE *f)
 {
-	/*循环发送,直到发送完毕*/
-	while ((USART1->SR & 0X40) == 0);
+	u32 primask = __get_PRIMASK();
+	u16 next;
 
-	/*装载要发送的数据*/
-	USART1->DR = (u8) ch;
+	__disable_irq();
+	next = (tx_head + 1) % USART_TX_LEN;
+	while (next == tx_tail)
+	{
+		if (USART_GetFlagStatus(USART1, USART_FLAG_TXE) != RESET)
+		{
+			Usart_SendNext();
+		}
+
+		/*等待期间允许其他中断执行*/
+		__set_PRIMASK(primask);
+		__disable_irq();
+	}
+	tx_buf[tx_head] = (u8) ch;
+	tx_head = next;
+	USART_ITConfig(USART1, USART_IT_TXE, ENABLE);
+	__set_PRIMASK(primask);
 
 	return ch;
 }
+
+/**
+ * @Description 等待发送缓冲中的数据全部发出，如进入低功耗或复位之前
+ */
+void Usart_Flush(void)
+{
+	while (USART_GetFlagStatus(USART1, USART_FLAG_TC) == RESET || tx_tail != tx_head)
+		;
+}
@@ -2,14 +2,58 @@
 #include "explore_system.h"
 #include "explore_systick.h"
 #include "explore_usart.h"
+#include "explore_sched.h"
 #include "driver_led.h"
 
-/*for循环计数变量*/
-u8 t;
-/*保存接收数据的长度*/
-u8 len;
-/*一个用于计时的变量*/
-u16 times = 0;
+/*回显任务的编号*/
+u8 echo_task;
+
+/**
+ * @Description 串口中断接收完一行时调用，使回显任务就绪
+ */
+void Usart_LineReceived(void)
+{
+	Sched_SetEvent(echo_task, 1);
+}
+
+/**
+ * @Description 回显任务，将接收的数据原封不动的打印回上位机
+ */
+void Task_Echo(u32 events)
+{
+	u8 len;
+
+	/*得到此次接收到的数据长度*/
+	len = USART_RX_STA & 0x3fff;
+	/*接收缓冲没有结束符，按长度打印接收到的字符，再插入换行*/
+	printf("Your input is: %.*s\r\n", len, (char *) USART_RX_BUF);
+	/*写入发送缓冲之后，清空自定义的标志寄存器*/
+	USART_RX_STA = 0;
+}
+
+/**
+ * @Description 提示任务，每2秒打印提示语句
+ */
+void Task_Prompt(u32 events)
+{
+	printf("I can output your input.\r\n");
+}
+
+/**
+ * @Description LED任务，每300ms闪烁DS0，提示系统正在运行
+ */
+void Task_Led(u32 events)
+{
+	DS0 = !DS0;
+}
+
+/**
+ * @Description 统计任务，每10秒通过串口输出各任务的CPU时间和延迟
+ */
+void Task_Report(u32 events)
+{
+	Sched_Report();
+}
 
 int main(void)
 {
@@ -19,44 +63,13 @@ int main(void)
 	Usart_Init(115200);
 	LED_Init();
 
-	while (1)
-	{
-		/*如果接收完了所有的字符(每一次串口中断接收一个字符)*/
-		if (USART_RX_STA & 0x8000)
-		{
-			/*得到此次接收到的数据长度*/
-			len = USART_RX_STA & 0x3fff;
-			printf("Your input is: ");
-			/*将接收的数据原封不动的打印回上位机*/
-			for (t = 0; t < len; t++)
-			{
-				/*向串口1发送数据，依次发送接收到的每一个字符*/
-				USART_SendData(USART1, USART_RX_BUF[t]);
-				/*等待发送结束*/
-				while (USART_GetFlagStatus(USART1, USART_FLAG_TC) != SET)
-					;
-			}
-			/*插入换行*/
-			printf("\r\n");
-			/*全部发送完成之后，清空自定义的标志寄存器*/
-			USART_RX_STA = 0;
-		}
-		else
-		{
-			/*在数据没有接收到或者没有接收完的情况下*/
-			times++;
-			if (times % 200 == 0)
-			{
-				/*每隔200*10ms = 2000ms 打印提示语句*/
-				printf("I can output your input.\r\n");
-			}
-			if (times % 30 == 0)
-			{
-				/*每隔30*10 = 300ms 闪烁LED,提示系统正在运行*/
-				DS0 = !DS0;
-			}
-			/*每隔10ms检查一次*/
-			delay_ms(10);
-		}
-	}
+	/*添加的顺序就是优先级，回显在中断收到一行后立即执行，不再等待10ms的轮询*/
+	Sched_Init();
+	echo_task = Sched_AddTask("echo", Task_Echo, 0, 100);
+	Sched_AddTask("led", Task_Led, 300, 0);
+	Sched_AddTask("prompt", Task_Prompt, 2000, 0);
+	Sched_AddTask("report", Task_Report, 10000, 0);
+	Usart_SetLineHandler(Usart_LineReceived);
+
+	Sched_Run();
 }
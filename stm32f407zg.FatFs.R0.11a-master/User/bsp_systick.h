@@ -51,10 +51,25 @@
 #define PIin(n)         BIT_ADDR(GPIOI_IDR_Addr, n)
 
 #define SYSTEM_CLOCK 168                        // 定义系统时钟，单位MHz
+#define SYSTICK_RATE 1000                       // 滴答中断频率，单位Hz
 
-void Systick_Init(void);                        // 初始化延时函数
-void delay_us(u32 nus);                         // 延时nus微秒，最大延时798915us
-void delay_ms(u16 nms);                         // 延时nms毫秒，最大延时65536ms
-void delay_xms(u16 nms);                        // 延时nms毫秒，最大延时798ms
+/**
+ * 时间基准使用内核DWT的32位周期计数器，滴答定时器只产生1kHz的周期中断，
+ * 在中断中把周期计数器扩展为64位，并调用Systick_SetTickHandler()设置的处理函数(如任务调度)。
+ * 延时只读取周期计数器，不修改滴答定时器，可以在中断中调用，中断中的延时和主循环中的延时互不影响。
+ * 在主机上测试时，可以在编译时把SYSTICK_CYCCNT()定义为模拟的计数器
+ */
+#ifndef SYSTICK_CYCCNT
+#define SYSTICK_CYCCNT()        (DWT->CYCCNT)
+#endif
+
+void Systick_Init(void);                        // 初始化周期计数器和滴答中断
+void Systick_SetTickHandler(void (*handler)(void));     // 设置滴答中断中调用的处理函数
+uint64_t cycles(void);                          // 上电以来的周期数
+u32 micros(void);                               // 上电以来的微秒数，约71分钟溢出一次
+u32 millis(void);                               // 上电以来的毫秒数，约49天溢出一次
+void delay_us(u32 nus);                         // 延时nus微秒
+void delay_ms(u16 nms);                         // 延时nms毫秒，最大延时65535ms
+void delay_xms(u16 nms);                        // 同delay_ms()，保留用于兼容
 
 #endif /* __BSP_SYSTICK_H */
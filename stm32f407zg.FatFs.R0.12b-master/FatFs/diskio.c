@@ -1,5 +1,6 @@
 #include "diskio.h"
 #include "bsp_w25qxx.h"
+#include "bsp_log.h"
 #include "stm32f4xx.h"
 
 /* 为每一个物理的磁盘分配盘符(编号) */
@@ -8,6 +9,11 @@
 #define DEV_SDCard      2       // SDIO SDCard
 #define DEV_USB         3       // USB
 
+/* W25Q128的最小擦除单位为4KB扇区，FatFs扇区大小与之一致，块擦除单位为64KB */
+#define FLASH_SECTOR_SIZE       4096
+#define FLASH_SECTOR_COUNT      (W25QXX_FATFS_SIZE / FLASH_SECTOR_SIZE) // 10MB/4KB，剩余空间存放字库
+#define FLASH_BLOCK_SECTORS     16      // 64KB/4KB
+
 /**
  * @Description 
  * @param 
@@ -24,7 +30,7 @@ DSTATUS disk_status(BYTE pdrv)
                 if(W25QXX_ReadID() == W25Q128)
                 {
                         stat = STA_OK;
-                        printf("diskio:\t\tFlash Init Status = %d\r\n\r\n", stat);
+                        LOG1("diskio:\t\tFlash Init Status = %d\r\n\r\n", stat);
                 }
                 else
                 {
@@ -87,7 +93,16 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
         switch(pdrv)
         {
         case DEV_FLASH:
-                W25QXX_Read(buff, sector * 4096, count * 4096);
+                /* 只允许访问文件系统区域，旧的16MB卷超出的部分是字库区域 */
+                if(sector >= FLASH_SECTOR_COUNT || count > FLASH_SECTOR_COUNT - sector)
+                {
+                        return RES_PARERR;
+                }
+                /* W25QXX_Read一次最多读65535字节，按扇区逐个读取 */
+                for(; count; count--, sector++, buff += FLASH_SECTOR_SIZE)
+                {
+                        W25QXX_Read(buff, sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+                }
                 res = RES_OK;
                 return res;
 
@@ -113,11 +128,38 @@ DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
 DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
 {
         DRESULT res;
+        UINT i;
 
         switch(pdrv)
         {
         case DEV_FLASH:
-                W25QXX_Write((u8*) buff, sector * 4096, count * 4096);
+                /* 只允许写入文件系统区域，不会擦除字库 */
+                if(sector >= FLASH_SECTOR_COUNT || count > FLASH_SECTOR_COUNT - sector)
+                {
+                        return RES_PARERR;
+                }
+                while(count)
+                {
+                        if((sector % FLASH_BLOCK_SECTORS) == 0 && count >= FLASH_BLOCK_SECTORS)
+                        {
+                                /* 整块覆盖写，一次块擦除后直接编程，省去逐扇区的读出、校验和擦除 */
+                                W25QXX_EraseBlock(sector / FLASH_BLOCK_SECTORS);
+                                for(i = 0; i < FLASH_BLOCK_SECTORS; i++)
+                                {
+                                        W25QXX_WriteNoCheck((u8*) buff, sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+                                        sector++;
+                                        buff += FLASH_SECTOR_SIZE;
+                                }
+                                count -= FLASH_BLOCK_SECTORS;
+                        }
+                        else
+                        {
+                                W25QXX_Write((u8*) buff, sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+                                sector++;
+                                buff += FLASH_SECTOR_SIZE;
+                                count--;
+                        }
+                }
                 res = RES_OK;
                 return res;
 
@@ -147,17 +189,23 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
         switch(pdrv)
         {
         case DEV_FLASH:
+                res = RES_OK;
                 switch(cmd)
                 { 
+			case CTRL_SYNC:                         // 写操作都是同步完成的，无需处理
+                                break;
 			case GET_SECTOR_COUNT:                  // 返回扇区个数
-				*(DWORD*)buff = 4096;           // 16MB/4KB
+				*(DWORD*)buff = FLASH_SECTOR_COUNT;
                                 break;
 			case GET_SECTOR_SIZE:
-				*(WORD*)buff = 4096;            // 返回每个扇区大小4KB
+				*(WORD*)buff = FLASH_SECTOR_SIZE; // 返回每个扇区大小4KB
                                 break;
-			case GET_BLOCK_SIZE:                    // 返回擦除扇区的最小个数(单位为扇区)
-                                *(WORD*)buff = 1;
+			case GET_BLOCK_SIZE:                    // 返回擦除块大小(单位为扇区)，f_mkfs据此对齐FAT和数据区
+                                *(DWORD*)buff = FLASH_BLOCK_SECTORS;
 			break;
+                        default:
+                                res = RES_PARERR;
+                                break;
                 }
                 return res;
                 
@@ -512,6 +512,14 @@ static BYTE CurrVol; /* Current drive */
 
 #if _FS_LOCK != 0
 static FILESEM Files[_FS_LOCK]; /* Open object lock semaphores */
+#if _FS_REENTRANT
+static _SYNC_t FilesSync; /* Sync object of the lock table, which is shared by all volumes */
+#define	ENTER_LOCK()	ff_req_grant(FilesSync)
+#define	LEAVE_LOCK()	ff_rel_grant(FilesSync)
+#else
+#define	ENTER_LOCK()	1
+#define	LEAVE_LOCK()
+#endif
 #endif
 
 #if _USE_LFN == 0			/* Non-LFN configuration */
@@ -740,6 +748,9 @@ FRESULT chk_lock ( /* Check if the file can be accessed */
 )
 {
         UINT i, be;
+        FRESULT res;
+
+        if (!ENTER_LOCK()) return FR_TIMEOUT; /* Tasks on other volumes may be changing the table */
 
         /* Search file semaphore table */
         for (i = be = 0; i < _FS_LOCK; i++)
@@ -757,11 +768,14 @@ FRESULT chk_lock ( /* Check if the file can be accessed */
         }
         if (i == _FS_LOCK)
         { /* The object is not opened */
-                return (be || acc == 2) ? FR_OK : FR_TOO_MANY_OPEN_FILES; /* Is there a blank entry for new object? */
+                res = (be || acc == 2) ? FR_OK : FR_TOO_MANY_OPEN_FILES; /* Is there a blank entry for new object? */
         }
-
-        /* The object has been opened. Reject any open against writing file and all write mode open */
-        return (acc || Files[i].ctr == 0x100) ? FR_LOCKED : FR_OK;
+        else
+        { /* The object has been opened. Reject any open against writing file and all write mode open */
+                res = (acc || Files[i].ctr == 0x100) ? FR_LOCKED : FR_OK;
+        }
+        LEAVE_LOCK();
+        return res;
 }
 
 static
@@ -769,7 +783,9 @@ int enq_lock (void) /* Check if an entry is available for a new object */
 {
         UINT i;
 
+        if (!ENTER_LOCK()) return 0;
         for (i = 0; i < _FS_LOCK && Files[i].fs; i++);
+        LEAVE_LOCK();
         return (i == _FS_LOCK) ? 0 : 1;
 }
 
@@ -781,6 +797,7 @@ UINT inc_lock ( /* Increment object open counter and returns its index (0:Intern
 {
         UINT i;
 
+        if (!ENTER_LOCK()) return 0;
         for (i = 0; i < _FS_LOCK; i++)
         { /* Find the object */
                 if (Files[i].fs == dp->obj.fs &&
@@ -791,16 +808,25 @@ UINT inc_lock ( /* Increment object open counter and returns its index (0:Intern
         if (i == _FS_LOCK)
         { /* Not opened. Register it as new. */
                 for (i = 0; i < _FS_LOCK && Files[i].fs; i++);
-                if (i == _FS_LOCK) return 0; /* No free entry to register (int err) */
+                if (i == _FS_LOCK)
+                { /* No free entry to register (int err) */
+                        LEAVE_LOCK();
+                        return 0;
+                }
                 Files[i].fs = dp->obj.fs;
                 Files[i].clu = dp->obj.sclust;
                 Files[i].ofs = dp->dptr;
                 Files[i].ctr = 0;
         }
 
-        if (acc && Files[i].ctr) return 0; /* Access violation (int err) */
+        if (acc && Files[i].ctr)
+        { /* Access violation (int err) */
+                LEAVE_LOCK();
+                return 0;
+        }
 
         Files[i].ctr = acc ? 0x100 : Files[i].ctr + 1; /* Set semaphore value */
+        LEAVE_LOCK();
 
         return i + 1;
 }
@@ -815,11 +841,13 @@ FRESULT dec_lock ( /* Decrement object open counter */
 
         if (--i < _FS_LOCK)
         { /* Shift index number origin from 0 */
+                if (!ENTER_LOCK()) return FR_TIMEOUT;
                 n = Files[i].ctr;
                 if (n == 0x100) n = 0; /* If write mode open, delete the entry */
                 if (n > 0) n--; /* Decrement read mode open count */
                 Files[i].ctr = n;
                 if (n == 0) Files[i].fs = 0; /* Delete the entry if open count gets zero */
+                LEAVE_LOCK();
                 res = FR_OK;
         }
         else
@@ -835,11 +863,13 @@ void clear_lock ( /* Clear lock entries of the volume */
 )
 {
         UINT i;
+        int grant = ENTER_LOCK(); /* f_mount() is not re-entrant, clear the entries even if the wait timed out */
 
         for (i = 0; i < _FS_LOCK; i++)
         {
                 if (Files[i].fs == fs) Files[i].fs = 0;
         }
+        if (grant) LEAVE_LOCK();
 }
 
 #endif	/* _FS_LOCK != 0 */
@@ -930,7 +960,7 @@ FATFS* fs /* File system object */
                         st_dword(fs->win + FSI_Free_Count, fs->free_clst);
                         st_dword(fs->win + FSI_Nxt_Free, fs->last_clst);
                         /* Write it into the FSInfo sector */
-                        fs->winsect = fs->volbase + 1;
+                        fs->winsect = fs->volbase + fs->fsi_ofs;
                         disk_write(fs->drv, fs->win, fs->winsect, 1);
                         fs->fsi_flag = 0;
                 }
@@ -1275,6 +1305,10 @@ DWORD pclst /* Previous cluster of clst (0:an entire chain) */
                         fs->free_clst++;
                         fs->fsi_flag |= 1;
                 }
+                else if(clst < fs->scan_clst)
+                { /* Keep the part already counted by the free cluster scan in sync */
+                        fs->scan_free++;
+                }
 #if _FS_EXFAT || _USE_TRIM
                 if (ecl + 1 == nxt)
                 { /* Is next cluster contiguous? */
@@ -1409,8 +1443,10 @@ DWORD clst /* Cluster# to stretch, 0:Create a new chain */
         if(res == FR_OK)
         { /* Update FSINFO if function succeeded. */
                 fs->last_clst = ncl;
-                if(fs->free_clst < fs->n_fatent - 2)
+                if(fs->free_clst <= fs->n_fatent - 2)
                         fs->free_clst--;
+                else if(ncl < fs->scan_clst)
+                        fs->scan_free--; /* Keep the part already counted by the free cluster scan in sync */
                 fs->fsi_flag |= 1;
         }
         else
@@ -1858,7 +1894,7 @@ void gen_numname (
 }
 #endif	/* _USE_LFN != 0 && !_FS_READONLY */
 
-#if _USE_LFN != 0
+#if _USE_LFN != 0 || (_USE_CHECK && !_FS_READONLY)
 /*-----------------------------------------------------------------------*/
 /* FAT-LFN: Calculate checksum of an SFN entry                           */
 /*-----------------------------------------------------------------------*/
@@ -1875,7 +1911,7 @@ BYTE sum_sfn (
         return sum;
 }
 
-#endif	/* _USE_LFN != 0 */
+#endif	/* _USE_LFN != 0 || (_USE_CHECK && !_FS_READONLY) */
 
 #if _FS_EXFAT
 /*-----------------------------------------------------------------------*/
@@ -3253,6 +3289,7 @@ BYTE mode /* !=0: Check write protection for write access */
                 if (i == SS(fs)) return FR_NO_FILESYSTEM;
 #if !_FS_READONLY
                 fs->last_clst = fs->free_clst = 0xFFFFFFFF; /* Initialize cluster allocation information */
+                fs->scan_clst = 0;
 #endif
                 fmt = FS_EXFAT; /* FAT sub-type */
         }
@@ -3329,10 +3366,12 @@ BYTE mode /* !=0: Check write protection for write access */
 #if !_FS_READONLY
                 /* Get FSINFO if available */
                 fs->last_clst = fs->free_clst = 0xFFFFFFFF; /* Initialize cluster allocation information */
+                fs->scan_clst = 0;
                 fs->fsi_flag = 0x80;
 #if (_FS_NOFSINFO & 3) != 3
-                if(fmt == FS_FAT32 /* Enable FSINFO only if FAT32 and BPB_FSInfo32 == 1 */
-                && ld_word(fs->win + BPB_FSInfo32) == 1 && move_window(fs, bsect + 1) == FR_OK)
+                fs->fsi_ofs = ld_word(fs->win + BPB_FSInfo32);
+                if(fmt == FS_FAT32 /* Enable FSINFO only if FAT32 and BPB_FSInfo32 points into the reserved area */
+                && fs->fsi_ofs >= 1 && fs->fsi_ofs < nrsv && move_window(fs, bsect + fs->fsi_ofs) == FR_OK)
                 {
                         fs->fsi_flag = 0;
                         if(ld_word(fs->win + BS_55AA) == 0xAA55 /* Load FSINFO data if available */
@@ -3416,6 +3455,9 @@ BYTE opt /* Mode option 0:Do not mount (delayed mount), 1:Mount immediately */
         vol = get_ldnumber(&rp);
         if(vol < 0)
                 return FR_INVALID_DRIVE;
+#if _FS_LOCK != 0 && _FS_REENTRANT				/* Create sync object of the lock table at the first mount */
+        if (!FilesSync && !ff_cre_syncobj(_VOLUMES, &FilesSync)) return FR_INT_ERR;
+#endif
         cfs = FatFs[vol]; /* Pointer to fs object */
 
         if(cfs)
@@ -4650,6 +4692,117 @@ FILINFO* fno /* Pointer to file information to return */
 }
 
 #if !_FS_READONLY
+/*-----------------------------------------------------------------------*/
+/* Count free clusters, up to nent FAT entries per call                  */
+/*-----------------------------------------------------------------------*/
+
+static FRESULT scan_free( /* FR_OK(0):succeeded, !=0:error */
+FATFS* fs, /* File system object */
+DWORD nent /* Number of FAT entries to check at this call */
+)
+{
+        FRESULT res = FR_OK;
+        DWORD clst, stat;
+        UINT i, esz;
+        BYTE *p;
+        _FDID obj;
+
+        if(fs->scan_clst < 2)
+        { /* Start a new scan */
+                fs->scan_clst = 2;
+                fs->scan_free = 0;
+        }
+        clst = fs->scan_clst;
+
+        if(fs->fs_type == FS_FAT12)
+        { /* FAT12: Sector unalighed FAT entries */
+                obj.fs = fs;
+                for(; nent && clst < fs->n_fatent; nent--, clst++)
+                {
+                        stat = get_fat(&obj, clst);
+                        if(stat == 0xFFFFFFFF)
+                        {
+                                res = FR_DISK_ERR;
+                                break;
+                        }
+                        if(stat == 1)
+                        {
+                                res = FR_INT_ERR;
+                                break;
+                        }
+                        if(stat == 0)
+                                fs->scan_free++;
+                }
+        }
+        else
+        {
+#if _FS_EXFAT
+                if (fs->fs_type == FS_EXFAT)
+                { /* exFAT: Scan bitmap table at once */
+                        BYTE bm;
+                        UINT b;
+                        DWORD sect;
+
+                        clst = fs->n_fatent - 2;
+                        sect = fs->database;
+                        i = 0;
+                        do
+                        {
+                                if (i == 0 && (res = move_window(fs, sect++)) != FR_OK) break;
+                                for (b = 8, bm = fs->win[i]; b && clst; b--, clst--)
+                                {
+                                        if (!(bm & 1)) fs->scan_free++;
+                                        bm >>= 1;
+                                }
+                                i = (i + 1) % SS(fs);
+                        }while (clst);
+                        clst = (res == FR_OK) ? fs->n_fatent : 2;
+                }
+                else
+#endif
+                { /* FAT16/32: Sector alighed FAT entries, stream the FAT sector by sector */
+                        esz = (fs->fs_type == FS_FAT16) ? 2 : 4;
+                        i = 0;
+                        p = 0;
+                        for(; nent && clst < fs->n_fatent; nent--, clst++)
+                        {
+                                if(i == 0)
+                                {
+                                        res = move_window(fs, fs->fatbase + clst / (SS(fs) / esz));
+                                        if(res != FR_OK)
+                                                break;
+                                        i = clst * esz % SS(fs);
+                                        p = fs->win + i;
+                                        i = SS(fs) - i;
+                                }
+                                if(esz == 2)
+                                {
+                                        if(ld_word(p) == 0)
+                                                fs->scan_free++;
+                                }
+                                else
+                                {
+                                        if((ld_dword(p) & 0x0FFFFFFF) == 0)
+                                                fs->scan_free++;
+                                }
+                                p += esz;
+                                i -= esz;
+                        }
+                }
+        }
+
+        fs->scan_clst = clst;
+        if(res == FR_OK && clst >= fs->n_fatent)
+        { /* Scan completed, free_clst is valid from now on */
+                fs->free_clst = fs->scan_free;
+                fs->scan_clst = 0;
+                fs->fsi_flag |= 1; /* FSInfo is to be updated */
+                res = sync_fs(fs); /* Write it back at once so that next mount can trust it */
+        }
+
+        return res;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Get Number of Free Clusters                                           */
 /*-----------------------------------------------------------------------*/
@@ -4661,110 +4814,798 @@ FATFS** fatfs /* Pointer to return pointer to corresponding file system object *
 {
         FRESULT res;
         FATFS *fs;
-        DWORD nfree, clst, sect, stat;
-        UINT i;
-        BYTE *p;
-        _FDID obj;
 
         /* Get logical drive */
         res = find_volume(&path, &fs, 0);
         if(res == FR_OK)
         {
                 *fatfs = fs; /* Return ptr to the fs object */
-                /* If free_clst is valid, return it without full cluster scan */
-                if(fs->free_clst <= fs->n_fatent - 2)
+                /* If free_clst is not valid, finish the scan (resumes from where f_scanfree() left off) */
+                if(fs->free_clst > fs->n_fatent - 2)
+                {
+                        res = scan_free(fs, fs->n_fatent);
+                }
+                if(res == FR_OK)
                 {
-                        *nclst = fs->free_clst;
+                        *nclst = fs->free_clst; /* Return the free clusters */
+                }
+        }
+
+        LEAVE_FF(fs, res);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Advance Free Cluster Scan                                             */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_scanfree(const TCHAR* path, /* Path name of the logical drive number */
+UINT nent, /* Number of FAT entries to check at this call */
+DWORD* nclst /* Pointer to return number of free clusters (0xFFFFFFFF:scan in progress) */
+)
+{
+        FRESULT res;
+        FATFS *fs;
+
+        /* Get logical drive */
+        res = find_volume(&path, &fs, 0);
+        if(res == FR_OK)
+        {
+                if(fs->free_clst > fs->n_fatent - 2)
+                {
+                        res = scan_free(fs, nent);
+                }
+                *nclst = (fs->free_clst <= fs->n_fatent - 2) ? fs->free_clst : 0xFFFFFFFF;
+        }
+
+        LEAVE_FF(fs, res);
+}
+
+#if _USE_CHECK
+/*-----------------------------------------------------------------------*/
+/* Check Volume Consistency                                              */
+/*-----------------------------------------------------------------------*/
+
+#define CHK_MAXDEPTH	8	/* Maximum depth of the directory tree to be checked */
+
+/* Result of chk_chain() */
+#define CW_EOC		0	/* Reached end of the chain */
+#define CW_XLINK	1	/* Ran into a cluster owned by another object */
+#define CW_BROKEN	2	/* Invalid link or free cluster in the chain */
+#define CW_LONG		3	/* Chain is longer than the limit */
+#define CW_ERROR	4	/* Disk error while reading the FAT */
+
+typedef struct
+{
+        FATFS* fs; /* Pointer to the fs object */
+        BYTE* buf; /* One sector slice of the work buffer */
+        DWORD sect; /* FAT sector held in buf (0:none) */
+} CHKFAT;
+
+typedef struct
+{
+        DIR dj; /* Directory object being checked */
+        DWORD lfn_ofs; /* Offset of the first entry of the LFN sequence in progress */
+        DWORD lfn_end; /* Offset next to the last entry of the LFN sequence in progress */
+        BYTE ord; /* LFN order expected next (0:no LFN sequence in progress) */
+        BYTE sum; /* SFN checksum of the LFN sequence in progress */
+} CHKDIR;
+
+static const BYTE* chk_sect( /* Pointer to the FAT byte, 0:disk error */
+CHKFAT* cf, /* FAT sector cache */
+DWORD ofs /* Byte offset in the FAT */
+)
+{
+        FATFS *fs = cf->fs;
+        DWORD sect = fs->fatbase + ofs / SS(fs);
+
+        if(sect == fs->winsect)
+                return fs->win + ofs % SS(fs); /* The window may hold changes not written yet */
+        if(sect != cf->sect)
+        { /* Read the sector into the slice, the window stays on the directory */
+                if(disk_read(fs->drv, cf->buf, sect, 1) != RES_OK)
+                {
+                        cf->sect = 0;
+                        return 0;
+                }
+                cf->sect = sect;
+        }
+
+        return cf->buf + ofs % SS(fs);
+}
+
+static DWORD chk_get( /* 0xFFFFFFFF:Disk error, Others:Cluster status */
+CHKFAT* cf, /* FAT sector cache */
+DWORD clst /* Cluster number (2..n_fatent-1) */
+)
+{
+        const BYTE *p;
+        UINT wc, bc;
+
+        switch(cf->fs->fs_type)
+        {
+        case FS_FAT12: /* The entry may straddle the sector boundary, read it byte by byte */
+                bc = (UINT) clst + (UINT) clst / 2;
+                if((p = chk_sect(cf, bc)) == 0)
+                        break;
+                wc = *p;
+                if((p = chk_sect(cf, bc + 1)) == 0)
+                        break;
+                wc |= (UINT) *p << 8;
+                return (clst & 1) ? wc >> 4 : wc & 0xFFF;
+        case FS_FAT16:
+                if((p = chk_sect(cf, clst * 2)) == 0)
+                        break;
+                return ld_word(p);
+        default:
+                if((p = chk_sect(cf, clst * 4)) == 0)
+                        break;
+                return ld_dword(p) & 0x0FFFFFFF;
+        }
+
+        return 0xFFFFFFFF;
+}
+
+static FRESULT chk_put( /* FR_OK(0):succeeded, !=0:error */
+CHKFAT* cf, /* FAT sector cache */
+DWORD clst, /* Cluster number to be changed */
+DWORD val /* New value to be set to the entry */
+)
+{
+        cf->sect = 0; /* The change goes to the window, the slice is no longer valid */
+
+        return put_fat(cf->fs, clst, val);
+}
+
+static DWORD chk_chain( /* CW_xxx:Result */
+CHKFAT* cf, /* FAT sector cache */
+BYTE* own, /* Bitmap of the clusters owned by any object */
+DWORD clst, /* Top cluster of the chain */
+DWORD limit, /* Maximum number of clusters allowed in the chain */
+DWORD* ncl, /* Pointer to return number of good clusters in the chain */
+DWORD* lcl /* Pointer to return the last good cluster (0:none) */
+)
+{
+        FATFS *fs = cf->fs;
+        DWORD nxt, n = 0, last = 0, res;
+
+        for(;;)
+        {
+                if(clst < 2 || clst >= fs->n_fatent)
+                {
+                        res = CW_BROKEN; /* Invalid link */
+                        break;
+                }
+                if(own[clst / 8] & 1 << clst % 8)
+                {
+                        res = CW_XLINK; /* Cross-linked */
+                        break;
+                }
+                if(n >= limit)
+                {
+                        res = CW_LONG; /* Longer than the file size */
+                        break;
+                }
+                nxt = chk_get(cf, clst);
+                if(nxt == 0xFFFFFFFF)
+                {
+                        res = CW_ERROR;
+                        break;
+                }
+                if(nxt == 0)
+                {
+                        res = CW_BROKEN; /* Free cluster in the chain */
+                        break;
+                }
+                own[clst / 8] |= 1 << clst % 8; /* Take the cluster */
+                n++;
+                last = clst;
+                if(nxt >= fs->n_fatent)
+                {
+                        res = CW_EOC; /* End of chain */
+                        break;
+                }
+                clst = nxt;
+        }
+        *ncl = n;
+        *lcl = last;
+
+        return res;
+}
+
+static FRESULT chk_fix( /* FR_OK(0):succeeded, !=0:error */
+CHKFAT* cf, /* FAT sector cache */
+DIR* dp, /* Directory object pointing the entry to be fixed */
+DWORD res, /* Result of chk_chain() */
+DWORD lcl, /* Last good cluster of the chain (0:none) */
+DWORD szmax, /* Size of the good part of the chain [byte] */
+BYTE isdir /* The entry is a directory */
+)
+{
+        FATFS *fs = cf->fs;
+        FRESULT r = FR_OK;
+        BYTE *dir;
+
+        if(res != CW_EOC && lcl)
+        { /* Cut the chain after the last good cluster */
+                r = chk_put(cf, lcl, 0xFFFFFFFF);
+        }
+        if(r == FR_OK)
+        {
+                r = move_window(fs, dp->sect);
+        }
+        if(r == FR_OK)
+        {
+                dir = dp->dir;
+                if(!lcl)
+                { /* No good cluster */
+                        if(isdir)
+                        {
+                                dir[DIR_Name] = DDEM; /* A directory without cluster cannot be kept, remove it */
+                        }
+                        else
+                        {
+                                st_clust(fs, dir, 0); /* Make the file empty */
+                        }
+                }
+                if(!isdir && ld_dword(dir + DIR_FileSize) > szmax)
+                {
+                        st_dword(dir + DIR_FileSize, szmax); /* Fit the file size into the chain */
+                }
+                fs->wflag = 1;
+        }
+
+        return r;
+}
+
+static FRESULT chk_orphan( /* FR_OK(0):succeeded, !=0:error */
+CHKDIR* cd, /* Directory with an orphan LFN sequence */
+CHKINFO* ci, /* Pointer to the result */
+BYTE repair /* Remove the orphan entries */
+)
+{
+        FRESULT res = FR_OK;
+        DIR dj;
+
+        ci->n_orphan++;
+        if(repair)
+        {
+                dj = cd->dj;
+                res = dir_sdi(&dj, cd->lfn_ofs);
+                while(res == FR_OK && dj.dptr < cd->lfn_end)
+                {
+                        res = move_window(dj.obj.fs, dj.sect);
+                        if(res != FR_OK)
+                                break;
+                        dj.dir[DIR_Name] = DDEM;
+                        dj.obj.fs->wflag = 1;
+                        res = dir_next(&dj, 0);
+                }
+                if(res == FR_NO_FILE)
+                        res = FR_OK;
+                ci->n_fixed++;
+        }
+        cd->ord = 0;
+
+        return res;
+}
+
+FRESULT f_check(const TCHAR* path, /* Logical drive number */
+BYTE opt, /* Check option (FCK_REPAIR:repair the errors found) */
+void* work, /* Pointer to working buffer (must be word aligned, one sector plus the cluster bitmaps) */
+UINT len, /* Size of working buffer [byte] */
+CHKINFO* ci /* Pointer to return the result */
+)
+{
+        FRESULT res;
+        FATFS *fs;
+        CHKDIR *stk, *cd;
+        CHKFAT cf;
+        BYTE *own, *ref, *dir, c, a, isdir, repair, incomplete = 0, again;
+        DWORD clst, nxt, bad, ncl, lcl, bcs, szb, szf, limit, cw;
+        UINT lv;
+#if _FS_LOCK != 0
+        UINT i;
+#endif
+
+        repair = opt & FCK_REPAIR;
+        res = find_volume(&path, &fs, repair);
+        if(res != FR_OK)
+                LEAVE_FF(fs, res);
+#if _FS_EXFAT
+        if(fs->fs_type == FS_EXFAT)
+                LEAVE_FF(fs, FR_INVALID_PARAMETER); /* exFAT has no FAT chain to be checked */
+#endif
+#if _FS_LOCK != 0
+        for(i = 0; i < _FS_LOCK; i++)
+        { /* The volume must not be in use */
+                if(Files[i].fs == fs)
+                        LEAVE_FF(fs, FR_LOCKED);
+        }
+#endif
+
+        /* Work area: one sector of the FAT, directory stack, ownership bitmap and reference bitmap */
+        szb = (fs->n_fatent + 7) / 8;
+        if(len < SS(fs) + sizeof(CHKDIR) * CHK_MAXDEPTH + szb * 2)
+                LEAVE_FF(fs, FR_NOT_ENOUGH_CORE);
+        cf.fs = fs;
+        cf.buf = (BYTE*) work;
+        cf.sect = 0;
+        stk = (CHKDIR*) (cf.buf + SS(fs));
+        own = (BYTE*) (stk + CHK_MAXDEPTH);
+        ref = own + szb;
+        mem_set(own, 0, szb * 2);
+        mem_set(ci, 0, sizeof(CHKINFO));
+        bcs = (DWORD) fs->csize * SS(fs);
+        bad = (fs->fs_type == FS_FAT12) ? 0xFF7 : (fs->fs_type == FS_FAT16) ? 0xFFF7 : 0x0FFFFFF7;
+
+        /* Pass 1: stream the FAT sector by sector and mark the clusters referred from any other cluster */
+        for(clst = 2; clst < fs->n_fatent; clst++)
+        {
+                nxt = chk_get(&cf, clst);
+                if(nxt == 0xFFFFFFFF)
+                        LEAVE_FF(fs, FR_DISK_ERR);
+                if(nxt >= 2 && nxt < fs->n_fatent)
+                        ref[nxt / 8] |= 1 << nxt % 8;
+        }
+
+        /* Pass 2: walk the directory tree and take the clusters owned by each object,
+         the chains are followed in the FAT sector slice so that the window stays on the directory */
+        if(fs->fs_type == FS_FAT32)
+        { /* Root directory of FAT32 is a cluster chain */
+                cw = chk_chain(&cf, own, fs->dirbase, 0xFFFFFFFF, &ncl, &lcl);
+                if(cw == CW_ERROR)
+                        LEAVE_FF(fs, FR_DISK_ERR);
+                if(cw != CW_EOC)
+                {
+                        ci->n_broken++;
+                        if(!ncl)
+                                LEAVE_FF(fs, FR_NO_FILESYSTEM);
+                        if(repair)
+                        {
+                                res = chk_put(&cf, lcl, 0xFFFFFFFF);
+                                if(res != FR_OK)
+                                        LEAVE_FF(fs, res);
+                                ci->n_fixed++;
+                        }
+                        else
+                        {
+                                incomplete = 1;
+                        }
+                }
+        }
+        lv = 0;
+        cd = &stk[0];
+        cd->dj.obj.fs = fs;
+        cd->dj.obj.sclust = 0; /* Root directory */
+        cd->ord = 0;
+        res = dir_sdi(&cd->dj, 0);
+        while(res == FR_OK)
+        {
+                cd = &stk[lv];
+                if(cd->dj.sect)
+                {
+                        res = move_window(fs, cd->dj.sect);
+                        if(res != FR_OK)
+                                break;
+                        if(cd->dj.dir[DIR_Name] == 0)
+                                cd->dj.sect = 0; /* End of the directory */
+                }
+                if(!cd->dj.sect)
+                { /* The directory has been checked */
+                        if(cd->ord)
+                        { /* LFN sequence without its SFN entry */
+                                res = chk_orphan(cd, ci, repair);
+                                if(res != FR_OK)
+                                        break;
+                        }
+                        if(lv == 0)
+                                break;
+                        lv--; /* Back to the parent directory */
+                        continue;
+                }
+
+                dir = cd->dj.dir;
+                c = dir[DIR_Name];
+                a = dir[DIR_Attr] & AM_MASK;
+                again = 0;
+                isdir = 0;
+                ncl = 0;
+                if(c != DDEM && a == AM_LFN)
+                { /* An LFN entry */
+                        if(c & LLEF)
+                        { /* Top of an LFN sequence */
+                                if(cd->ord)
+                                { /* Previous sequence is not terminated by its SFN entry */
+                                        res = chk_orphan(cd, ci, repair);
+                                        again = 1; /* Check this entry again */
+                                }
+                                else
+                                {
+                                        cd->ord = c & ~LLEF;
+                                        cd->sum = dir[LDIR_Chksum];
+                                        cd->lfn_ofs = cd->dj.dptr;
+                                        cd->lfn_end = cd->dj.dptr + SZDIRE;
+                                        if(!cd->ord)
+                                                res = chk_orphan(cd, ci, repair); /* Invalid order */
+                                }
+                        }
+                        else if(cd->ord && c == cd->ord - 1 && c && dir[LDIR_Chksum] == cd->sum)
+                        { /* Next entry of the sequence */
+                                cd->ord = c;
+                                cd->lfn_end = cd->dj.dptr + SZDIRE;
+                        }
+                        else
+                        { /* Out of order LFN entry, remove it along with the sequence in progress */
+                                if(!cd->ord)
+                                        cd->lfn_ofs = cd->dj.dptr;
+                                cd->lfn_end = cd->dj.dptr + SZDIRE;
+                                res = chk_orphan(cd, ci, repair);
+                        }
+                }
+                else if(cd->ord && (c == DDEM || cd->ord != 1 || sum_sfn(dir) != cd->sum))
+                { /* LFN sequence not tied to this entry */
+                        res = chk_orphan(cd, ci, repair);
+                        again = 1;
                 }
                 else
                 {
-                        /* Get number of free clusters */
-                        nfree = 0;
-                        if(fs->fs_type == FS_FAT12)
-                        { /* FAT12: Sector unalighed FAT entries */
-                                clst = 2;
-                                obj.fs = fs;
-                                do
+                        cd->ord = 0;
+                        if(c != DDEM && c != '.' && !(a & AM_VOL))
+                        { /* A file or directory, check its cluster chain */
+                                isdir = a & AM_DIR;
+                                clst = ld_clust(fs, dir);
+                                szf = ld_dword(dir + DIR_FileSize);
+                                limit = isdir ? 0xFFFFFFFF : szf / bcs + (szf % bcs != 0);
+                                if(clst == 0)
+                                {
+                                        cw = isdir ? CW_BROKEN : CW_EOC;
+                                        lcl = 0;
+                                }
+                                else
                                 {
-                                        stat = get_fat(&obj, clst);
-                                        if(stat == 0xFFFFFFFF)
+                                        cw = chk_chain(&cf, own, clst, limit, &ncl, &lcl);
+                                }
+                                if(cw == CW_ERROR)
+                                {
+                                        res = FR_DISK_ERR;
+                                        break;
+                                }
+                                if(cw == CW_XLINK)
+                                        ci->n_xlink++;
+                                if(cw == CW_BROKEN)
+                                        ci->n_broken++;
+                                if(!isdir && (cw == CW_LONG || ncl < limit))
+                                        ci->n_size++;
+                                if(cw != CW_EOC || (!isdir && ncl < limit))
+                                {
+                                        if(repair)
                                         {
-                                                res = FR_DISK_ERR;
-                                                break;
+                                                res = chk_fix(&cf, &cd->dj, cw, lcl, ncl * bcs, isdir);
+                                                ci->n_fixed++;
                                         }
-                                        if(stat == 1)
+                                        else if(isdir)
                                         {
-                                                res = FR_INT_ERR;
-                                                break;
+                                                ncl = 0; /* Do not enter a damaged directory */
+                                                incomplete = 1;
                                         }
-                                        if(stat == 0)
-                                                nfree++;
-                                } while(++clst < fs->n_fatent);
+                                }
                         }
-                        else
+                }
+                if(res != FR_OK)
+                        break;
+                if(again)
+                        continue;
+
+                /* Move to the next entry of this directory */
+                res = dir_next(&cd->dj, 0);
+                if(res == FR_NO_FILE || res == FR_INT_ERR)
+                { /* End of the directory (or broken chain that has been reported) */
+                        if(res == FR_INT_ERR)
+                                incomplete = 1;
+                        cd->dj.sect = 0;
+                        res = FR_OK;
+                }
+                if(res == FR_OK && isdir && ncl)
+                { /* Enter the sub-directory */
+                        if(lv + 1 >= CHK_MAXDEPTH)
+                        {
+                                res = FR_NOT_ENOUGH_CORE;
+                                break;
+                        }
+                        cd = &stk[++lv];
+                        cd->dj.obj.fs = fs;
+                        cd->dj.obj.sclust = clst;
+                        cd->ord = 0;
+                        res = dir_sdi(&cd->dj, 0);
+                }
+        }
+
+        /* Pass 3: clusters in use but not owned by any object are lost */
+        for(clst = 2; res == FR_OK && clst < fs->n_fatent; clst++)
+        {
+                if(own[clst / 8] & 1 << clst % 8)
+                        continue;
+                nxt = chk_get(&cf, clst);
+                if(nxt == 0xFFFFFFFF)
+                {
+                        res = FR_DISK_ERR;
+                        break;
+                }
+                if(nxt == 0 || nxt == bad)
+                        continue; /* Free or bad cluster */
+                ci->n_lost++;
+                if(!(ref[clst / 8] & 1 << clst % 8))
+                        ci->n_lostchain++; /* Top of a lost chain */
+                if(repair && !incomplete)
+                { /* Free the lost cluster (only when all directories could be checked) */
+                        res = chk_put(&cf, clst, 0);
+                        ci->n_fixed++;
+                }
+        }
+
+        if(res == FR_OK && repair && ci->n_fixed)
+        {
+                fs->free_clst = 0xFFFFFFFF; /* Free cluster count is no longer valid */
+                fs->scan_clst = 0;
+                fs->fsi_flag |= 1;
+                res = sync_fs(fs);
+        }
+
+        LEAVE_FF(fs, res);
+}
+#endif /* _USE_CHECK */
+
+#if _USE_DEFRAG
+/*-----------------------------------------------------------------------*/
+/* Defragment File                                                       */
+/*-----------------------------------------------------------------------*/
+
+static DWORD find_block( /* 0:Not found, 0xFFFFFFFF:Disk error, >=2:Top of the free block */
+FATFS* fs, /* Pointer to the fs object */
+DWORD ncl /* Number of contiguous free clusters required */
+)
+{
+        DWORD clst, scl, n, v;
+        _FDID obj;
+
+        obj.fs = fs;
+        scl = 2;
+        n = 0;
+        for(clst = 2; clst < fs->n_fatent; clst++)
+        {
+                v = get_fat(&obj, clst);
+                if(v == 0xFFFFFFFF)
+                        return v;
+                if(v == 0)
+                { /* Free cluster */
+                        if(++n == ncl)
+                                return scl;
+                }
+                else
+                {
+                        scl = clst + 1;
+                        n = 0;
+                }
+        }
+
+        return 0;
+}
+
+static FRESULT move_clust( /* FR_OK(0):succeeded, !=0:error */
+FIL* fp, /* Pointer to the file object */
+DWORD pcl, /* Previous cluster in the chain (0:scl is the top of the chain) */
+DWORD scl, /* Cluster to be moved */
+DWORD dcl /* Free cluster to move it to */
+)
+{
+        FRESULT res;
+        FATFS *fs = fp->obj.fs;
+        DWORD nxt, ssect, dsect;
+        UINT i;
+
+        nxt = get_fat(&fp->obj, scl);
+        if(nxt == 0xFFFFFFFF)
+                return FR_DISK_ERR;
+        ssect = clust2sect(fs, scl);
+        dsect = clust2sect(fs, dcl);
+        if(nxt < 2 || !ssect || !dsect)
+                return FR_INT_ERR;
+
+        /* Copy the cluster data through the window, the data is moved before any link is changed */
+        res = sync_window(fs);
+        if(res != FR_OK)
+                return res;
+        fs->winsect = 0xFFFFFFFF; /* Window is used as a copy buffer */
+        for(i = 0; i < fs->csize; i++)
+        {
+                if(disk_read(fs->drv, fs->win, ssect + i, 1) != RES_OK || disk_write(fs->drv, fs->win, dsect + i, 1) != RES_OK)
+                        return FR_DISK_ERR;
+        }
+
+        /* Link the new cluster in place of the old one, then free the old one.
+         An interruption leaves only a lost cluster that f_check() can free */
+        res = put_fat(fs, dcl, (nxt >= fs->n_fatent) ? 0xFFFFFFFF : nxt);
+        if(res == FR_OK)
+        {
+                if(pcl)
+                {
+                        res = put_fat(fs, pcl, dcl);
+                }
+                else
+                { /* Top of the chain is in the directory entry */
+                        res = move_window(fs, fp->dir_sect);
+                        if(res == FR_OK)
                         {
+                                st_clust(fs, fp->dir_ptr, dcl);
+                                fs->wflag = 1;
+                                fp->obj.sclust = dcl;
+                        }
+                }
+        }
+        if(res == FR_OK)
+        {
+                res = put_fat(fs, scl, 0);
+        }
+        if(res == FR_OK)
+        {
+                if(fs->free_clst > fs->n_fatent - 2)
+                { /* Keep the part already counted by the free cluster scan in sync */
+                        if(dcl < fs->scan_clst)
+                                fs->scan_free--;
+                        if(scl < fs->scan_clst)
+                                fs->scan_free++;
+                }
+                /* Follow the file object */
+                if(fp->clust == scl)
+                        fp->clust = dcl;
+                if(fp->sect >= ssect && fp->sect < ssect + fs->csize)
+                        fp->sect += dsect - ssect;
+        }
+
+        return res;
+}
+
+FRESULT f_defrag(FIL* fp, /* Pointer to the file object (write access is needed only when ncl > 0) */
+UINT ncl, /* Maximum number of clusters to be moved at this call (0:only count the fragments) */
+DWORD* nfrag /* Pointer to return number of fragments of the file (1:contiguous, 0:no cluster) */
+)
+{
+        FRESULT res;
+        FATFS *fs;
+        DWORD clst, nxt, pcl, bcl, bprev, tcl, n, frag;
+
+        res = validate(&fp->obj, &fs); /* Check validity of the file object */
+        if(res != FR_OK || (res = (FRESULT) fp->err) != FR_OK)
+                LEAVE_FF(fs, res);
+        if(ncl && !(fp->flag & FA_WRITE))
+                LEAVE_FF(fs, FR_DENIED); /* Only counting the fragments works on a read-only file */
 #if _FS_EXFAT
-                                if (fs->fs_type == FS_EXFAT)
-                                { /* exFAT: Scan bitmap table */
-                                        BYTE bm;
-                                        UINT b;
+        if(fs->fs_type == FS_EXFAT)
+                LEAVE_FF(fs, FR_INVALID_PARAMETER);
+#endif
+#if _USE_FASTSEEK
+        if(fp->cltbl)
+                LEAVE_FF(fs, FR_INVALID_PARAMETER); /* Link map table would be out of date */
+#endif
+#if !_FS_TINY
+        if(fp->flag & FA_DIRTY)
+        { /* Write-back cached data before the cluster is copied */
+                if(disk_write(fs->drv, fp->buf, fp->sect, 1) != RES_OK)
+                        ABORT(fs, FR_DISK_ERR);
+                fp->flag &= (BYTE) ~FA_DIRTY;
+        }
+#endif
 
-                                        clst = fs->n_fatent - 2;
-                                        sect = fs->database;
-                                        i = 0;
-                                        do
-                                        {
-                                                if (i == 0 && (res = move_window(fs, sect++)) != FR_OK) break;
-                                                for (b = 8, bm = fs->win[i]; b && clst; b--, clst--)
-                                                {
-                                                        if (!(bm & 1)) nfree++;
-                                                        bm >>= 1;
-                                                }
-                                                i = (i + 1) % SS(fs);
-                                        }while (clst);
+        for(;;)
+        {
+                /* Follow the chain, count the fragments and find the first break */
+                n = frag = 0;
+                pcl = bcl = bprev = 0;
+                clst = fp->obj.sclust;
+                while(clst >= 2 && clst < fs->n_fatent)
+                {
+                        if(!n || clst != pcl + 1)
+                        {
+                                frag++;
+                                if(n && !bcl)
+                                {
+                                        bcl = clst;
+                                        bprev = pcl;
                                 }
-                                else
+                        }
+                        nxt = get_fat(&fp->obj, clst);
+                        if(nxt == 0xFFFFFFFF)
+                                ABORT(fs, FR_DISK_ERR);
+                        if(nxt < 2 || ++n >= fs->n_fatent)
+                                ABORT(fs, FR_INT_ERR);
+                        pcl = clst;
+                        clst = nxt;
+                }
+                if(frag <= 1 || !ncl)
+                        break; /* Contiguous or no more move is allowed at this call */
+
+                /* The cluster at the break goes next to the block ahead of it if it is free */
+                tcl = bprev + 1;
+                nxt = (tcl < fs->n_fatent) ? get_fat(&fp->obj, tcl) : 1;
+                if(nxt == 0xFFFFFFFF)
+                        ABORT(fs, FR_DISK_ERR);
+                if(nxt != 0)
+                { /* Not free, move the whole file to a free block that can hold it */
+                        tcl = find_block(fs, n);
+                        if(tcl == 0xFFFFFFFF)
+                                ABORT(fs, FR_DISK_ERR);
+                        if(tcl == 0)
+                        {
+                                res = FR_DENIED; /* No contiguous free block */
+                                break;
+                        }
+                        bcl = fp->obj.sclust;
+                        bprev = 0;
+                        fs->last_clst = tcl + n - 1; /* Keep new allocations out of the block */
+                }
+                res = move_clust(fp, bprev, bcl, tcl);
+                if(res != FR_OK)
+                        ABORT(fs, res);
+                ncl--;
+        }
+        *nfrag = frag;
+        if(res == FR_OK)
+        {
+                res = sync_fs(fs);
+        }
+
+        LEAVE_FF(fs, res);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Get Fragmentation of the Volume                                       */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_getfrag(const TCHAR* path, /* Path name of the logical drive number */
+DWORD* nclst, /* Pointer to return number of clusters in use */
+DWORD* nfrag /* Pointer to return number of contiguous fragments on the volume */
+)
+{
+        FRESULT res;
+        FATFS *fs;
+        DWORD clst, v, pv, nc, nf;
+        _FDID obj;
+
+        res = find_volume(&path, &fs, 0);
+        if(res == FR_OK)
+        {
+#if _FS_EXFAT
+                if(fs->fs_type == FS_EXFAT)
+                        LEAVE_FF(fs, FR_INVALID_PARAMETER);
 #endif
-                                { /* FAT16/32: Sector alighed FAT entries */
-                                        clst = fs->n_fatent;
-                                        sect = fs->fatbase;
-                                        i = 0;
-                                        p = 0;
-                                        do
-                                        {
-                                                if(i == 0)
-                                                {
-                                                        res = move_window(fs, sect++);
-                                                        if(res != FR_OK)
-                                                                break;
-                                                        p = fs->win;
-                                                        i = SS(fs);
-                                                }
-                                                if(fs->fs_type == FS_FAT16)
-                                                {
-                                                        if(ld_word(p) == 0)
-                                                                nfree++;
-                                                        p += 2;
-                                                        i -= 2;
-                                                }
-                                                else
-                                                {
-                                                        if((ld_dword(p) & 0x0FFFFFFF) == 0)
-                                                                nfree++;
-                                                        p += 4;
-                                                        i -= 4;
-                                                }
-                                        } while(--clst);
-                                }
+                obj.fs = fs;
+                nc = nf = pv = 0;
+                for(clst = 2; clst < fs->n_fatent; clst++)
+                {
+                        v = get_fat(&obj, clst);
+                        if(v == 0xFFFFFFFF)
+                        {
+                                res = FR_DISK_ERR;
+                                break;
+                        }
+                        if(v != 0)
+                        { /* A fragment starts at every cluster not linked from the cluster before it */
+                                nc++;
+                                if(pv != clst)
+                                        nf++;
                         }
-                        *nclst = nfree; /* Return the free clusters */
-                        fs->free_clst = nfree; /* Now free_clst is valid */
-                        fs->fsi_flag |= 1; /* FSInfo is to be updated */
+                        pv = v;
+                }
+                if(res == FR_OK)
+                {
+                        *nclst = nc;
+                        *nfrag = nf;
                 }
         }
 
         LEAVE_FF(fs, res);
 }
+#endif /* _USE_DEFRAG */
 
 /*-----------------------------------------------------------------------*/
 /* Truncate File                                                         */
@@ -5595,11 +6436,15 @@ FRESULT f_expand (
                         fp->obj.objsize = fsz;
                         if (_FS_EXFAT) fp->obj.stat = 2; /* Set status 'contiguous chain' */
                         fp->flag |= FA_MODIFIED;
-                        if (fs->free_clst < fs->n_fatent - 2)
+                        if (fs->free_clst <= fs->n_fatent - 2)
                         { /* Update FSINFO */
                                 fs->free_clst -= tcl;
                                 fs->fsi_flag |= 1;
                         }
+                        else
+                        { /* The block may straddle the scan position, restart the free cluster scan */
+                                fs->scan_clst = 0;
+                        }
                 }
         }
 
@@ -5694,8 +6539,8 @@ FRESULT f_mkfs (
                 UINT len /* Size of working buffer */
 )
 {
-        const UINT n_fats = 1; /* Number of FATs for FAT12/16/32 volume (1 or 2) */
-        const UINT n_rootdir = 512; /* Number of root directory entries for FAT12/16 volume */
+        UINT n_fats; /* Number of FATs for FAT12/16/32 volume (1 or 2) */
+        UINT n_rootdir; /* Number of root directory entries for FAT12/16 volume */
         static const WORD cst[] =
         {       1, 4, 16, 64, 256, 512, 0}; /* Cluster size boundary for FAT12/16 volume (4Ks unit) */
         static const WORD cst32[] =
@@ -5705,6 +6550,7 @@ FRESULT f_mkfs (
         DWORD szb_buf, sz_buf, sz_blk, n_clst, pau, sect, nsect, n;
         DWORD b_vol, b_fat, b_data; /* Base LBA for volume, fat, data */
         DWORD sz_vol, sz_rsv, sz_fat, sz_dir; /* Size for volume, fat, dir, data */
+        DWORD b_fsi; /* Offset of FSINFO sector from the VBR */
         UINT i;
         int vol;
         DSTATUS stat;
@@ -5732,6 +6578,7 @@ FRESULT f_mkfs (
 #endif
         if ((au != 0 && au < ss) || au > 0x1000000 || (au & (au - 1))) return FR_INVALID_PARAMETER; /* Check if au is valid */
         au /= ss; /* Cluster size in unit of sector */
+        n_fats = (opt & FM_2FAT) ? 2 : 1;
 
         /* Get working buffer */
         buf = (BYTE*)work; /* Working buffer */
@@ -5754,7 +6601,7 @@ FRESULT f_mkfs (
         {
                 /* Create a single-partition in this function */
                 if (disk_ioctl(pdrv, GET_SECTOR_COUNT, &sz_vol) != RES_OK) return FR_DISK_ERR;
-                b_vol = (opt & FM_SFD) ? 0 : 63; /* Volume start sector */
+                b_vol = (opt & FM_SFD) ? 0 : ((opt & FM_FLASH) ? sz_blk : 63); /* Volume start sector */
                 if (sz_vol < b_vol) return FR_MKFS_ABORTED;
                 sz_vol -= b_vol; /* Volume size */
         }
@@ -5966,6 +6813,8 @@ FRESULT f_mkfs (
                 do
                 {
                         pau = au;
+                        n_rootdir = 512;
+                        b_fsi = 1;
                         /* Pre-determine number of clusters and FAT sub-type */
                         if (fmt == FS_FAT32)
                         { /* FAT32 volume */
@@ -6001,6 +6850,23 @@ FRESULT f_mkfs (
                                 sz_rsv = 1; /* Number of reserved sectors */
                                 sz_dir = (DWORD)n_rootdir * SZDIRE / ss; /* Rootdir size [sector] */
                         }
+                        if (opt & FM_FLASH)
+                        { /* Give each of reserved area, FATs and root directory its own erase blocks */
+                                sz_rsv = ((b_vol + sz_rsv + sz_blk - 1) & ~(sz_blk - 1)) - b_vol; /* FAT base on erase block boundary */
+                                sz_fat = (sz_fat + sz_blk - 1) & ~(sz_blk - 1); /* Each FAT fills whole erase blocks */
+                                if (fmt == FS_FAT32)
+                                {
+                                        if (sz_rsv > sz_blk) b_fsi = sz_blk; /* Move FSINFO out of the erase block holding the VBR */
+                                }
+                                else
+                                {
+                                        n = (sz_dir + sz_blk - 1) & ~(sz_blk - 1); /* Spend the padding on more root entries */
+                                        if (n * ss / SZDIRE <= 0xFFF0)
+                                        {
+                                                sz_dir = n; n_rootdir = (UINT)(n * ss / SZDIRE);
+                                        }
+                                }
+                        }
                         b_fat = b_vol + sz_rsv; /* FAT base */
                         b_data = b_fat + sz_fat * n_fats + sz_dir; /* Data base */
 
@@ -6082,7 +6948,7 @@ FRESULT f_mkfs (
                         st_dword(buf + BS_VolID32, GET_FATTIME()); /* VSN */
                         st_dword(buf + BPB_FATSz32, sz_fat); /* FAT size [sector] */
                         st_dword(buf + BPB_RootClus32, 2); /* Root directory cluster # (2) */
-                        st_word(buf + BPB_FSInfo32, 1); /* Offset of FSINFO sector (VBR + 1) */
+                        st_word(buf + BPB_FSInfo32, (WORD)b_fsi); /* Offset of FSINFO sector (VBR + 1, or the next erase block at FM_FLASH) */
                         st_word(buf + BPB_BkBootSec32, 6); /* Offset of backup VBR (VBR + 6) */
                         buf[BS_DrvNum32] = 0x80; /* Drive number (for int13) */
                         buf[BS_BootSig32] = 0x29; /* Extended boot signature */
@@ -6110,7 +6976,7 @@ FRESULT f_mkfs (
                         st_dword(buf + FSI_Nxt_Free, 2); /* Last allocated cluster# */
                         st_word(buf + BS_55AA, 0xAA55);
                         disk_write(pdrv, buf, b_vol + 7, 1); /* Write backup FSINFO (VBR + 7) */
-                        disk_write(pdrv, buf, b_vol + 1, 1); /* Write original FSINFO (VBR + 1) */
+                        disk_write(pdrv, buf, b_vol + b_fsi, 1); /* Write original FSINFO */
                 }
 
                 /* Initialize FAT area */
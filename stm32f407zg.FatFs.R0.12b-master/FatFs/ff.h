@@ -107,6 +107,9 @@ typedef struct
 #if !_FS_READONLY                
         DWORD last_clst;        // Last allocated cluster */
         DWORD free_clst;        // Number of free clusters */
+        WORD fsi_ofs;           // Offset of FSINFO sector from the volume base */
+        DWORD scan_clst;        // Next cluster to be checked by the free cluster scan (0:idle) */
+        DWORD scan_free;        // Free clusters found below scan_clst */
 #endif                           
 #if _FS_RPATH != 0               
         DWORD cdir;             // Current directory start cluster (0:root) */
@@ -203,6 +206,19 @@ TCHAR fname[13]; /* File name */
 #endif
 } FILINFO;
 
+/* Volume check result structure (CHKINFO) */
+
+typedef struct
+{
+DWORD n_lost; /* Clusters in use but not owned by any file or directory */
+DWORD n_lostchain; /* Lost cluster chains */
+DWORD n_xlink; /* Objects running into a cluster owned by another object */
+DWORD n_broken; /* Objects with an invalid link in their chain */
+DWORD n_size; /* Files whose size does not match the chain length */
+DWORD n_orphan; /* Orphan LFN entry sequences */
+DWORD n_fixed; /* Repairs done (FCK_REPAIR) */
+} CHKINFO;
+
 /* File function return code (FRESULT) */
 
 typedef enum
@@ -254,6 +270,7 @@ FRESULT f_chdir(const TCHAR* path); /* Change current directory */
 FRESULT f_chdrive(const TCHAR* path); /* Change current drive */
 FRESULT f_getcwd(TCHAR* buff, UINT len); /* Get current directory */
 FRESULT f_getfree(const TCHAR* path, DWORD* nclst, FATFS** fatfs); /* Get number of free clusters on the drive */
+FRESULT f_scanfree(const TCHAR* path, UINT nent, DWORD* nclst); /* Advance the free cluster count scan by nent FAT entries */
 FRESULT f_getlabel(const TCHAR* path, TCHAR* label, DWORD* vsn); /* Get volume label */
 FRESULT f_setlabel(const TCHAR* label); /* Set volume label */
 FRESULT f_forward(FIL* fp, UINT (*func)(const BYTE*, UINT), UINT btf, UINT* bf); /* Forward data to the stream */
@@ -261,6 +278,9 @@ FRESULT f_expand(FIL* fp, FSIZE_t szf, BYTE opt); /* Allocate a contiguous block
 FRESULT f_mount(FATFS* fs, const TCHAR* path, BYTE opt); /* Mount/Unmount a logical drive */
 FRESULT f_mkfs(const TCHAR* path, BYTE opt, DWORD au, void* work, UINT len); /* Create a FAT volume */
 FRESULT f_fdisk(BYTE pdrv, const DWORD* szt, void* work); /* Divide a physical drive into some partitions */
+FRESULT f_check(const TCHAR* path, BYTE opt, void* work, UINT len, CHKINFO* ci); /* Check (and repair) consistency of a FAT volume */
+FRESULT f_defrag(FIL* fp, UINT ncl, DWORD* nfrag); /* Move some clusters of the file into a contiguous block */
+FRESULT f_getfrag(const TCHAR* path, DWORD* nclst, DWORD* nfrag); /* Get number of used clusters and fragments of the volume */
 int f_putc(TCHAR c, FIL* fp); /* Put a character to the file */
 int f_puts(const TCHAR* str, FIL* cp); /* Put a string to the file */
 int f_printf(FIL* fp, const TCHAR* str, ...); /* Put a formatted string to the file */
@@ -324,6 +344,11 @@ int ff_del_syncobj (_SYNC_t sobj); /* Delete a sync object */
 #define FM_EXFAT	0x04
 #define FM_ANY		0x07
 #define FM_SFD		0x08
+#define FM_FLASH	0x10	/* Erase block aligned layout for flash memory media */
+#define FM_2FAT		0x20	/* Create two FAT copies (default is single FAT) */
+
+/* Check options (2nd argument of f_check) */
+#define FCK_REPAIR	0x01	/* Repair the errors found */
 
 /* Filesystem type (FATFS.fs_type) */
 #define FS_FAT12	1
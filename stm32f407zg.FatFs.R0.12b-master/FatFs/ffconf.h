@@ -30,6 +30,9 @@
  /  f_findnext(). (0:Disable, 1:Enable 2:Enable with matching altname[] too) */
 
 /* 配置是否支持文件系统格式化操作，对应的格式化函数为f_mkfs() */ 
+/* 对SPI Flash格式化时建议使用 FM_FAT | FM_SFD | FM_FLASH，FAT区和数据区按64KB擦除块对齐；
+   au为0时簇大小按标准表选择(10MB的卷为一个4KB扇区)，日志负载每MB的擦除次数与簇大小基本无关(Tools/fsflash.c)，
+   主要用来存放大文件时可以指定au为65536，整块写入只需一次块擦除，但卷上最多只能放约160个文件 */
 /* (0:Disable or 1:Enable) */
 #define	_USE_MKFS		1
 
@@ -50,6 +53,16 @@
 #define	_USE_FORWARD	        0
 /* This option switches f_forward() function. (0:Disable or 1:Enable) */
 
+/* 配置是否支持文件系统一致性检查函数f_check()，掉电后上电时用于快速检查和修复卷 */
+#define	_USE_CHECK	        1
+/* This option switches f_check() function. (0:Disable or 1:Enable)
+ /  Also _FS_READONLY needs to be 0 to enable this option. */
+
+/* 配置是否支持碎片整理函数f_defrag()和f_getfrag()，空闲时分步把文件的簇搬到连续的空闲区域 */
+#define	_USE_DEFRAG	        1
+/* This option switches f_defrag() and f_getfrag() function. (0:Disable or 1:Enable)
+ /  Also _FS_READONLY needs to be 0 to enable this option. */
+
 /*---------------------------------------------------------------------------/
  / Locale and Namespace Configurations
  /---------------------------------------------------------------------------*/
@@ -156,6 +169,7 @@
  /  To enable Trim function, also CTRL_TRIM command should be implemented to the
  /  disk_ioctl() function. */
 
+/* FSINFO中的空闲簇数在f_getfree()统计后立即回写，FAT12/16没有FSINFO，可在空闲时调用f_scanfree()分步统计 */
 #define _FS_NOFSINFO	        0
 /* If you need to know correct free space on the FAT32 volume, set bit 0 of this
  /  option, and f_getfree() function at first time after volume mount will force
@@ -195,7 +209,8 @@
  /  _NORTC_MDAY and _NORTC_YEAR have no effect.
  /  These options have no effect at read-only configuration (_FS_READONLY = 1). */
 
-#define	_FS_LOCK                0
+/* 开启文件锁，最多同时打开4个文件/目录，供日志任务和串口文件服务任务同时使用 */
+#define	_FS_LOCK                4
 /* The option _FS_LOCK switches file lock function to control duplicated file open
  /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
  /  is 1.
@@ -206,9 +221,10 @@
  /      can be opened simultaneously under file lock control. Note that the file
  /      lock control is independent of re-entrancy. */
 
-#define _FS_REENTRANT           0
+/* 开启可重入，同步对象由syscall.c实现，每个卷一把锁，_FS_TIMEOUT为等锁时最大让出CPU次数 */
+#define _FS_REENTRANT           1
 #define _FS_TIMEOUT		1000
-#define	_SYNC_t			HANDLE
+#define	_SYNC_t			FF_MUTEX*
 /* The option _FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
  /  module itself. Note that regardless of this option, file access to different
  /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -226,6 +242,6 @@
  /  SemaphoreHandle_t and etc.. A header file for O/S definitions needs to be
  /  included somewhere in the scope of ff.h. */
 
-/* #include <windows.h>	// O/S definitions  */
+#include "syscall.h"	// O/S definitions
 
 /*--- End of configuration options ---*/
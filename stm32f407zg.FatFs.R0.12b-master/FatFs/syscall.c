@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------*/
+/* Sample code of OS dependent controls for FatFs                         */
+/* (C)ChaN, 2014                                                          */
+/*   Ported to a cooperative (run-to-completion) scheduler                */
+/*------------------------------------------------------------------------*/
+
+#include "ff.h"
+#include "stm32f4xx.h"
+
+#if _FS_REENTRANT
+
+/* 每个卷一个互斥锁对象，最后一个保护所有卷共用的文件锁表，静态分配，不需要堆 */
+static FF_MUTEX Mutex[_VOLUMES + 1];
+
+/**
+ * @Description 尝试获取锁，使用LDREX/STREX保证即使在中断中调用也不会出现竞态
+ * @param sobj  锁对象
+ * @return int  1:获取成功 0:锁已被占用
+ */
+static int ff_try_lock(FF_MUTEX *sobj)
+{
+        do
+        {
+                if(__LDREXB(&sobj->lock) != 0)
+                {
+                        /* 锁已被占用，清除独占标记后返回 */
+                        __CLREX();
+                        return 0;
+                }
+        } while(__STREXB(1, &sobj->lock) != 0);
+
+        /* 确保临界区内的访存不会被提前到拿锁之前 */
+        __DMB();
+
+        return 1;
+}
+
+/**
+ * @Description 原子地修改等锁的任务数，等锁的任务可能在不同的优先级或核上
+ */
+static void ff_add_waiter(FF_MUTEX *sobj, int n)
+{
+        BYTE v;
+
+        do
+        {
+                v = __LDREXB(&sobj->waiters);
+        } while(__STREXB(v + n, &sobj->waiters) != 0);
+}
+
+/**
+ * @Description 等锁时让出CPU，能切换任务的调度器应重新实现该函数，切到其他任务后返回1
+ * @return int  1:已经让其他任务运行过，可以重试 0:无法让出CPU，放弃等待
+ * @notice      默认实现返回0。主循环和run-to-completion的协作式调度器(如explore_sched)中，
+ *              任务在FatFs函数返回之前不会切换，持锁期间不会有其他任务调用FatFs，竞争只可能来自中断；
+ *              这时持锁的代码要等中断返回才能继续，原地重试不会等到锁释放，所以直接返回FR_TIMEOUT
+ */
+__weak int ff_yield(void)
+{
+        return 0;
+}
+
+/**
+ * @Description 创建同步对象，由f_mount()在挂载卷时调用
+ * @param vol   逻辑卷号 0~_VOLUMES-1，为_VOLUMES时创建文件锁表(_FS_LOCK)的同步对象
+ * @param sobj  返回创建好的同步对象
+ * @return int  1:成功 0:失败
+ */
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj)
+{
+        if(vol > _VOLUMES)
+        {
+                return 0;
+        }
+
+        Mutex[vol].lock = 0;
+        Mutex[vol].vol = vol;
+        Mutex[vol].wait = 0;
+        Mutex[vol].waiters = 0;
+        *sobj = &Mutex[vol];
+
+        return 1;
+}
+
+/**
+ * @Description 删除同步对象，由f_mount()在卸载卷时调用
+ * @param sobj  要删除的同步对象
+ * @return int  1:成功 0:失败
+ */
+int ff_del_syncobj(_SYNC_t sobj)
+{
+        sobj->lock = 0;
+        return 1;
+}
+
+/**
+ * @Description 请求访问卷的权限，在每个API函数入口处调用
+ * @param sobj  卷对应的同步对象
+ * @return int  1:获得权限 0:等待超时
+ * @notice      无竞争时只需一次LDREX/STREX；有竞争时每次重试前调用ff_yield()，_FS_TIMEOUT为最大让出次数。
+ *              在中断中或ff_yield()无法让出CPU时，持锁的代码不可能在等待期间释放锁，立即返回0
+ */
+int ff_req_grant(_SYNC_t sobj)
+{
+        UINT retry;
+
+        /* 快速路径：锁空闲，直接拿到 */
+        if(ff_try_lock(sobj))
+        {
+                return 1;
+        }
+
+        /* 慢速路径：持锁任务还在进行磁盘IO，让出CPU等它释放 */
+        sobj->wait++;
+        if(__get_IPSR() != 0)
+        {
+                return 0;
+        }
+        ff_add_waiter(sobj, 1);
+        for(retry = 0; retry < _FS_TIMEOUT; retry++)
+        {
+                if(!ff_yield())
+                {
+                        break;
+                }
+                if(ff_try_lock(sobj))
+                {
+                        ff_add_waiter(sobj, -1);
+                        return 1;
+                }
+        }
+        ff_add_waiter(sobj, -1);
+
+        return 0;
+}
+
+/**
+ * @Description 释放访问卷的权限，在每个API函数出口处调用
+ * @param sobj  卷对应的同步对象
+ * @notice      有任务在等锁时让出一次CPU，否则释放后紧接着又调用FatFs的任务会一直抢在等锁的任务前面
+ */
+void ff_rel_grant(_SYNC_t sobj)
+{
+        /* 保证临界区内的访存在释放锁之前完成 */
+        __DMB();
+        sobj->lock = 0;
+
+        if(sobj->waiters != 0 && __get_IPSR() == 0)
+        {
+                ff_yield();
+        }
+}
+
+#endif /* _FS_REENTRANT */
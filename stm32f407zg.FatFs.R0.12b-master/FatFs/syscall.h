@@ -0,0 +1,22 @@
+/*------------------------------------------------------------------------*/
+/* Sync object definitions for FatFs on a cooperative scheduler           */
+/*------------------------------------------------------------------------*/
+
+#ifndef _FF_SYSCALL
+#define _FF_SYSCALL
+
+#include "integer.h"
+
+/* 每个逻辑卷一把锁，锁之间互不影响，不同卷上的操作不会相互串行化 */
+typedef struct
+{
+        volatile BYTE lock;     // 0:空闲 1:已被占用
+        BYTE vol;               // 锁所属的逻辑卷号
+        volatile BYTE waiters;  // 正在等锁的任务数，释放锁时据此让出CPU
+        WORD wait;              // 发生竞争(需要让出CPU)的累计次数，用于评估锁开销
+} FF_MUTEX;
+
+/* 等待锁期间让出CPU的钩子，返回0表示无法让出，默认实现返回0，由能切换任务的调度器重新实现 */
+int ff_yield(void);
+
+#endif /* _FF_SYSCALL */
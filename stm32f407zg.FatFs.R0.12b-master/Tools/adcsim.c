@@ -0,0 +1,196 @@
+/**
+ * adcsim.c 上位机ADC测试，在ADC、定时器和DMA模型上运行stm32f4.library.adc-master的Driver/driver_adc.c，
+ * 检查TIM2触发的三重同时扫描经DMA写入乒乓采样块的数据、块中断的时机和ADC溢出后的恢复，测量能达到的采样率
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -I host
+ *           -I ../../stm32f4.library.adc-master/User -I ../../stm32f4.library.adc-master/Libraries/inc
+ *           -I ../../stm32f4.library.adc-master/System -I ../../stm32f4.library.adc-master/Driver -o adcsim adcsim.c
+ *           ../../stm32f4.library.adc-master/Driver/driver_adc.c host/host.c host/periph.c host/adc.c
+ * 用法：adcsim
+ *
+ * 模拟输入把规则组的序号和数据在帧内的位置编码在结果中：(序号 & 0x1FF) << 3 | (序号内的位置 * 3 + ADC编号 - 1)，
+ * 块中断中检查每一帧的6个数据在正确的位置、帧的序号连续，块的最后一帧是刚刚转换完的一帧；
+ * 同时检查每个ADC在每个序号上转换的通道与驱动头文件中的帧格式一致。
+ * 采样率：按驱动允许的采样率运行，再绕过ADC_SAMPLE_RATE_MAX直接设置TIM2，比较触发频率与实际转换的帧数。
+ * 溢出：运行中关闭DMA数据流，ADC溢出中断重新开始DMA传输后，采样块仍然按帧对齐。
+ */
+
+#include <stdio.h>
+#include "driver_adc.h"
+#include "adc.h"
+
+#define CYCLES_PER_US           (HOST_CLOCK_HZ / 1000000)
+#define RUN_CYCLES              (HOST_CLOCK_HZ / 2)     // 每种采样率运行0.5秒
+#define FRAME_MASK              0x1FF
+
+static int failures;
+static u32 channel_errors;                              // 转换的通道与帧格式不一致
+static u32 block_errors;                                // 数据位置错误或帧不连续
+static u32 late_blocks;                                 // 块中断时最后一帧不是刚刚转换完的一帧
+static u32 blocks, block_frames;
+static u32 last_sequence;                               // 最近转换完最后一个序号的规则组
+static s32 next_frame = -1;                             // 下一块第一帧的序号，-1表示不检查(刚开始或溢出之后)
+static const u16 *block_seen[2];
+
+/* 各ADC在第一、二个序号上应该转换的通道，与driver_adc.h中的帧格式一致 */
+static const u8 expect_channel[3][2] =
+{
+        {ADC_Channel_16, ADC_Channel_17},
+        {ADC_Channel_6, ADC_Channel_6},
+        {ADC_Channel_5, ADC_Channel_5}
+};
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static u16 input(u8 adc, u8 rank, u8 channel, u32 sequence)
+{
+        if(rank > 2 || channel != expect_channel[adc - 1][rank - 1])
+        {
+                channel_errors++;
+        }
+        if(rank == 2 && adc == 3)
+        {
+                last_sequence = sequence;
+        }
+        return (u16)(((sequence & FRAME_MASK) << 3) | ((rank - 1) * 3 + adc - 1));
+}
+
+/**
+ * @Description 块中断中调用，检查块中每一帧的数据
+ */
+static void block_handler(const u16 *block, u16 frames)
+{
+        u32 first = block[0] >> 3;
+        u16 f, i;
+
+        blocks++;
+        block_frames += frames;
+        block_seen[blocks & 1] = block;
+        if(next_frame >= 0 && first != (u32)next_frame)
+        {
+                block_errors++;
+        }
+        for(f = 0; f < frames; f++)
+        {
+                for(i = 0; i < ADC_FRAME_SIZE; i++)
+                {
+                        if(block[f * ADC_FRAME_SIZE + i] != (((first + f) & FRAME_MASK) << 3 | i))
+                        {
+                                if(block_errors++ < 3)
+                                {
+                                        printf("  block %u frame %u[%u] = %03x\n", blocks, f, i, block[f * ADC_FRAME_SIZE + i]);
+                                }
+                        }
+                }
+        }
+        if(((first + frames - 1) & FRAME_MASK) != (last_sequence & FRAME_MASK))
+        {
+                late_blocks++;
+        }
+        next_frame = (first + frames) & FRAME_MASK;
+}
+
+/**
+ * @Description 运行RUN_CYCLES，输出实际转换的帧率
+ * @return u32  每秒转换的帧数
+ */
+static u32 run_rate(const char *name, u32 trigger_rate)
+{
+        HOST_AdcStatTypeDef stat;
+        u32 blocks_before = blocks, rate;
+
+        Host_AdcStat(NULL, 1);
+        Host_Run(RUN_CYCLES);
+        Host_AdcStat(&stat, 0);
+        rate = (u32)((uint64_t)stat.sequences * HOST_CLOCK_HZ / RUN_CYCLES);
+        printf("  %-22s trigger %6u/s: %6u frames/s = %6u samples/s, %4u block irq/s, %u triggers ignored\n", name,
+               trigger_rate, rate, rate * ADC_FRAME_SIZE, (u32)((uint64_t)(blocks - blocks_before) * HOST_CLOCK_HZ / RUN_CYCLES),
+               stat.busy_ignored);
+        return rate;
+}
+
+int main(int argc, char *argv[])
+{
+        static const u32 rates[] = {ADC_SAMPLE_RATE, 5000, 10000, ADC_SAMPLE_RATE_MAX};
+        static const u32 fast[] = {21000, 25000, 40000};
+        HOST_AdcStatTypeDef stat;
+        u32 rank_cycles, max_rate, rate, i, frame, sum;
+        const u16 *last;
+
+        NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+        Host_AdcAttach(DMA2_Stream0, input);
+        Adc_SetBlockHandler(block_handler);
+        Adc_Init();
+
+        rank_cycles = Host_AdcRankCycles();
+        max_rate = HOST_CLOCK_HZ / (2 * rank_cycles);
+        printf("adcsim: %u frames x %u samples per block, %.2f us per frame, conversion limit %u frames/s\n",
+               ADC_BLOCK_FRAMES, ADC_FRAME_SIZE, 2.0 * rank_cycles / CYCLES_PER_US, max_rate);
+
+        /* 驱动允许的采样率，每个触发都转换一帧 */
+        for(i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+        {
+                Adc_SetSampleRate(rates[i]);
+                rate = run_rate("Adc_SetSampleRate()", rates[i]);
+                CHECK(rate >= rates[i] - 2 && rate <= rates[i] + 2, "%u frames/s at %u/s", rate, rates[i]);
+        }
+        Adc_SetSampleRate(ADC_SAMPLE_RATE_MAX * 2);
+        CHECK(TIM2->ARR == 84000000 / ADC_SAMPLE_RATE_MAX - 1, "Adc_SetSampleRate() does not clamp to ADC_SAMPLE_RATE_MAX");
+
+        /* 触发比转换快时，转换中到达的触发被忽略 */
+        for(i = 0; i < sizeof(fast) / sizeof(fast[0]); i++)
+        {
+                TIM_SetAutoreload(TIM2, 84000000 / fast[i] - 1);
+                TIM_SetCounter(TIM2, 0);
+                rate = run_rate("TIM2 only", fast[i]);
+                CHECK(rate <= max_rate, "%u frames/s above the conversion limit", rate);
+        }
+        Adc_SetSampleRate(ADC_SAMPLE_RATE_MAX);
+        Host_Run(RUN_CYCLES / 10);
+
+        Host_AdcStat(&stat, 0);
+        printf("  %u blocks, %u channel errors, %u data errors, %u late blocks, %u overruns\n", blocks, channel_errors,
+               block_errors, late_blocks, adc_overruns);
+        CHECK(channel_errors == 0, "%u conversions on the wrong channel", channel_errors);
+        CHECK(block_errors == 0 && late_blocks == 0, "%u data errors, %u late blocks", block_errors, late_blocks);
+        CHECK(adc_blocks == blocks && block_frames == blocks * ADC_BLOCK_FRAMES, "%u blocks, adc_blocks %u", blocks,
+              adc_blocks);
+        CHECK(block_seen[0] != block_seen[1], "the two blocks are not used in turn");
+        CHECK(adc_overruns == 0 && stat.overruns == 0, "%u overruns", adc_overruns);
+
+        /* 读取函数返回最近写满的块中的数据，不再等待转换 */
+        last = block_seen[blocks & 1];
+        frame = last[(ADC_BLOCK_FRAMES - 1) * ADC_FRAME_SIZE] >> 3;
+        CHECK(Adc_GetValue(ADC_Channel_16) == (frame << 3 | ADC_INDEX_TEMP), "Adc_GetValue(temp) %03x", Adc_GetValue(ADC_Channel_16));
+        CHECK(Adc_GetValue(ADC_Channel_5) == (frame << 3 | ADC_INDEX_PF7), "Adc_GetValue(PF7) %03x", Adc_GetValue(ADC_Channel_5));
+        CHECK(Adc_GetValue(ADC_Channel_0) == 0, "Adc_GetValue() of a channel that is not scanned");
+        CHECK(Adc_GetAverageValue(ADC_Channel_17, 1) == (frame << 3 | ADC_INDEX_VREF), "Adc_GetAverageValue(Vref, 1) %03x",
+              Adc_GetAverageValue(ADC_Channel_17, 1));
+        for(i = 0, sum = 0; i < 21; i++)
+        {
+                sum += last[(ADC_BLOCK_FRAMES - 1 - i) * ADC_FRAME_SIZE + ADC_INDEX_TEMP];
+        }
+        CHECK(Adc_GetAverageValue(ADC_Channel_16, 21) == sum / 21, "Adc_GetAverageValue(temp, 21) %03x, expected %03x",
+              Adc_GetAverageValue(ADC_Channel_16, 21), sum / 21);
+        CHECK(Adc_GetAverageValue(ADC_Channel_6, 1) == (frame << 3) + (ADC_INDEX_PA6 * 2 + 3) / 2,
+              "Adc_GetAverageValue(PA6, 1) %03x", Adc_GetAverageValue(ADC_Channel_6, 1));
+
+        /* DMA停止一段时间，ADC溢出，中断中重新开始DMA传输 */
+        DMA_Cmd(DMA2_Stream0, DISABLE);
+        Host_Run(4 * rank_cycles);
+        Host_AdcStat(&stat, 0);
+        CHECK(adc_overruns == 1 && stat.overruns == 1, "%u overruns after stopping the DMA", adc_overruns);
+        CHECK(DMA_GetCmdStatus(DMA2_Stream0) == ENABLE, "DMA not restarted after the overrun");
+        next_frame = -1;
+        i = blocks;
+        Host_Run(RUN_CYCLES / 10);
+        printf("  DMA stopped: %u overrun, %u blocks after the restart, %u data errors\n", adc_overruns, blocks - i,
+               block_errors);
+        CHECK(blocks - i >= (u32)(ADC_SAMPLE_RATE_MAX / 20 / ADC_BLOCK_FRAMES - 1), "%u blocks after the overrun", blocks - i);
+        CHECK(block_errors == 0 && late_blocks == 0, "%u data errors, %u late blocks after the overrun", block_errors,
+              late_blocks);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+/**
+ * filtersim.c 上位机滤波器测试，用64位直接卷积的参考实现逐位检查stm32f4.library.adc-master的System/explore_filter.c，
+ * 测量各抽取比的噪声和中值滤波去除尖峰的效果
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -I host -I ../../stm32f4.library.adc-master/System -o filtersim filtersim.c -lm
+ * 用法：filtersim
+ *
+ * 测试程序直接包含explore_filter.c，分别用SIMD(host/stm32f4xx.h按指令语义模拟__UADD16和__SMLAD)
+ * 和普通C代码的第一级运行Filter_Run()，两者都必须与参考实现逐位相同。
+ * 参考实现不用积分器：先做3点中值(前两帧从0开始)，再把FILTER_PRESUM * decim^order点的CIC冲激响应与输入直接卷积，
+ * 用64位整数计算，不会溢出，按相同的舍入右移并限幅到16位。
+ * 输入为带噪声和随机满量程尖峰的6通道帧(与driver_adc.h的帧格式相同)，采样块的帧数随机，检查跨块的状态。
+ * 耗时是主机上的时间，只用来比较两种第一级；芯片上每个采样的周期数用FILTER_BENCH的Filter_Benchmark()测量。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "explore_filter.c"
+
+#define WORDS                   3                       // 每帧的字数，与driver_adc.h的ADC_FRAME_SIZE / 2相同
+#define LANES                   (2 * WORDS)
+#define FRAMES                  6400                    // 每种配置输入的帧数
+#define BLOCK_MAX               64                      // 随机采样块的最大帧数
+#define OUTPUT_MAX              (FRAMES / FILTER_RATIO_MIN)
+#define TAPS_MAX                (FILTER_ORDER_MAX * (FILTER_RATIO_MAX / FILTER_PRESUM - 1) + 1)
+#define SETTLE                  4                       // 计算噪声时跳过的输出，等CIC的冲激响应填满
+
+static int failures;
+static u16 input[FRAMES * LANES] __attribute__((aligned(4)));
+static u16 output[OUTPUT_MAX][LANES];
+static u32 outputs;
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void record(const u16 *value, u8 lanes)
+{
+        if(outputs < OUTPUT_MAX)
+        {
+                memcpy(output[outputs], value, lanes * sizeof(u16));
+        }
+        outputs++;
+}
+
+static u16 median3(u16 a, u16 b, u16 c)
+{
+        u16 t;
+
+        if(a > b)
+        {
+                t = a; a = b; b = t;
+        }
+        if(b > c)
+        {
+                t = b; b = c; c = t;
+        }
+        return (a > b) ? a : b;
+}
+
+/**
+ * @Description 每个通道为center附近的均匀噪声，spikes分之一的采样换成0或4095
+ */
+static void make_input(u16 center, u16 noise, u32 spikes)
+{
+        u32 i;
+        s32 v;
+
+        for(i = 0; i < FRAMES * LANES; i++)
+        {
+                v = center + (s32)(i % LANES) * 300 + rand() % (2 * noise + 1) - noise;
+                if(spikes != 0 && rand() % spikes == 0)
+                {
+                        v = (rand() & 1) ? 4095 : 0;
+                }
+                input[i] = (u16)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+        }
+}
+
+/**
+ * @Description 把全部输入按随机帧数(FILTER_PRESUM的倍数)的采样块送给滤波器
+ * @return u32  滤波器的输出个数
+ */
+static u32 run(FILTER_TypeDef *filter, FILTER_PresumFunc presum)
+{
+        u32 f = 0, n;
+
+        outputs = 0;
+        while(f < FRAMES)
+        {
+                n = FILTER_PRESUM * (1 + rand() % (BLOCK_MAX / FILTER_PRESUM));
+                if(n > FRAMES - f)
+                {
+                        n = FRAMES - f;
+                }
+                Filter_Run(filter, input + f * LANES, (u16)n, presum);
+                f += n;
+        }
+        return outputs;
+}
+
+/**
+ * @Description 参考实现，结果放在expect中
+ * @return u32  输出个数
+ */
+static u32 reference(u16 ratio, u8 order, u8 median, u16 expect[][LANES])
+{
+        static u16 x[FRAMES * LANES];
+        static int64_t h[TAPS_MAX], t[TAPS_MAX];
+        u32 decim = ratio / FILTER_PRESUM, taps = order * (decim - 1) + 1, bits, shift, n = 0;
+        u32 i, k, o, l, last, m;
+        int64_t acc, presum, r;
+
+        for(i = 0; i < FRAMES; i++)
+        {
+                for(l = 0; l < LANES; l++)
+                {
+                        x[i * LANES + l] = median ? median3(i >= 2 ? input[(i - 2) * LANES + l] : 0,
+                                                            i >= 1 ? input[(i - 1) * LANES + l] : 0, input[i * LANES + l])
+                                                  : input[i * LANES + l];
+                }
+        }
+
+        /* 第二级的冲激响应：decim点矩形窗自身卷积order次 */
+        memset(h, 0, sizeof(h));
+        h[0] = 1;
+        for(o = 0; o < order; o++)
+        {
+                memset(t, 0, sizeof(t));
+                for(i = 0; i < taps; i++)
+                {
+                        for(k = 0; k < decim && i + k < taps; k++)
+                        {
+                                t[i + k] += h[i];
+                        }
+                }
+                memcpy(h, t, sizeof(t));
+        }
+        for(bits = 0; (1u << bits) < decim; bits++);
+        shift = order * bits - 1;
+
+        /* 第j个输出在第一级的第(j + 1) * decim - 1个和之后 */
+        for(last = decim - 1; (last + 1) * FILTER_PRESUM <= FRAMES; last += decim, n++)
+        {
+                for(l = 0; l < LANES; l++)
+                {
+                        acc = 0;
+                        for(i = 0; i < taps && i <= last; i++)
+                        {
+                                m = last - i;
+                                for(k = 0, presum = 0; k < FILTER_PRESUM; k++)
+                                {
+                                        presum += x[(m * FILTER_PRESUM + k) * LANES + l];
+                                }
+                                acc += h[i] * presum;
+                        }
+                        r = shift > 0 ? (acc + ((int64_t)1 << (shift - 1))) >> shift : acc;
+                        expect[n][l] = (u16)(r > 0xFFFF ? 0xFFFF : r);
+                }
+        }
+        return n;
+}
+
+/**
+ * @Description 比较滤波器的输出与参考实现
+ * @return u32  不同的输出个数
+ */
+static u32 compare(const char *name, u32 n, u16 expect[][LANES], u32 expect_n, u16 ratio, u8 order, u8 median)
+{
+        u32 j, l, bad = 0;
+
+        CHECK(n == expect_n, "%s ratio %u order %u median %u: %u outputs, expected %u", name, ratio, order, median, n,
+              expect_n);
+        for(j = 0; j < n && j < expect_n; j++)
+        {
+                for(l = 0; l < LANES; l++)
+                {
+                        if(output[j][l] != expect[j][l] && bad++ < 3)
+                        {
+                                printf("  %s ratio %u order %u median %u: output %u lane %u = %u, expected %u\n", name,
+                                       ratio, order, median, j, l, output[j][l], expect[j][l]);
+                        }
+                }
+        }
+        return bad;
+}
+
+/**
+ * @Description 第一个通道稳定后输出的均值和标准差(16位满量程的LSB)
+ */
+static void lane_stat(u32 n, double *mean, double *rms)
+{
+        double s = 0, s2 = 0;
+        u32 j;
+
+        for(j = SETTLE; j < n; j++)
+        {
+                s += output[j][0];
+                s2 += (double)output[j][0] * output[j][0];
+        }
+        *mean = s / (n - SETTLE);
+        *rms = sqrt(s2 / (n - SETTLE) - *mean * *mean);
+}
+
+int main(int argc, char *argv[])
+{
+        static u16 expect[OUTPUT_MAX][LANES];
+        static const char *name[2] = {"simd", "c"};
+        static const FILTER_PresumFunc presum[2] = {Filter_PresumSimd, Filter_PresumScalar};
+        FILTER_TypeDef filter;
+        u32 n, expect_n, compared = 0, mismatches = 0;
+        u16 ratio;
+        u8 order, median, p;
+        double t0, ns[2] = {0, 0}, mean, rms, rms_min = 0, rms_max = 0, spike_raw, spike_median;
+
+        printf("filtersim: %u lanes, presum %u, ratio %u~%u, order 1~%u\n", LANES, FILTER_PRESUM, FILTER_RATIO_MIN,
+               FILTER_RATIO_MAX, FILTER_ORDER_MAX);
+        CHECK(Filter_Init(&filter, 0, 64, 1, 0, 0) == 1 && Filter_Init(&filter, FILTER_LANES_MAX / 2 + 1, 64, 1, 0, 0) == 1,
+              "Filter_Init() accepts a wrong frame size");
+        CHECK(Filter_Init(&filter, WORDS, 64, 0, 0, 0) == 1 && Filter_Init(&filter, WORDS, 64, FILTER_ORDER_MAX + 1, 0, 0) == 1,
+              "Filter_Init() accepts a wrong order");
+        CHECK(Filter_Init(&filter, WORDS, FILTER_RATIO_MIN / 2, 1, 0, 0) == 1 &&
+              Filter_Init(&filter, WORDS, FILTER_RATIO_MAX * 2, 1, 0, 0) == 1 && Filter_Init(&filter, WORDS, 48, 1, 0, 0) == 1,
+              "Filter_Init() accepts a wrong ratio");
+
+        /* 逐位比较：所有抽取比、阶数和中值滤波的组合，两种第一级 */
+        srand(3);
+        make_input(1000, 20, 500);
+        for(median = 0; median < 2; median++)
+        {
+                for(order = 1; order <= FILTER_ORDER_MAX; order++)
+                {
+                        for(ratio = FILTER_RATIO_MIN; ratio <= FILTER_RATIO_MAX; ratio *= 2)
+                        {
+                                expect_n = reference(ratio, order, median, expect);
+                                for(p = 0; p < 2; p++)
+                                {
+                                        Filter_Init(&filter, WORDS, ratio, order, median, record);
+                                        t0 = now_ns();
+                                        n = run(&filter, presum[p]);
+                                        ns[p] += now_ns() - t0;
+                                        mismatches += compare(name[p], n, expect, expect_n, ratio, order, median);
+                                        compared += n * LANES;
+                                }
+                        }
+                }
+        }
+        printf("  compared %u outputs with the reference, %u different\n", compared, mismatches);
+        printf("  host time per sample: simd %.2f ns, c %.2f ns\n", ns[0] / (2 * FILTER_ORDER_MAX * 5 * FRAMES * LANES),
+               ns[1] / (2 * FILTER_ORDER_MAX * 5 * FRAMES * LANES));
+        CHECK(mismatches == 0, "%u outputs differ from the reference", mismatches);
+
+        /* 满量程输入放大16倍，不限幅 */
+        make_input(4095, 0, 0);
+        Filter_Init(&filter, WORDS, FILTER_RATIO_MAX, FILTER_ORDER_MAX, 1, record);
+        n = run(&filter, Filter_PresumSimd);
+        CHECK(output[n - 1][0] == 4095 * 16, "full scale %u, expected %u", output[n - 1][0], 4095 * 16);
+
+        /* 噪声：中心2048，均匀噪声±2(标准差1.41 LSB12，即22.6 LSB16) */
+        for(order = 1; order <= FILTER_ORDER_MAX; order++)
+        {
+                printf("  order %u rms noise (LSB16):", order);
+                for(ratio = FILTER_RATIO_MIN; ratio <= FILTER_RATIO_MAX; ratio *= 2)
+                {
+                        srand(7);
+                        make_input(2048, 2, 0);
+                        Filter_Init(&filter, WORDS, ratio, order, 0, record);
+                        n = run(&filter, Filter_PresumSimd);
+                        lane_stat(n, &mean, &rms);
+                        printf(" %u:%.2f", ratio, rms);
+                        CHECK(fabs(mean - 2048 * 16) < 2, "ratio %u order %u: mean %.2f", ratio, order, mean);
+                        if(ratio == FILTER_RATIO_MIN)
+                        {
+                                rms_min = rms;
+                        }
+                        rms_max = rms;
+                }
+                printf("\n");
+                CHECK(rms_max < rms_min / 3, "order %u: rms %.2f at %u, %.2f at %u", order, rms_max, FILTER_RATIO_MAX,
+                      rms_min, FILTER_RATIO_MIN);
+        }
+
+        /* 尖峰：没有噪声的恒定输入中有单个的满量程尖峰，中值滤波后的输出不受影响 */
+        srand(11);
+        make_input(2048, 0, 200);
+        Filter_Init(&filter, WORDS, 64, 1, 0, record);
+        n = run(&filter, Filter_PresumSimd);
+        lane_stat(n, &mean, &spike_raw);
+        Filter_Init(&filter, WORDS, 64, 1, 1, record);
+        n = run(&filter, Filter_PresumSimd);
+        lane_stat(n, &mean, &spike_median);
+        printf("  spikes 1/200 at ratio 64: rms %.2f LSB16 without median, %.2f with median\n", spike_raw, spike_median);
+        CHECK(spike_median < spike_raw / 4, "median filter rms %.2f, without %.2f", spike_median, spike_raw);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
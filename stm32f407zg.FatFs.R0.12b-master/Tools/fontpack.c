@@ -0,0 +1,344 @@
+/**
+ * fontpack.c 上位机GBK字库打包工具，生成bsp_text.c使用的字库文件
+ *
+ * 编译：gcc -O2 -o fontpack fontpack.c
+ * 用法：fontpack GBK.FON 12:font12.bdf 16:font16.bdf 24:font24.bdf 32:font32.bdf
+ *
+ * 输入为Unicode编码(ENCODING为Unicode码)的BDF点阵字体，如文泉驿点阵宋体，
+ * 每种字号按GBK码顺序取出23940个字模，取模方式与bsp_font.h中的ASCII字库相同：
+ * 逐列式，每列从上到下高位在前，字模宽高均为字号。最后附加Unicode->GBK映射表。
+ * GBK与Unicode之间的转换使用系统的iconv。
+ * 生成的文件拷贝到文件系统根目录下，开发板上调用Text_Update("0:/GBK.FON")写入Flash。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <iconv.h>
+
+/* 与bsp_text.h保持一致 */
+#define TEXT_MAGIC              0x464B4247
+#define TEXT_VERSION            1
+#define TEXT_FONT_MAX           4
+#define TEXT_GLYPH_NUM          23940
+#define TEXT_FONT_SIZE          (6 * 1024 * 1024)       // W25QXX_FONT_SIZE
+#define TEXT_HEADER_SIZE        (16 + TEXT_FONT_MAX * 8)
+
+/* BDF中的一个字形，位图按行存放，每行一个字节数组 */
+typedef struct
+{
+        int width, height;
+        int xoff, yoff;
+        unsigned char *bits;
+        int pitch;
+} Glyph;
+
+/* 一种字号的BDF字体，按Unicode码索引 */
+typedef struct
+{
+        int size;
+        int ascent;
+        Glyph *glyph[65536];
+} Font;
+
+static uint16_t gbk2uni[TEXT_GLYPH_NUM];
+static uint16_t uni2gbk[65536];
+
+static void put16(unsigned char *p, unsigned v)
+{
+        p[0] = v;
+        p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, unsigned long v)
+{
+        put16(p, v & 0xFFFF);
+        put16(p + 2, v >> 16);
+}
+
+/**
+ * @Description 用iconv建立GBK与Unicode之间的对照表
+ * @return int  0:成功
+ */
+static int build_map(void)
+{
+        iconv_t cd = iconv_open("UCS-2LE", "GBK");
+        int hi, lo, index;
+
+        if(cd == (iconv_t)-1)
+        {
+                perror("iconv_open");
+                return -1;
+        }
+
+        for(hi = 0x81; hi <= 0xFE; hi++)
+        {
+                for(lo = 0x40; lo <= 0xFE; lo++)
+                {
+                        char in[2], out[4];
+                        char *pin = in, *pout = out;
+                        size_t nin = 2, nout = sizeof(out);
+
+                        if(lo == 0x7F)
+                        {
+                                continue;
+                        }
+
+                        index = (hi - 0x81) * 190 + (lo - 0x40) - (lo > 0x7F ? 1 : 0);
+                        in[0] = hi;
+                        in[1] = lo;
+                        iconv(cd, NULL, NULL, NULL, NULL);
+                        if(iconv(cd, &pin, &nin, &pout, &nout) == (size_t)-1 || nout != 2)
+                        {
+                                continue;
+                        }
+
+                        gbk2uni[index] = (unsigned char)out[0] | ((unsigned char)out[1] << 8);
+                        if(uni2gbk[gbk2uni[index]] == 0)
+                        {
+                                uni2gbk[gbk2uni[index]] = (hi << 8) | lo;
+                        }
+                }
+        }
+
+        iconv_close(cd);
+        return 0;
+}
+
+/**
+ * @Description 读取BDF字体文件
+ * @param font  返回的字体，font->size需要事先设置
+ * @param path  文件路径
+ * @return int  0:成功
+ */
+static int load_bdf(Font *font, const char *path)
+{
+        FILE *fp = fopen(path, "r");
+        char line[512];
+        Glyph *g = NULL;
+        long code = -1;
+        int row = -1;
+        int descent = 0;
+
+        if(fp == NULL)
+        {
+                perror(path);
+                return -1;
+        }
+
+        while(fgets(line, sizeof(line), fp) != NULL)
+        {
+                if(row >= 0 && g != NULL)
+                {
+                        if(strncmp(line, "ENDCHAR", 7) == 0)
+                        {
+                                if(code >= 0 && code <= 0xFFFF)
+                                {
+                                        free(font->glyph[code]);
+                                        font->glyph[code] = g;
+                                }
+                                else
+                                {
+                                        free(g);
+                                }
+                                g = NULL;
+                                row = -1;
+                        }
+                        else if(row < g->height)
+                        {
+                                int i;
+                                for(i = 0; i < g->pitch && line[i * 2] && line[i * 2 + 1]; i++)
+                                {
+                                        unsigned v;
+                                        sscanf(line + i * 2, "%2x", &v);
+                                        g->bits[row * g->pitch + i] = v;
+                                }
+                                row++;
+                        }
+                        continue;
+                }
+
+                if(sscanf(line, "FONT_ASCENT %d", &font->ascent) == 1)
+                {
+                        continue;
+                }
+                if(sscanf(line, "FONT_DESCENT %d", &descent) == 1)
+                {
+                        continue;
+                }
+                if(sscanf(line, "ENCODING %ld", &code) == 1)
+                {
+                        continue;
+                }
+                if(strncmp(line, "BBX", 3) == 0)
+                {
+                        int w, h, x, y;
+                        if(sscanf(line, "BBX %d %d %d %d", &w, &h, &x, &y) == 4 && w > 0 && h > 0)
+                        {
+                                g = malloc(sizeof(Glyph) + ((w + 7) / 8) * h);
+                                g->width = w;
+                                g->height = h;
+                                g->xoff = x;
+                                g->yoff = y;
+                                g->pitch = (w + 7) / 8;
+                                g->bits = (unsigned char *)(g + 1);
+                                memset(g->bits, 0, g->pitch * h);
+                        }
+                        continue;
+                }
+                if(strncmp(line, "BITMAP", 6) == 0)
+                {
+                        row = 0;
+                        continue;
+                }
+                if(strncmp(line, "ENDCHAR", 7) == 0)
+                {
+                        /* 空白字符没有位图 */
+                        free(g);
+                        g = NULL;
+                        code = -1;
+                }
+        }
+
+        fclose(fp);
+
+        /* 没有FONT_ASCENT时按字号的7/8作为基线 */
+        if(font->ascent == 0)
+        {
+                font->ascent = font->size - (descent ? descent : font->size / 8);
+        }
+
+        return 0;
+}
+
+/**
+ * @Description 把一个BDF字形画到size*size的格子中，再转换为逐列式字模
+ * @param font  字体
+ * @param uni   Unicode码
+ * @param out   返回的字模，size*csize字节
+ */
+static void render(const Font *font, unsigned uni, unsigned char *out)
+{
+        const Glyph *g = uni ? font->glyph[uni] : NULL;
+        int size = font->size;
+        int csize = size / 8 + ((size % 8) ? 1 : 0);
+        int r, c, x, y;
+
+        memset(out, 0, size * csize);
+        if(g == NULL)
+        {
+                return;
+        }
+
+        for(r = 0; r < g->height; r++)
+        {
+                /* BDF的y向上为正，基线在格子中第ascent行 */
+                y = font->ascent - (g->yoff + g->height) + r;
+                if(y < 0 || y >= size)
+                {
+                        continue;
+                }
+                for(c = 0; c < g->width; c++)
+                {
+                        x = g->xoff + c;
+                        if(x < 0 || x >= size)
+                        {
+                                continue;
+                        }
+                        if(g->bits[r * g->pitch + c / 8] & (0x80 >> (c % 8)))
+                        {
+                                out[x * csize + y / 8] |= 0x80 >> (y % 8);
+                        }
+                }
+        }
+}
+
+int main(int argc, char *argv[])
+{
+        static Font fonts[TEXT_FONT_MAX];
+        unsigned char header[TEXT_HEADER_SIZE];
+        unsigned char glyph[32 * 4];
+        unsigned long offset = TEXT_HEADER_SIZE;
+        unsigned long total;
+        FILE *fp;
+        int count = argc - 2;
+        int i, j;
+
+        if(argc < 3 || count > TEXT_FONT_MAX)
+        {
+                fprintf(stderr, "usage: %s out.fon size:font.bdf ... (at most %d sizes)\n", argv[0], TEXT_FONT_MAX);
+                return 1;
+        }
+
+        if(build_map() != 0)
+        {
+                return 1;
+        }
+
+        /* 文件头 */
+        memset(header, 0, sizeof(header));
+        for(i = 0; i < count; i++)
+        {
+                char *colon = strchr(argv[i + 2], ':');
+                int csize;
+
+                fonts[i].size = atoi(argv[i + 2]);
+                if(colon == NULL || fonts[i].size <= 0 || fonts[i].size > 32 || load_bdf(&fonts[i], colon + 1) != 0)
+                {
+                        fprintf(stderr, "bad font argument: %s\n", argv[i + 2]);
+                        return 1;
+                }
+
+                csize = fonts[i].size / 8 + ((fonts[i].size % 8) ? 1 : 0);
+                header[16 + i * 8] = fonts[i].size;
+                put16(header + 16 + i * 8 + 2, fonts[i].size * csize);
+                put32(header + 16 + i * 8 + 4, offset);
+                offset += (unsigned long)TEXT_GLYPH_NUM * fonts[i].size * csize;
+        }
+
+        total = offset + sizeof(uni2gbk);
+        if(total > TEXT_FONT_SIZE)
+        {
+                fprintf(stderr, "font file is %lu bytes, larger than the %d bytes flash region\n", total, TEXT_FONT_SIZE);
+                return 1;
+        }
+
+        put32(header + 0, TEXT_MAGIC);
+        put16(header + 4, TEXT_VERSION);
+        put16(header + 6, count);
+        put32(header + 8, offset);
+        put32(header + 12, total);
+
+        fp = fopen(argv[1], "wb");
+        if(fp == NULL)
+        {
+                perror(argv[1]);
+                return 1;
+        }
+        fwrite(header, 1, sizeof(header), fp);
+
+        /* 字模数据 */
+        for(i = 0; i < count; i++)
+        {
+                int csize = fonts[i].size / 8 + ((fonts[i].size % 8) ? 1 : 0);
+                for(j = 0; j < TEXT_GLYPH_NUM; j++)
+                {
+                        render(&fonts[i], gbk2uni[j], glyph);
+                        fwrite(glyph, 1, fonts[i].size * csize, fp);
+                }
+        }
+
+        /* Unicode->GBK映射表 */
+        for(j = 0; j < 65536; j++)
+        {
+                unsigned char v[2];
+                put16(v, uni2gbk[j]);
+                fwrite(v, 1, 2, fp);
+        }
+
+        fclose(fp);
+        printf("%s: %d sizes, %lu bytes\n", argv[1], count, total);
+
+        return 0;
+}
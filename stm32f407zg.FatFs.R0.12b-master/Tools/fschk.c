@@ -0,0 +1,481 @@
+/**
+ * fschk.c 上位机f_check()测试，生成一组损坏的卷镜像，检查f_check()报告的错误、修复后卷是否一致，并统计读扇区数
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -I host -I ../FatFs -o fschk fschk.c host/host.c host/ramdisk.c ../FatFs/ff.c ../FatFs/syscall.c
+ * 用法：fschk              运行全部用例
+ *       fschk -w 目录      运行全部用例，并把每个损坏的镜像保存到目录中，文件名为FAT类型-用例名.img
+ *       fschk 镜像文件...  检查镜像文件(例如从开发板的W25Q128读出的10MB卷)，输出检查结果，不修改文件
+ *
+ * 基础镜像分别格式化为FAT12(12MB)、FAT16(20MB)和FAT16(32MB)，每簇一个4KB扇区，根目录下有A.BIN、B.BIN和子目录SUB，
+ * SUB中有C.BIN和D.BIN。每个用例直接修改镜像中的FAT和目录项制造一种掉电或写坏后的错误，
+ * 然后依次运行检查、修复、再检查，再检查必须没有任何错误。
+ * FAT12的丢失簇链跨过FAT的扇区边界(簇2730的表项一半在第一个扇区，一半在第二个扇区)。
+ * f_check()的工作缓冲区与开发板main()中的相同(8KB)，FAT16镜像的FAT(12KB和16KB)都比它大，f_check()按扇区读FAT。
+ * (4KB的簇在16MB的卷上按擦除块对齐后只有4080个簇，不能格式化为FAT16，所以用32MB的卷。)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "ramdisk.h"
+
+#define FAT12_SECTORS           3072                    // 12MB
+#define FAT16_SECTORS           5120                    // 20MB
+#define FAT16_LARGE_SECTORS     8192                    // 32MB
+#define STRADDLE_CLUSTER        2729                    // FAT12中簇2730的表项跨过扇区边界
+
+/* 基础镜像中一个文件或目录的位置 */
+typedef struct
+{
+        DWORD sclust;                                   // 起始簇
+        DWORD dir_ofs;                                  // 目录项在镜像中的偏移
+} Entry;
+
+/* 一种基础镜像 */
+typedef struct
+{
+        const char *name;
+        DWORD sectors;
+        BYTE fs_type;
+} Image;
+
+/* 一个损坏用例：修改镜像的函数和f_check()应该报告的错误数 */
+typedef struct
+{
+        const char *name;
+        void (*corrupt)(void);
+        DWORD n_lost;
+        DWORD n_lostchain;
+        DWORD n_xlink;
+        DWORD n_broken;
+        DWORD n_size;
+        DWORD n_orphan;
+} Case;
+
+static FATFS fs;
+static BYTE *image;
+static BYTE *base;
+static DWORD image_size;
+static Entry file_a, file_b, dir_sub, file_c, file_d;
+static DWORD work[_MAX_SS * 2 / sizeof(DWORD)];         // 与开发板main()中f_check()的缓冲区相同(8KB)
+
+static const Image images[] =
+{
+        { "fat12",     FAT12_SECTORS,       FS_FAT12 },
+        { "fat16",     FAT16_SECTORS,       FS_FAT16 },
+        { "fat16-32m", FAT16_LARGE_SECTORS, FS_FAT16 },
+};
+
+/**
+ * @Description 读取镜像中的FAT表项
+ */
+static DWORD fat_get(DWORD clst)
+{
+        BYTE *fat = image + fs.fatbase * RAMDISK_SECTOR_SIZE;
+        DWORD w;
+
+        switch(fs.fs_type)
+        {
+        case FS_FAT12:
+                w = fat[clst + clst / 2] | fat[clst + clst / 2 + 1] << 8;
+                return (clst & 1) ? w >> 4 : w & 0xFFF;
+        case FS_FAT16:
+                return fat[clst * 2] | fat[clst * 2 + 1] << 8;
+        default:
+                return (fat[clst * 4] | fat[clst * 4 + 1] << 8 | fat[clst * 4 + 2] << 16 | (DWORD)fat[clst * 4 + 3] << 24) & 0x0FFFFFFF;
+        }
+}
+
+/**
+ * @Description 直接修改镜像中的FAT表项，0xFFFFFFFF表示链尾
+ */
+static void fat_put(DWORD clst, DWORD val)
+{
+        BYTE *fat = image + fs.fatbase * RAMDISK_SECTOR_SIZE;
+        BYTE *p;
+
+        switch(fs.fs_type)
+        {
+        case FS_FAT12:
+                p = fat + clst + clst / 2;
+                if(clst & 1)
+                {
+                        p[0] = (p[0] & 0x0F) | (BYTE)(val << 4);
+                        p[1] = (BYTE)(val >> 4);
+                }
+                else
+                {
+                        p[0] = (BYTE)val;
+                        p[1] = (p[1] & 0xF0) | ((val >> 8) & 0x0F);
+                }
+                break;
+        case FS_FAT16:
+                fat[clst * 2] = (BYTE)val;
+                fat[clst * 2 + 1] = (BYTE)(val >> 8);
+                break;
+        default:
+                p = fat + clst * 4;
+                p[0] = (BYTE)val;
+                p[1] = (BYTE)(val >> 8);
+                p[2] = (BYTE)(val >> 16);
+                p[3] = (p[3] & 0xF0) | ((val >> 24) & 0x0F);
+                break;
+        }
+}
+
+/**
+ * @Description 簇链中的第n个簇，n从0开始
+ */
+static DWORD chain_at(const Entry *e, DWORD n)
+{
+        DWORD clst = e->sclust;
+
+        while(n--)
+        {
+                clst = fat_get(clst);
+        }
+        return clst;
+}
+
+static void set_size(const Entry *e, DWORD size)
+{
+        BYTE *dir = image + e->dir_ofs;
+
+        dir[28] = (BYTE)size;
+        dir[29] = (BYTE)(size >> 8);
+        dir[30] = (BYTE)(size >> 16);
+        dir[31] = (BYTE)(size >> 24);
+}
+
+static void set_sclust(const Entry *e, DWORD clst)
+{
+        BYTE *dir = image + e->dir_ofs;
+
+        dir[26] = (BYTE)clst;
+        dir[27] = (BYTE)(clst >> 8);
+        dir[20] = (BYTE)(clst >> 16);
+        dir[21] = (BYTE)(clst >> 24);
+}
+
+/**
+ * @Description 创建一个文件，记录它的起始簇和目录项的位置
+ */
+static int make_file(const char *path, DWORD size, Entry *e)
+{
+        static BYTE buf[8 * RAMDISK_SECTOR_SIZE];
+        FIL fil;
+        UINT bw;
+        DWORD i;
+
+        for(i = 0; i < size; i++)
+        {
+                buf[i] = (BYTE)(i * 7 + size);
+        }
+        if(f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK || f_write(&fil, buf, size, &bw) != FR_OK || f_sync(&fil) != FR_OK)
+        {
+                return -1;
+        }
+        e->sclust = fil.obj.sclust;
+        e->dir_ofs = fil.dir_sect * RAMDISK_SECTOR_SIZE + (DWORD)(fil.dir_ptr - fs.win);
+        return (f_close(&fil) == FR_OK) ? 0 : -1;
+}
+
+/**
+ * @Description 在根目录区中查找短文件名的目录项
+ */
+static int find_root(const char *sfn, Entry *e)
+{
+        BYTE *dir = image + fs.dirbase * RAMDISK_SECTOR_SIZE;
+        DWORD i;
+
+        for(i = 0; i < fs.n_rootdir; i++, dir += 32)
+        {
+                if(memcmp(dir, sfn, 11) == 0)
+                {
+                        e->dir_ofs = (DWORD)(dir - image);
+                        e->sclust = dir[26] | dir[27] << 8;
+                        return 0;
+                }
+        }
+        return -1;
+}
+
+/**
+ * @Description 格式化并创建基础镜像，A和B的簇交错分配，两个文件都不连续
+ */
+static int make_base(DWORD sectors)
+{
+        static BYTE buf[RAMDISK_SECTOR_SIZE];
+        FIL a, b;
+        UINT bw;
+        int i;
+
+        image = Ramdisk_Create(0, sectors);
+        image_size = sectors * RAMDISK_SECTOR_SIZE;
+        if(f_mkfs("0:", FM_FAT | FM_SFD, RAMDISK_SECTOR_SIZE, buf, sizeof(buf)) != FR_OK || f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                return -1;
+        }
+
+        if(f_open(&a, "0:A.BIN", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK || f_open(&b, "0:B.BIN", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+        {
+                return -1;
+        }
+        for(i = 0; i < 4; i++)
+        {
+                memset(buf, 'A' + i, sizeof(buf));
+                if((i < 3 && f_write(&a, buf, (i < 2) ? sizeof(buf) : 1000, &bw) != FR_OK) || f_write(&b, buf, sizeof(buf), &bw) != FR_OK)
+                {
+                        return -1;
+                }
+        }
+        if(f_close(&a) != FR_OK || f_close(&b) != FR_OK || f_mkdir("0:SUB") != FR_OK ||
+           make_file("0:SUB/C.BIN", 6000, &file_c) != FR_OK || make_file("0:SUB/D.BIN", 100, &file_d) != FR_OK)
+        {
+                return -1;
+        }
+
+        /* 保持挂载，修改镜像时使用fs中的FAT类型和位置 */
+        if(find_root("A       BIN", &file_a) != 0 || find_root("B       BIN", &file_b) != 0 || find_root("SUB        ", &dir_sub) != 0)
+        {
+                return -1;
+        }
+
+        free(base);
+        base = malloc(image_size);
+        memcpy(base, image, image_size);
+        return 0;
+}
+
+static void corrupt_none(void)
+{
+}
+
+/* 分配了但没有写入目录项的簇链，FAT12中跨过FAT的扇区边界 */
+static void corrupt_lost_chain(void)
+{
+        fat_put(STRADDLE_CLUSTER, STRADDLE_CLUSTER + 1);
+        fat_put(STRADDLE_CLUSTER + 1, STRADDLE_CLUSTER + 2);
+        fat_put(STRADDLE_CLUSTER + 2, 0xFFFFFFFF);
+}
+
+/* B的第一个簇链接到A的第二个簇 */
+static void corrupt_xlink(void)
+{
+        fat_put(file_b.sclust, chain_at(&file_a, 1));
+}
+
+/* A的第二个簇在FAT中是空闲的 */
+static void corrupt_free_link(void)
+{
+        fat_put(chain_at(&file_a, 1), 0);
+}
+
+/* A的第一个簇链接到无效的簇号 */
+static void corrupt_bad_link(void)
+{
+        fat_put(file_a.sclust, 1);
+}
+
+/* A的文件大小比簇链长 */
+static void corrupt_size_long(void)
+{
+        set_size(&file_a, 5 * RAMDISK_SECTOR_SIZE);
+}
+
+/* A的文件大小比簇链短 */
+static void corrupt_size_short(void)
+{
+        set_size(&file_a, 100);
+}
+
+/* B和A的起始簇相同 */
+static void corrupt_same_start(void)
+{
+        set_sclust(&file_b, file_a.sclust);
+}
+
+/* 子目录的簇在FAT中是空闲的 */
+static void corrupt_dir(void)
+{
+        fat_put(dir_sub.sclust, 0);
+}
+
+/* 根目录中有两个长文件名目录项，后面没有短文件名目录项 */
+static void corrupt_orphan(void)
+{
+        BYTE *dir = image + dir_sub.dir_ofs + 32;
+
+        memset(dir, 0, 64);
+        dir[0] = 0x42;
+        dir[11] = 0x0F;                                 // 长文件名目录项的属性
+        dir[13] = 0x55;
+        dir[32] = 0x01;
+        dir[32 + 11] = 0x0F;
+        dir[32 + 13] = 0x55;
+}
+
+static const Case cases[] =
+{
+        /* name         corrupt                 lost lostchain xlink broken size orphan */
+        { "clean",      corrupt_none,           0, 0, 0, 0, 0, 0 },
+        { "lostchain",  corrupt_lost_chain,     3, 1, 0, 0, 0, 0 },
+        { "xlink",      corrupt_xlink,          3, 1, 1, 0, 1, 0 },
+        { "freelink",   corrupt_free_link,      1, 1, 0, 1, 1, 0 },
+        { "badlink",    corrupt_bad_link,       2, 1, 0, 1, 1, 0 },
+        { "sizelong",   corrupt_size_long,      0, 0, 0, 0, 1, 0 },
+        { "sizeshort",  corrupt_size_short,     2, 0, 0, 0, 1, 0 },
+        { "samestart",  corrupt_same_start,     4, 1, 1, 0, 1, 0 },
+        { "brokendir",  corrupt_dir,            3, 2, 0, 1, 0, 0 },
+        { "orphan",     corrupt_orphan,         0, 0, 0, 0, 0, 1 },
+};
+
+static int has_error(const CHKINFO *ci)
+{
+        return ci->n_lost || ci->n_lostchain || ci->n_xlink || ci->n_broken || ci->n_size || ci->n_orphan;
+}
+
+static void print_info(const char *name, FRESULT res, const CHKINFO *ci, DWORD reads)
+{
+        printf("%-24s f_check = %d, lost %lu, lostchain %lu, xlink %lu, broken %lu, size %lu, orphan %lu, %lu sectors read\n",
+               name, res, (unsigned long)ci->n_lost, (unsigned long)ci->n_lostchain, (unsigned long)ci->n_xlink,
+               (unsigned long)ci->n_broken, (unsigned long)ci->n_size, (unsigned long)ci->n_orphan, (unsigned long)reads);
+}
+
+/**
+ * @Description 挂载卷并运行一次f_check()
+ * @param reads 返回检查期间读取的扇区数
+ */
+static FRESULT check(BYTE opt, CHKINFO *ci, DWORD *reads)
+{
+        DWORD before, after;
+        FRESULT res;
+
+        memset(ci, 0, sizeof(CHKINFO));
+        f_mount(NULL, "0:", 0);
+        res = f_mount(&fs, "0:", 1);
+        if(res != FR_OK)
+        {
+                return res;
+        }
+        Ramdisk_Data(0, NULL, &before, NULL);
+        res = f_check("0:", opt, work, sizeof(work), ci);
+        Ramdisk_Data(0, NULL, &after, NULL);
+        *reads = after - before;
+
+        return res;
+}
+
+/**
+ * @Description 运行一个用例：检查结果与预期相同，修复后再检查没有错误
+ * @return int  0:通过 1:失败
+ */
+static int run_case(const char *type, const Case *c, const char *save_dir)
+{
+        char name[64], path[300];
+        CHKINFO ci;
+        DWORD reads;
+        FRESULT res;
+        int failed;
+
+        sprintf(name, "%s-%s", type, c->name);
+        memcpy(image, base, image_size);
+        c->corrupt();
+        if(save_dir)
+        {
+                sprintf(path, "%s/%s.img", save_dir, name);
+                if(Ramdisk_Save(0, path) != 0)
+                {
+                        printf("%s: cannot write %s\n", name, path);
+                        return 1;
+                }
+        }
+
+        res = check(0, &ci, &reads);
+        print_info(name, res, &ci, reads);
+        failed = res != FR_OK || ci.n_lost != c->n_lost || ci.n_lostchain != c->n_lostchain || ci.n_xlink != c->n_xlink ||
+                 ci.n_broken != c->n_broken || ci.n_size != c->n_size || ci.n_orphan != c->n_orphan;
+
+        res = check(FCK_REPAIR, &ci, &reads);
+        if(res != FR_OK || (has_error(&ci) && ci.n_fixed == 0))
+        {
+                print_info("  repair", res, &ci, reads);
+                failed = 1;
+        }
+        res = check(0, &ci, &reads);
+        if(res != FR_OK || has_error(&ci))
+        {
+                print_info("  after repair", res, &ci, reads);
+                failed = 1;
+        }
+        if(failed)
+        {
+                printf("  FAILED\n");
+        }
+
+        return failed;
+}
+
+/**
+ * @Description 只检查镜像文件，不修复
+ */
+static int check_file(const char *path)
+{
+        CHKINFO ci;
+        DWORD reads;
+        FRESULT res;
+
+        if(Ramdisk_Load(0, path) != 0)
+        {
+                printf("%s: cannot read\n", path);
+                return 1;
+        }
+        res = check(0, &ci, &reads);
+        print_info(path, res, &ci, reads);
+        f_mount(NULL, "0:", 0);
+
+        return (res != FR_OK || has_error(&ci)) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+        const char *save_dir = NULL;
+        unsigned failed = 0;
+        unsigned i, j;
+        DWORD n;
+        int k;
+
+        if(argc > 1 && strcmp(argv[1], "-w") != 0)
+        {
+                for(k = 1; k < argc; k++)
+                {
+                        failed += check_file(argv[k]);
+                }
+                return failed ? 1 : 0;
+        }
+        if(argc > 2)
+        {
+                save_dir = argv[2];
+        }
+
+        for(j = 0; j < sizeof(images) / sizeof(images[0]); j++)
+        {
+                if(make_base(images[j].sectors) != 0 || fs.fs_type != images[j].fs_type)
+                {
+                        printf("cannot create the %s image\n", images[j].name);
+                        return 1;
+                }
+                n = (fs.fs_type == FS_FAT12) ? (fs.n_fatent * 3 + 1) / 2 : fs.n_fatent * 2;
+                printf("%s: %lu clusters, FAT entries %lu bytes, work buffer %u bytes\n", images[j].name,
+                       (unsigned long)(fs.n_fatent - 2), (unsigned long)n, (unsigned)sizeof(work));
+                for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+                {
+                        failed += run_case(images[j].name, &cases[i], save_dir);
+                }
+        }
+
+        printf("%s\n", failed ? "FAILED" : "passed");
+        return failed ? 1 : 0;
+}
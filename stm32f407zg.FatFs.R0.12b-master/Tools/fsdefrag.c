@@ -0,0 +1,203 @@
+/**
+ * fsdefrag.c 上位机碎片整理测试，在W25Q128模型上运行FatFs/diskio.c和ff.c，比较f_defrag()前后的碎片数和读文件的速度
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -I host -I ../User
+ *           -I ../Libraries -I ../FatFs -o fsdefrag fsdefrag.c ../FatFs/diskio.c ../FatFs/ff.c ../FatFs/syscall.c
+ *           host/host.c host/w25qxx.c
+ * 用法：fsdefrag
+ *
+ * 格式化10MB的卷(每簇4KB)，交替写入FILE_NUM个文件，每次写一簇，删除除第一个文件以外的文件，第一个文件的每个簇都是一个碎片。
+ * 然后每次调用f_defrag()最多移动DEFRAG_STEP个簇，直到文件连续，统计调用次数、擦除次数和Flash忙的时间。
+ * 整理前后分别用f_getfrag()统计卷的碎片数，按READ_CHUNK读出整个文件并校验内容，读的时间按W25Q128的SPI传输(21MHz)计算。
+ * f_read()每次最多读到簇的边界，每簇4KB时每个扇区都单独读，FAT12的FAT只有一个扇区且一直在窗口中，整理前后读的时间应该相同。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "bsp_w25qxx.h"
+#include "w25qxx.h"
+
+#define FILE_SIZE               (1024 * 1024)           // 被整理的文件大小
+#define FILE_NUM                3                       // 交替写入的文件个数
+#define CLUSTER                 4096
+#define DEFRAG_STEP             16                      // 每次f_defrag()最多移动的簇数，相当于主循环中空闲时调用
+#define READ_CHUNK              4096
+
+/* 一次读文件的结果 */
+typedef struct
+{
+        DWORD nclst;                                    // f_getfrag()：卷上使用的簇数
+        DWORD vfrag;                                    // f_getfrag()：卷上的碎片数
+        DWORD ffrag;                                    // f_defrag(ncl=0)：文件的碎片数
+        double read_ms;                                 // 读出整个文件的Flash时间
+        u32 read_kb;                                    // 读出的字节数，包括FAT和目录
+} Result;
+
+static FATFS fs;
+static int failures;
+static BYTE work[_MAX_SS];
+static BYTE buf[READ_CHUNK];
+
+/* diskio.c中的日志，不输出 */
+void Log_Write(const char *fmt, u32 n, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+}
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @Description 文件中第pos个字节的内容
+ */
+static BYTE pattern(u32 pos)
+{
+        return (BYTE)(pos * 13 + pos / CLUSTER);
+}
+
+/**
+ * @Description 格式化后交替写入FILE_NUM个文件，只保留F0.BIN
+ */
+static int fragment(void)
+{
+        static FIL fil[FILE_NUM];
+        char name[16];
+        UINT bw;
+        u32 pos, i, k;
+
+        W25QXX_EraseChip();
+        if(f_mkfs("0:", FM_FAT | FM_SFD, CLUSTER, work, sizeof(work)) != FR_OK || f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                return -1;
+        }
+        for(k = 0; k < FILE_NUM; k++)
+        {
+                sprintf(name, "0:F%u.BIN", k);
+                if(f_open(&fil[k], name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+                {
+                        return -1;
+                }
+        }
+        for(pos = 0; pos < FILE_SIZE; pos += CLUSTER)
+        {
+                for(i = 0; i < CLUSTER; i++)
+                {
+                        buf[i] = pattern(pos + i);
+                }
+                for(k = 0; k < FILE_NUM; k++)
+                {
+                        if(f_write(&fil[k], buf, CLUSTER, &bw) != FR_OK || bw != CLUSTER)
+                        {
+                                return -1;
+                        }
+                }
+        }
+        for(k = 0; k < FILE_NUM; k++)
+        {
+                sprintf(name, "0:F%u.BIN", k);
+                if(f_close(&fil[k]) != FR_OK || (k && f_unlink(name) != FR_OK))
+                {
+                        return -1;
+                }
+        }
+        return 0;
+}
+
+/**
+ * @Description 统计碎片数，读出F0.BIN并校验
+ */
+static int measure(Result *r)
+{
+        HOST_FlashStatTypeDef stat;
+        FIL fil;
+        UINT br;
+        u32 pos, i;
+        int bad = 0;
+
+        if(f_getfrag("0:", &r->nclst, &r->vfrag) != FR_OK || f_open(&fil, "0:F0.BIN", FA_READ) != FR_OK ||
+           f_defrag(&fil, 0, &r->ffrag) != FR_OK)
+        {
+                return -1;
+        }
+        f_close(&fil);
+
+        /* 重新挂载，FAT和目录也从Flash读出 */
+        f_mount(NULL, "0:", 0);
+        if(f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                return -1;
+        }
+        Host_FlashStat(NULL, 1);
+        if(f_open(&fil, "0:F0.BIN", FA_READ) != FR_OK)
+        {
+                return -1;
+        }
+        for(pos = 0; pos < FILE_SIZE; pos += br)
+        {
+                if(f_read(&fil, buf, READ_CHUNK, &br) != FR_OK || br != READ_CHUNK)
+                {
+                        return -1;
+                }
+                for(i = 0; i < br; i++)
+                {
+                        bad |= buf[i] != pattern(pos + i);
+                }
+        }
+        f_close(&fil);
+        Host_FlashStat(&stat, 1);
+        r->read_ms = stat.busy_us / 1e3;
+        r->read_kb = stat.read / 1024;
+        return bad ? -1 : 0;
+}
+
+static void print_result(const char *name, const Result *r)
+{
+        printf("  %-7s %8lu %9lu %9lu | %8u %9.1f %9.0f\n", name, (unsigned long)r->nclst, (unsigned long)r->vfrag,
+               (unsigned long)r->ffrag, r->read_kb, r->read_ms, FILE_SIZE / 1024 / (r->read_ms / 1e3));
+}
+
+int main(int argc, char *argv[])
+{
+        HOST_FlashStatTypeDef stat;
+        Result before, after;
+        FIL fil;
+        DWORD nfrag = 0;
+        u32 calls = 0;
+        FRESULT res = FR_OK;
+
+        W25QXX_Init();
+        Host_FlashSetTiming(700, 45000, 150000);
+        printf("fsdefrag: %u KB file written interleaved with %u others, %u KB clusters, f_defrag() moves %u clusters per call\n",
+               FILE_SIZE / 1024, FILE_NUM - 1, CLUSTER / 1024, DEFRAG_STEP);
+        CHECK(fragment() == 0, "cannot fragment the file");
+        CHECK(measure(&before) == 0, "cannot read the file before defrag");
+
+        /* 分步整理 */
+        Host_FlashStat(NULL, 1);
+        res = f_open(&fil, "0:F0.BIN", FA_READ | FA_WRITE);
+        while(res == FR_OK)
+        {
+                res = f_defrag(&fil, DEFRAG_STEP, &nfrag);
+                calls++;
+                if(nfrag <= 1)
+                {
+                        break;
+                }
+        }
+        f_close(&fil);
+        Host_FlashStat(&stat, 1);
+        CHECK(res == FR_OK && nfrag == 1, "f_defrag = %d, %lu fragments left", res, (unsigned long)nfrag);
+        CHECK(measure(&after) == 0, "cannot read the file after defrag");
+
+        printf("  %-7s %8s %9s %9s | %8s %9s %9s\n", "", "clusters", "vol frag", "file frag", "read KB", "flash ms", "KB/s");
+        print_result("before", &before);
+        print_result("after", &after);
+        printf("  f_defrag: %u calls, %u sector erases, %u block erases, %.1f s flash busy (%.1f ms per cluster)\n", calls,
+               stat.sector_erase, stat.block_erase, stat.busy_us / 1e6, stat.busy_us / 1e3 / (FILE_SIZE / CLUSTER));
+        CHECK(after.ffrag == 1 && after.vfrag < before.vfrag, "volume still fragmented: %lu", (unsigned long)after.vfrag);
+        CHECK(after.read_ms <= before.read_ms, "reading got slower after defrag");
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * fsflash.c 上位机Flash卷测试，在W25Q128模型上运行FatFs/diskio.c和ff.c，比较不同f_mkfs布局下每写入1MB的擦除次数
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -I host -I ../User
+ *           -I ../Libraries -I ../FatFs -o fsflash fsflash.c ../FatFs/diskio.c ../FatFs/ff.c ../FatFs/syscall.c
+ *           host/host.c host/w25qxx.c
+ * 用法：fsflash
+ *
+ * 每种布局先格式化10MB的卷，写满一次后删除(数据区不再是擦除状态)，再分别运行两种负载，统计扇区擦除、块擦除、擦除的总字节数和Flash忙的时间：
+ *       日志：一个日志文件每次追加一条记录后f_sync()，写满LOG_FILE_SIZE后换新文件，只保留最近LOG_KEEP个；
+ *       大文件：按64KB一次写入BULK_FILE_SIZE的文件，相当于YMODEM上传字库或图片，写完后删除。
+ * Flash按W25Q128的典型时间计时(页编程0.7ms、扇区擦除45ms、块擦除150ms)，擦除前的读出和SPI传输也计入忙的时间。
+ * 最后列出每种布局的簇数，也就是卷上最多能放的文件和目录个数。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "bsp_w25qxx.h"
+#include "w25qxx.h"
+
+#define LOG_BYTES               (1024 * 1024)           // 日志负载写入的总字节数
+#define LOG_RECORD_MIN          40                      // 一条日志记录的长度范围
+#define LOG_RECORD_MAX          160
+#define LOG_FILE_SIZE           (64 * 1024)
+#define LOG_KEEP                8
+#define BULK_BYTES              (2 * 1024 * 1024)       // 大文件负载写入的总字节数
+#define BULK_FILE_SIZE          (512 * 1024)
+#define BULK_CHUNK              (64 * 1024)
+
+/* 一种格式化布局 */
+typedef struct
+{
+        const char *name;
+        BYTE opt;
+        DWORD au;
+} Layout;
+
+/* 一种负载在一种布局上的结果 */
+typedef struct
+{
+        double erases;                                  // 每MB的擦除次数(扇区和块)
+        double erased_kb;                               // 每MB擦除的KB数
+        double busy_s;                                  // 每MB的Flash忙时间
+} Result;
+
+#define LAYOUT_NUM              (sizeof(layouts) / sizeof(layouts[0]))
+#define LAYOUT_DEFAULT          0                       // layouts[]中的默认布局
+#define LAYOUT_FLASH            2                       // layouts[]中自动选择簇大小的FM_FLASH布局
+
+static FATFS fs;
+static int failures;
+static BYTE work[_MAX_SS];
+static BYTE chunk[BULK_CHUNK];
+
+static const Layout layouts[] =
+{
+        { "default (FM_FAT|FM_SFD)",   FM_FAT | FM_SFD,            0 },
+        { "default, 64KB cluster",     FM_FAT | FM_SFD,            65536 },
+        { "FM_FLASH, auto cluster",    FM_FAT | FM_SFD | FM_FLASH, 0 },
+        { "FM_FLASH, 4KB cluster",     FM_FAT | FM_SFD | FM_FLASH, 4096 },
+        { "FM_FLASH, 16KB cluster",    FM_FAT | FM_SFD | FM_FLASH, 16384 },
+        { "FM_FLASH, 64KB cluster",    FM_FAT | FM_SFD | FM_FLASH, 65536 },
+};
+
+/* diskio.c中的日志，不输出 */
+void Log_Write(const char *fmt, u32 n, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+}
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @Description 擦除整个Flash，按布局格式化并挂载，再用一个文件写满卷后删除，
+ *              数据区都是旧数据，与用过一段时间的卷一样，写入时要先擦除
+ * @return DWORD 簇数，0表示失败
+ */
+static DWORD format(const Layout *l)
+{
+        FIL fil;
+        UINT bw;
+
+        f_mount(NULL, "0:", 0);
+        W25QXX_EraseChip();
+        if(f_mkfs("0:", l->opt, l->au, work, sizeof(work)) != FR_OK || f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                return 0;
+        }
+        memset(chunk, 0, sizeof(chunk));
+        if(f_open(&fil, "0:FILL.BIN", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+        {
+                return 0;
+        }
+        while(f_write(&fil, chunk, sizeof(chunk), &bw) == FR_OK && bw == sizeof(chunk))
+        {
+        }
+        if(f_close(&fil) != FR_OK || f_unlink("0:FILL.BIN") != FR_OK)
+        {
+                return 0;
+        }
+        return fs.n_fatent - 2;
+}
+
+/**
+ * @Description 把本次负载的Flash统计换算为每MB的值
+ */
+static void result(Result *r, u32 bytes)
+{
+        HOST_FlashStatTypeDef stat;
+        double mb = (double)bytes / (1024 * 1024);
+
+        Host_FlashStat(&stat, 1);
+        r->erases = (stat.sector_erase + stat.block_erase) / mb;
+        r->erased_kb = (stat.sector_erase * 4.0 + stat.block_erase * 64.0) / mb;
+        r->busy_s = stat.busy_us / 1e6 / mb;
+}
+
+/**
+ * @Description 日志负载，每条记录后f_sync()，相当于掉电不丢记录的记录仪
+ */
+static int run_log(Result *r)
+{
+        static char line[LOG_RECORD_MAX];
+        char name[20];
+        FIL fil;
+        UINT bw;
+        u32 total = 0, seq = 0, n, i;
+        FRESULT res = FR_OK;
+
+        srand(1);
+        Host_FlashStat(NULL, 1);
+        while(total < LOG_BYTES && res == FR_OK)
+        {
+                sprintf(name, "0:L%05u.LOG", seq);
+                res = f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE);
+                while(res == FR_OK && f_size(&fil) < LOG_FILE_SIZE && total < LOG_BYTES)
+                {
+                        n = LOG_RECORD_MIN + rand() % (LOG_RECORD_MAX - LOG_RECORD_MIN + 1);
+                        for(i = 0; i < n - 2; i++)
+                        {
+                                line[i] = 'a' + (total + i) % 26;
+                        }
+                        line[n - 2] = '\r';
+                        line[n - 1] = '\n';
+                        res = f_write(&fil, line, n, &bw);
+                        if(res == FR_OK)
+                        {
+                                res = f_sync(&fil);
+                        }
+                        total += n;
+                }
+                if(f_close(&fil) != FR_OK && res == FR_OK)
+                {
+                        res = FR_INT_ERR;
+                }
+                if(res == FR_OK && seq >= LOG_KEEP)
+                {
+                        sprintf(name, "0:L%05u.LOG", seq - LOG_KEEP);
+                        res = f_unlink(name);
+                }
+                seq++;
+        }
+        result(r, total);
+        return res;
+}
+
+/**
+ * @Description 大文件负载，每次写入64KB
+ */
+static int run_bulk(Result *r)
+{
+        FIL fil;
+        UINT bw;
+        u32 total = 0, n;
+        FRESULT res = FR_OK;
+
+        memset(chunk, 0x5A, sizeof(chunk));
+        Host_FlashStat(NULL, 1);
+        while(total < BULK_BYTES && res == FR_OK)
+        {
+                res = f_open(&fil, "0:BULK.BIN", FA_CREATE_ALWAYS | FA_WRITE);
+                for(n = 0; res == FR_OK && n < BULK_FILE_SIZE; n += BULK_CHUNK)
+                {
+                        res = f_write(&fil, chunk, BULK_CHUNK, &bw);
+                        total += bw;
+                }
+                if(f_close(&fil) != FR_OK && res == FR_OK)
+                {
+                        res = FR_INT_ERR;
+                }
+                if(res == FR_OK)
+                {
+                        res = f_unlink("0:BULK.BIN");
+                }
+        }
+        result(r, total);
+        return res;
+}
+
+int main(int argc, char *argv[])
+{
+        static Result log[LAYOUT_NUM], bulk[LAYOUT_NUM];
+        static DWORD clusters[LAYOUT_NUM];
+        u32 i;
+        int res;
+
+        W25QXX_Init();
+        Host_FlashSetTiming(700, 45000, 150000);
+        printf("fsflash: %u MB volume, log %u-%u byte records with f_sync, bulk %u KB writes\n",
+               W25QXX_FATFS_SIZE / 1024 / 1024, LOG_RECORD_MIN, LOG_RECORD_MAX, BULK_CHUNK / 1024);
+        printf("  %-26s %8s | %-28s | %-28s\n", "", "", "log, per MB written", "bulk, per MB written");
+        printf("  %-26s %8s | %8s %9s %9s | %8s %9s %9s\n", "layout", "clusters", "erases", "erased KB", "busy s",
+               "erases", "erased KB", "busy s");
+        for(i = 0; i < LAYOUT_NUM; i++)
+        {
+                clusters[i] = format(&layouts[i]);
+                CHECK(clusters[i] != 0, "%s: cannot format", layouts[i].name);
+                if(clusters[i] == 0)
+                {
+                        continue;
+                }
+                res = run_log(&log[i]);
+                CHECK(res == FR_OK, "%s: log workload = %d", layouts[i].name, res);
+                res = run_bulk(&bulk[i]);
+                CHECK(res == FR_OK, "%s: bulk workload = %d", layouts[i].name, res);
+                printf("  %-26s %8lu | %8.1f %9.1f %9.2f | %8.1f %9.1f %9.2f\n", layouts[i].name, (unsigned long)clusters[i],
+                       log[i].erases, log[i].erased_kb, log[i].busy_s, bulk[i].erases, bulk[i].erased_kb, bulk[i].busy_s);
+        }
+
+        /* 对齐的布局不比默认布局多擦除，自动选择的簇大小不减少能放的文件数 */
+        CHECK(log[LAYOUT_FLASH].erases <= log[LAYOUT_DEFAULT].erases && bulk[LAYOUT_FLASH].erases <= bulk[LAYOUT_DEFAULT].erases,
+              "FM_FLASH erases more than the default layout");
+        CHECK(clusters[LAYOUT_FLASH] * 100 >= clusters[LAYOUT_DEFAULT] * 95, "FM_FLASH auto cluster leaves %lu clusters",
+              (unsigned long)clusters[LAYOUT_FLASH]);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
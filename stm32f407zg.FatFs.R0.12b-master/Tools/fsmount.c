@@ -0,0 +1,223 @@
+/**
+ * fsmount.c 上位机挂载测试，统计不同大小的卷挂载后第一次f_getfree()读的扇区数和所需的时间
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -I host -I ../FatFs -o fsmount fsmount.c host/host.c host/ramdisk.c ../FatFs/ff.c ../FatFs/syscall.c
+ * 用法：fsmount
+ *
+ * 每种卷在内存盘上格式化(每簇一个4KB扇区)，用f_lseek()扩展文件占用一半的簇，再重新挂载，统计：
+ * (FAT32卷的FSINFO正常时挂载后不读FAT，测试时先把其中的空闲簇数改为未知，相当于在PC上写过或异常掉电的卷)
+ *       第一次f_getfree()读的扇区数、上位机用时和按W25Q128(SPI 21MHz)读这些扇区估算的时间；
+ *       改用主循环中的f_scanfree(64)分步统计时的调用次数和每次最多读的扇区数；
+ *       再次挂载后的f_getfree()，FAT32直接使用回写的FSINFO，不再读FAT。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff.h"
+#include "ramdisk.h"
+
+#define FLASH_SPI_HZ            21000000                // 与host/w25qxx.c相同
+#define SCAN_STEP               64                      // 主循环中每次f_scanfree()检查的表项数
+#define FILE_NUM                8
+
+/* 一种卷 */
+typedef struct
+{
+        const char *name;
+        DWORD sectors;
+        BYTE opt;
+} Volume;
+
+/* 一次f_getfree()或一组f_scanfree()的统计 */
+typedef struct
+{
+        DWORD nclst;
+        DWORD reads;
+        double host_ms;
+} Scan;
+
+static FATFS fs;
+static int failures;
+static BYTE work[_MAX_SS];
+
+static const Volume volumes[] =
+{
+        { "4MB",   1024,   FM_FAT | FM_SFD },
+        { "10MB",  2560,   FM_FAT | FM_SFD },
+        { "20MB",  5120,   FM_FAT | FM_SFD },
+        { "64MB",  16384,  FM_FAT | FM_SFD },
+        { "512MB", 131072, FM_FAT32 | FM_SFD },
+};
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static double now_ms(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static DWORD reads(void)
+{
+        DWORD n;
+
+        Ramdisk_Data(0, NULL, &n, NULL);
+        return n;
+}
+
+/**
+ * @Description 按W25Q128的SPI时钟估算读count个扇区的时间，每个扇区另有4字节的命令和地址
+ */
+static double flash_ms(DWORD count)
+{
+        return count * (RAMDISK_SECTOR_SIZE + 4.0) * 8 * 1e3 / FLASH_SPI_HZ;
+}
+
+/**
+ * @Description 格式化卷，建立FILE_NUM个文件，一共占用约一半的簇
+ * @return DWORD 占用的簇数，0表示失败
+ */
+static DWORD make_volume(const Volume *v)
+{
+        FIL fil;
+        char name[16];
+        DWORD used = 0, size;
+        UINT i;
+
+        Ramdisk_Create(0, v->sectors);
+        if(f_mkfs("0:", v->opt, RAMDISK_SECTOR_SIZE, work, sizeof(work)) != FR_OK || f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                return 0;
+        }
+        size = (fs.n_fatent - 2) / 2 / FILE_NUM * fs.csize * RAMDISK_SECTOR_SIZE;
+        for(i = 0; i < FILE_NUM; i++)
+        {
+                sprintf(name, "0:F%u.BIN", i);
+                if(f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK || f_lseek(&fil, size) != FR_OK ||
+                   f_tell(&fil) != size || f_close(&fil) != FR_OK)
+                {
+                        return 0;
+                }
+                used += size / (fs.csize * RAMDISK_SECTOR_SIZE);
+        }
+        return (fs.fs_type == FS_FAT32) ? used + 1 : used;     // FAT32的根目录占用一个簇
+}
+
+/**
+ * @Description 把FAT32卷FSINFO中的空闲簇数改为未知，挂载后要重新统计，在卸载前调用(卸载后fs.fs_type为0)
+ */
+static void invalidate_fsinfo(void)
+{
+        BYTE *data = Ramdisk_Data(0, NULL, NULL, NULL);
+
+        if(fs.fs_type == FS_FAT32)
+        {
+                memset(data + (fs.volbase + fs.fsi_ofs) * RAMDISK_SECTOR_SIZE + 488, 0xFF, 4);     // FSI_Free_Count
+        }
+}
+
+/**
+ * @Description 重新挂载卷，f_mount()立即挂载，不计入统计
+ */
+static int remount(void)
+{
+        f_mount(NULL, "0:", 0);
+        return f_mount(&fs, "0:", 1) == FR_OK;
+}
+
+/**
+ * @Description 挂载后第一次f_getfree()
+ */
+static int getfree(Scan *s)
+{
+        FATFS *pfs;
+        DWORD r = reads();
+        double t = now_ms();
+        FRESULT res;
+
+        res = f_getfree("0:", &s->nclst, &pfs);
+        s->host_ms = now_ms() - t;
+        s->reads = reads() - r;
+        return res == FR_OK;
+}
+
+/**
+ * @Description 用f_scanfree(SCAN_STEP)分步统计，返回调用次数，max_reads为一次调用最多读的扇区数
+ */
+static DWORD scanfree(Scan *s, DWORD *max_reads)
+{
+        DWORD steps = 0, r0 = reads(), r;
+        double t = now_ms();
+
+        *max_reads = 0;
+        do
+        {
+                r = reads();
+                if(f_scanfree("0:", SCAN_STEP, &s->nclst) != FR_OK)
+                {
+                        return 0;
+                }
+                r = reads() - r;
+                *max_reads = (r > *max_reads) ? r : *max_reads;
+                steps++;
+        } while(s->nclst == 0xFFFFFFFF);
+        s->host_ms = now_ms() - t;
+        s->reads = reads() - r0;
+        return steps;
+}
+
+int main(int argc, char *argv[])
+{
+        static const char *types[] = { "", "FAT12", "FAT16", "FAT32", "exFAT" };
+        Scan first, step, again;
+        DWORD used, steps, max_reads, nfree;
+        UINT i;
+
+        printf("fsmount: first f_getfree() after f_mount(), 4KB sectors, flash time at %u MHz SPI\n", FLASH_SPI_HZ / 1000000);
+        printf("  %-6s %-5s %8s | %-27s | %-24s | %-16s\n", "volume", "type", "clusters", "first f_getfree()",
+               "f_scanfree(64) steps", "second mount");
+        printf("  %-6s %-5s %8s | %6s %9s %9s | %6s %7s %9s | %6s %9s\n", "", "", "", "reads", "flash ms", "host ms",
+               "calls", "reads", "max/call", "reads", "flash ms");
+        for(i = 0; i < sizeof(volumes) / sizeof(volumes[0]); i++)
+        {
+                used = make_volume(&volumes[i]);
+                CHECK(used != 0, "%s: cannot make volume", volumes[i].name);
+                if(used == 0)
+                {
+                        continue;
+                }
+                nfree = fs.n_fatent - 2 - used;
+
+                invalidate_fsinfo();
+                CHECK(remount() && getfree(&first), "%s: f_getfree failed", volumes[i].name);
+                CHECK(first.nclst == nfree, "%s: f_getfree = %lu, expected %lu", volumes[i].name,
+                      (unsigned long)first.nclst, (unsigned long)nfree);
+
+                invalidate_fsinfo();
+                CHECK(remount(), "%s: remount failed", volumes[i].name);
+                steps = scanfree(&step, &max_reads);
+                CHECK(steps != 0 && step.nclst == nfree, "%s: f_scanfree = %lu", volumes[i].name, (unsigned long)step.nclst);
+
+                CHECK(remount() && getfree(&again), "%s: f_getfree failed", volumes[i].name);
+                CHECK(again.nclst == nfree, "%s: second f_getfree = %lu", volumes[i].name, (unsigned long)again.nclst);
+                if(fs.fs_type == FS_FAT32)
+                {
+                        /* FSINFO在统计完成后已经回写，再次挂载后不读FAT */
+                        CHECK(again.reads == 0, "%s: second f_getfree read %lu sectors", volumes[i].name, (unsigned long)again.reads);
+                }
+
+                printf("  %-6s %-5s %8lu | %6lu %9.1f %9.3f | %6lu %7lu %9lu | %6lu %9.1f\n", volumes[i].name,
+                       types[fs.fs_type], (unsigned long)(fs.n_fatent - 2), (unsigned long)first.reads, flash_ms(first.reads),
+                       first.host_ms, (unsigned long)steps, (unsigned long)step.reads, (unsigned long)max_reads,
+                       (unsigned long)again.reads, flash_ms(again.reads));
+                f_mount(NULL, "0:", 0);
+        }
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+/**
+ * fsstress.c 上位机FatFs可重入测试，多个线程同时在内存磁盘上读写文件，检查数据和卷的一致性，并测量锁的开销
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -I host -I ../FatFs -o fsstress fsstress.c host/host.c host/ramdisk.c ../FatFs/ff.c ../FatFs/syscall.c
+ * 用法：fsstress [每个线程的操作次数]
+ *
+ * 使用FatFs/ffconf.h中的配置(_FS_REENTRANT、_FS_LOCK)和FatFs/syscall.c中的锁，每个线程相当于一个任务，
+ * ff_yield()重新实现为短暂睡眠，相当于能切换任务的调度器。
+ * 第一轮每个卷一个线程，相当于日志任务和文件服务任务在不同的卷上同时运行；第二轮所有线程在同一个卷上。
+ * 每个线程反复创建、追加、读出校验和删除自己的文件，磁盘读写带有模拟的访问时间，结束后用f_check()检查每个卷，
+ * 并输出无竞争时一次加锁解锁的耗时、每次API调用的耗时和发生竞争的次数。
+ * 上位机的原子操作比Cortex-M4的LDREX/STREX慢，锁的耗时只用于比较修改前后的变化。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "ff.h"
+#include "ramdisk.h"
+
+#define THREAD_NUM              4                       // 线程数，每个线程同时最多打开一个文件，不超过_FS_LOCK
+#define VOLUME_SECTORS          512                     // 每个卷2MB
+#define FILE_MAX                16                      // 每个线程最多同时存在的文件数
+#define FILE_SIZE_MAX           20000
+#define READ_US                 20                      // 每次读扇区的耗时，持锁等待IO时其他线程才有机会竞争
+#define WRITE_US                100                     // 每次写扇区的耗时
+#define YIELD_US                50                      // 每次让出CPU的时间
+
+typedef struct
+{
+        int id;
+        int vol;
+        int ops;
+        unsigned rand;
+        unsigned errors;
+        unsigned calls;                                 // FatFs函数调用次数
+        DWORD size[FILE_MAX];                           // 每个文件的大小，0表示不存在
+        DWORD seed[FILE_MAX];                           // 每个文件内容的种子
+        DWORD log;                                      // 日志文件的长度
+} Worker;
+
+static FATFS fs[_VOLUMES];
+
+/**
+ * @Description 等锁时让出CPU，代替syscall.c中的默认实现
+ * @notice      睡眠YIELD_US相当于调度器运行一轮其他任务，_FS_TIMEOUT次让出的总时间要大于持锁期间的磁盘IO时间
+ */
+int ff_yield(void)
+{
+        struct timespec ts = { 0, YIELD_US * 1000 };
+
+        nanosleep(&ts, NULL);
+        return 1;
+}
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned next_rand(Worker *w)
+{
+        w->rand = w->rand * 1103515245 + 12345;
+        return w->rand >> 8;
+}
+
+static BYTE pattern(DWORD seed, DWORD i)
+{
+        return (BYTE)(seed * 131 + i * 7 + (i >> 8));
+}
+
+static void check(Worker *w, FRESULT res, const char *what, int index)
+{
+        w->calls++;
+        if(res != FR_OK)
+        {
+                if(w->errors++ < 10)
+                {
+                        fprintf(stderr, "thread %d vol %d file %d: %s = %d\n", w->id, w->vol, index, what, res);
+                }
+        }
+}
+
+static void file_name(char *name, Worker *w, int index)
+{
+        sprintf(name, "%d:T%dF%d.BIN", w->vol, w->id, index);
+}
+
+/**
+ * @Description 写入一个新文件，分几次写入，每次写入的长度随机
+ */
+static void write_file(Worker *w, int index)
+{
+        static __thread BYTE buf[FILE_SIZE_MAX];
+        char name[20];
+        FIL fil;
+        UINT bw, n;
+        DWORD size = 1 + next_rand(w) % FILE_SIZE_MAX, pos, i;
+        FRESULT res;
+
+        file_name(name, w, index);
+        w->seed[index] = next_rand(w);
+        for(i = 0; i < size; i++)
+        {
+                buf[i] = pattern(w->seed[index], i);
+        }
+
+        res = f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE);
+        check(w, res, "f_open(write)", index);
+        if(res != FR_OK)
+        {
+                w->size[index] = 0;
+                return;
+        }
+        for(pos = 0; pos < size; pos += n)
+        {
+                n = 1 + next_rand(w) % 5000;
+                if(n > size - pos)
+                {
+                        n = size - pos;
+                }
+                res = f_write(&fil, buf + pos, n, &bw);
+                check(w, res, "f_write", index);
+                if(res != FR_OK || bw != n)
+                {
+                        break;
+                }
+        }
+        check(w, f_close(&fil), "f_close", index);
+        w->size[index] = (pos >= size) ? size : 0;
+}
+
+/**
+ * @Description 读出文件并校验内容
+ */
+static void verify_file(Worker *w, int index)
+{
+        static __thread BYTE buf[FILE_SIZE_MAX];
+        char name[20];
+        FIL fil;
+        UINT br;
+        DWORD i;
+        FRESULT res;
+
+        file_name(name, w, index);
+        res = f_open(&fil, name, FA_READ);
+        check(w, res, "f_open(read)", index);
+        if(res != FR_OK)
+        {
+                return;
+        }
+        res = f_read(&fil, buf, sizeof(buf), &br);
+        check(w, res, "f_read", index);
+        check(w, f_close(&fil), "f_close", index);
+
+        if(res == FR_OK && br != w->size[index])
+        {
+                check(w, FR_INT_ERR, "size", index);
+                return;
+        }
+        for(i = 0; res == FR_OK && i < br; i++)
+        {
+                if(buf[i] != pattern(w->seed[index], i))
+                {
+                        check(w, FR_INT_ERR, "data", index);
+                        return;
+                }
+        }
+}
+
+/**
+ * @Description 在日志文件末尾追加一行
+ */
+static void append_log(Worker *w)
+{
+        char name[20], line[48];
+        FIL fil;
+        UINT bw;
+        int n;
+        FRESULT res;
+
+        sprintf(name, "%d:LOG%d.TXT", w->vol, w->id);
+        res = f_open(&fil, name, FA_OPEN_APPEND | FA_WRITE);
+        check(w, res, "f_open(log)", -1);
+        if(res != FR_OK)
+        {
+                return;
+        }
+        n = sprintf(line, "thread %d log record %lu\r\n", w->id, (unsigned long)w->log);
+        check(w, f_write(&fil, line, n, &bw), "f_write(log)", -1);
+        if(f_size(&fil) != w->log + n)
+        {
+                check(w, FR_INT_ERR, "log size", -1);
+        }
+        w->log += n;
+        check(w, f_close(&fil), "f_close(log)", -1);
+}
+
+static void *worker_run(void *arg)
+{
+        Worker *w = arg;
+        char name[20];
+        DWORD nclst;
+        FILINFO fno;
+        int k, index;
+
+        for(k = 0; k < w->ops; k++)
+        {
+                index = next_rand(w) % FILE_MAX;
+                switch(next_rand(w) % 6)
+                {
+                case 0:
+                case 1:
+                        write_file(w, index);
+                        break;
+                case 2:
+                        if(w->size[index] != 0)
+                        {
+                                verify_file(w, index);
+                        }
+                        break;
+                case 3:
+                        append_log(w);
+                        break;
+                case 4:
+                        if(w->size[index] != 0)
+                        {
+                                file_name(name, w, index);
+                                check(w, f_stat(name, &fno), "f_stat", index);
+                                if(fno.fsize != w->size[index])
+                                {
+                                        check(w, FR_INT_ERR, "f_stat size", index);
+                                }
+                                check(w, f_unlink(name), "f_unlink", index);
+                                w->size[index] = 0;
+                        }
+                        break;
+                default:
+                        sprintf(name, "%d:", w->vol);
+                        check(w, f_scanfree(name, 64, &nclst), "f_scanfree", -1);
+                        break;
+                }
+        }
+
+        /* 最后校验还存在的文件 */
+        for(index = 0; index < FILE_MAX; index++)
+        {
+                if(w->size[index] != 0)
+                {
+                        verify_file(w, index);
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * @Description 运行一轮测试
+ * @param shared 1:所有线程在卷0上 0:每个线程一个卷
+ */
+static unsigned run(int shared, int ops)
+{
+        static Worker workers[THREAD_NUM];
+        pthread_t threads[THREAD_NUM];
+        unsigned errors = 0, calls = 0, waits = 0;
+        double start, time;
+        int i;
+
+        for(i = 0; i < _VOLUMES; i++)
+        {
+                fs[i].sobj->wait = 0;
+        }
+
+        memset(workers, 0, sizeof(workers));
+        start = now_ns();
+        for(i = 0; i < THREAD_NUM; i++)
+        {
+                workers[i].id = i + (shared ? THREAD_NUM : 0);
+                workers[i].vol = shared ? 0 : i % _VOLUMES;
+                workers[i].ops = ops;
+                workers[i].rand = 1 + i * 7919 + shared;
+                pthread_create(&threads[i], NULL, worker_run, &workers[i]);
+        }
+        for(i = 0; i < THREAD_NUM; i++)
+        {
+                pthread_join(threads[i], NULL);
+                errors += workers[i].errors;
+                calls += workers[i].calls;
+        }
+        time = now_ns() - start;
+
+        for(i = 0; i < _VOLUMES; i++)
+        {
+                waits += fs[i].sobj->wait;
+        }
+
+        printf("%-16s %d threads, %u calls, %.1f us/call, %u contended, %u errors\n", shared ? "shared volume:" : "separate volumes:",
+               THREAD_NUM, calls, time / 1000 / calls, waits, errors);
+        return errors;
+}
+
+/**
+ * @Description 用f_check()检查所有卷
+ */
+static unsigned check_volumes(void)
+{
+        static DWORD work[8192];
+        CHKINFO ci;
+        char path[4];
+        unsigned errors = 0;
+        FRESULT res;
+        int i;
+
+        for(i = 0; i < _VOLUMES; i++)
+        {
+                sprintf(path, "%d:", i);
+                memset(&ci, 0, sizeof(ci));
+                res = f_check(path, 0, work, sizeof(work), &ci);
+                if(res != FR_OK || ci.n_lost || ci.n_xlink || ci.n_size || ci.n_broken || ci.n_orphan)
+                {
+                        printf("volume %d: f_check = %d, lost %lu, xlink %lu, size %lu, broken %lu, orphan %lu\n", i, res,
+                               (unsigned long)ci.n_lost, (unsigned long)ci.n_xlink, (unsigned long)ci.n_size,
+                               (unsigned long)ci.n_broken, (unsigned long)ci.n_orphan);
+                        errors++;
+                }
+        }
+        return errors;
+}
+
+/**
+ * @Description 测量锁的开销：无竞争时一次加锁解锁的耗时，和一次读取缓存中数据的API调用的耗时
+ */
+static void measure_lock(void)
+{
+        static BYTE buf[16];
+        const int loops = 1000000;
+        FIL fil;
+        UINT n;
+        double start, lock, call;
+        int i;
+
+        start = now_ns();
+        for(i = 0; i < loops; i++)
+        {
+                ff_req_grant(fs[1].sobj);
+                ff_rel_grant(fs[1].sobj);
+        }
+        lock = (now_ns() - start) / loops;
+
+        f_open(&fil, "1:LOCK.BIN", FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+        f_write(&fil, buf, sizeof(buf), &n);
+        start = now_ns();
+        for(i = 0; i < loops; i++)
+        {
+                f_lseek(&fil, 0);
+                f_read(&fil, buf, sizeof(buf), &n);
+        }
+        call = (now_ns() - start) / loops / 2;
+        f_close(&fil);
+        f_unlink("1:LOCK.BIN");
+
+        printf("lock overhead:    %.1f ns per ff_req_grant/ff_rel_grant pair, %.1f ns per f_lseek/f_read call (%.0f%%)\n",
+               lock, call, lock * 100 / call);
+}
+
+/**
+ * @Description 检查文件锁：同一个文件不能同时以写方式打开两次，打开的文件不能删除
+ */
+static unsigned check_file_lock(void)
+{
+        FIL a, b;
+        unsigned errors = 0;
+
+        f_open(&a, "2:SHARE.TXT", FA_CREATE_ALWAYS | FA_WRITE);
+        if(f_open(&b, "2:SHARE.TXT", FA_WRITE) != FR_LOCKED)
+        {
+                errors++;
+        }
+        if(f_unlink("2:SHARE.TXT") != FR_LOCKED)
+        {
+                errors++;
+        }
+        f_close(&a);
+        if(f_open(&a, "2:SHARE.TXT", FA_READ) != FR_OK || f_open(&b, "2:SHARE.TXT", FA_READ) != FR_OK)
+        {
+                errors++;
+        }
+        f_close(&a);
+        f_close(&b);
+        if(f_unlink("2:SHARE.TXT") != FR_OK)
+        {
+                errors++;
+        }
+
+        printf("file lock:        %s\n", errors ? "FAILED" : "ok");
+        return errors;
+}
+
+int main(int argc, char *argv[])
+{
+        static BYTE work[RAMDISK_SECTOR_SIZE];
+        int ops = (argc > 1) ? atoi(argv[1]) : 2000;
+        unsigned errors = 0;
+        char path[4];
+        int i;
+
+        for(i = 0; i < _VOLUMES; i++)
+        {
+                sprintf(path, "%d:", i);
+                Ramdisk_Create(i, VOLUME_SECTORS);
+                if(f_mkfs(path, FM_FAT | FM_SFD, 0, work, sizeof(work)) != FR_OK || f_mount(&fs[i], path, 1) != FR_OK)
+                {
+                        printf("volume %d: format failed\n", i);
+                        return 1;
+                }
+        }
+
+        measure_lock();
+        errors += check_file_lock();
+        for(i = 0; i < _VOLUMES; i++)
+        {
+                Ramdisk_SetLatency(i, READ_US, WRITE_US);
+        }
+        errors += run(0, ops);
+        errors += run(1, ops);
+        errors += check_volumes();
+
+        printf("%s\n", errors ? "FAILED" : "passed");
+        return errors ? 1 : 0;
+}
@@ -0,0 +1,562 @@
+/**
+ * adc.c 上位机测试程序使用的ADC和定时器模型，以及它们的标准外设库函数，与Tools/host/host.c、host/periph.c一起链接
+ *
+ * 编译时包含路径中要有ADC和定时器的库头文件(如stm32f4.library.adc-master的User和Libraries/inc)。
+ * 模型模拟定时器触发的规则组扫描：ADC1的EXTSEL选择TIM2或TIM3的TRGO、定时器的主模式为更新事件时，
+ * 定时器每次更新触发一次规则组转换，规则组还在转换或OVR没有清除时到达的触发与芯片一样被忽略。
+ * 独立模式下只有ADC1转换；双重、三重规则同时模式下ADC2、ADC3与ADC1同时转换同一序号。
+ * 每个序号的转换时间为(采样时间+分辨率位数)个ADC时钟，同时转换时取各ADC中最长的采样时间；
+ * ADC时钟为APB2时钟84MHz按ADCPRE分频。温度传感器和Vrefint(通道16、17)没有置位TSVREFE时结果为0。
+ * 每个序号转换完时结果交给Host_AdcAttach()登记的DMA数据流(半字)：多重模式的DMA模式1按ADC1、ADC2、ADC3的顺序
+ * 各搬运一个，独立模式在ADC1的CR2.DMA置位时搬运ADC1的结果；循环模式下半满和全满时置位HT和TC标志。
+ * 数据流没有使能时结果留在数据寄存器中，下一个序号转换完时还没有读走就置位各ADC的OVR并停止转换，
+ * 使能了溢出中断时产生ADC中断；OVR清除后的下一次触发从第一个序号开始。DDS不模拟，DMA请求一直有效。
+ * 定时器只模拟TIM1~TIM5的向上计数时基(TIM1时钟168MHz，其余84MHz)，只有触发ADC的定时器产生更新事件(置位UIF，不产生中断)；
+ * 修改自动重装载值时计数器按新的周期取模，不模拟先计数到最大值再回到0。
+ */
+
+#include <string.h>
+#include "adc.h"
+
+#define ADC_SR_OVR              0x00000020
+#define ADC_CR1_SCAN            0x00000100
+#define ADC_CR1_RES             0x03000000
+#define ADC_CR1_OVRIE           0x04000000
+#define ADC_CR2_ADON            0x00000001
+#define ADC_CR2_DMA             0x00000100
+#define ADC_CR2_EXTSEL          0x0F000000
+#define ADC_CR2_EXTEN           0x30000000
+#define ADC_CCR_MULTI           0x0000001F
+#define ADC_CCR_DMA             0x0000C000
+#define ADC_CCR_DDS             0x00002000
+#define ADC_CCR_ADCPRE          0x00030000
+#define ADC_CCR_TSVREFE         0x00800000
+#define ADC_CR1_CLEAR_MASK      0xFCFFFEFF              // 与库函数相同
+#define ADC_CR2_CLEAR_MASK      0xC0FFF7FD
+#define ADC_SQR1_L_RESET        0xFF0FFFFF
+#define ADC_CCR_CLEAR_MASK      0xFFFC30E0
+#define ADC_APB2_HZ             84000000
+#define TIM_CR1_CEN             0x0001
+#define TIM_CR1_MODE            0x0370                  // DIR、CMS、CKD
+#define TIM_CR2_MMS             0x0070
+#define TIM_SR_UIF              0x0001
+#define DMA_SxCR_CIRC           0x0100
+
+static DMA_Stream_TypeDef *adc_stream;
+static Host_AdcInput adc_input;
+static u32 adc_dma_addr, adc_dma_size;                  // DMA的起始地址和循环的数据项数
+
+static u8 adc_busy;                                     // 正在转换规则组
+static u8 adc_rank;                                     // 正在转换的序号，从0开始
+static uint64_t adc_rank_end;                           // 这个序号转换完的时间
+static u16 adc_result[3];                               // 最近一个序号各ADC的结果
+static u8 adc_result_num;
+static u8 adc_unread;                                   // 还没有被DMA读走的结果个数
+static u32 adc_sequence;                                // 正在转换的规则组的序号
+static uint64_t adc_trigger_at = UINT64_MAX;            // 触发ADC的定时器下一次更新的时间
+
+static uint64_t tim_base[5];                            // 各定时器计数器从0开始计数的时间
+
+static HOST_AdcStatTypeDef adc_stat;
+
+/**
+ * @Description 定时器计数一次的CPU周期数
+ */
+static u32 Host_TimTickCycles(TIM_TypeDef *TIMx)
+{
+        return (TIMx == TIM1 ? 1 : HOST_CLOCK_HZ / 84000000) * ((u32)TIMx->PSC + 1);
+}
+
+static u32 Host_TimCounter(TIM_TypeDef *TIMx)
+{
+        if(!(TIMx->CR1 & TIM_CR1_CEN))
+        {
+                return TIMx->CNT;
+        }
+        return (u32)((Host_Cycles() - tim_base[TIMx - host_tim]) / Host_TimTickCycles(TIMx) % ((uint64_t)TIMx->ARR + 1));
+}
+
+/**
+ * @Description 定时器下一次更新的时间，正好在当前时间的更新还没有处理时返回当前时间
+ */
+static uint64_t Host_TimNextUpdate(TIM_TypeDef *TIMx)
+{
+        uint64_t base = tim_base[TIMx - host_tim];
+        uint64_t period = ((uint64_t)TIMx->ARR + 1) * Host_TimTickCycles(TIMx);
+        uint64_t n = (Host_Cycles() - base + period - 1) / period;
+
+        return base + (n ? n : 1) * period;
+}
+
+/**
+ * @Description ADC1选择的、正在以更新事件作为TRGO的定时器
+ * @return      没有使能外部触发或定时器没有运行时返回NULL
+ */
+static TIM_TypeDef *Host_AdcTriggerTimer(void)
+{
+        TIM_TypeDef *TIMx;
+
+        if(!(ADC1->CR2 & ADC_CR2_ADON) || !(ADC1->CR2 & ADC_CR2_EXTEN))
+        {
+                return NULL;
+        }
+        switch(ADC1->CR2 & ADC_CR2_EXTSEL)
+        {
+        case ADC_ExternalTrigConv_T2_TRGO:
+                TIMx = TIM2;
+                break;
+        case ADC_ExternalTrigConv_T3_TRGO:
+                TIMx = TIM3;
+                break;
+        default:
+                return NULL;
+        }
+        if(!(TIMx->CR1 & TIM_CR1_CEN) || (TIMx->CR2 & TIM_CR2_MMS) != TIM_TRGOSource_Update)
+        {
+                return NULL;
+        }
+        return TIMx;
+}
+
+/**
+ * @Description 同时转换的ADC个数
+ */
+static u8 Host_AdcNum(void)
+{
+        switch(ADC->CCR & ADC_CCR_MULTI)
+        {
+        case ADC_DualMode_RegSimult:
+                return 2;
+        case ADC_TripleMode_RegSimult:
+                return 3;
+        default:
+                return 1;
+        }
+}
+
+static u8 Host_AdcLength(void)
+{
+        return (ADC1->CR1 & ADC_CR1_SCAN) ? ((ADC1->SQR1 >> 20) & 0x0F) + 1 : 1;
+}
+
+/**
+ * @Description 规则组第rank个序号(从0开始)上的通道
+ */
+static u8 Host_AdcChannel(ADC_TypeDef *ADCx, u8 rank)
+{
+        if(rank < 6)
+        {
+                return (ADCx->SQR3 >> (5 * rank)) & 0x1F;
+        }
+        if(rank < 12)
+        {
+                return (ADCx->SQR2 >> (5 * (rank - 6))) & 0x1F;
+        }
+        return (ADCx->SQR1 >> (5 * (rank - 12))) & 0x1F;
+}
+
+/**
+ * @Description 转换第rank个序号的CPU周期数
+ */
+static u32 Host_AdcCycles(u8 rank)
+{
+        static const u16 sample[8] = {3, 15, 28, 56, 84, 112, 144, 480};
+        u32 smp, max = 0;
+        u8 k, channel;
+
+        for(k = 0; k < Host_AdcNum(); k++)
+        {
+                channel = Host_AdcChannel(&host_adc[k], rank);
+                smp = channel >= 10 ? host_adc[k].SMPR1 >> (3 * (channel - 10)) : host_adc[k].SMPR2 >> (3 * channel);
+                if(sample[smp & 7] > max)
+                {
+                        max = sample[smp & 7];
+                }
+        }
+        return (max + 12 - 2 * ((ADC1->CR1 & ADC_CR1_RES) >> 24)) *
+               (HOST_CLOCK_HZ / ADC_APB2_HZ) * 2 * (((ADC->CCR & ADC_CCR_ADCPRE) >> 16) + 1);
+}
+
+/**
+ * @Description 把数据寄存器中还没有读走的结果写入DMA数据流
+ */
+static void Host_AdcDmaService(void)
+{
+        DMA_Stream_TypeDef *stream = adc_stream;
+        u32 index;
+
+        while(adc_unread != 0 && stream != NULL && (stream->CR & DMA_SxCR_EN) && stream->NDTR != 0)
+        {
+                index = adc_dma_size - stream->NDTR;
+                Host_BusWriteItem(adc_dma_addr + index * 2, adc_result[adc_result_num - adc_unread], 2);
+                adc_unread--;
+                adc_stat.dma_items++;
+                if(--stream->NDTR == 0)
+                {
+                        if(stream->CR & DMA_SxCR_CIRC)
+                        {
+                                stream->NDTR = adc_dma_size;
+                        }
+                        else
+                        {
+                                stream->CR &= ~DMA_SxCR_EN;
+                        }
+                        Host_DmaSetFlag(stream, 0x20);
+                }
+                else if(stream->NDTR == adc_dma_size / 2)
+                {
+                        Host_DmaSetFlag(stream, 0x10);
+                }
+        }
+}
+
+/**
+ * @Description DMA_Cmd()使能了数据流，从存储器的起始地址开始写入
+ */
+static void Host_AdcDmaStart(DMA_Stream_TypeDef *stream)
+{
+        adc_dma_addr = stream->M0AR;
+        adc_dma_size = stream->NDTR;
+        Host_AdcDmaService();
+}
+
+/**
+ * @Description 上一个序号的结果还没有读走，置位OVR并停止转换，DMA请求被阻止
+ */
+static void Host_AdcOverrun(void)
+{
+        u8 k, irq = 0;
+
+        for(k = 0; k < Host_AdcNum(); k++)
+        {
+                host_adc[k].SR |= ADC_SR_OVR;
+                irq |= (host_adc[k].CR1 & ADC_CR1_OVRIE) != 0;
+        }
+        adc_stat.overruns++;
+        adc_busy = 0;
+        adc_unread = 0;
+        if(irq)
+        {
+                Host_IrqRaise(ADC_IRQn);
+        }
+}
+
+/**
+ * @Description 一个序号转换完，结果交给DMA，开始转换下一个序号
+ */
+static void Host_AdcRankDone(void)
+{
+        u8 shift = ((ADC1->CR1 & ADC_CR1_RES) >> 24) * 2;
+        u8 k, channel;
+        u16 value;
+
+        if(adc_unread != 0)
+        {
+                Host_AdcOverrun();
+                return;
+        }
+
+        adc_result_num = Host_AdcNum();
+        for(k = 0; k < adc_result_num; k++)
+        {
+                channel = Host_AdcChannel(&host_adc[k], adc_rank);
+                value = 0;
+                if(adc_input != NULL && (channel < ADC_Channel_16 || (ADC->CCR & ADC_CCR_TSVREFE)))
+                {
+                        value = adc_input(k + 1, adc_rank + 1, channel, adc_sequence) & 0x0FFF;
+                }
+                adc_result[k] = value >> shift;
+                host_adc[k].DR = adc_result[k];
+        }
+        ADC->CDR = adc_result[0] | (adc_result_num > 1 ? (u32)adc_result[1] << 16 : 0);
+        if(adc_result_num > 1 ? (ADC->CCR & ADC_CCR_DMA) == ADC_DMAAccessMode_1 : (ADC1->CR2 & ADC_CR2_DMA) != 0)
+        {
+                adc_unread = adc_result_num;
+                Host_AdcDmaService();
+        }
+
+        if(++adc_rank == Host_AdcLength())
+        {
+                adc_busy = 0;
+                adc_sequence++;
+                adc_stat.sequences++;
+        }
+        else
+        {
+                adc_rank_end += Host_AdcCycles(adc_rank);
+        }
+}
+
+/**
+ * @Description 定时器更新，触发一次规则组转换
+ */
+static void Host_AdcTrigger(void)
+{
+        TIM_TypeDef *TIMx = Host_AdcTriggerTimer();
+        u8 k;
+
+        tim_base[TIMx - host_tim] = Host_Cycles();
+        TIMx->SR |= TIM_SR_UIF;
+        adc_stat.triggers++;
+
+        for(k = 0; k < Host_AdcNum(); k++)
+        {
+                if(host_adc[k].SR & ADC_SR_OVR)
+                {
+                        adc_stat.ovr_ignored++;
+                        return;
+                }
+        }
+        if(adc_busy)
+        {
+                adc_stat.busy_ignored++;
+                return;
+        }
+        adc_busy = 1;
+        adc_rank = 0;
+        adc_rank_end = Host_Cycles() + Host_AdcCycles(0);
+}
+
+static uint64_t Host_AdcNext(void)
+{
+        TIM_TypeDef *TIMx = Host_AdcTriggerTimer();
+        uint64_t next = adc_busy ? adc_rank_end : UINT64_MAX;
+
+        adc_trigger_at = TIMx != NULL ? Host_TimNextUpdate(TIMx) : UINT64_MAX;
+        return adc_trigger_at < next ? adc_trigger_at : next;
+}
+
+static void Host_AdcEvent(void)
+{
+        uint64_t now = Host_Cycles();
+
+        if(adc_busy && now >= adc_rank_end)
+        {
+                Host_AdcRankDone();
+        }
+        /* 转换完时的DMA中断可能修改了定时器，重新判断更新是否正好在现在 */
+        if(now >= adc_trigger_at && Host_AdcTriggerTimer() != NULL && Host_TimNextUpdate(Host_AdcTriggerTimer()) == now)
+        {
+                Host_AdcTrigger();
+        }
+}
+
+/**
+ * @Description 登记ADC的DMA数据流和模拟输入
+ */
+void Host_AdcAttach(DMA_Stream_TypeDef *stream, Host_AdcInput input)
+{
+        static u8 added = 0;
+
+        adc_stream = stream;
+        adc_input = input;
+        if(stream != NULL)
+        {
+                Host_SetDmaRequest(stream, Host_AdcDmaStart);
+        }
+        if(!added)
+        {
+                Host_AddClockDevice(Host_AdcNext, Host_AdcEvent);
+                added = 1;
+        }
+}
+
+u32 Host_AdcRankCycles(void)
+{
+        return Host_AdcCycles(0);
+}
+
+void Host_AdcStat(HOST_AdcStatTypeDef *stat, u8 reset)
+{
+        if(stat != NULL)
+        {
+                *stat = adc_stat;
+        }
+        if(reset)
+        {
+                memset(&adc_stat, 0, sizeof(adc_stat));
+        }
+}
+
+/* 标准外设库函数 */
+void RCC_APB2PeriphResetCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+        if((RCC_APB2Periph & RCC_APB2Periph_ADC) && NewState != DISABLE)
+        {
+                memset(host_adc, 0, sizeof(host_adc));
+                memset(&host_adc_common, 0, sizeof(host_adc_common));
+                adc_busy = 0;
+                adc_unread = 0;
+        }
+}
+
+void ADC_CommonInit(ADC_CommonInitTypeDef *ADC_CommonInitStruct)
+{
+        ADC->CCR = (ADC->CCR & ADC_CCR_CLEAR_MASK) | ADC_CommonInitStruct->ADC_Mode | ADC_CommonInitStruct->ADC_Prescaler |
+                   ADC_CommonInitStruct->ADC_DMAAccessMode | ADC_CommonInitStruct->ADC_TwoSamplingDelay;
+}
+
+void ADC_Init(ADC_TypeDef *ADCx, ADC_InitTypeDef *ADC_InitStruct)
+{
+        ADCx->CR1 = (ADCx->CR1 & ADC_CR1_CLEAR_MASK) | ((u32)ADC_InitStruct->ADC_ScanConvMode << 8) |
+                    ADC_InitStruct->ADC_Resolution;
+        ADCx->CR2 = (ADCx->CR2 & ADC_CR2_CLEAR_MASK) | ADC_InitStruct->ADC_DataAlign | ADC_InitStruct->ADC_ExternalTrigConv |
+                    ADC_InitStruct->ADC_ExternalTrigConvEdge | ((u32)ADC_InitStruct->ADC_ContinuousConvMode << 1);
+        ADCx->SQR1 = (ADCx->SQR1 & ADC_SQR1_L_RESET) | ((u32)(u8)(ADC_InitStruct->ADC_NbrOfConversion - 1) << 20);
+}
+
+void ADC_Cmd(ADC_TypeDef *ADCx, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                ADCx->CR2 |= ADC_CR2_ADON;
+        }
+        else
+        {
+                ADCx->CR2 &= ~ADC_CR2_ADON;
+        }
+}
+
+void ADC_RegularChannelConfig(ADC_TypeDef *ADCx, uint8_t ADC_Channel, uint8_t Rank, uint8_t ADC_SampleTime)
+{
+        if(ADC_Channel > ADC_Channel_9)
+        {
+                ADCx->SMPR1 = (ADCx->SMPR1 & ~(7u << (3 * (ADC_Channel - 10)))) | ((u32)ADC_SampleTime << (3 * (ADC_Channel - 10)));
+        }
+        else
+        {
+                ADCx->SMPR2 = (ADCx->SMPR2 & ~(7u << (3 * ADC_Channel))) | ((u32)ADC_SampleTime << (3 * ADC_Channel));
+        }
+        if(Rank < 7)
+        {
+                ADCx->SQR3 = (ADCx->SQR3 & ~(0x1Fu << (5 * (Rank - 1)))) | ((u32)ADC_Channel << (5 * (Rank - 1)));
+        }
+        else if(Rank < 13)
+        {
+                ADCx->SQR2 = (ADCx->SQR2 & ~(0x1Fu << (5 * (Rank - 7)))) | ((u32)ADC_Channel << (5 * (Rank - 7)));
+        }
+        else
+        {
+                ADCx->SQR1 = (ADCx->SQR1 & ~(0x1Fu << (5 * (Rank - 13)))) | ((u32)ADC_Channel << (5 * (Rank - 13)));
+        }
+}
+
+void ADC_TempSensorVrefintCmd(FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                ADC->CCR |= ADC_CCR_TSVREFE;
+        }
+        else
+        {
+                ADC->CCR &= ~ADC_CCR_TSVREFE;
+        }
+}
+
+void ADC_DMACmd(ADC_TypeDef *ADCx, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                ADCx->CR2 |= ADC_CR2_DMA;
+        }
+        else
+        {
+                ADCx->CR2 &= ~ADC_CR2_DMA;
+        }
+}
+
+void ADC_MultiModeDMARequestAfterLastTransferCmd(FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                ADC->CCR |= ADC_CCR_DDS;
+        }
+        else
+        {
+                ADC->CCR &= ~ADC_CCR_DDS;
+        }
+}
+
+void ADC_ITConfig(ADC_TypeDef *ADCx, uint16_t ADC_IT, FunctionalState NewState)
+{
+        u32 itmask = 1u << (u8)ADC_IT;
+
+        if(NewState != DISABLE)
+        {
+                ADCx->CR1 |= itmask;
+        }
+        else
+        {
+                ADCx->CR1 &= ~itmask;
+        }
+}
+
+FlagStatus ADC_GetFlagStatus(ADC_TypeDef *ADCx, uint8_t ADC_FLAG)
+{
+        return (ADCx->SR & ADC_FLAG) ? SET : RESET;
+}
+
+void ADC_ClearFlag(ADC_TypeDef *ADCx, uint8_t ADC_FLAG)
+{
+        ADCx->SR &= ~(u32)ADC_FLAG;
+}
+
+ITStatus ADC_GetITStatus(ADC_TypeDef *ADCx, uint16_t ADC_IT)
+{
+        return ((ADCx->SR & (ADC_IT >> 8)) && (ADCx->CR1 & (1u << (u8)ADC_IT))) ? SET : RESET;
+}
+
+void ADC_ClearITPendingBit(ADC_TypeDef *ADCx, uint16_t ADC_IT)
+{
+        ADCx->SR &= ~(u32)(u8)(ADC_IT >> 8);
+}
+
+void TIM_TimeBaseInit(TIM_TypeDef *TIMx, TIM_TimeBaseInitTypeDef *TIM_TimeBaseInitStruct)
+{
+        TIMx->CR1 = (TIMx->CR1 & ~TIM_CR1_MODE) | TIM_TimeBaseInitStruct->TIM_CounterMode |
+                    TIM_TimeBaseInitStruct->TIM_ClockDivision;
+        TIMx->ARR = TIM_TimeBaseInitStruct->TIM_Period;
+        TIMx->PSC = TIM_TimeBaseInitStruct->TIM_Prescaler;
+
+        /* 库函数产生一次更新事件，装入预分频值，计数器清零 */
+        TIMx->CNT = 0;
+        tim_base[TIMx - host_tim] = Host_Cycles();
+}
+
+void TIM_Cmd(TIM_TypeDef *TIMx, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                if(!(TIMx->CR1 & TIM_CR1_CEN))
+                {
+                        tim_base[TIMx - host_tim] = Host_Cycles() - (uint64_t)TIMx->CNT * Host_TimTickCycles(TIMx);
+                        TIMx->CR1 |= TIM_CR1_CEN;
+                }
+        }
+        else
+        {
+                TIMx->CNT = Host_TimCounter(TIMx);
+                TIMx->CR1 &= ~TIM_CR1_CEN;
+        }
+}
+
+void TIM_SetAutoreload(TIM_TypeDef *TIMx, uint32_t Autoreload)
+{
+        TIMx->ARR = Autoreload;
+}
+
+void TIM_SetCounter(TIM_TypeDef *TIMx, uint32_t Counter)
+{
+        TIMx->CNT = Counter;
+        tim_base[TIMx - host_tim] = Host_Cycles() - (uint64_t)Counter * Host_TimTickCycles(TIMx);
+}
+
+uint32_t TIM_GetCounter(TIM_TypeDef *TIMx)
+{
+        return Host_TimCounter(TIMx);
+}
+
+void TIM_SelectOutputTrigger(TIM_TypeDef *TIMx, uint16_t TIM_TRGOSource)
+{
+        TIMx->CR2 = (TIMx->CR2 & ~TIM_CR2_MMS) | TIM_TRGOSource;
+}
@@ -0,0 +1,27 @@
+#ifndef __HOST_ADC_H
+#define __HOST_ADC_H
+
+#include "stm32f4xx.h"
+
+/* ADC模型的统计 */
+typedef struct
+{
+        u32 triggers;                                   // 定时器TRGO触发的次数
+        u32 sequences;                                  // 转换完的规则组(帧)
+        u32 busy_ignored;                               // 上一个规则组还在转换时到达、被忽略的触发
+        u32 ovr_ignored;                                // 溢出标志没有清除时被忽略的触发
+        u32 dma_items;                                  // DMA搬运的数据项
+        u32 overruns;                                   // DMA没有读走上一个结果时的溢出
+} HOST_AdcStatTypeDef;
+
+/**
+ * 模拟输入，返回ADC编号adc(1~3)在规则组第rank(从1开始)个序号上转换通道channel的12位结果，
+ * sequence为从开始模拟起转换的规则组的序号
+ */
+typedef u16 (*Host_AdcInput)(u8 adc, u8 rank, u8 channel, u32 sequence);
+
+void Host_AdcAttach(DMA_Stream_TypeDef *stream, Host_AdcInput input);
+u32 Host_AdcRankCycles(void);                           // 当前配置下转换规则组一个序号的CPU周期数
+void Host_AdcStat(HOST_AdcStatTypeDef *stat, u8 reset);
+
+#endif /* __HOST_ADC_H */
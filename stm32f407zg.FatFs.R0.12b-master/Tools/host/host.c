@@ -0,0 +1,508 @@
+/**
+ * host.c 上位机测试程序的内核模型，与Tools/host/stm32f4xx.h一起代替芯片运行驱动代码
+ *
+ * 中断模型：外设模型调用Host_IrqRaise()挂起中断，开中断、中断已使能并且优先级高于正在执行的中断时，
+ * 在调用者的线程中直接执行中断服务函数；关中断期间挂起的中断在__enable_irq()时执行。
+ * 没有被测试程序定义的中断服务函数使用这里的空函数。
+ *
+ * 模拟时间：登记了时钟设备(串口等外设模型)的程序用Host_Run()推进时间，外设事件按时间顺序处理。
+ * 线程模式下开中断时时间前进HOST_IRQ_ENABLE_CYCLES个周期，相当于开关中断之间的几条指令，
+ * 驱动中开关中断等待外设的循环(如发送缓冲满时的Usart_Write())才能等到外设完成。
+ * SysTick_Config()把滴答定时器登记为时钟设备；编译驱动时把SYSTICK_CYCCNT()定义为Host_Cyccnt()，
+ * 每次读周期计数器时间前进HOST_CYCCNT_CYCLES个周期，查询时间的循环(如millis()、delay_us())也能等到时间到达。
+ * 调度器等没有事可做的空闲循环调用Host_Wfi()，时间直接前进到下一个外设事件。
+ */
+
+#include <stddef.h>
+#include <sys/mman.h>
+#include "stm32f4xx.h"
+
+__thread u32 host_primask = 0;
+__thread u32 host_ipsr = 0;
+__thread u32 host_excl_value = 0;
+
+DMA_Stream_TypeDef host_dma_stream[16];
+DMA_TypeDef host_dma[2];
+GPIO_TypeDef host_gpio[9];
+SPI_TypeDef host_spi[3];
+USART_TypeDef host_usart[6];
+ADC_TypeDef host_adc[3];
+ADC_Common_TypeDef host_adc_common;
+TIM_TypeDef host_tim[5];
+DWT_Type host_dwt;
+CoreDebug_Type host_coredebug;
+uint32_t SystemCoreClock = HOST_CLOCK_HZ;
+
+/* 芯片上的存储区，驱动用固定地址访问，在同样的地址映射内存 */
+#define HOST_FSMC_SRAM_ADDR     0x68000000              // FSMC Bank1.sector3外部SRAM，1MB
+#define HOST_FSMC_SRAM_SIZE     0x00100000
+#define HOST_BITBAND_ADDR       0x42400000              // AHB1上GPIO寄存器的位带别名区
+#define HOST_BITBAND_SIZE       0x00048000
+
+/* 外部总线上的设备 */
+#define HOST_BUS_DEVICE_MAX     4
+
+typedef struct
+{
+        u32 base;
+        u32 size;
+        Host_BusWrite write;
+        Host_BusRead read;
+} HOST_BusDevice;
+
+static HOST_BusDevice host_bus[HOST_BUS_DEVICE_MAX];
+
+/* 外设请求的DMA数据流 */
+static Host_DmaStart host_dma_request[16];
+
+/* 模拟时间 */
+#define HOST_CLOCK_DEVICE_MAX   8
+#define HOST_IRQ_ENABLE_CYCLES  8
+#define HOST_CYCCNT_CYCLES      32                      // 一次查询时间的循环：读计数器、64位扩展、比较
+
+typedef struct
+{
+        Host_ClockNext next;
+        Host_ClockEvent event;
+} HOST_ClockDevice;
+
+static HOST_ClockDevice host_clock[HOST_CLOCK_DEVICE_MAX];
+static int host_clock_num = 0;
+static uint64_t host_cycles = 0;
+static u8 host_running = 0;                             // 正在处理事件，事件中产生的中断不能再推进时间
+static u32 host_systick_load = 0;                       // 滴答定时器的周期，0表示没有启动
+static uint64_t host_systick_next;
+
+/* 中断控制器 */
+#define HOST_VECTOR(irq)        ((irq) + 1)             // 向量表下标，0是SysTick
+
+static volatile u8 host_irq_pending[HOST_IRQ_NUM + 1];
+static u8 host_irq_enable[HOST_IRQ_NUM + 1];
+static u8 host_irq_priority[HOST_IRQ_NUM + 1];
+static __thread int host_irq_level = 0x100;             // 正在执行的中断的优先级，0x100表示线程模式
+static u32 host_irq_taken = 0;                          // 执行过的中断次数，Host_Wfi()用来判断是否被唤醒
+
+__weak void SysTick_Handler(void) { }
+__weak void EXTI0_IRQHandler(void) { }
+__weak void EXTI1_IRQHandler(void) { }
+__weak void EXTI2_IRQHandler(void) { }
+__weak void EXTI3_IRQHandler(void) { }
+__weak void EXTI4_IRQHandler(void) { }
+__weak void DMA1_Stream0_IRQHandler(void) { }
+__weak void DMA1_Stream1_IRQHandler(void) { }
+__weak void DMA1_Stream2_IRQHandler(void) { }
+__weak void DMA1_Stream3_IRQHandler(void) { }
+__weak void DMA1_Stream4_IRQHandler(void) { }
+__weak void DMA1_Stream5_IRQHandler(void) { }
+__weak void DMA1_Stream6_IRQHandler(void) { }
+__weak void DMA1_Stream7_IRQHandler(void) { }
+__weak void ADC_IRQHandler(void) { }
+__weak void TIM2_IRQHandler(void) { }
+__weak void TIM3_IRQHandler(void) { }
+__weak void TIM4_IRQHandler(void) { }
+__weak void SPI1_IRQHandler(void) { }
+__weak void USART1_IRQHandler(void) { }
+__weak void USART2_IRQHandler(void) { }
+__weak void USART3_IRQHandler(void) { }
+__weak void DMA2_Stream0_IRQHandler(void) { }
+__weak void DMA2_Stream1_IRQHandler(void) { }
+__weak void DMA2_Stream2_IRQHandler(void) { }
+__weak void DMA2_Stream3_IRQHandler(void) { }
+__weak void DMA2_Stream4_IRQHandler(void) { }
+__weak void DMA2_Stream5_IRQHandler(void) { }
+__weak void DMA2_Stream6_IRQHandler(void) { }
+__weak void DMA2_Stream7_IRQHandler(void) { }
+__weak void USART6_IRQHandler(void) { }
+
+static void (*const host_vector[HOST_IRQ_NUM + 1])(void) =
+{
+        [HOST_VECTOR(SysTick_IRQn)] = SysTick_Handler,
+        [HOST_VECTOR(EXTI0_IRQn)] = EXTI0_IRQHandler,
+        [HOST_VECTOR(EXTI1_IRQn)] = EXTI1_IRQHandler,
+        [HOST_VECTOR(EXTI2_IRQn)] = EXTI2_IRQHandler,
+        [HOST_VECTOR(EXTI3_IRQn)] = EXTI3_IRQHandler,
+        [HOST_VECTOR(EXTI4_IRQn)] = EXTI4_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream0_IRQn)] = DMA1_Stream0_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream1_IRQn)] = DMA1_Stream1_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream2_IRQn)] = DMA1_Stream2_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream3_IRQn)] = DMA1_Stream3_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream4_IRQn)] = DMA1_Stream4_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream5_IRQn)] = DMA1_Stream5_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream6_IRQn)] = DMA1_Stream6_IRQHandler,
+        [HOST_VECTOR(DMA1_Stream7_IRQn)] = DMA1_Stream7_IRQHandler,
+        [HOST_VECTOR(ADC_IRQn)] = ADC_IRQHandler,
+        [HOST_VECTOR(TIM2_IRQn)] = TIM2_IRQHandler,
+        [HOST_VECTOR(TIM3_IRQn)] = TIM3_IRQHandler,
+        [HOST_VECTOR(TIM4_IRQn)] = TIM4_IRQHandler,
+        [HOST_VECTOR(SPI1_IRQn)] = SPI1_IRQHandler,
+        [HOST_VECTOR(USART1_IRQn)] = USART1_IRQHandler,
+        [HOST_VECTOR(USART2_IRQn)] = USART2_IRQHandler,
+        [HOST_VECTOR(USART3_IRQn)] = USART3_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream0_IRQn)] = DMA2_Stream0_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream1_IRQn)] = DMA2_Stream1_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream2_IRQn)] = DMA2_Stream2_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream3_IRQn)] = DMA2_Stream3_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream4_IRQn)] = DMA2_Stream4_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream5_IRQn)] = DMA2_Stream5_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream6_IRQn)] = DMA2_Stream6_IRQHandler,
+        [HOST_VECTOR(DMA2_Stream7_IRQn)] = DMA2_Stream7_IRQHandler,
+        [HOST_VECTOR(USART6_IRQn)] = USART6_IRQHandler,
+};
+
+/**
+ * @Description 在芯片的地址上映射内存，已被占用时放弃，只有用到该区域的测试程序会出错
+ */
+__attribute__((constructor)) static void Host_MapMemory(void)
+{
+        mmap((void *)HOST_FSMC_SRAM_ADDR, HOST_FSMC_SRAM_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        mmap((void *)HOST_BITBAND_ADDR, HOST_BITBAND_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+}
+
+/**
+ * @Description 执行可以执行的挂起中断，优先级数值小的先执行，可以抢占正在执行的低优先级中断
+ */
+static void Host_IrqDispatch(void)
+{
+        int i, best, level, saved_level;
+        u32 saved_ipsr;
+
+        while(host_primask == 0)
+        {
+                best = -1;
+                level = host_irq_level;
+                for(i = 0; i <= HOST_IRQ_NUM; i++)
+                {
+                        if(host_irq_pending[i] && host_irq_enable[i] && host_irq_priority[i] < level)
+                        {
+                                best = i;
+                                level = host_irq_priority[i];
+                        }
+                }
+                if(best < 0)
+                {
+                        break;
+                }
+
+                host_irq_pending[best] = 0;
+                host_irq_taken++;
+                saved_level = host_irq_level;
+                saved_ipsr = host_ipsr;
+                host_irq_level = level;
+                host_ipsr = best + 15;                  // 异常号，外部中断从16开始
+                if(host_vector[best] != NULL)
+                {
+                        host_vector[best]();
+                }
+                host_ipsr = saved_ipsr;
+                host_irq_level = saved_level;
+        }
+}
+
+/**
+ * @Description 开中断，执行关中断期间挂起的中断
+ */
+void Host_IrqEnable(void)
+{
+        host_primask = 0;
+        Host_IrqDispatch();
+        if(host_clock_num != 0 && host_ipsr == 0)
+        {
+                Host_Run(HOST_IRQ_ENABLE_CYCLES);
+        }
+}
+
+/**
+ * @Description 关中断
+ */
+void Host_IrqDisable(void)
+{
+        host_primask = 1;
+}
+
+/**
+ * @Description 设置中断的优先级和使能状态，由NVIC_Init()和NVIC_EnableIRQ()调用
+ * @param priority 抢占优先级和子优先级合成的优先级，数值小的优先
+ */
+void Host_IrqConfig(IRQn_Type irq, u8 priority, u8 enable)
+{
+        host_irq_priority[HOST_VECTOR(irq)] = priority;
+        host_irq_enable[HOST_VECTOR(irq)] = enable;
+}
+
+/**
+ * @Description 使能或禁止中断，由NVIC_EnableIRQ()和NVIC_DisableIRQ()调用，使能时执行已经挂起的中断
+ */
+void Host_IrqSetEnable(IRQn_Type irq, u8 enable)
+{
+        host_irq_enable[HOST_VECTOR(irq)] = enable;
+        if(enable)
+        {
+                Host_IrqDispatch();
+        }
+}
+
+/**
+ * @Description 外设产生中断
+ */
+void Host_IrqRaise(IRQn_Type irq)
+{
+        host_irq_pending[HOST_VECTOR(irq)] = 1;
+        Host_IrqDispatch();
+}
+
+/**
+ * @Description 登记外部总线上的设备，DMA的目标地址落在[base, base+size)内时由设备模型处理读写
+ */
+void Host_SetBusDevice(u32 base, u32 size, Host_BusWrite write, Host_BusRead read)
+{
+        int i;
+
+        for(i = 0; i < HOST_BUS_DEVICE_MAX; i++)
+        {
+                if(host_bus[i].size == 0 || host_bus[i].base == base)
+                {
+                        host_bus[i].base = base;
+                        host_bus[i].size = size;
+                        host_bus[i].write = write;
+                        host_bus[i].read = read;
+                        return;
+                }
+        }
+}
+
+/**
+ * @Description 按地址写一个数据项，地址属于总线设备时交给设备模型，否则写内存
+ * @param size  数据项字节数 1/2/4
+ */
+void Host_BusWriteItem(u32 addr, u32 data, u8 size)
+{
+        int i;
+
+        for(i = 0; i < HOST_BUS_DEVICE_MAX; i++)
+        {
+                if(host_bus[i].size != 0 && addr - host_bus[i].base < host_bus[i].size)
+                {
+                        host_bus[i].write(addr, data);
+                        return;
+                }
+        }
+        if(size == 1)
+        {
+                *(volatile u8 *)(uintptr_t)addr = (u8)data;
+        }
+        else if(size == 2)
+        {
+                *(volatile u16 *)(uintptr_t)addr = (u16)data;
+        }
+        else
+        {
+                *(volatile u32 *)(uintptr_t)addr = data;
+        }
+}
+
+/**
+ * @Description 按地址读一个数据项
+ */
+u32 Host_BusReadItem(u32 addr, u8 size)
+{
+        int i;
+
+        for(i = 0; i < HOST_BUS_DEVICE_MAX; i++)
+        {
+                if(host_bus[i].size != 0 && addr - host_bus[i].base < host_bus[i].size)
+                {
+                        return host_bus[i].read ? host_bus[i].read(addr) : 0;
+                }
+        }
+        if(size == 1)
+        {
+                return *(volatile u8 *)(uintptr_t)addr;
+        }
+        if(size == 2)
+        {
+                return *(volatile u16 *)(uintptr_t)addr;
+        }
+        return *(volatile u32 *)(uintptr_t)addr;
+}
+
+/**
+ * @Description 登记由外设请求的DMA数据流，数据流使能时调用start，由外设模型按自己的时序搬运数据
+ */
+void Host_SetDmaRequest(DMA_Stream_TypeDef *stream, Host_DmaStart start)
+{
+        host_dma_request[stream - host_dma_stream] = start;
+}
+
+/**
+ * @Description DMA_Cmd()使能了外设与存储器之间的数据流
+ */
+void Host_DmaEnabled(DMA_Stream_TypeDef *stream)
+{
+        Host_DmaStart start = host_dma_request[stream - host_dma_stream];
+
+        if(start != NULL)
+        {
+                start(stream);
+        }
+}
+
+/**
+ * @Description 登记时钟设备
+ */
+void Host_AddClockDevice(Host_ClockNext next, Host_ClockEvent event)
+{
+        if(host_clock_num < HOST_CLOCK_DEVICE_MAX)
+        {
+                host_clock[host_clock_num].next = next;
+                host_clock[host_clock_num].event = event;
+                host_clock_num++;
+        }
+}
+
+/**
+ * @Description 模拟时间前进cycles个周期，依次处理到期的外设事件
+ * @notice      在事件处理(包括事件产生的中断)中调用时不推进时间，直接返回
+ */
+void Host_Run(u32 cycles)
+{
+        uint64_t target, when, best;
+        int i, index;
+
+        if(host_running)
+        {
+                return;
+        }
+        host_running = 1;
+
+        target = host_cycles + cycles;
+        while(1)
+        {
+                best = UINT64_MAX;
+                index = -1;
+                for(i = 0; i < host_clock_num; i++)
+                {
+                        when = host_clock[i].next();
+                        if(when < best)
+                        {
+                                best = when;
+                                index = i;
+                        }
+                }
+                if(index < 0 || best > target)
+                {
+                        break;
+                }
+                if(best > host_cycles)
+                {
+                        host_cycles = best;
+                }
+                host_dwt.CYCCNT = (u32)host_cycles;
+
+                /* 事件中产生的中断可能调用驱动中再次开中断的函数，这时不能递归推进时间 */
+                host_clock[index].event();
+        }
+        /* 中断中延时会让时间超过target */
+        if(host_cycles < target)
+        {
+                host_cycles = target;
+        }
+        host_dwt.CYCCNT = (u32)host_cycles;
+
+        host_running = 0;
+}
+
+/**
+ * @Description 当前的模拟时间
+ */
+uint64_t Host_Cycles(void)
+{
+        return host_cycles;
+}
+
+/**
+ * @Description 读周期计数器，时间前进一次查询循环的周期数
+ * @notice      在事件产生的中断中(如中断里的delay_us())只推进时间，到期的外设事件在中断返回后处理
+ */
+u32 Host_Cyccnt(void)
+{
+        if(host_running)
+        {
+                host_cycles += HOST_CYCCNT_CYCLES;
+                host_dwt.CYCCNT = (u32)host_cycles;
+        }
+        else
+        {
+                Host_Run(HOST_CYCCNT_CYCLES);
+        }
+        return host_dwt.CYCCNT;
+}
+
+/**
+ * @Description 等待中断，模拟时间直接前进到下一个外设事件，执行了中断或有可以抢占的中断挂起(关中断时)后返回
+ * @notice      没有外设事件或在事件产生的中断中调用时立即返回
+ */
+void Host_Wfi(void)
+{
+        u32 taken = host_irq_taken;
+        uint64_t when, best;
+        int i;
+
+        while(!host_running && host_irq_taken == taken)
+        {
+                for(i = 0; i <= HOST_IRQ_NUM; i++)
+                {
+                        if(host_irq_pending[i] && host_irq_enable[i] && host_irq_priority[i] < host_irq_level)
+                        {
+                                return;
+                        }
+                }
+                best = UINT64_MAX;
+                for(i = 0; i < host_clock_num; i++)
+                {
+                        when = host_clock[i].next();
+                        if(when < best)
+                        {
+                                best = when;
+                        }
+                }
+                if(best == UINT64_MAX)
+                {
+                        return;
+                }
+                Host_Run(best > host_cycles ? (u32)(best - host_cycles < 0xFFFFFFFF ? best - host_cycles : 0xFFFFFFFF) : 0);
+        }
+}
+
+static uint64_t Host_SysTickNext(void)
+{
+        return host_systick_load ? host_systick_next : UINT64_MAX;
+}
+
+static void Host_SysTickEvent(void)
+{
+        host_systick_next += host_systick_load;
+        Host_IrqRaise(SysTick_IRQn);
+}
+
+/**
+ * @Description 启动滴答定时器，与CMSIS相同，SysTick中断为最低优先级
+ * @param ticks 中断周期，单位为CPU周期
+ * @return u32  0:成功 1:周期超出24位
+ */
+u32 SysTick_Config(u32 ticks)
+{
+        if(ticks - 1 > 0xFFFFFF)
+        {
+                return 1;
+        }
+        if(host_systick_load == 0)
+        {
+                Host_AddClockDevice(Host_SysTickNext, Host_SysTickEvent);
+        }
+        host_systick_load = ticks;
+        host_systick_next = host_cycles + ticks;
+        Host_IrqConfig(SysTick_IRQn, 0x0F, 1);
+        return 0;
+}
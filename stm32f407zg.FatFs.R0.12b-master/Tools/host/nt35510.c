@@ -0,0 +1,329 @@
+/**
+ * nt35510.c 上位机测试程序使用的NT35510模型，与Tools/host/host.c一起链接，驱动编译时包含host/nt35510.h
+ *
+ * GRAM为480*800个RGB565点，按面板的物理行列存放。命令使用16位寄存器地址，与驱动相同：
+ * 0x2A00~0x2A03/0x2B00~0x2B03设置列/行地址窗口，0x2C00从窗口左上角开始写GRAM，0x2E00开始读GRAM，
+ * 窗口内先加列地址，到达结束列后回到起始列并加行地址，与芯片一样不会写到窗口外；
+ * 0x3600的MY/MX/MV位决定逻辑坐标到物理坐标的映射，0x3300~0x3305和0x3700~0x3701设置垂直滚动。
+ * 读GRAM时第一次读是假读，之后每个点按R、G、B三个字节输出，每次读出两个字节，与芯片的16位接口相同。
+ * 其他配置寄存器只接收不处理。LCD_RAM(0x6C000080)登记为总线设备，DMA写入的点单独统计。
+ */
+
+#include <string.h>
+#include "nt35510.h"
+
+#define LCD_BUS_BASE            0x6C000000              // FSMC Bank1.sector4
+#define LCD_BUS_RAM             0x6C000080              // A6=1，数据
+#define LCD_BUS_SIZE            0x100
+
+static u16 gram[HOST_LCD_HEIGHT][HOST_LCD_WIDTH];
+
+static struct
+{
+        u16 reg;                                        // 最近一次写入的命令
+        u16 xs, xe, ys, ye;                             // 列/行地址窗口，逻辑坐标
+        u16 x, y;                                       // 读写GRAM的当前位置
+        u8 madctl;
+        u8 on;
+        u16 tfa, vsa, bfa, vsp;                         // 垂直滚动：顶部固定区、滚动区、底部固定区、滚动起始行
+        u8 rd_dummy;                                    // 下一次读GRAM是假读
+        u8 rd_fifo[4];                                  // 还没有读出的颜色字节
+        u8 rd_num;
+} lcd;
+
+static HOST_LcdStatTypeDef lcd_stat;
+
+/**
+ * @Description 把逻辑坐标转换为GRAM的物理行列，MV交换行列，MX翻转列，MY翻转行
+ * @return u16* 对应的GRAM单元，超出面板时返回NULL
+ */
+static u16 *Host_LcdCell(u16 x, u16 y)
+{
+        u16 col, row;
+
+        if(lcd.madctl & 0x20)
+        {
+                col = y;
+                row = x;
+        }
+        else
+        {
+                col = x;
+                row = y;
+        }
+        if(col >= HOST_LCD_WIDTH || row >= HOST_LCD_HEIGHT)
+        {
+                return NULL;
+        }
+        if(lcd.madctl & 0x40)
+        {
+                col = HOST_LCD_WIDTH - 1 - col;
+        }
+        if(lcd.madctl & 0x80)
+        {
+                row = HOST_LCD_HEIGHT - 1 - row;
+        }
+        return &gram[row][col];
+}
+
+/**
+ * @Description 读写GRAM后移动到窗口内的下一个位置
+ */
+static void Host_LcdAdvance(void)
+{
+        if(lcd.x >= lcd.xe)
+        {
+                lcd.x = lcd.xs;
+                lcd.y = (lcd.y >= lcd.ye) ? lcd.ys : lcd.y + 1;
+        }
+        else
+        {
+                lcd.x++;
+        }
+}
+
+static void Host_LcdCommand(u16 reg)
+{
+        lcd.reg = reg;
+        switch(reg)
+        {
+        case 0x2C00:
+        case 0x2E00:
+                lcd.x = lcd.xs;
+                lcd.y = lcd.ys;
+                lcd.rd_dummy = 1;
+                lcd.rd_num = 0;
+                break;
+        case 0x2800:
+                lcd.on = 0;
+                break;
+        case 0x2900:
+                lcd.on = 1;
+                break;
+        }
+}
+
+/**
+ * @Description 设置16位参数的高字节或低字节
+ */
+static void Host_LcdSetByte(u16 *value, u8 low, u16 data)
+{
+        if(low)
+        {
+                *value = (*value & 0xFF00) | (data & 0xFF);
+        }
+        else
+        {
+                *value = (*value & 0x00FF) | ((data & 0xFF) << 8);
+        }
+}
+
+static void Host_LcdData(u16 data)
+{
+        u16 *cell;
+
+        switch(lcd.reg)
+        {
+        case 0x2C00:
+                cell = Host_LcdCell(lcd.x, lcd.y);
+                if(cell != NULL)
+                {
+                        *cell = data;
+                }
+                Host_LcdAdvance();
+                break;
+        case 0x2A00:
+        case 0x2A01:
+                Host_LcdSetByte(&lcd.xs, lcd.reg & 1, data);
+                break;
+        case 0x2A02:
+        case 0x2A03:
+                Host_LcdSetByte(&lcd.xe, lcd.reg & 1, data);
+                break;
+        case 0x2B00:
+        case 0x2B01:
+                Host_LcdSetByte(&lcd.ys, lcd.reg & 1, data);
+                break;
+        case 0x2B02:
+        case 0x2B03:
+                Host_LcdSetByte(&lcd.ye, lcd.reg & 1, data);
+                break;
+        case 0x3300:
+        case 0x3301:
+                Host_LcdSetByte(&lcd.tfa, lcd.reg & 1, data);
+                break;
+        case 0x3302:
+        case 0x3303:
+                Host_LcdSetByte(&lcd.vsa, lcd.reg & 1, data);
+                break;
+        case 0x3304:
+        case 0x3305:
+                Host_LcdSetByte(&lcd.bfa, lcd.reg & 1, data);
+                break;
+        case 0x3600:
+                lcd.madctl = (u8)data;
+                break;
+        case 0x3700:
+        case 0x3701:
+                Host_LcdSetByte(&lcd.vsp, lcd.reg & 1, data);
+                break;
+        }
+}
+
+static u16 Host_LcdRead(void)
+{
+        u16 *cell, color;
+        u8 r, g, b;
+
+        switch(lcd.reg)
+        {
+        case 0x2E00:
+                break;
+        case 0x0B00:
+                return lcd.madctl;
+        case 0xDB00:
+                return 0x80;                            // ID2，ID1和ID3为0
+        default:
+                return 0;
+        }
+
+        if(lcd.rd_dummy)
+        {
+                lcd.rd_dummy = 0;
+                return 0;
+        }
+        while(lcd.rd_num < 2)
+        {
+                cell = Host_LcdCell(lcd.x, lcd.y);
+                color = (cell != NULL) ? *cell : 0;
+                Host_LcdAdvance();
+
+                /* 每个分量扩展为8位，低位用高位填充 */
+                r = (color >> 11) & 0x1F;
+                g = (color >> 5) & 0x3F;
+                b = color & 0x1F;
+                lcd.rd_fifo[lcd.rd_num++] = (r << 3) | (r >> 2);
+                lcd.rd_fifo[lcd.rd_num++] = (g << 2) | (g >> 4);
+                lcd.rd_fifo[lcd.rd_num++] = (b << 3) | (b >> 2);
+        }
+        color = (lcd.rd_fifo[0] << 8) | lcd.rd_fifo[1];
+        lcd.rd_num -= 2;
+        memmove(lcd.rd_fifo, lcd.rd_fifo + 2, lcd.rd_num);
+        return color;
+}
+
+void Host_LcdWriteReg(u16 reg)
+{
+        lcd_stat.cmd++;
+        Host_LcdCommand(reg);
+}
+
+void Host_LcdWriteData(u16 data)
+{
+        lcd_stat.wdata++;
+        Host_LcdData(data);
+}
+
+u16 Host_LcdReadData(void)
+{
+        lcd_stat.rdata++;
+        return Host_LcdRead();
+}
+
+/**
+ * @Description DMA写FSMC地址，A6区分命令和数据
+ */
+static void Host_LcdBusWrite(u32 addr, u32 data)
+{
+        if(addr == LCD_BUS_RAM)
+        {
+                lcd_stat.dma++;
+                Host_LcdData((u16)data);
+        }
+        else
+        {
+                lcd_stat.cmd++;
+                Host_LcdCommand((u16)data);
+        }
+}
+
+static u32 Host_LcdBusRead(u32 addr)
+{
+        lcd_stat.rdata++;
+        return Host_LcdRead();
+}
+
+/**
+ * @Description 上电复位，GRAM填充固定种子的伪随机数，没有清屏就显示的区域在图像中是噪点
+ */
+void Host_LcdReset(void)
+{
+        u32 seed = 1;
+        u16 *p = &gram[0][0];
+        u32 i;
+
+        for(i = 0; i < HOST_LCD_WIDTH * HOST_LCD_HEIGHT; i++)
+        {
+                seed = seed * 1103515245 + 12345;
+                p[i] = seed >> 16;
+        }
+        memset(&lcd, 0, sizeof(lcd));
+        lcd.xe = HOST_LCD_WIDTH - 1;
+        lcd.ye = HOST_LCD_HEIGHT - 1;
+        lcd.vsa = HOST_LCD_HEIGHT;
+        memset(&lcd_stat, 0, sizeof(lcd_stat));
+
+        Host_SetBusDevice(LCD_BUS_BASE, LCD_BUS_SIZE, Host_LcdBusWrite, Host_LcdBusRead);
+}
+
+/**
+ * @Description 取得总线访问统计，reset为1时读出后清零
+ */
+void Host_LcdStat(HOST_LcdStatTypeDef *stat, u8 reset)
+{
+        if(stat)
+        {
+                *stat = lcd_stat;
+        }
+        if(reset)
+        {
+                memset(&lcd_stat, 0, sizeof(lcd_stat));
+        }
+}
+
+u16 Host_LcdGram(u16 col, u16 row)
+{
+        return gram[row % HOST_LCD_HEIGHT][col % HOST_LCD_WIDTH];
+}
+
+u16 Host_LcdPixel(u16 x, u16 y)
+{
+        u16 *cell = Host_LcdCell(x, y);
+
+        return (cell != NULL) ? *cell : 0;
+}
+
+/**
+ * @Description 面板上第row行显示的GRAM行，滚动区内的行从VSP开始循环
+ */
+u16 Host_LcdDisplayRow(u16 row)
+{
+        u32 start;
+
+        if(row < lcd.tfa || row >= lcd.tfa + lcd.vsa || lcd.vsa == 0)
+        {
+                return row;
+        }
+        start = (lcd.vsp >= lcd.tfa && lcd.vsp < lcd.tfa + lcd.vsa) ? lcd.vsp : lcd.tfa;
+        return lcd.tfa + (row - lcd.tfa + start - lcd.tfa) % lcd.vsa;
+}
+
+u8 Host_LcdDisplayOn(void)
+{
+        return lcd.on;
+}
+
+u8 Host_LcdMadctl(void)
+{
+        return lcd.madctl;
+}
@@ -0,0 +1,39 @@
+#ifndef __HOST_NT35510_H
+#define __HOST_NT35510_H
+
+/**
+ * NT35510模型的接口，编译驱动时用-include host/nt35510.h预先定义User/bsp_lcd.h中的总线访问宏，
+ * 驱动的命令、数据和读操作都交给模型，DMA写LCD_RAM时由host.c按地址交给模型
+ */
+
+#include "stm32f4xx.h"
+
+#define LCD_WR_REG(reg)         Host_LcdWriteReg(reg)
+#define LCD_WR_DATA(data)       Host_LcdWriteData(data)
+#define LCD_RD_DATA()           Host_LcdReadData()
+
+#define HOST_LCD_WIDTH          480                     // 面板的物理列数
+#define HOST_LCD_HEIGHT         800                     // 面板的物理行数
+
+/* 总线访问统计 */
+typedef struct
+{
+        u32 cmd;                                        // 写命令次数
+        u32 wdata;                                      // CPU写数据次数
+        u32 dma;                                        // DMA写数据次数
+        u32 rdata;                                      // 读数据次数
+} HOST_LcdStatTypeDef;
+
+void Host_LcdWriteReg(u16 reg);
+void Host_LcdWriteData(u16 data);
+u16 Host_LcdReadData(void);
+
+void Host_LcdReset(void);                               // 上电复位，GRAM为随机内容
+void Host_LcdStat(HOST_LcdStatTypeDef *stat, u8 reset);
+u16 Host_LcdGram(u16 col, u16 row);                     // 按物理坐标读GRAM
+u16 Host_LcdPixel(u16 x, u16 y);                        // 按当前MADCTL下的逻辑坐标读GRAM
+u16 Host_LcdDisplayRow(u16 row);                        // 面板第row行显示的GRAM行号，考虑垂直滚动
+u8 Host_LcdDisplayOn(void);
+u8 Host_LcdMadctl(void);
+
+#endif /* __HOST_NT35510_H */
@@ -0,0 +1,274 @@
+/**
+ * periph.c 上位机测试程序使用的标准外设库函数，代替Libraries下的库文件，与Tools/host/host.c一起链接
+ *
+ * 编译时定义USE_STDPERIPH_DRIVER，包含路径依次为Tools/host、User、Libraries。
+ * 时钟、GPIO复用和FSMC时序的配置没有作用；GPIO只保存输出数据寄存器；NVIC的配置交给host.c中的中断模型。
+ * DMA的寄存器与芯片相同，存储器到存储器的数据流在使能时立即完成整个传输，置位传输完成标志并产生中断，
+ * 目标地址属于Host_SetBusDevice()登记的设备(如LCD)时由设备模型处理写入；
+ * 外设与存储器之间的数据流由Host_SetDmaRequest()登记的外设模型(如host/usart.c、host/adc.c)按外设的时序搬运。
+ */
+
+#include "stm32f4xx.h"
+
+#define DMA_HIGH_ISR_MASK       ((uint32_t)0x20000000)
+#define DMA_RESERVED_MASK       ((uint32_t)0x0F7D0F7D)
+#define DMA_SxCR_DIR            ((uint32_t)0x000000C0)
+#define DMA_SxCR_PINC           ((uint32_t)0x00000200)
+#define DMA_SxCR_MINC           ((uint32_t)0x00000400)
+#define DMA_SxCR_TCIE           ((uint32_t)0x00000010)
+#define DMA_SxCR_HTIE           ((uint32_t)0x00000008)
+
+/* 每个数据流的中断号 */
+static const IRQn_Type dma_irq[16] =
+{
+        DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+        DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn,
+        DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+        DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+};
+
+static u32 nvic_group_bits = 2;                         // 抢占优先级的位数
+
+void RCC_AHB1PeriphClockCmd(uint32_t RCC_AHB1Periph, FunctionalState NewState) { }
+void RCC_AHB3PeriphClockCmd(uint32_t RCC_AHB3Periph, FunctionalState NewState) { }
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState) { }
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState) { }
+
+void FSMC_NORSRAMInit(FSMC_NORSRAMInitTypeDef *FSMC_NORSRAMInitStruct) { }
+void FSMC_NORSRAMCmd(uint32_t FSMC_Bank, FunctionalState NewState) { }
+
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct) { }
+void GPIO_PinAFConfig(GPIO_TypeDef *GPIOx, uint16_t GPIO_PinSource, uint8_t GPIO_AF) { }
+
+void GPIO_SetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+        GPIOx->ODR |= GPIO_Pin;
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+        GPIOx->ODR &= ~(u32)GPIO_Pin;
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+        return (GPIOx->IDR & GPIO_Pin) ? Bit_SET : Bit_RESET;
+}
+
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+        /* NVIC_PriorityGroup_0..4 = 0x700..0x300 */
+        nvic_group_bits = (0x700 - NVIC_PriorityGroup) >> 8;
+}
+
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct)
+{
+        u8 priority;
+
+        priority = (NVIC_InitStruct->NVIC_IRQChannelPreemptionPriority << (4 - nvic_group_bits)) |
+                   (NVIC_InitStruct->NVIC_IRQChannelSubPriority & (0x0F >> nvic_group_bits));
+        Host_IrqConfig((IRQn_Type)NVIC_InitStruct->NVIC_IRQChannel, priority, NVIC_InitStruct->NVIC_IRQChannelCmd == ENABLE);
+}
+
+/**
+ * @Description 数据流在host_dma_stream[]中的下标，0~7为DMA1，8~15为DMA2
+ */
+static int DMA_Index(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+        return (int)(DMAy_Streamx - host_dma_stream);
+}
+
+/**
+ * @Description 数据流的标志在LISR/HISR中的偏移
+ */
+static u32 DMA_FlagShift(int index)
+{
+        static const u8 shift[4] = { 0, 6, 16, 22 };
+
+        return shift[index % 4];
+}
+
+/**
+ * @Description 置位数据流的中断标志，对应的中断已使能时产生中断
+ * @param flags DMA_FLAG_TCIFx等标志相对于数据流0的位置，0x20:TC 0x10:HT
+ */
+void Host_DmaSetFlag(DMA_Stream_TypeDef *DMAy_Streamx, u32 flags)
+{
+        int index = DMA_Index(DMAy_Streamx);
+        DMA_TypeDef *dma = &host_dma[index / 8];
+        u32 bits = flags << DMA_FlagShift(index);
+
+        if(index % 8 < 4)
+        {
+                dma->LISR |= bits;
+        }
+        else
+        {
+                dma->HISR |= bits;
+        }
+        if(((flags & 0x20) && (DMAy_Streamx->CR & DMA_SxCR_TCIE)) || ((flags & 0x10) && (DMAy_Streamx->CR & DMA_SxCR_HTIE)))
+        {
+                Host_IrqRaise(dma_irq[index]);
+        }
+}
+
+void DMA_DeInit(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+        int index = DMA_Index(DMAy_Streamx);
+        u32 mask = 0x3D << DMA_FlagShift(index);
+
+        DMAy_Streamx->CR = 0;
+        DMAy_Streamx->NDTR = 0;
+        DMAy_Streamx->PAR = 0;
+        DMAy_Streamx->M0AR = 0;
+        DMAy_Streamx->M1AR = 0;
+        DMAy_Streamx->FCR = 0x21;
+        if(index % 8 < 4)
+        {
+                host_dma[index / 8].LISR &= ~mask;
+        }
+        else
+        {
+                host_dma[index / 8].HISR &= ~mask;
+        }
+}
+
+void DMA_Init(DMA_Stream_TypeDef *DMAy_Streamx, DMA_InitTypeDef *DMA_InitStruct)
+{
+        DMAy_Streamx->CR = DMA_InitStruct->DMA_Channel | DMA_InitStruct->DMA_DIR | DMA_InitStruct->DMA_PeripheralInc |
+                           DMA_InitStruct->DMA_MemoryInc | DMA_InitStruct->DMA_PeripheralDataSize |
+                           DMA_InitStruct->DMA_MemoryDataSize | DMA_InitStruct->DMA_Mode | DMA_InitStruct->DMA_Priority |
+                           DMA_InitStruct->DMA_MemoryBurst | DMA_InitStruct->DMA_PeripheralBurst;
+        DMAy_Streamx->FCR = DMA_InitStruct->DMA_FIFOMode | DMA_InitStruct->DMA_FIFOThreshold;
+        DMAy_Streamx->NDTR = DMA_InitStruct->DMA_BufferSize;
+        DMAy_Streamx->PAR = DMA_InitStruct->DMA_PeripheralBaseAddr;
+        DMAy_Streamx->M0AR = DMA_InitStruct->DMA_Memory0BaseAddr;
+}
+
+/**
+ * @Description 存储器到存储器传输：PAR是源地址，M0AR是目标地址，一次完成NDTR个数据项
+ */
+static void DMA_MemToMem(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+        u32 cr = DMAy_Streamx->CR;
+        u8 psize = 1 << ((cr >> 11) & 3);
+        u8 msize = 1 << ((cr >> 13) & 3);
+        u32 src = DMAy_Streamx->PAR, dst = DMAy_Streamx->M0AR;
+        u32 n;
+
+        for(n = DMAy_Streamx->NDTR; n; n--)
+        {
+                Host_BusWriteItem(dst, Host_BusReadItem(src, psize), msize);
+                if(cr & DMA_SxCR_PINC)
+                {
+                        src += psize;
+                }
+                if(cr & DMA_SxCR_MINC)
+                {
+                        dst += msize;
+                }
+        }
+        DMAy_Streamx->NDTR = 0;
+        DMAy_Streamx->CR &= ~DMA_SxCR_EN;
+        Host_DmaSetFlag(DMAy_Streamx, 0x20);
+}
+
+void DMA_Cmd(DMA_Stream_TypeDef *DMAy_Streamx, FunctionalState NewState)
+{
+        if(NewState == DISABLE)
+        {
+                DMAy_Streamx->CR &= ~DMA_SxCR_EN;
+                return;
+        }
+
+        DMAy_Streamx->CR |= DMA_SxCR_EN;
+        if((DMAy_Streamx->CR & DMA_SxCR_DIR) == DMA_DIR_MemoryToMemory)
+        {
+                DMA_MemToMem(DMAy_Streamx);
+        }
+        else
+        {
+                Host_DmaEnabled(DMAy_Streamx);
+        }
+}
+
+void DMA_MemoryTargetConfig(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t MemoryBaseAddr, uint32_t DMA_MemoryTarget)
+{
+        if(DMA_MemoryTarget != DMA_Memory_0)
+        {
+                DMAy_Streamx->M1AR = MemoryBaseAddr;
+        }
+        else
+        {
+                DMAy_Streamx->M0AR = MemoryBaseAddr;
+        }
+}
+
+FunctionalState DMA_GetCmdStatus(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+        return (DMAy_Streamx->CR & DMA_SxCR_EN) ? ENABLE : DISABLE;
+}
+
+void DMA_ITConfig(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t DMA_IT, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                DMAy_Streamx->CR |= DMA_IT & 0x1E;
+        }
+        else
+        {
+                DMAy_Streamx->CR &= ~(DMA_IT & 0x1E);
+        }
+}
+
+uint16_t DMA_GetCurrDataCounter(DMA_Stream_TypeDef *DMAy_Streamx)
+{
+        return (uint16_t)DMAy_Streamx->NDTR;
+}
+
+void DMA_SetCurrDataCounter(DMA_Stream_TypeDef *DMAy_Streamx, uint16_t Counter)
+{
+        DMAy_Streamx->NDTR = Counter;
+}
+
+static FlagStatus DMA_TestFlag(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t flag)
+{
+        DMA_TypeDef *dma = &host_dma[DMA_Index(DMAy_Streamx) / 8];
+        u32 reg = (flag & DMA_HIGH_ISR_MASK) ? dma->HISR : dma->LISR;
+
+        return (reg & flag & DMA_RESERVED_MASK) ? SET : RESET;
+}
+
+static void DMA_Clear(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t flag)
+{
+        DMA_TypeDef *dma = &host_dma[DMA_Index(DMAy_Streamx) / 8];
+
+        if(flag & DMA_HIGH_ISR_MASK)
+        {
+                dma->HISR &= ~(flag & DMA_RESERVED_MASK);
+        }
+        else
+        {
+                dma->LISR &= ~(flag & DMA_RESERVED_MASK);
+        }
+}
+
+FlagStatus DMA_GetFlagStatus(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t DMA_FLAG)
+{
+        return DMA_TestFlag(DMAy_Streamx, DMA_FLAG);
+}
+
+void DMA_ClearFlag(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t DMA_FLAG)
+{
+        DMA_Clear(DMAy_Streamx, DMA_FLAG);
+}
+
+ITStatus DMA_GetITStatus(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t DMA_IT)
+{
+        return DMA_TestFlag(DMAy_Streamx, DMA_IT);
+}
+
+void DMA_ClearITPendingBit(DMA_Stream_TypeDef *DMAy_Streamx, uint32_t DMA_IT)
+{
+        DMA_Clear(DMAy_Streamx, DMA_IT);
+}
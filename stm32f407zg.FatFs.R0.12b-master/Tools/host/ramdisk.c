@@ -0,0 +1,213 @@
+/**
+ * ramdisk.c 上位机测试程序使用的FatFs磁盘接口，每个物理驱动器是内存中的一个磁盘镜像，代替FatFs/diskio.c
+ *
+ * 扇区大小和擦除块大小与W25Q128上的卷相同(4KB扇区，16个扇区一块)，镜像可以从文件读入或保存到文件。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "diskio.h"
+#include "ramdisk.h"
+
+typedef struct
+{
+        BYTE *data;
+        DWORD sectors;
+        DWORD reads;
+        DWORD writes;
+        DWORD read_us;
+        DWORD write_us;
+} RAMDISK;
+
+static RAMDISK ramdisk[RAMDISK_NUM];
+
+/**
+ * @Description 创建一个全0的磁盘镜像，已经存在时先释放
+ * @param pdrv  物理驱动器号
+ * @param sectors 扇区数
+ * @return BYTE* 镜像数据，失败时返回NULL
+ */
+BYTE *Ramdisk_Create(BYTE pdrv, DWORD sectors)
+{
+        if(pdrv >= RAMDISK_NUM)
+        {
+                return NULL;
+        }
+
+        free(ramdisk[pdrv].data);
+        ramdisk[pdrv].data = calloc(sectors, RAMDISK_SECTOR_SIZE);
+        ramdisk[pdrv].sectors = ramdisk[pdrv].data ? sectors : 0;
+        ramdisk[pdrv].reads = 0;
+        ramdisk[pdrv].writes = 0;
+        ramdisk[pdrv].read_us = 0;
+        ramdisk[pdrv].write_us = 0;
+
+        return ramdisk[pdrv].data;
+}
+
+/**
+ * @Description 从文件读入磁盘镜像，文件大小必须为扇区大小的整数倍
+ * @return int  0:成功 -1:失败
+ */
+int Ramdisk_Load(BYTE pdrv, const char *path)
+{
+        FILE *fp = fopen(path, "rb");
+        long size;
+        int res = -1;
+
+        if(fp == NULL)
+        {
+                return -1;
+        }
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        if(size > 0 && size % RAMDISK_SECTOR_SIZE == 0 && Ramdisk_Create(pdrv, size / RAMDISK_SECTOR_SIZE) != NULL &&
+           fread(ramdisk[pdrv].data, 1, size, fp) == (size_t)size)
+        {
+                res = 0;
+        }
+        fclose(fp);
+
+        return res;
+}
+
+/**
+ * @Description 把磁盘镜像保存到文件
+ * @return int  0:成功 -1:失败
+ */
+int Ramdisk_Save(BYTE pdrv, const char *path)
+{
+        FILE *fp;
+        size_t size = (size_t)ramdisk[pdrv].sectors * RAMDISK_SECTOR_SIZE;
+        int res;
+
+        if(pdrv >= RAMDISK_NUM || ramdisk[pdrv].data == NULL || (fp = fopen(path, "wb")) == NULL)
+        {
+                return -1;
+        }
+        res = (fwrite(ramdisk[pdrv].data, 1, size, fp) == size) ? 0 : -1;
+        fclose(fp);
+
+        return res;
+}
+
+/**
+ * @Description 设置每次读写的耗时，模拟Flash的访问时间，等待期间让出CPU，其他线程可以运行
+ * @param read_us  每次disk_read()的耗时，单位微秒
+ * @param write_us 每次disk_write()的耗时，单位微秒
+ */
+void Ramdisk_SetLatency(BYTE pdrv, DWORD read_us, DWORD write_us)
+{
+        if(pdrv < RAMDISK_NUM)
+        {
+                ramdisk[pdrv].read_us = read_us;
+                ramdisk[pdrv].write_us = write_us;
+        }
+}
+
+static void Ramdisk_Wait(DWORD us)
+{
+        struct timespec ts;
+
+        if(us != 0)
+        {
+                ts.tv_sec = us / 1000000;
+                ts.tv_nsec = (us % 1000000) * 1000;
+                nanosleep(&ts, NULL);
+        }
+}
+
+/**
+ * @Description 读取镜像数据和读写扇区的次数，用于直接修改镜像或统计IO
+ */
+BYTE *Ramdisk_Data(BYTE pdrv, DWORD *sectors, DWORD *reads, DWORD *writes)
+{
+        if(pdrv >= RAMDISK_NUM)
+        {
+                return NULL;
+        }
+        if(sectors)
+        {
+                *sectors = ramdisk[pdrv].sectors;
+        }
+        if(reads)
+        {
+                *reads = ramdisk[pdrv].reads;
+        }
+        if(writes)
+        {
+                *writes = ramdisk[pdrv].writes;
+        }
+        return ramdisk[pdrv].data;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+        return (pdrv < RAMDISK_NUM && ramdisk[pdrv].data != NULL) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+        return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+        if(disk_status(pdrv) != 0 || sector >= ramdisk[pdrv].sectors || count > ramdisk[pdrv].sectors - sector)
+        {
+                return RES_PARERR;
+        }
+        memcpy(buff, ramdisk[pdrv].data + (size_t)sector * RAMDISK_SECTOR_SIZE, (size_t)count * RAMDISK_SECTOR_SIZE);
+        ramdisk[pdrv].reads += count;
+        Ramdisk_Wait(ramdisk[pdrv].read_us);
+
+        return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+        if(disk_status(pdrv) != 0 || sector >= ramdisk[pdrv].sectors || count > ramdisk[pdrv].sectors - sector)
+        {
+                return RES_PARERR;
+        }
+        memcpy(ramdisk[pdrv].data + (size_t)sector * RAMDISK_SECTOR_SIZE, buff, (size_t)count * RAMDISK_SECTOR_SIZE);
+        ramdisk[pdrv].writes += count;
+        Ramdisk_Wait(ramdisk[pdrv].write_us);
+
+        return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+        if(disk_status(pdrv) != 0)
+        {
+                return RES_NOTRDY;
+        }
+
+        switch(cmd)
+        {
+        case CTRL_SYNC:
+                return RES_OK;
+        case GET_SECTOR_COUNT:
+                *(DWORD *)buff = ramdisk[pdrv].sectors;
+                return RES_OK;
+        case GET_SECTOR_SIZE:
+                *(WORD *)buff = RAMDISK_SECTOR_SIZE;
+                return RES_OK;
+        case GET_BLOCK_SIZE:
+                *(DWORD *)buff = RAMDISK_BLOCK_SECTORS;
+                return RES_OK;
+        }
+
+        return RES_PARERR;
+}
+
+DWORD get_fattime(void)
+{
+        /* 2016-01-01 00:00:00 */
+        return ((DWORD)(2016 - 1980) << 25) | (1UL << 21) | (1UL << 16);
+}
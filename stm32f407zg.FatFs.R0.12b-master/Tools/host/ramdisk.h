@@ -0,0 +1,16 @@
+#ifndef __RAMDISK_H
+#define __RAMDISK_H
+
+#include "integer.h"
+
+#define RAMDISK_NUM             4                       // 物理驱动器个数，与_VOLUMES相同
+#define RAMDISK_SECTOR_SIZE     4096                    // 扇区大小，与W25Q128上的卷相同
+#define RAMDISK_BLOCK_SECTORS   16                      // 擦除块大小，单位为扇区
+
+BYTE *Ramdisk_Create(BYTE pdrv, DWORD sectors);
+int Ramdisk_Load(BYTE pdrv, const char *path);
+int Ramdisk_Save(BYTE pdrv, const char *path);
+void Ramdisk_SetLatency(BYTE pdrv, DWORD read_us, DWORD write_us);
+BYTE *Ramdisk_Data(BYTE pdrv, DWORD *sectors, DWORD *reads, DWORD *writes);
+
+#endif /* __RAMDISK_H */
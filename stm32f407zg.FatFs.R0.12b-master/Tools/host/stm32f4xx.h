@@ -0,0 +1,485 @@
+/**
+ * stm32f4xx.h 上位机测试程序使用的替代头文件，代替CMSIS和标准外设库的头文件，驱动源文件不需要修改
+ *
+ * 编译上位机测试程序时把Tools/host放在包含路径的最前面，并链接Tools/host/host.c，
+ * 只提供被测试的模块用到的类型、内核函数和外设接口，外设的行为由host.c中的模型实现。
+ * 每个线程相当于一个CPU核，PRIMASK和IPSR按线程分别保存；LDREX/STREX用原子操作模拟，
+ * 多个线程同时执行时与多核上的独占访问语义相同。
+ *
+ * 外设寄存器结构体与Startup/stm32f4xx.h相同，外设实例是host.c中的全局变量，驱动直接读写寄存器时访问的是这些变量；
+ * 与工程一样定义USE_STDPERIPH_DRIVER时通过stm32f4xx_conf.h包含标准外设库的头文件，库函数由periph.c实现。
+ * 驱动中把指针转换为u32的地方要求程序的数据在低4GB，编译时加-fno-pie -no-pie。
+ */
+
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+#include <stdint.h>
+
+/* 与工程的预定义宏相同，标准外设库头文件按这个型号选择外设 */
+#ifndef STM32F40_41xxx
+#define STM32F40_41xxx
+#endif
+
+typedef int32_t  s32;
+typedef int16_t  s16;
+typedef int8_t   s8;
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t  u8;
+
+typedef volatile uint32_t vu32;
+typedef volatile uint16_t vu16;
+typedef volatile uint8_t  vu8;
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {ERROR = 0, SUCCESS = !ERROR} ErrorStatus;
+
+#define __weak                  __attribute__((weak))
+#define __IO                    volatile
+
+/* 内核状态，按线程保存 */
+extern __thread u32 host_primask;                       // 1:已关中断
+extern __thread u32 host_ipsr;                          // 正在执行的中断号，0表示线程模式
+
+void Host_IrqEnable(void);                              // 开中断，执行关中断期间挂起的中断
+void Host_IrqDisable(void);                             // 关中断
+
+static inline void __enable_irq(void)
+{
+        Host_IrqEnable();
+}
+
+static inline void __disable_irq(void)
+{
+        Host_IrqDisable();
+}
+
+static inline u32 __get_PRIMASK(void)
+{
+        return host_primask;
+}
+
+static inline void __set_PRIMASK(u32 primask)
+{
+        if(primask)
+        {
+                Host_IrqDisable();
+        }
+        else
+        {
+                Host_IrqEnable();
+        }
+}
+
+static inline u32 __get_IPSR(void)
+{
+        return host_ipsr;
+}
+
+static inline void __DMB(void)
+{
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __DSB(void)
+{
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __NOP(void)
+{
+}
+
+/* 独占访问：LDREX记住读到的值，STREX在值没有被其他线程改变时才写入，与硬件一样允许偶尔失败 */
+extern __thread u32 host_excl_value;
+
+static inline u8 __LDREXB(volatile u8 *addr)
+{
+        host_excl_value = __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+        return (u8)host_excl_value;
+}
+
+static inline u32 __STREXB(u8 value, volatile u8 *addr)
+{
+        u8 expect = (u8)host_excl_value;
+
+        return __atomic_compare_exchange_n(addr, &expect, value, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ? 0 : 1;
+}
+
+static inline u32 __LDREXW(volatile u32 *addr)
+{
+        host_excl_value = __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+        return host_excl_value;
+}
+
+static inline u32 __STREXW(u32 value, volatile u32 *addr)
+{
+        u32 expect = host_excl_value;
+
+        return __atomic_compare_exchange_n(addr, &expect, value, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ? 0 : 1;
+}
+
+static inline void __CLREX(void)
+{
+}
+
+/* Cortex-M4 SIMD指令，按ARMv7-M架构手册的语义计算，与core_cm4_simd.h中的同名函数结果相同 */
+static inline u32 __UADD16(u32 op1, u32 op2)
+{
+        return ((op1 + op2) & 0xFFFF) | ((((op1 >> 16) + (op2 >> 16)) & 0xFFFF) << 16);
+}
+
+static inline u32 __SMLAD(u32 op1, u32 op2, u32 op3)
+{
+        return op3 + (u32)((s32)(s16)op1 * (s16)op2 + (s32)(s16)(op1 >> 16) * (s16)(op2 >> 16));
+}
+
+static inline u32 __UXTB16(u32 op1)
+{
+        return op1 & 0x00FF00FF;
+}
+
+static inline u32 __PKHBT(u32 op1, u32 op2, u32 shift)
+{
+        return (op1 & 0x0000FFFF) | ((op2 << shift) & 0xFFFF0000);
+}
+
+static inline u32 __PKHTB(u32 op1, u32 op2, u32 shift)
+{
+        return (op1 & 0xFFFF0000) | ((op2 >> shift) & 0x0000FFFF);
+}
+
+static inline u32 __ROR(u32 op1, u32 op2)
+{
+        return (op2 % 32) ? (op1 >> (op2 % 32)) | (op1 << (32 - op2 % 32)) : op1;
+}
+
+/* 中断号，只列出驱动用到的中断 */
+typedef enum IRQn
+{
+        SysTick_IRQn = -1,
+        EXTI0_IRQn = 6,
+        EXTI1_IRQn = 7,
+        EXTI2_IRQn = 8,
+        EXTI3_IRQn = 9,
+        EXTI4_IRQn = 10,
+        DMA1_Stream0_IRQn = 11,
+        DMA1_Stream1_IRQn = 12,
+        DMA1_Stream2_IRQn = 13,
+        DMA1_Stream3_IRQn = 14,
+        DMA1_Stream4_IRQn = 15,
+        DMA1_Stream5_IRQn = 16,
+        DMA1_Stream6_IRQn = 17,
+        ADC_IRQn = 18,
+        TIM2_IRQn = 28,
+        TIM3_IRQn = 29,
+        TIM4_IRQn = 30,
+        SPI1_IRQn = 35,
+        USART1_IRQn = 37,
+        USART2_IRQn = 38,
+        USART3_IRQn = 39,
+        DMA1_Stream7_IRQn = 47,
+        DMA2_Stream0_IRQn = 56,
+        DMA2_Stream1_IRQn = 57,
+        DMA2_Stream2_IRQn = 58,
+        DMA2_Stream3_IRQn = 59,
+        DMA2_Stream4_IRQn = 60,
+        DMA2_Stream5_IRQn = 68,
+        DMA2_Stream6_IRQn = 69,
+        DMA2_Stream7_IRQn = 70,
+        USART6_IRQn = 71,
+        HOST_IRQ_NUM = 82
+} IRQn_Type;
+
+#define __I                     volatile const
+#define __O                     volatile
+
+/* 外设寄存器，与Startup/stm32f4xx.h相同 */
+typedef struct
+{
+        __IO uint32_t CR;
+        __IO uint32_t NDTR;
+        __IO uint32_t PAR;
+        __IO uint32_t M0AR;
+        __IO uint32_t M1AR;
+        __IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+        __IO uint32_t LISR;
+        __IO uint32_t HISR;
+        __IO uint32_t LIFCR;
+        __IO uint32_t HIFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+        __IO uint32_t MODER;
+        __IO uint32_t OTYPER;
+        __IO uint32_t OSPEEDR;
+        __IO uint32_t PUPDR;
+        __IO uint32_t IDR;
+        __IO uint32_t ODR;
+        __IO uint16_t BSRRL;
+        __IO uint16_t BSRRH;
+        __IO uint32_t LCKR;
+        __IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct
+{
+        __IO uint16_t CR1;
+        uint16_t RESERVED0;
+        __IO uint16_t CR2;
+        uint16_t RESERVED1;
+        __IO uint16_t SR;
+        uint16_t RESERVED2;
+        __IO uint16_t DR;
+        uint16_t RESERVED3;
+        __IO uint16_t CRCPR;
+        uint16_t RESERVED4;
+        __IO uint16_t RXCRCR;
+        uint16_t RESERVED5;
+        __IO uint16_t TXCRCR;
+        uint16_t RESERVED6;
+        __IO uint16_t I2SCFGR;
+        uint16_t RESERVED7;
+        __IO uint16_t I2SPR;
+        uint16_t RESERVED8;
+} SPI_TypeDef;
+
+typedef struct
+{
+        __IO uint16_t SR;
+        uint16_t RESERVED0;
+        __IO uint16_t DR;
+        uint16_t RESERVED1;
+        __IO uint16_t BRR;
+        uint16_t RESERVED2;
+        __IO uint16_t CR1;
+        uint16_t RESERVED3;
+        __IO uint16_t CR2;
+        uint16_t RESERVED4;
+        __IO uint16_t CR3;
+        uint16_t RESERVED5;
+        __IO uint16_t GTPR;
+        uint16_t RESERVED6;
+} USART_TypeDef;
+
+typedef struct
+{
+        __IO uint32_t SR;
+        __IO uint32_t CR1;
+        __IO uint32_t CR2;
+        __IO uint32_t SMPR1;
+        __IO uint32_t SMPR2;
+        __IO uint32_t JOFR1;
+        __IO uint32_t JOFR2;
+        __IO uint32_t JOFR3;
+        __IO uint32_t JOFR4;
+        __IO uint32_t HTR;
+        __IO uint32_t LTR;
+        __IO uint32_t SQR1;
+        __IO uint32_t SQR2;
+        __IO uint32_t SQR3;
+        __IO uint32_t JSQR;
+        __IO uint32_t JDR1;
+        __IO uint32_t JDR2;
+        __IO uint32_t JDR3;
+        __IO uint32_t JDR4;
+        __IO uint32_t DR;
+} ADC_TypeDef;
+
+typedef struct
+{
+        __IO uint32_t CSR;
+        __IO uint32_t CCR;
+        __IO uint32_t CDR;
+} ADC_Common_TypeDef;
+
+typedef struct
+{
+        __IO uint16_t CR1;
+        uint16_t RESERVED0;
+        __IO uint16_t CR2;
+        uint16_t RESERVED1;
+        __IO uint16_t SMCR;
+        uint16_t RESERVED2;
+        __IO uint16_t DIER;
+        uint16_t RESERVED3;
+        __IO uint16_t SR;
+        uint16_t RESERVED4;
+        __IO uint16_t EGR;
+        uint16_t RESERVED5;
+        __IO uint16_t CCMR1;
+        uint16_t RESERVED6;
+        __IO uint16_t CCMR2;
+        uint16_t RESERVED7;
+        __IO uint16_t CCER;
+        uint16_t RESERVED8;
+        __IO uint32_t CNT;
+        __IO uint16_t PSC;
+        uint16_t RESERVED9;
+        __IO uint32_t ARR;
+        __IO uint16_t RCR;
+        uint16_t RESERVED10;
+        __IO uint32_t CCR1;
+        __IO uint32_t CCR2;
+        __IO uint32_t CCR3;
+        __IO uint32_t CCR4;
+        __IO uint16_t BDTR;
+        uint16_t RESERVED11;
+        __IO uint16_t DCR;
+        uint16_t RESERVED12;
+        __IO uint16_t DMAR;
+        uint16_t RESERVED13;
+        __IO uint16_t OR;
+        uint16_t RESERVED14;
+} TIM_TypeDef;
+
+typedef struct
+{
+        __IO uint32_t CTRL;
+        __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+        __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+/* 外设实例，地址与芯片不同，*_BASE保留芯片上的地址供位带宏计算 */
+extern DMA_Stream_TypeDef host_dma_stream[16];
+extern DMA_TypeDef host_dma[2];
+extern GPIO_TypeDef host_gpio[9];
+extern SPI_TypeDef host_spi[3];
+extern USART_TypeDef host_usart[6];
+extern ADC_TypeDef host_adc[3];
+extern ADC_Common_TypeDef host_adc_common;
+extern TIM_TypeDef host_tim[5];
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_coredebug;
+extern uint32_t SystemCoreClock;
+
+#define PERIPH_BASE             ((uint32_t)0x40000000)
+#define AHB1PERIPH_BASE         (PERIPH_BASE + 0x00020000)
+#define GPIOA_BASE              (AHB1PERIPH_BASE + 0x0000)
+#define GPIOB_BASE              (AHB1PERIPH_BASE + 0x0400)
+#define GPIOC_BASE              (AHB1PERIPH_BASE + 0x0800)
+#define GPIOD_BASE              (AHB1PERIPH_BASE + 0x0C00)
+#define GPIOE_BASE              (AHB1PERIPH_BASE + 0x1000)
+#define GPIOF_BASE              (AHB1PERIPH_BASE + 0x1400)
+#define GPIOG_BASE              (AHB1PERIPH_BASE + 0x1800)
+#define GPIOH_BASE              (AHB1PERIPH_BASE + 0x1C00)
+#define GPIOI_BASE              (AHB1PERIPH_BASE + 0x2000)
+
+#define GPIOA                   (&host_gpio[0])
+#define GPIOB                   (&host_gpio[1])
+#define GPIOC                   (&host_gpio[2])
+#define GPIOD                   (&host_gpio[3])
+#define GPIOE                   (&host_gpio[4])
+#define GPIOF                   (&host_gpio[5])
+#define GPIOG                   (&host_gpio[6])
+#define GPIOH                   (&host_gpio[7])
+#define GPIOI                   (&host_gpio[8])
+
+#define SPI1                    (&host_spi[0])
+#define SPI2                    (&host_spi[1])
+#define SPI3                    (&host_spi[2])
+
+#define USART1                  (&host_usart[0])
+#define USART2                  (&host_usart[1])
+#define USART3                  (&host_usart[2])
+#define UART4                   (&host_usart[3])
+#define UART5                   (&host_usart[4])
+#define USART6                  (&host_usart[5])
+
+#define ADC1                    (&host_adc[0])
+#define ADC2                    (&host_adc[1])
+#define ADC3                    (&host_adc[2])
+#define ADC                     (&host_adc_common)
+
+#define TIM1                    (&host_tim[0])
+#define TIM2                    (&host_tim[1])
+#define TIM3                    (&host_tim[2])
+#define TIM4                    (&host_tim[3])
+#define TIM5                    (&host_tim[4])
+
+#define DMA1                    (&host_dma[0])
+#define DMA2                    (&host_dma[1])
+#define DMA1_Stream0            (&host_dma_stream[0])
+#define DMA1_Stream1            (&host_dma_stream[1])
+#define DMA1_Stream2            (&host_dma_stream[2])
+#define DMA1_Stream3            (&host_dma_stream[3])
+#define DMA1_Stream4            (&host_dma_stream[4])
+#define DMA1_Stream5            (&host_dma_stream[5])
+#define DMA1_Stream6            (&host_dma_stream[6])
+#define DMA1_Stream7            (&host_dma_stream[7])
+#define DMA2_Stream0            (&host_dma_stream[8])
+#define DMA2_Stream1            (&host_dma_stream[9])
+#define DMA2_Stream2            (&host_dma_stream[10])
+#define DMA2_Stream3            (&host_dma_stream[11])
+#define DMA2_Stream4            (&host_dma_stream[12])
+#define DMA2_Stream5            (&host_dma_stream[13])
+#define DMA2_Stream6            (&host_dma_stream[14])
+#define DMA2_Stream7            (&host_dma_stream[15])
+
+#define DWT                     (&host_dwt)
+#define CoreDebug               (&host_coredebug)
+#define DWT_CTRL_CYCCNTENA_Msk  (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+#define DMA_SxCR_EN             ((uint32_t)0x00000001)
+
+/* 外设模型的接口 */
+typedef void (*Host_BusWrite)(u32 addr, u32 data);     // 写外部总线上的设备，DMA目标地址落在设备的地址范围内时调用
+typedef u32 (*Host_BusRead)(u32 addr);                  // 读外部总线上的设备
+
+void Host_IrqConfig(IRQn_Type irq, u8 priority, u8 enable);
+void Host_IrqRaise(IRQn_Type irq);                      // 外设产生中断，开中断且中断已使能时立即执行中断服务函数，否则挂起
+void Host_SetBusDevice(u32 base, u32 size, Host_BusWrite write, Host_BusRead read);
+void Host_BusWriteItem(u32 addr, u32 data, u8 size);    // DMA按地址写一个数据项，size为字节数
+u32 Host_BusReadItem(u32 addr, u8 size);
+void Host_DmaSetFlag(DMA_Stream_TypeDef *stream, u32 flags);   // 置位DMA数据流的标志(0x20:传输完成 0x10:半传输)，并按使能产生中断
+void Host_IrqSetEnable(IRQn_Type irq, u8 enable);
+
+/* 外设请求的DMA数据流由外设模型搬运数据，DMA_Cmd()使能数据流时调用外设模型登记的函数 */
+typedef void (*Host_DmaStart)(DMA_Stream_TypeDef *stream);
+void Host_SetDmaRequest(DMA_Stream_TypeDef *stream, Host_DmaStart start);
+void Host_DmaEnabled(DMA_Stream_TypeDef *stream);
+
+/**
+ * 模拟时间，单位为CPU周期(HOST_CLOCK_HZ)。外设模型用Host_AddClockDevice()登记下一个事件的时间和事件处理函数，
+ * Host_Run()让时间前进并按时间顺序处理事件，事件中产生的中断在调用者的线程中执行，DWT->CYCCNT跟随模拟时间。
+ * 没有登记时钟设备的程序不受影响
+ */
+#define HOST_CLOCK_HZ           168000000
+
+typedef uint64_t (*Host_ClockNext)(void);               // 返回下一个事件的时间，没有事件时返回UINT64_MAX
+typedef void (*Host_ClockEvent)(void);
+
+void Host_AddClockDevice(Host_ClockNext next, Host_ClockEvent event);
+void Host_Run(u32 cycles);
+uint64_t Host_Cycles(void);
+u32 Host_Cyccnt(void);                                  // 读周期计数器并让时间前进一次查询循环，用作SYSTICK_CYCCNT()
+u32 SysTick_Config(u32 ticks);                          // 滴答定时器，每ticks个周期产生一次SysTick中断
+void Host_Wfi(void);                                    // 等待中断，时间前进到下一个外设事件
+
+static inline void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+        Host_IrqSetEnable(IRQn, 1);
+}
+
+static inline void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+        Host_IrqSetEnable(IRQn, 0);
+}
+
+#ifdef USE_STDPERIPH_DRIVER
+#include "stm32f4xx_conf.h"
+#endif
+
+#endif /* __STM32F4xx_H */
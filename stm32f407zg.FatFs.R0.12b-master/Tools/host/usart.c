@@ -0,0 +1,466 @@
+/**
+ * usart.c 上位机测试程序使用的串口模型和串口的标准外设库函数，与Tools/host/host.c、host/periph.c一起链接
+ *
+ * 模型按波特率在模拟时间上发送数据：DR和移位寄存器各一个字节，DR空(TXE)时把数据移入DR，
+ * 移位寄存器空时从DR取走一个字节，经过10位的时间后出现在TX线上，TXE和TC标志与芯片相同。
+ * 使能了发送DMA请求(CR3.DMAT)时，DR空就由登记的DMA数据流写入下一个字节，传输完成时置位DMA的TC标志。
+ * 接收：Host_UsartReceive()给出的数据按波特率一个接一个地到达，每个字节经过10位的时间后进入DR，
+ * 使能了接收DMA请求(CR3.DMAR)时由接收DMA数据流写入存储器，循环模式下半满和全满时置位HT和TC标志，
+ * 否则置位RXNE，上一个字节还没有读走时置位ORE并丢弃。收到数据后线路空闲一个字节的时间置位IDLE，
+ * 使能了IDLEIE时产生串口中断。芯片上先读SR再读DR清除IDLE，驱动直接读寄存器，模型在下一个字节到达时清除。
+ * 逐字节中断收发的驱动：使能了RXNEIE、TXEIE或TCIE并且对应的标志置位时产生串口中断，USART_ReceiveData()清除RXNE。
+ * 只模拟Host_UsartAttach()登记的一个串口，其他串口的库函数只读写寄存器。
+ * CPU查询标志的USART_GetFlagStatus()每次让模拟时间前进USART_POLL_CYCLES个周期，相当于一次轮询循环。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "usart.h"
+
+#define USART_SR_ORE            0x0008
+#define USART_SR_IDLE           0x0010
+#define USART_SR_RXNE           0x0020
+#define USART_SR_TC             0x0040
+#define USART_SR_TXE            0x0080
+#define USART_CR1_IDLEIE        0x0010
+#define USART_CR1_RXNEIE        0x0020
+#define USART_CR1_TCIE          0x0040
+#define USART_CR1_TXEIE         0x0080
+#define USART_CR1_UE            0x2000
+#define USART_CR3_DMAR          0x0040
+#define USART_CR3_DMAT          0x0080
+#define DMA_SxCR_CIRC           0x0100
+#define DMA_SxCR_MINC           0x0400
+#define USART_POLL_CYCLES       12                      // 一次查询状态寄存器的循环：读APB寄存器、比较、跳转
+
+static USART_TypeDef *usart;
+static DMA_Stream_TypeDef *usart_tx_stream;
+static DMA_Stream_TypeDef *usart_rx_stream;
+static IRQn_Type usart_irq;
+static u32 usart_byte_cycles = HOST_CLOCK_HZ * 10 / 115200;
+
+static u8 tx_dr, tx_dr_full;                            // 发送数据寄存器
+static u8 tx_shift, tx_shift_busy;                      // 移位寄存器
+static uint64_t tx_shift_end;                           // 移位寄存器中的字节发送完毕的时间
+static u32 tx_dma_addr;                                 // DMA下一个要读的存储器地址
+
+static u8 *tx_log;                                      // TX线上发出的数据
+static u32 tx_len, tx_cap;
+
+static u8 *rx_queue;                                    // 还没有到达的接收数据
+static u32 rx_head, rx_tail, rx_cap;
+static u8 rx_busy;                                      // 正在接收一个字节
+static uint64_t rx_end;                                 // 正在接收的字节到达DR的时间
+static u8 rx_idle_wait;                                 // 收到数据后等待线路空闲
+static uint64_t rx_idle_at;                             // 线路空闲一个字节时间的时刻
+static u32 rx_dma_addr, rx_dma_size;                    // 接收DMA的起始地址和循环的数据项数
+
+static HOST_UsartStatTypeDef usart_stat;
+
+/**
+ * @Description 使能了中断的RXNE、TXE、TC标志置位时产生串口中断，与芯片一样是电平触发的
+ */
+static void Host_UsartIrqCheck(void)
+{
+        u16 sr = usart->SR;
+        u16 cr1 = usart->CR1;
+
+        if(((cr1 & USART_CR1_RXNEIE) && (sr & USART_SR_RXNE)) || ((cr1 & USART_CR1_TXEIE) && (sr & USART_SR_TXE)) ||
+           ((cr1 & USART_CR1_TCIE) && (sr & USART_SR_TC)))
+        {
+                Host_IrqRaise(usart_irq);
+        }
+}
+
+static void Host_UsartUpdateSR(void)
+{
+        usart->SR &= ~(USART_SR_TXE | USART_SR_TC);
+        if(!tx_dr_full)
+        {
+                usart->SR |= USART_SR_TXE;
+                if(!tx_shift_busy)
+                {
+                        usart->SR |= USART_SR_TC;
+                }
+        }
+        Host_UsartIrqCheck();
+}
+
+/**
+ * @Description 推进发送：移位寄存器空时从DR取数据，DR空时由DMA写入，DMA最后一个字节写入DR后置位传输完成标志
+ * @notice      传输完成中断中可能立即启动下一段传输，再次调用本函数，所以先更新完状态再置位标志
+ */
+static void Host_UsartTxService(void)
+{
+        while(1)
+        {
+                if(!tx_shift_busy && tx_dr_full)
+                {
+                        tx_shift = tx_dr;
+                        tx_dr_full = 0;
+                        tx_shift_busy = 1;
+                        tx_shift_end = Host_Cycles() + usart_byte_cycles;
+                }
+
+                if(!tx_dr_full && (usart->CR3 & USART_CR3_DMAT) && usart_tx_stream != NULL &&
+                   (usart_tx_stream->CR & DMA_SxCR_EN) && usart_tx_stream->NDTR != 0)
+                {
+                        tx_dr = (u8)Host_BusReadItem(tx_dma_addr, 1);
+                        tx_dr_full = 1;
+                        if(usart_tx_stream->CR & DMA_SxCR_MINC)
+                        {
+                                tx_dma_addr++;
+                        }
+                        usart_stat.tx_dma++;
+                        if(--usart_tx_stream->NDTR == 0)
+                        {
+                                usart_tx_stream->CR &= ~DMA_SxCR_EN;
+                                Host_UsartUpdateSR();
+                                Host_DmaSetFlag(usart_tx_stream, 0x20);
+                        }
+                        continue;
+                }
+                break;
+        }
+        Host_UsartUpdateSR();
+}
+
+static void Host_UsartTxStart(DMA_Stream_TypeDef *stream)
+{
+        tx_dma_addr = stream->M0AR;
+        Host_UsartTxService();
+}
+
+static void Host_UsartRxStart(DMA_Stream_TypeDef *stream)
+{
+        rx_dma_addr = stream->M0AR;
+        rx_dma_size = stream->NDTR;
+}
+
+/**
+ * @Description 开始接收队列中的下一个字节，字节之间没有间隔
+ */
+static void Host_UsartRxNext(uint64_t start)
+{
+        if(rx_head != rx_tail)
+        {
+                rx_busy = 1;
+                rx_end = start + usart_byte_cycles;
+        }
+}
+
+/**
+ * @Description 一个字节到达DR，交给接收DMA或置位RXNE
+ */
+static void Host_UsartRxByte(u8 data)
+{
+        DMA_Stream_TypeDef *stream = usart_rx_stream;
+        u32 index;
+
+        usart_stat.rx_bytes++;
+        usart->SR &= ~USART_SR_IDLE;
+        rx_idle_wait = 1;
+        rx_idle_at = Host_Cycles() + usart_byte_cycles;
+
+        if((usart->CR3 & USART_CR3_DMAR) && stream != NULL && (stream->CR & DMA_SxCR_EN) && stream->NDTR != 0)
+        {
+                index = rx_dma_size - stream->NDTR;
+                Host_BusWriteItem(rx_dma_addr + ((stream->CR & DMA_SxCR_MINC) ? index : 0), data, 1);
+                if(--stream->NDTR == 0)
+                {
+                        if(stream->CR & DMA_SxCR_CIRC)
+                        {
+                                stream->NDTR = rx_dma_size;
+                        }
+                        else
+                        {
+                                stream->CR &= ~DMA_SxCR_EN;
+                        }
+                        usart_stat.rx_dma_irq++;
+                        Host_DmaSetFlag(stream, 0x20);
+                }
+                else if(stream->NDTR == rx_dma_size / 2)
+                {
+                        usart_stat.rx_dma_irq++;
+                        Host_DmaSetFlag(stream, 0x10);
+                }
+                return;
+        }
+
+        if(usart->SR & USART_SR_RXNE)
+        {
+                usart->SR |= USART_SR_ORE;
+                usart_stat.rx_overrun++;
+                return;
+        }
+        usart->DR = data;
+        usart->SR |= USART_SR_RXNE;
+        Host_UsartIrqCheck();
+}
+
+static uint64_t Host_UsartNext(void)
+{
+        uint64_t next = tx_shift_busy ? tx_shift_end : UINT64_MAX;
+
+        if(rx_busy && rx_end < next)
+        {
+                next = rx_end;
+        }
+        if(rx_idle_wait && !rx_busy && rx_idle_at < next)
+        {
+                next = rx_idle_at;
+        }
+        return next;
+}
+
+static void Host_UsartEvent(void)
+{
+        uint64_t now = Host_Cycles();
+        u8 data;
+
+        if(rx_busy && now >= rx_end)
+        {
+                data = rx_queue[rx_tail++ % rx_cap];
+                rx_busy = 0;
+                Host_UsartRxNext(rx_end);
+                Host_UsartRxByte(data);
+        }
+        else if(rx_idle_wait && !rx_busy && now >= rx_idle_at)
+        {
+                rx_idle_wait = 0;
+                usart->SR |= USART_SR_IDLE;
+                if(usart->CR1 & USART_CR1_IDLEIE)
+                {
+                        usart_stat.rx_idle_irq++;
+                        Host_IrqRaise(usart_irq);
+                }
+        }
+
+        if(tx_shift_busy && now >= tx_shift_end)
+        {
+                if(tx_len == tx_cap)
+                {
+                        tx_cap = tx_cap ? tx_cap * 2 : 65536;
+                        tx_log = realloc(tx_log, tx_cap);
+                }
+                tx_log[tx_len++] = tx_shift;
+                usart_stat.tx_bytes++;
+                tx_shift_busy = 0;
+                Host_UsartTxService();
+        }
+}
+
+/**
+ * @Description 登记要模拟的串口和它的发送、接收DMA数据流
+ * @param irq   串口中断号
+ */
+void Host_UsartAttach(USART_TypeDef *USARTx, DMA_Stream_TypeDef *tx_stream, DMA_Stream_TypeDef *rx_stream, IRQn_Type irq)
+{
+        static u8 added = 0;
+
+        usart = USARTx;
+        usart_tx_stream = tx_stream;
+        usart_rx_stream = rx_stream;
+        usart_irq = irq;
+        usart->SR = USART_SR_TXE | USART_SR_TC;
+        if(tx_stream != NULL)
+        {
+                Host_SetDmaRequest(tx_stream, Host_UsartTxStart);
+        }
+        if(rx_stream != NULL)
+        {
+                Host_SetDmaRequest(rx_stream, Host_UsartRxStart);
+        }
+        if(!added)
+        {
+                Host_AddClockDevice(Host_UsartNext, Host_UsartEvent);
+                added = 1;
+        }
+}
+
+u32 Host_UsartByteCycles(void)
+{
+        return usart_byte_cycles;
+}
+
+const u8 *Host_UsartTxData(u32 *len)
+{
+        *len = tx_len;
+        return tx_log;
+}
+
+void Host_UsartTxClear(void)
+{
+        tx_len = 0;
+}
+
+/**
+ * @Description 数据从RX线上到达，排在还没有到达的数据之后，中间没有间隔
+ * @notice      要在数据之间留出空闲(分帧)，先用Host_Run()让前面的数据到达
+ */
+void Host_UsartReceive(const u8 *data, u32 len)
+{
+        u32 i, cap;
+        u8 *queue;
+
+        if(rx_head - rx_tail + len > rx_cap)
+        {
+                for(cap = rx_cap ? rx_cap : 65536; cap < rx_head - rx_tail + len; cap *= 2)
+                {
+                }
+                queue = malloc(cap);
+                for(i = 0; rx_tail + i != rx_head; i++)
+                {
+                        queue[i] = rx_queue[(rx_tail + i) % rx_cap];
+                }
+                free(rx_queue);
+                rx_queue = queue;
+                rx_cap = cap;
+                rx_head = i;
+                rx_tail = 0;
+        }
+        for(i = 0; i < len; i++)
+        {
+                rx_queue[rx_head++ % rx_cap] = data[i];
+        }
+        if(!rx_busy)
+        {
+                Host_UsartRxNext(Host_Cycles());
+        }
+}
+
+/**
+ * @Description 还没有到达的接收字节数
+ */
+u32 Host_UsartRxPending(void)
+{
+        return rx_head - rx_tail;
+}
+
+/**
+ * @Description 取得统计信息，reset为1时读出后清零
+ */
+void Host_UsartStat(HOST_UsartStatTypeDef *stat, u8 reset)
+{
+        if(stat)
+        {
+                *stat = usart_stat;
+        }
+        if(reset)
+        {
+                memset(&usart_stat, 0, sizeof(usart_stat));
+        }
+}
+
+void USART_Init(USART_TypeDef *USARTx, USART_InitTypeDef *USART_InitStruct)
+{
+        /* 与库相同，只改写字长、校验、收发使能、停止位和流控，中断和DMA使能不变 */
+        USARTx->CR1 = (USARTx->CR1 & ~0x160C) | USART_InitStruct->USART_Mode | USART_InitStruct->USART_WordLength |
+                      USART_InitStruct->USART_Parity;
+        USARTx->CR2 = (USARTx->CR2 & ~0x3000) | USART_InitStruct->USART_StopBits;
+        USARTx->CR3 = (USARTx->CR3 & ~0x0300) | USART_InitStruct->USART_HardwareFlowControl;
+        USARTx->BRR = 42000000 / USART_InitStruct->USART_BaudRate;
+        if(USARTx == usart)
+        {
+                usart_byte_cycles = ((uint64_t)HOST_CLOCK_HZ * 10 + USART_InitStruct->USART_BaudRate / 2) /
+                                    USART_InitStruct->USART_BaudRate;
+        }
+}
+
+void USART_Cmd(USART_TypeDef *USARTx, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                USARTx->CR1 |= USART_CR1_UE;
+        }
+        else
+        {
+                USARTx->CR1 &= ~USART_CR1_UE;
+        }
+}
+
+/**
+ * @Description 中断号的编码与库相同：bit7~5为控制寄存器(1:CR1 2:CR2 3:CR3)，bit4~0为使能位，bit15~8为SR中的标志位
+ */
+static vu16 *USART_ItReg(USART_TypeDef *USARTx, uint16_t USART_IT)
+{
+        switch((USART_IT >> 5) & 0x07)
+        {
+        case 1:
+                return &USARTx->CR1;
+        case 2:
+                return &USARTx->CR2;
+        default:
+                return &USARTx->CR3;
+        }
+}
+
+void USART_ITConfig(USART_TypeDef *USARTx, uint16_t USART_IT, FunctionalState NewState)
+{
+        vu16 *reg = USART_ItReg(USARTx, USART_IT);
+
+        if(NewState != DISABLE)
+        {
+                *reg |= 1 << (USART_IT & 0x1F);
+        }
+        else
+        {
+                *reg &= ~(1 << (USART_IT & 0x1F));
+        }
+        if(USARTx == usart)
+        {
+                Host_UsartIrqCheck();
+        }
+}
+
+ITStatus USART_GetITStatus(USART_TypeDef *USARTx, uint16_t USART_IT)
+{
+        vu16 *reg = USART_ItReg(USARTx, USART_IT);
+
+        return ((*reg & (1 << (USART_IT & 0x1F))) && (USARTx->SR & (1 << (USART_IT >> 8)))) ? SET : RESET;
+}
+
+void USART_DMACmd(USART_TypeDef *USARTx, uint16_t USART_DMAReq, FunctionalState NewState)
+{
+        if(NewState != DISABLE)
+        {
+                USARTx->CR3 |= USART_DMAReq;
+        }
+        else
+        {
+                USARTx->CR3 &= ~USART_DMAReq;
+        }
+        if(USARTx == usart)
+        {
+                Host_UsartTxService();
+        }
+}
+
+void USART_SendData(USART_TypeDef *USARTx, uint16_t Data)
+{
+        if(USARTx != usart)
+        {
+                USARTx->DR = Data;
+                return;
+        }
+        if(tx_dr_full)
+        {
+                usart_stat.tx_overwrite++;
+        }
+        tx_dr = (u8)Data;
+        tx_dr_full = 1;
+        usart_stat.tx_cpu++;
+        Host_UsartTxService();
+}
+
+uint16_t USART_ReceiveData(USART_TypeDef *USARTx)
+{
+        USARTx->SR &= ~USART_SR_RXNE;
+        return USARTx->DR & 0x1FF;
+}
+
+FlagStatus USART_GetFlagStatus(USART_TypeDef *USARTx, uint16_t USART_FLAG)
+{
+        Host_Run(USART_POLL_CYCLES);
+        return (USARTx->SR & USART_FLAG) ? SET : RESET;
+}
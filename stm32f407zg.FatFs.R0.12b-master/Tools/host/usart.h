@@ -0,0 +1,27 @@
+#ifndef __HOST_USART_H
+#define __HOST_USART_H
+
+#include "stm32f4xx.h"
+
+/* 串口模型的统计 */
+typedef struct
+{
+        u32 tx_bytes;                                   // 从TX线上发出的字节数
+        u32 tx_dma;                                     // DMA写入DR的字节数
+        u32 tx_cpu;                                     // CPU写入DR的字节数
+        u32 tx_overwrite;                               // CPU在DR非空时写入，覆盖了还没有发送的字节
+        u32 rx_bytes;                                   // 从RX线上收到的字节数
+        u32 rx_overrun;                                 // 没有使用DMA时上一个字节还没有读走，丢弃的字节数
+        u32 rx_dma_irq;                                 // 接收DMA的半满和全满事件
+        u32 rx_idle_irq;                                // 总线空闲中断
+} HOST_UsartStatTypeDef;
+
+void Host_UsartAttach(USART_TypeDef *usart, DMA_Stream_TypeDef *tx_stream, DMA_Stream_TypeDef *rx_stream, IRQn_Type irq);
+u32 Host_UsartByteCycles(void);                         // 按当前波特率发送一个字节(10位)的周期数
+const u8 *Host_UsartTxData(u32 *len);                   // TX线上已经发出的数据
+void Host_UsartTxClear(void);
+void Host_UsartReceive(const u8 *data, u32 len);       // 数据从RX线上按波特率连续到达
+u32 Host_UsartRxPending(void);                          // 还没有到达的接收字节数
+void Host_UsartStat(HOST_UsartStatTypeDef *stat, u8 reset);
+
+#endif /* __HOST_USART_H */
@@ -0,0 +1,214 @@
+/**
+ * w25qxx.c 上位机测试程序使用的W25Q128模型，代替User/bsp_w25qxx.c，与Tools/host/host.c一起链接
+ *
+ * 16MB存储阵列放在内存中，初始为擦除状态(全0xFF)。编程只能把1改为0，擦除以4KB扇区或64KB块为单位，
+ * 与芯片的行为相同，驱动中漏掉擦除时读回的数据会出错。Host_FlashStat()返回读、编程和擦除的统计。
+ * Host_FlashSetTiming()设置了编程和擦除时间后，每次操作按SPI传输和芯片忙的时间推进模拟时间(host.c)，
+ * 相当于驱动在W25QXX_WaitBusy()中等待，这段时间中断照常执行；没有设置时不计时。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_w25qxx.h"
+#include "w25qxx.h"
+
+#define FLASH_SIZE              (16 * 1024 * 1024)
+#define FLASH_SECTOR            4096
+#define FLASH_BLOCK             65536
+#define FLASH_PAGE              256
+#define FLASH_SPI_HZ            21000000                // SPI1在APB2(84MHz)上4分频
+
+u16 W25QXX_TYPE = 0;
+
+static u8 *flash;
+static HOST_FlashStatTypeDef flash_stat;
+static u32 flash_page_us, flash_sector_us, flash_block_us;
+static uint64_t flash_busy_end;                         // 当前操作结束的模拟时间
+
+/**
+ * @Description 芯片忙或SPI传输，模拟时间前进us微秒加上传输bytes个字节的时间
+ */
+static void Host_FlashBusy(u32 us, u32 bytes)
+{
+        u32 cycles;
+
+        if(flash_page_us == 0)
+        {
+                return;
+        }
+        cycles = us * (HOST_CLOCK_HZ / 1000000) + (u32)((uint64_t)bytes * 8 * HOST_CLOCK_HZ / FLASH_SPI_HZ);
+        flash_stat.busy_us += cycles / (HOST_CLOCK_HZ / 1000000);
+        flash_busy_end = Host_Cycles() + cycles;
+        Host_Run(cycles);
+}
+
+/**
+ * @Description 模拟时间是否在一次读、编程或擦除操作中，在中断中调用可以知道主循环是否正在等待Flash
+ */
+u8 Host_FlashBusyNow(void)
+{
+        return Host_Cycles() < flash_busy_end;
+}
+
+/**
+ * @Description 设置页编程、扇区擦除和块擦除的时间，单位微秒，W25Q128典型值为700、45000、150000，最大值为3000、400000、2000000
+ * @notice      page_us为0时不计时
+ */
+void Host_FlashSetTiming(u32 page_us, u32 sector_us, u32 block_us)
+{
+        flash_page_us = page_us;
+        flash_sector_us = sector_us;
+        flash_block_us = block_us;
+}
+
+/**
+ * @Description 取得存储阵列，第一次调用时分配并擦除
+ */
+u8 *Host_FlashData(void)
+{
+        if(flash == NULL)
+        {
+                flash = malloc(FLASH_SIZE);
+                memset(flash, 0xFF, FLASH_SIZE);
+        }
+        return flash;
+}
+
+/**
+ * @Description 取得统计信息，reset为1时读出后清零
+ */
+void Host_FlashStat(HOST_FlashStatTypeDef *stat, u8 reset)
+{
+        if(stat)
+        {
+                *stat = flash_stat;
+        }
+        if(reset)
+        {
+                memset(&flash_stat, 0, sizeof(flash_stat));
+        }
+}
+
+void W25QXX_Init(void)
+{
+        Host_FlashData();
+        W25QXX_TYPE = W25Q128;
+}
+
+u16 W25QXX_ReadID(void)
+{
+        return W25Q128;
+}
+
+u8 W25QXX_ReadSR(void)
+{
+        return 0;
+}
+
+void W25QXX_WriteSR(u8 state) { }
+void W25QXX_WriteEnable(void) { }
+void W25QXX_WriteDisable(void) { }
+void W25QXX_WaitBusy(void) { }
+void W25QXX_PowerDown(void) { }
+void W25QXX_WakeUp(void) { }
+
+void W25QXX_Read(u8 *pBuffer, u32 address, u16 length)
+{
+        u8 *data = Host_FlashData();
+
+        address %= FLASH_SIZE;
+        if(length > FLASH_SIZE - address)
+        {
+                length = FLASH_SIZE - address;
+        }
+        memcpy(pBuffer, data + address, length);
+        flash_stat.read += length;
+        Host_FlashBusy(0, 4 + length);
+}
+
+/**
+ * @Description 编程，不擦除，只能把1改为0，与驱动一样按256字节的页分次编程
+ */
+void W25QXX_WriteNoCheck(u8 *pBuffer, u32 address, u16 length)
+{
+        u8 *data = Host_FlashData();
+        u32 i, n;
+
+        for(i = 0; i < length; i++)
+        {
+                data[(address + i) % FLASH_SIZE] &= pBuffer[i];
+        }
+        flash_stat.program += length;
+
+        for(i = 0; i < length; i += n)
+        {
+                n = FLASH_PAGE - (address + i) % FLASH_PAGE;
+                if(n > length - i)
+                {
+                        n = length - i;
+                }
+                Host_FlashBusy(flash_page_us, 4 + n);
+        }
+}
+
+/**
+ * @Description 擦除一个扇区，与驱动相同，参数是扇区号
+ */
+void W25QXX_EraseSector(u32 Dst_Addr)
+{
+        memset(Host_FlashData() + Dst_Addr % (FLASH_SIZE / FLASH_SECTOR) * FLASH_SECTOR, 0xFF, FLASH_SECTOR);
+        flash_stat.sector_erase++;
+        Host_FlashBusy(flash_sector_us, 4);
+}
+
+/**
+ * @Description 擦除一个64KB块，参数是块号
+ */
+void W25QXX_EraseBlock(u32 Dst_Addr)
+{
+        memset(Host_FlashData() + Dst_Addr % (FLASH_SIZE / FLASH_BLOCK) * FLASH_BLOCK, 0xFF, FLASH_BLOCK);
+        flash_stat.block_erase++;
+        Host_FlashBusy(flash_block_us, 4);
+}
+
+void W25QXX_EraseChip(void)
+{
+        memset(Host_FlashData(), 0xFF, FLASH_SIZE);
+}
+
+/**
+ * @Description 带擦除的写入，与驱动一样先读出整个扇区，要写的部分没有擦除时擦除扇区后整个写回
+ */
+void W25QXX_Write(u8 *pBuffer, u32 address, u16 length)
+{
+        static u8 sector[FLASH_SECTOR];
+        u32 base, offset, n, i;
+
+        while(length)
+        {
+                base = address / FLASH_SECTOR * FLASH_SECTOR;
+                offset = address - base;
+                n = FLASH_SECTOR - offset;
+                if(n > length)
+                {
+                        n = length;
+                }
+                W25QXX_Read(sector, base, FLASH_SECTOR);
+                for(i = 0; i < n && sector[offset + i] == 0xFF; i++)
+                {
+                }
+                if(i < n)
+                {
+                        memcpy(sector + offset, pBuffer, n);
+                        W25QXX_EraseSector(base / FLASH_SECTOR);
+                        W25QXX_WriteNoCheck(sector, base, FLASH_SECTOR);
+                }
+                else
+                {
+                        W25QXX_WriteNoCheck(pBuffer, address, n);
+                }
+                pBuffer += n;
+                address += n;
+                length -= n;
+        }
+}
@@ -0,0 +1,21 @@
+#ifndef __HOST_W25QXX_H
+#define __HOST_W25QXX_H
+
+#include "stm32f4xx.h"
+
+/* W25Q128模型的访问统计 */
+typedef struct
+{
+        u32 read;                                       // 读出的字节数
+        u32 program;                                    // 编程的字节数
+        u32 sector_erase;                               // 4KB扇区擦除次数
+        u32 block_erase;                                // 64KB块擦除次数
+        u32 busy_us;                                    // 设置了操作时间后，SPI传输和芯片忙的总时间
+} HOST_FlashStatTypeDef;
+
+u8 *Host_FlashData(void);
+void Host_FlashStat(HOST_FlashStatTypeDef *stat, u8 reset);
+void Host_FlashSetTiming(u32 page_us, u32 sector_us, u32 block_us);
+u8 Host_FlashBusyNow(void);                             // 模拟时间是否在一次Flash操作中
+
+#endif /* __HOST_W25QXX_H */
@@ -0,0 +1,427 @@
+/**
+ * imzpack.c 上位机IMZ压缩图片生成工具，生成Image_ShowImz()使用的图片文件，格式见bsp_image.h
+ *
+ * 编译：gcc -O2 -o imzpack imzpack.c
+ * 用法：imzpack in.bmp out.imz                       24位或16位(RGB565 BITFIELDS)BMP
+ *       imzpack -r width height in.raw out.imz       没有文件头的RGB565小端数据
+ *
+ * 压缩后用参考解码器解压一遍，与原图比较，并输出压缩率和解码速度，
+ * 解码速度为上位机上的速度，只用来比较不同图片和参数，开发板上的耗时用Image_Benchmark()测量。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/* 与bsp_image.h保持一致 */
+#define IMAGE_IMZ_MAGIC         0x315A4D49
+#define IMAGE_IMZ_WINDOW        2048
+
+#define MATCH_MIN               2                       // 最短的复制长度，复制记录3字节，比2个直接像素少1字节
+#define CHAIN_MAX               64                      // 每个位置最多比较的候选位置数
+#define LEN_MAX                 65535
+
+typedef struct
+{
+        unsigned char *data;
+        size_t size;
+        size_t cap;
+} Buffer;
+
+static void put8(Buffer *b, unsigned v)
+{
+        if(b->size == b->cap)
+        {
+                b->cap = b->cap ? b->cap * 2 : 65536;
+                b->data = realloc(b->data, b->cap);
+        }
+        b->data[b->size++] = v;
+}
+
+static void put16(Buffer *b, unsigned v)
+{
+        put8(b, v & 0xFF);
+        put8(b, (v >> 8) & 0xFF);
+}
+
+/**
+ * @Description 写记录头，长度超过63时用u16给出
+ */
+static void put_op(Buffer *b, unsigned type, unsigned len)
+{
+        if(len <= 0x3F)
+        {
+                put8(b, (type << 6) | (len - 1));
+        }
+        else
+        {
+                put8(b, (type << 6) | 0x3F);
+                put16(b, len);
+        }
+}
+
+static void put_literal(Buffer *b, const uint16_t *pix, size_t start, size_t end)
+{
+        size_t len;
+
+        while(start < end)
+        {
+                len = end - start;
+                if(len > LEN_MAX)
+                {
+                        len = LEN_MAX;
+                }
+                put_op(b, 0, len);
+                while(len--)
+                {
+                        put16(b, pix[start++]);
+                }
+        }
+}
+
+/**
+ * @Description 压缩，贪心选择连续相同像素和复制中较长的一个
+ * @param pix   像素
+ * @param n     像素个数
+ * @param out   输出，不含文件头
+ */
+static void encode(const uint16_t *pix, size_t n, Buffer *out)
+{
+        int32_t *head = malloc(65536 * sizeof(int32_t));
+        int32_t *prev = malloc(n * sizeof(int32_t));
+        size_t i = 0, lit = 0, j;
+
+        memset(head, 0xFF, 65536 * sizeof(int32_t));
+
+        while(i < n)
+        {
+                size_t run = 1, best = 0, dist = 0, step;
+                uint32_t h;
+                int32_t cand;
+                int chain;
+
+                while(i + run < n && run < LEN_MAX && pix[i + run] == pix[i])
+                {
+                        run++;
+                }
+
+                /* 以两个像素为键的哈希链，查找窗口内最长的匹配 */
+                if(i + 1 < n)
+                {
+                        h = (pix[i] * 2654435761u ^ pix[i + 1]) >> 16;
+                        for(cand = head[h], chain = 0; cand >= 0 && i - cand <= IMAGE_IMZ_WINDOW && chain < CHAIN_MAX; cand = prev[cand], chain++)
+                        {
+                                size_t m = 0;
+                                while(i + m < n && m < LEN_MAX && pix[cand + m] == pix[i + m])
+                                {
+                                        m++;
+                                }
+                                if(m > best)
+                                {
+                                        best = m;
+                                        dist = i - cand;
+                                }
+                        }
+                }
+
+                if(run >= MATCH_MIN && run >= best)
+                {
+                        put_literal(out, pix, lit, i);
+                        put_op(out, 1, run);
+                        put16(out, pix[i]);
+                        step = run;
+                }
+                else if(best >= MATCH_MIN)
+                {
+                        put_literal(out, pix, lit, i);
+                        put_op(out, 2, best);
+                        put16(out, dist);
+                        step = best;
+                }
+                else
+                {
+                        step = 1;
+                }
+
+                /* 把经过的位置加入哈希链 */
+                for(j = i; j < i + step; j++)
+                {
+                        if(j + 1 < n)
+                        {
+                                h = (pix[j] * 2654435761u ^ pix[j + 1]) >> 16;
+                                prev[j] = head[h];
+                                head[h] = j;
+                        }
+                }
+
+                i += step;
+                if(step > 1)
+                {
+                        lit = i;
+                }
+        }
+        put_literal(out, pix, lit, n);
+
+        free(head);
+        free(prev);
+}
+
+/**
+ * @Description 参考解码器，与Image_ShowImz()的解码过程相同，输出到内存
+ * @return int  0:成功
+ */
+static int decode(const unsigned char *in, size_t size, uint16_t *pix, size_t n)
+{
+        const unsigned char *end = in + size;
+        size_t pos = 0, len, dist, i;
+        unsigned op;
+
+        while(pos < n)
+        {
+                if(in >= end)
+                {
+                        return -1;
+                }
+                op = *in++;
+                len = (op & 0x3F) + 1;
+                if((op & 0x3F) == 0x3F)
+                {
+                        len = in[0] | (in[1] << 8);
+                        in += 2;
+                }
+                if(len == 0 || len > n - pos)
+                {
+                        return -1;
+                }
+
+                switch(op >> 6)
+                {
+                case 0:
+                        for(i = 0; i < len; i++, in += 2)
+                        {
+                                pix[pos++] = in[0] | (in[1] << 8);
+                        }
+                        break;
+                case 1:
+                        for(i = 0; i < len; i++)
+                        {
+                                pix[pos++] = in[0] | (in[1] << 8);
+                        }
+                        in += 2;
+                        break;
+                case 2:
+                        dist = in[0] | (in[1] << 8);
+                        in += 2;
+                        if(dist == 0 || dist > IMAGE_IMZ_WINDOW || dist > pos)
+                        {
+                                return -1;
+                        }
+                        for(i = 0; i < len; i++, pos++)
+                        {
+                                pix[pos] = pix[pos - dist];
+                        }
+                        break;
+                default:
+                        return -1;
+                }
+        }
+
+        return (in == end) ? 0 : -1;
+}
+
+static unsigned char *load(const char *path, size_t *size)
+{
+        FILE *fp = fopen(path, "rb");
+        unsigned char *data;
+        long len;
+
+        if(fp == NULL)
+        {
+                perror(path);
+                return NULL;
+        }
+        fseek(fp, 0, SEEK_END);
+        len = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        data = malloc(len ? len : 1);
+        *size = fread(data, 1, len, fp);
+        fclose(fp);
+
+        return data;
+}
+
+static unsigned get16(const unsigned char *p)
+{
+        return p[0] | (p[1] << 8);
+}
+
+static unsigned long get32(const unsigned char *p)
+{
+        return get16(p) | ((unsigned long)get16(p + 2) << 16);
+}
+
+/**
+ * @Description 读取BMP并转换为从上到下的RGB565像素
+ */
+static uint16_t *load_bmp(const char *path, unsigned *width, unsigned *height)
+{
+        size_t size, stride;
+        unsigned char *bmp = load(path, &size);
+        const unsigned char *row;
+        uint16_t *pix;
+        long w, h;
+        unsigned bpp, x, y, bottomup;
+
+        if(bmp == NULL)
+        {
+                return NULL;
+        }
+        if(size < 54 || bmp[0] != 'B' || bmp[1] != 'M')
+        {
+                fprintf(stderr, "%s: not a BMP file\n", path);
+                return NULL;
+        }
+
+        w = (int32_t)get32(bmp + 18);
+        h = (int32_t)get32(bmp + 22);
+        bpp = get16(bmp + 28);
+        bottomup = h > 0;
+        h = h > 0 ? h : -h;
+        if(w <= 0 || w > 65535 || h == 0 || h > 65535 ||
+           (!(bpp == 24 && get32(bmp + 30) == 0) && !(bpp == 16 && get32(bmp + 30) == 3 && get32(bmp + 54) == 0xF800)))
+        {
+                fprintf(stderr, "%s: only 24-bit and RGB565 BMP are supported\n", path);
+                return NULL;
+        }
+
+        stride = ((size_t)w * (bpp / 8) + 3) & ~(size_t)3;
+        if(get32(bmp + 10) + stride * h > size)
+        {
+                fprintf(stderr, "%s: truncated\n", path);
+                return NULL;
+        }
+
+        pix = malloc((size_t)w * h * 2);
+        for(y = 0; y < h; y++)
+        {
+                row = bmp + get32(bmp + 10) + stride * (bottomup ? h - 1 - y : y);
+                for(x = 0; x < w; x++)
+                {
+                        if(bpp == 24)
+                        {
+                                pix[(size_t)y * w + x] = ((row[x * 3 + 2] & 0xF8) << 8) | ((row[x * 3 + 1] & 0xFC) << 3) | (row[x * 3] >> 3);
+                        }
+                        else
+                        {
+                                pix[(size_t)y * w + x] = get16(row + x * 2);
+                        }
+                }
+        }
+
+        free(bmp);
+        *width = w;
+        *height = h;
+        return pix;
+}
+
+int main(int argc, char *argv[])
+{
+        Buffer out = { NULL, 0, 0 };
+        const char *outpath;
+        uint16_t *pix, *check;
+        unsigned width, height;
+        size_t n, i, size;
+        clock_t start;
+        double sec;
+        int loops;
+        FILE *fp;
+
+        if(argc == 6 && strcmp(argv[1], "-r") == 0)
+        {
+                unsigned char *raw;
+
+                width = atoi(argv[2]);
+                height = atoi(argv[3]);
+                raw = load(argv[4], &size);
+                if(raw == NULL || width == 0 || height == 0 || width > 65535 || height > 65535 || size < (size_t)width * height * 2)
+                {
+                        fprintf(stderr, "%s: bad raw image\n", argv[4]);
+                        return 1;
+                }
+                pix = malloc((size_t)width * height * 2);
+                for(i = 0; i < (size_t)width * height; i++)
+                {
+                        pix[i] = get16(raw + i * 2);
+                }
+                free(raw);
+                outpath = argv[5];
+        }
+        else if(argc == 3)
+        {
+                pix = load_bmp(argv[1], &width, &height);
+                if(pix == NULL)
+                {
+                        return 1;
+                }
+                outpath = argv[2];
+        }
+        else
+        {
+                fprintf(stderr, "usage: %s in.bmp out.imz\n       %s -r width height in.raw out.imz\n", argv[0], argv[0]);
+                return 1;
+        }
+
+        n = (size_t)width * height;
+        encode(pix, n, &out);
+
+        /* 用参考解码器检查，并测量解码速度 */
+        check = malloc(n * 2);
+        start = clock();
+        loops = 0;
+        do
+        {
+                if(decode(out.data, out.size, check, n) != 0 || memcmp(check, pix, n * 2) != 0)
+                {
+                        fprintf(stderr, "verify failed\n");
+                        return 1;
+                }
+                loops++;
+                sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+        } while(sec < 0.2);
+
+        fp = fopen(outpath, "wb");
+        if(fp == NULL)
+        {
+                perror(outpath);
+                return 1;
+        }
+        {
+                unsigned char head[12];
+                head[0] = IMAGE_IMZ_MAGIC & 0xFF;
+                head[1] = (IMAGE_IMZ_MAGIC >> 8) & 0xFF;
+                head[2] = (IMAGE_IMZ_MAGIC >> 16) & 0xFF;
+                head[3] = (IMAGE_IMZ_MAGIC >> 24) & 0xFF;
+                head[4] = width & 0xFF;
+                head[5] = width >> 8;
+                head[6] = height & 0xFF;
+                head[7] = height >> 8;
+                head[8] = out.size & 0xFF;
+                head[9] = (out.size >> 8) & 0xFF;
+                head[10] = (out.size >> 16) & 0xFF;
+                head[11] = (out.size >> 24) & 0xFF;
+                fwrite(head, 1, sizeof(head), fp);
+        }
+        fwrite(out.data, 1, out.size, fp);
+        fclose(fp);
+
+        printf("%s: %ux%u, %lu -> %lu bytes (%.1f%%), host decode %.1f Mpixel/s\n", outpath, width, height,
+               (unsigned long)(n * 2), (unsigned long)(out.size + 12), 100.0 * (out.size + 12) / (n * 2),
+               n * loops / sec / 1e6);
+
+        free(pix);
+        free(check);
+        free(out.data);
+        return 0;
+}
@@ -0,0 +1,1128 @@
+/**
+ * lcdsim.c 上位机LCD模拟器，在NT35510模型上运行User/bsp_lcd.c等绘图驱动，输出屏幕图像和每个场景的总线访问次数
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -include host/nt35510.h -Wno-pointer-to-int-cast
+ *           -I host -I ../User -I ../Libraries -I ../FatFs -o lcdsim lcdsim.c ../User/bsp_lcd.c ../User/bsp_draw.c
+ *           ../User/bsp_text.c ../User/bsp_widget.c ../User/bsp_image.c ../User/bsp_console.c host/host.c host/periph.c
+ *           host/nt35510.c host/w25qxx.c host/ramdisk.c
+ *           ../FatFs/ff.c ../FatFs/syscall.c -lm
+ * 用法：lcdsim              运行全部场景，检查结果并输出总线访问次数
+ *       lcdsim -w 目录      同时把每个场景结束时的屏幕保存为目录中的NN_场景名.ppm和.png，作为基准图像
+ *       lcdsim -c 目录      同时与目录中的基准图像(.ppm)比较，有不同的点时失败
+ *
+ * 驱动源文件不修改，-include host/nt35510.h预先定义bsp_lcd.h中的LCD_WR_REG/LCD_WR_DATA/LCD_RD_DATA，
+ * DMA写LCD_RAM由host/periph.c中的DMA模型交给NT35510模型，帧缓冲使用host.c映射在0x68000000的外部SRAM。
+ * widget场景移植stm32f4.library.adc-I中的ADC电压显示画面，比较原来每次清除整行后重画和使用bsp_widget.c控件时每次更新的总线写入次数。
+ * 每个场景除了输出图像，还检查模型中的GRAM：填充区域的颜色、Lcd_ReadPoint()读回的颜色、
+ * 帧缓冲刷新后与直接绘制的结果是否相同、横屏和从下到上写入时的方向、垂直滚动后显示的行。
+ * 图像是面板上显示的内容，考虑显示开关和垂直滚动，横屏场景旋转为800*480。
+ * W25Q128模型中没有GBK字库，Lcd_ShowString()只显示ASCII字符；glyph场景在模型的字库区域写入一个合成的24号字库，
+ * 测试bsp_text.c的字形缓存，每个字模是左边一条竖线加上第(序号%24)行的横线。
+ * image场景在内存盘上写入800*480的16位BMP(RGB565，从上到下)、24位BMP(从下到上)和RGB565原始数据，用bsp_image.c显示，
+ * 读文件的时间按内存盘读的扇区数和W25Q128的SPI时钟估算，与LCD总线时间相加，不包括24位转换为RGB565的CPU时间。
+ * console场景分别在竖屏(硬件滚动)和横屏(整个区域重画)下用bsp_console.c输出CONSOLE_LINES行，比较每行的总线写入次数，
+ * 滚动后显示的内容必须与只输出最后一屏各行时相同。
+ * DMA的源地址按u32传递，颜色块要放在静态存储区，不能放在栈上。
+ * 总线时间按bsp_lcd.c中的FSMC时序计算：写一次(命令或数据，CPU或DMA)ADDSET+DATAST+1=7个HCLK，读一次16+60+1=77个HCLK，
+ * Flash读字模的时间按SPI 21MHz计算(host/w25qxx.c)，都不包括CPU计算字模等的时间，由此算出的填充速度(Mpixel/s)和显示字符的速度(chars/s)是总线允许的上限。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_lcd.h"
+#include "bsp_draw.h"
+#include "bsp_text.h"
+#include "bsp_widget.h"
+#include "bsp_image.h"
+#include "bsp_console.h"
+#include "ff.h"
+#include "nt35510.h"
+#include "w25qxx.h"
+#include "ramdisk.h"
+
+#define GRAY                    0x8410
+#define CYAN                    0x07FF
+#define MAGENTA                 0xF81F
+
+#define LCD_WRITE_HCLK          7                       // FSMC写时序：ADDSET(3)+DATAST(3)+1
+#define LCD_READ_HCLK           77                      // FSMC读时序：ADDSET(16)+DATAST(60)+1
+#define FLASH_SPI_HZ            21000000                // 与host/w25qxx.c相同
+#define IMAGE_W                 800                     // image场景中图片的大小，横屏全屏
+#define IMAGE_H                 480
+#define CONSOLE_LINES           200                     // console场景中每种方式输出的行数
+#define CONSOLE_SIZE            16                      // console场景的字号
+
+/* 一个场景：绘图函数和输出图像的方向 */
+typedef struct
+{
+        const char *name;
+        void (*draw)(void);
+        u8 landscape;
+} Scene;
+
+static int failures;
+static u16 gradient[64 * 64];
+static u16 snapshot[HOST_LCD_HEIGHT][HOST_LCD_WIDTH];
+static u8 rgb[HOST_LCD_WIDTH * HOST_LCD_HEIGHT * 3];
+
+void delay_us(u32 nus) { }
+void delay_ms(u16 nms) { }
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @Description 检查逻辑坐标下的矩形区域是否都是指定颜色
+ */
+static int rect_is(u16 sx, u16 sy, u16 ex, u16 ey, u16 color)
+{
+        u16 x, y;
+
+        for(y = sy; y <= ey; y++)
+        {
+                for(x = sx; x <= ex; x++)
+                {
+                        if(Host_LcdPixel(x, y) != color)
+                        {
+                                return 0;
+                        }
+                }
+        }
+        return 1;
+}
+
+/**
+ * @Description 用Lcd_ReadPoint()读回一组点，与模型中的GRAM比较
+ * @return int  不同的点数
+ */
+static int readback(u16 step)
+{
+        u16 x, y, color;
+        int diff = 0;
+
+        for(y = 0; y < lcddev.height; y += step)
+        {
+                for(x = 0; x < lcddev.width; x += step)
+                {
+                        color = Lcd_ReadPoint(x, y);
+                        if(color != Host_LcdPixel(x, y))
+                        {
+                                if(diff == 0)
+                                {
+                                        printf("  readback (%u,%u) = %04X, GRAM %04X\n", x, y, color, Host_LcdPixel(x, y));
+                                }
+                                diff++;
+                        }
+                }
+        }
+        return diff;
+}
+
+/**
+ * @Description 保存面板上显示的内容，考虑垂直滚动，不滚动时就是GRAM
+ */
+static void take_snapshot(void)
+{
+        u16 col, row;
+
+        for(row = 0; row < HOST_LCD_HEIGHT; row++)
+        {
+                for(col = 0; col < HOST_LCD_WIDTH; col++)
+                {
+                        snapshot[row][col] = Host_LcdGram(col, Host_LcdDisplayRow(row));
+                }
+        }
+}
+
+static int snapshot_diff(void)
+{
+        u16 col, row;
+        int diff = 0;
+
+        for(row = 0; row < HOST_LCD_HEIGHT; row++)
+        {
+                for(col = 0; col < HOST_LCD_WIDTH; col++)
+                {
+                        diff += (snapshot[row][col] != Host_LcdGram(col, Host_LcdDisplayRow(row)));
+                }
+        }
+        return diff;
+}
+
+/**
+ * @Description 按FSMC时序计算总线访问的时间
+ * @return double 微秒
+ */
+static double bus_us(const HOST_LcdStatTypeDef *stat)
+{
+        return ((double)(stat->cmd + stat->wdata + stat->dma) * LCD_WRITE_HCLK + (double)stat->rdata * LCD_READ_HCLK) /
+               (HOST_CLOCK_HZ / 1e6);
+}
+
+/**
+ * @Description 输出并清零总线访问统计
+ * @return double 总线时间，微秒
+ */
+static double print_stat(const char *name)
+{
+        HOST_LcdStatTypeDef stat;
+
+        Host_LcdStat(&stat, 1);
+        printf("  %-24s cmd %7u  cpu data %7u  dma data %7u  read %6u  bus %9.1f us\n", name, stat.cmd, stat.wdata, stat.dma,
+               stat.rdata, bus_us(&stat));
+        return bus_us(&stat);
+}
+
+/**
+ * @Description 一个测试画面，帧缓冲场景中分别直接绘制和画到帧缓冲中
+ */
+static void draw_panel(void)
+{
+        Lcd_ClearScreen(WHITE);
+        Lcd_Fill(0, 0, lcddev.width - 1, 59, BLUE);
+        POINT_COLOR = WHITE;
+        BACK_COLOR = BLUE;
+        Lcd_ShowString(16, 18, 300, 24, 24, "bsp_lcd panel");
+        POINT_COLOR = BLACK;
+        BACK_COLOR = WHITE;
+        Lcd_FillRect(20, 80, 200, 120, YELLOW);
+        Draw_Rect(20, 80, 219, 199);
+        Draw_FillCircle(340, 140, 60);
+        Draw_Line(0, 220, lcddev.width - 1, 320);
+        Lcd_ShowString(20, 340, 440, 16, 16, "Frame buffer vs direct");
+        Lcd_ShowInt(20, 370, 123456, 16);
+}
+
+static void scene_init(void)
+{
+        Host_LcdReset();
+        Lcd_Init();
+        print_stat("Lcd_Init");
+
+        CHECK(Host_LcdDisplayOn(), "display off after Lcd_Init");
+        CHECK(Host_LcdMadctl() == 0, "MADCTL %02X after Lcd_Init", Host_LcdMadctl());
+        CHECK(lcddev.width == 480 && lcddev.height == 800, "screen %ux%u", lcddev.width, lcddev.height);
+        CHECK(rect_is(0, 0, 479, 799, WHITE), "screen not cleared");
+}
+
+static void scene_fill(void)
+{
+        HOST_LcdStatTypeDef stat;
+
+        Lcd_Fill(20, 20, 459, 219, RED);
+        Host_LcdStat(&stat, 0);
+        printf("  %-24s %.1f Mpixel/s\n", "", 440 * 200 / print_stat("Lcd_Fill 440x200"));
+        CHECK(stat.dma == 440 * 200, "Lcd_Fill dma %u", stat.dma);
+        CHECK(stat.cmd == 17 && stat.wdata == 16, "Lcd_Fill cmd %u cpu data %u, expect 17/16", stat.cmd, stat.wdata);
+        CHECK(rect_is(20, 20, 459, 219, RED), "Lcd_Fill area");
+        CHECK(rect_is(0, 0, 479, 19, WHITE) && rect_is(0, 20, 19, 219, WHITE) && rect_is(460, 20, 479, 219, WHITE),
+              "Lcd_Fill wrote outside the area");
+
+        /* 超过LCD_DMA_MAX的区域在DMA中断中分段传输 */
+        Lcd_Fill(0, 240, 479, 799, BLUE);
+        Host_LcdStat(&stat, 0);
+        printf("  %-24s %.1f Mpixel/s\n", "", 480 * 560 / print_stat("Lcd_Fill 480x560"));
+        CHECK(stat.dma == 480 * 560, "Lcd_Fill dma %u", stat.dma);
+        CHECK(rect_is(0, 240, 479, 799, BLUE), "Lcd_Fill multi-segment area");
+        CHECK(rect_is(0, 220, 479, 239, WHITE), "Lcd_Fill multi-segment wrote outside the area");
+}
+
+static void scene_fillrect(void)
+{
+        HOST_LcdStatTypeDef stat;
+
+        Lcd_FillRect(40, 260, 200, 100, GREEN);
+        Host_LcdStat(&stat, 0);
+        printf("  %-24s %.1f Mpixel/s\n", "", 200 * 100 / print_stat("Lcd_FillRect 200x100"));
+        CHECK(stat.dma == 0 && stat.wdata == 200 * 100 + 16, "Lcd_FillRect cpu data %u dma %u", stat.wdata, stat.dma);
+        CHECK(rect_is(40, 260, 239, 359, GREEN), "Lcd_FillRect area");
+
+        Lcd_FillRect(40, 380, 200, 1, BLACK);
+        print_stat("Lcd_FillRect 200x1");
+        CHECK(rect_is(40, 380, 239, 380, BLACK), "Lcd_FillRect single line");
+        CHECK(Host_LcdPixel(39, 380) == BLUE && Host_LcdPixel(240, 380) == BLUE, "Lcd_FillRect single line overrun");
+
+        /* 超出屏幕的部分不填充，也不能从下一行开头绕回来 */
+        Lcd_FillRect(400, 400, 200, 20, YELLOW);
+        print_stat("Lcd_FillRect clipped");
+        CHECK(rect_is(400, 400, 479, 419, YELLOW), "Lcd_FillRect clipped area");
+        CHECK(rect_is(0, 401, 399, 419, BLUE), "Lcd_FillRect clipped wrapped around");
+}
+
+static void scene_shapes(void)
+{
+        u8 r;
+
+        Lcd_ClearScreen(WHITE);
+        Host_LcdStat(NULL, 1);
+
+        POINT_COLOR = BLACK;
+        Lcd_DrawLine(10, 10, 469, 10);
+        Lcd_DrawLine(10, 10, 10, 789);
+        Lcd_DrawLine(10, 10, 469, 789);
+        print_stat("Lcd_DrawLine x3");
+
+        POINT_COLOR = RED;
+        Lcd_DrawRectangle(40, 60, 440, 200);
+        print_stat("Lcd_DrawRectangle");
+
+        POINT_COLOR = BLUE;
+        for(r = 20; r <= 100; r += 20)
+        {
+                Lcd_DrawCircle(240, 400, r);
+        }
+        print_stat("Lcd_DrawCircle x5");
+
+        POINT_COLOR = GREEN;
+        Draw_FillCircle(120, 620, 60);
+        Draw_FillRoundRect(260, 560, 440, 680, 16);
+        Draw_FillTriangle(40, 780, 240, 700, 440, 780);
+        print_stat("Draw_Fill* x3");
+
+        CHECK(Host_LcdPixel(10, 10) == BLACK && Host_LcdPixel(469, 10) == BLACK && Host_LcdPixel(10, 789) == BLACK,
+              "line end points");
+        CHECK(Host_LcdPixel(240, 10) == BLACK && Host_LcdPixel(240, 11) == WHITE, "horizontal line");
+        CHECK(Host_LcdPixel(40, 130) == RED && Host_LcdPixel(440, 130) == RED && Host_LcdPixel(41, 130) == WHITE,
+              "rectangle edges");
+        CHECK(Host_LcdPixel(340, 400) == BLUE && Host_LcdPixel(240, 300) == BLUE, "circle r=100");
+        CHECK(Host_LcdPixel(120, 620) == GREEN && rect_is(100, 600, 140, 640, GREEN), "filled circle");
+}
+
+/**
+ * @Description 显示一个字符串，输出总线访问次数和每秒能显示的字符数
+ */
+static void show_string(const char *name, u16 x, u16 y, u16 width, u16 height, u8 size, const char *s)
+{
+        Lcd_ShowString(x, y, width, height, size, (char *)s);
+        printf("  %-24s %.0f chars/s\n", "", strlen(s) * 1e6 / print_stat(name));
+}
+
+static void scene_text(void)
+{
+        Lcd_ClearScreen(WHITE);
+        Host_LcdStat(NULL, 1);
+
+        POINT_COLOR = BLACK;
+        BACK_COLOR = WHITE;
+        show_string("Lcd_ShowString 12", 10, 10, 460, 12, 12, "ShowString 12: The quick brown fox jumps over the lazy dog");
+        show_string("Lcd_ShowString 16", 10, 40, 460, 16, 16, "ShowString 16: 0123456789 !\"#$%&'()*+,-./");
+        show_string("Lcd_ShowString 24", 10, 80, 300, 48, 24, "ShowString 24 wraps at the area width");
+
+        POINT_COLOR = BLUE;
+        Lcd_ShowInt(10, 150, 4294967295u, 24);
+        print_stat("Lcd_ShowInt");
+        Lcd_ShowFloat(10, 190, -3.14159f, 24);
+        print_stat("Lcd_ShowFloat");
+        POINT_COLOR = BLACK;
+
+        /* 12号'S'的左上角是背景，字符区域以外不改变 */
+        CHECK(Host_LcdPixel(10, 10) == WHITE, "glyph background");
+        CHECK(!rect_is(10, 10, 15, 21, WHITE), "no glyph drawn");
+        CHECK(!rect_is(10, 104, 460, 127, WHITE), "ShowString 24 did not wrap to the second line");
+        CHECK(!rect_is(10, 150, 130, 173, WHITE), "Lcd_ShowInt drew nothing");
+}
+
+/**
+ * @Description 在W25Q128模型的字库区域写入只有24号字的GBK字库，不带Unicode映射表
+ */
+static void pack_font(void)
+{
+        TEXT_HeaderTypeDef *header = (TEXT_HeaderTypeDef *)(Host_FlashData() + W25QXX_FONT_ADDR);
+        u8 *glyph;
+        u32 n, col;
+
+        memset(header, 0, sizeof(TEXT_HeaderTypeDef));
+        header->magic = TEXT_MAGIC;
+        header->version = TEXT_VERSION;
+        header->count = 1;
+        header->font[0].size = 24;
+        header->font[0].bytes = 24 * 3;
+        header->font[0].offset = 256;
+        header->total = 256 + TEXT_GLYPH_NUM * 24 * 3;
+        for(n = 0; n < TEXT_GLYPH_NUM; n++)
+        {
+                glyph = (u8 *)header + 256 + n * 24 * 3;
+                memset(glyph, 0, 24 * 3);
+                memset(glyph, 0xFF, 3);
+                for(col = 1; col < 24; col++)
+                {
+                        glyph[col * 3 + n % 24 / 8] = 0x80 >> (n % 8);
+                }
+        }
+}
+
+/**
+ * @Description 显示GBK第一个汉字区的前TEXT_CACHE_NUM个字，输出每个字的时间(Flash读字模+LCD总线)
+ */
+static void show_glyphs(const char *name, u16 y)
+{
+        HOST_LcdStatTypeDef lcd;
+        HOST_FlashStatTypeDef flash;
+        TEXT_CacheStatTypeDef cache = text_cache_stat;
+        u16 i;
+
+        Host_LcdStat(NULL, 1);
+        Host_FlashStat(NULL, 1);
+        for(i = 0; i < TEXT_CACHE_NUM; i++)
+        {
+                Text_ShowChar(10 + i % 16 * 28, y + i / 16 * 28, 0xB0A1 + i, 24, DRAW_REDRAW);
+        }
+        Host_LcdStat(&lcd, 1);
+        Host_FlashStat(&flash, 1);
+        printf("  %-24s hit %3u  miss %3u  flash %6u bytes  lcd %5u writes  %5.1f us/glyph\n", name,
+               text_cache_stat.hit - cache.hit, text_cache_stat.miss - cache.miss, flash.read, lcd.cmd + lcd.wdata + lcd.dma,
+               (flash.busy_us + bus_us(&lcd)) / TEXT_CACHE_NUM);
+}
+
+static void scene_glyph(void)
+{
+        TEXT_CacheStatTypeDef cache;
+        u32 n;
+
+        pack_font();
+        CHECK(Text_Init() == 0, "Text_Init rejected the packed font");
+        Text_SetEncoding(TEXT_ENC_GBK);
+        Text_CacheFlush();
+        Host_FlashSetTiming(700, 45000, 150000);
+        Lcd_ClearScreen(WHITE);
+        POINT_COLOR = BLACK;
+        BACK_COLOR = WHITE;
+
+        /* 第一遍全部未命中，第二遍全部命中 */
+        cache = text_cache_stat;
+        show_glyphs("cold (cache flushed)", 20);
+        show_glyphs("warm (cached)", 100);
+        CHECK(text_cache_stat.miss - cache.miss == TEXT_CACHE_NUM && text_cache_stat.hit - cache.hit == TEXT_CACHE_NUM,
+              "cache hit %u miss %u, expect %u each", text_cache_stat.hit - cache.hit, text_cache_stat.miss - cache.miss,
+              TEXT_CACHE_NUM);
+
+        /* 第二遍第二个字0xB0A2在(38,100)，序号与bsp_text.c中Text_GbkIndex()的计算相同 */
+        n = (0xB0 - 0x81) * 190 + (0xA2 - 0x40) - 1;
+        CHECK(rect_is(38, 100, 38, 123, BLACK), "glyph left column");
+        CHECK(Host_LcdPixel(50, 100 + n % 24) == BLACK && Host_LcdPixel(50, 100 + (n + 1) % 24) == WHITE,
+              "glyph row %u", n % 24);
+
+        Host_FlashSetTiming(0, 0, 0);
+        Text_SetEncoding(TEXT_ENC_UTF8);
+}
+
+#define ADC_UPDATES             64                      // widget场景中ADC画面的更新次数
+
+/**
+ * @Description widget场景中第i次ADC采样值，内部温度传感器在950附近小幅波动，偶尔进位
+ */
+static u16 adc_sample(u16 i)
+{
+        static const s8 noise[8] = { 0, 1, -1, 2, 0, -2, 1, 3 };
+
+        return 950 + noise[i % 8] + i / 16;
+}
+
+static u32 bus_writes(void)
+{
+        HOST_LcdStatTypeDef stat;
+
+        Host_LcdStat(&stat, 1);
+        return stat.cmd + stat.wdata + stat.dma;
+}
+
+static void scene_widget(void)
+{
+        static WIDGET_NumberTypeDef adc, volt, temp;
+        static WIDGET_BarTypeDef bar;
+        static WIDGET_LabelTypeDef label;
+        u32 demo = 0, number = 0, bars = 0, n, same;
+        u16 i, adcx, mv;
+        u8 length;
+        float voltage;
+
+        /* stm32f4.library.adc-I的画面：每次采样后清除整行，再用Lcd_ShowInt()/Lcd_ShowFloat()重画 */
+        Lcd_ClearScreen(WHITE);
+        POINT_COLOR = BLUE;
+        BACK_COLOR = WHITE;
+        Lcd_ShowString(30, 100, 450, 30, 24, "ADC Number:");
+        Lcd_ShowString(30, 130, 450, 30, 24, "Voltage:");
+        Lcd_ShowString(30, 160, 450, 30, 24, "Temperature:");
+        Host_LcdStat(NULL, 1);
+        for(i = 0; i < ADC_UPDATES; i++)
+        {
+                adcx = adc_sample(i);
+                Lcd_Fill(174, 100, 479, 129, BACK_COLOR);
+                Lcd_ShowInt(174, 100, adcx, 24);
+                voltage = (float)adcx * (3.3f / 4096.0f);
+                Lcd_Fill(138, 130, 479, 159, BACK_COLOR);
+                length = Lcd_ShowFloat(138, 130, voltage, 24);
+                Lcd_ShowChar(138 + length * 12, 130, 'V', 24, DRAW_DIRECT);
+                Lcd_Fill(186, 160, 479, 189, BACK_COLOR);
+                length = Lcd_ShowFloat(186, 160, (voltage - 0.76f) * 400.0f + 25.0f, 24);
+                Lcd_ShowChar(186 + length * 12, 160, 'C', 24, DRAW_DIRECT);
+                demo += bus_writes();
+        }
+        printf("  %-24s %7.1f bus writes per update\n", "demo: Lcd_Fill + Show*", (double)demo / ADC_UPDATES);
+
+        /* 同一个画面用控件显示，电压和温度用定点数，数值没有变化的控件不访问LCD */
+        Lcd_ClearScreen(WHITE);
+        Lcd_ShowString(30, 100, 450, 30, 24, "ADC Number:");
+        Lcd_ShowString(30, 130, 450, 30, 24, "Voltage:");
+        Lcd_ShowString(30, 160, 450, 30, 24, "Temperature:");
+        Widget_NumberInit(&adc, 174, 100, 24, 6, 0, NULL);
+        Widget_NumberInit(&volt, 138, 130, 24, 7, 3, "V");
+        Widget_NumberInit(&temp, 186, 160, 24, 8, 2, "C");
+        Widget_BarInit(&bar, 30, 200, 420, 16, 4095);
+        Host_LcdStat(NULL, 1);
+        for(i = 0; i < ADC_UPDATES; i++)
+        {
+                adcx = adc_sample(i);
+                mv = adcx * 3300 / 4096;
+                Widget_NumberSet(&adc, adcx);
+                Widget_NumberSet(&volt, mv);
+                Widget_NumberSet(&temp, ((s32)mv - 760) * 40 + 2500);
+                number += bus_writes();
+                Widget_BarSet(&bar, adcx);
+                bars += bus_writes();
+        }
+        printf("  %-24s %7.1f bus writes per update (3 numbers)\n", "widget: Widget_NumberSet", (double)number / ADC_UPDATES);
+        printf("  %-24s %7.1f bus writes per update\n", "widget: Widget_BarSet", (double)bars / ADC_UPDATES);
+        CHECK(number + bars < demo / 4, "widgets used %u bus writes, demo %u", number + bars, demo);
+
+        /* 数值不变时不访问LCD */
+        Widget_NumberSet(&adc, adcx);
+        Widget_BarSet(&bar, adcx);
+        CHECK(bus_writes() == 0, "unchanged widgets wrote to the LCD");
+        CHECK(rect_is(30, 200, 30 + (adcx * 420 + 2047) / 4095 - 1, 215, BLUE), "bar fill");
+
+        /* 含中文的内容没有变化时也不重画 */
+        Widget_LabelInit(&label, 30, 240, 24, 16, BLACK, WHITE);
+        Widget_LabelSet(&label, "温度 Temp");
+        n = bus_writes();
+        Widget_LabelSet(&label, "温度 Temp");
+        same = bus_writes();
+        CHECK(same == 0, "unchanged non-ASCII label redrawn");
+        Widget_LabelSet(&label, "Temp");
+        printf("  %-24s %7u bus writes, unchanged %u, back to ASCII %u\n", "Widget_LabelSet non-ASCII", n, same, bus_writes());
+        POINT_COLOR = BLACK;
+}
+
+static void scene_readback(void)
+{
+        HOST_LcdStatTypeDef stat;
+        u16 x, y, color;
+        int diff = 0;
+
+        for(y = 0; y < 64; y++)
+        {
+                for(x = 0; x < 64; x++)
+                {
+                        gradient[y * 64 + x] = ((x >> 1) << 11) | ((y) << 5) | (31 - (x >> 1));
+                }
+        }
+        Lcd_ColorFill(300, 300, 363, 363, gradient);
+        print_stat("Lcd_ColorFill 64x64");
+
+        for(y = 0; y < 64; y++)
+        {
+                for(x = 0; x < 64; x++)
+                {
+                        color = Lcd_ReadPoint(300 + x, 300 + y);
+                        if(color != gradient[y * 64 + x] && diff++ == 0)
+                        {
+                                printf("  Lcd_ReadPoint(%u,%u) = %04X, expect %04X\n", 300 + x, 300 + y, color, gradient[y * 64 + x]);
+                        }
+                }
+        }
+        Host_LcdStat(&stat, 0);
+        print_stat("Lcd_ReadPoint x4096");
+        CHECK(diff == 0, "%d gradient points read back wrong", diff);
+        CHECK(stat.rdata == 3 * 4096, "Lcd_ReadPoint read %u, expect 3 per point", stat.rdata);
+        CHECK(readback(7) == 0, "screen readback");
+}
+
+static void scene_blit(void)
+{
+        static u16 row[64];
+        static const u16 solid = MAGENTA;
+        u16 x, y;
+
+        Lcd_ClearScreen(GRAY);
+        Host_LcdStat(NULL, 1);
+
+        /* 从下到上：最先写入的是区域的最后一行 */
+        Lcd_BlitBegin(40, 40, 64, 64, 1);
+        for(y = 0; y < 64; y++)
+        {
+                for(x = 0; x < 64; x++)
+                {
+                        row[x] = gradient[(63 - y) * 64 + x];
+                }
+                Lcd_BlitRow(row);
+        }
+        Lcd_BlitEnd();
+        print_stat("Lcd_Blit bottom-up");
+        CHECK(Host_LcdMadctl() == 0, "scan direction not restored, MADCTL %02X", Host_LcdMadctl());
+        for(y = 0; y < 64; y++)
+        {
+                for(x = 0; x < 64; x++)
+                {
+                        if(Host_LcdPixel(40 + x, 40 + y) != gradient[y * 64 + x])
+                        {
+                                CHECK(0, "bottom-up blit (%u,%u) = %04X, expect %04X", x, y,
+                                      Host_LcdPixel(40 + x, 40 + y), gradient[y * 64 + x]);
+                                y = 64;
+                                break;
+                        }
+                }
+        }
+
+        /* 超过LCD_BLIT_DMA_MIN的纯色段交给DMA，之后接着写入 */
+        Lcd_BlitBegin(200, 40, 64, 64, 0);
+        Lcd_BlitPixels(&solid, 64 * 32, 0);
+        for(y = 32; y < 64; y++)
+        {
+                Lcd_BlitRow(&gradient[y * 64]);
+        }
+        Lcd_BlitEnd();
+        print_stat("Lcd_Blit solid + rows");
+        CHECK(rect_is(200, 40, 263, 71, MAGENTA), "blit solid run");
+        CHECK(Host_LcdPixel(200, 72) == gradient[32 * 64] && Host_LcdPixel(263, 103) == gradient[63 * 64 + 63], "blit rows after DMA");
+        CHECK(rect_is(0, 104, 479, 104, GRAY), "blit wrote outside the area");
+
+        /* 超出屏幕的部分丢弃 */
+        Lcd_BlitBegin(440, 760, 64, 64, 1);
+        for(y = 0; y < 64; y++)
+        {
+                Lcd_BlitRow(&gradient[(63 - y) * 64]);
+        }
+        Lcd_BlitEnd();
+        print_stat("Lcd_Blit clipped");
+        CHECK(Host_LcdPixel(440, 760) == gradient[0] && Host_LcdPixel(479, 799) == gradient[39 * 64 + 39], "clipped blit");
+}
+
+/**
+ * @Description image场景中图片(x,y)点的RGB565颜色，横向红色、纵向绿色渐变，蓝色是x^y的低位，行序或像素顺序错了都能发现
+ */
+static u16 image_color(u16 x, u16 y)
+{
+        return ((x * 31 / (IMAGE_W - 1)) << 11) | ((y * 63 / (IMAGE_H - 1)) << 5) | ((x ^ y) & 0x1F);
+}
+
+static void put_le16(u8 *p, u16 v)
+{
+        p[0] = v;
+        p[1] = v >> 8;
+}
+
+static void put_le32(u8 *p, u32 v)
+{
+        put_le16(p, v);
+        put_le16(p + 2, v >> 16);
+}
+
+/**
+ * @Description 在内存盘上写入一个图片文件
+ * @param bpp   16:BITFIELDS格式的RGB565 BMP，从上到下存放 24:BMP，从下到上存放 0:没有文件头的RGB565
+ */
+static int write_image(const char *path, u8 bpp)
+{
+        static u8 line[IMAGE_W * 3];
+        u8 head[66];
+        u32 offset = (bpp == 16) ? 66 : 54, stride = IMAGE_W * (bpp ? bpp / 8 : 2);
+        u16 x, y, row, color;
+        FIL fil;
+        UINT bw;
+
+        if(f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+        {
+                return -1;
+        }
+        if(bpp)
+        {
+                memset(head, 0, sizeof(head));
+                head[0] = 'B';
+                head[1] = 'M';
+                put_le32(head + 2, offset + stride * IMAGE_H);
+                put_le32(head + 10, offset);
+                put_le32(head + 14, 40);
+                put_le32(head + 18, IMAGE_W);
+                put_le32(head + 22, (bpp == 16) ? -IMAGE_H : IMAGE_H);
+                put_le16(head + 26, 1);
+                put_le16(head + 28, bpp);
+                put_le32(head + 30, (bpp == 16) ? 3 : 0);
+                put_le32(head + 34, stride * IMAGE_H);
+                put_le32(head + 54, 0xF800);
+                put_le32(head + 58, 0x07E0);
+                put_le32(head + 62, 0x001F);
+                if(f_write(&fil, head, offset, &bw) != FR_OK || bw != offset)
+                {
+                        f_close(&fil);
+                        return -1;
+                }
+        }
+        for(row = 0; row < IMAGE_H; row++)
+        {
+                y = (bpp == 24) ? IMAGE_H - 1 - row : row;
+                for(x = 0; x < IMAGE_W; x++)
+                {
+                        color = image_color(x, y);
+                        if(bpp == 24)
+                        {
+                                /* BGR888，低位用高位填充，转换时截去 */
+                                line[x * 3] = ((color << 3) & 0xF8) | ((color >> 2) & 0x07);
+                                line[x * 3 + 1] = ((color >> 3) & 0xFC) | ((color >> 9) & 0x03);
+                                line[x * 3 + 2] = ((color >> 8) & 0xF8) | (color >> 13);
+                        }
+                        else
+                        {
+                                put_le16(line + x * 2, color);
+                        }
+                }
+                if(f_write(&fil, line, stride, &bw) != FR_OK || bw != stride)
+                {
+                        f_close(&fil);
+                        return -1;
+                }
+        }
+        return (f_close(&fil) == FR_OK) ? 0 : -1;
+}
+
+/**
+ * @Description 显示一张图片，输出读文件和LCD总线的时间，检查GRAM中的每个点
+ * @param bpp   同write_image()
+ */
+static void show_image(const char *name, const char *path, u8 bpp)
+{
+        HOST_LcdStatTypeDef stat;
+        DWORD r0, r1;
+        double flash_ms, bus_ms;
+        u16 x, y;
+        u8 res;
+        int diff = 0;
+
+        Lcd_ClearScreen(BLACK);
+        Host_LcdStat(NULL, 1);
+        Ramdisk_Data(0, NULL, &r0, NULL);
+        res = bpp ? Image_ShowBmp(path, 0, 0) : Image_ShowRaw(path, 0, 0, IMAGE_W, IMAGE_H);
+        Ramdisk_Data(0, NULL, &r1, NULL);
+        Host_LcdStat(&stat, 1);
+
+        flash_ms = (r1 - r0) * (RAMDISK_SECTOR_SIZE + 4.0) * 8 * 1e3 / FLASH_SPI_HZ;
+        bus_ms = bus_us(&stat) / 1e3;
+        printf("  %-24s read %4lu sectors %6.1f ms  bus %7u writes %6.1f ms  total %6.1f ms\n", name,
+               (unsigned long)(r1 - r0), flash_ms, stat.cmd + stat.wdata + stat.dma, bus_ms, flash_ms + bus_ms);
+        CHECK(res == IMAGE_OK, "%s = %u", path, res);
+
+        for(y = 0; y < IMAGE_H; y++)
+        {
+                for(x = 0; x < IMAGE_W; x++)
+                {
+                        diff += Host_LcdPixel(x, y) != image_color(x, y);
+                }
+        }
+        CHECK(diff == 0, "%s: %d points differ", path, diff);
+}
+
+static void scene_image(void)
+{
+        static FATFS fs;
+        static BYTE work[_MAX_SS];
+
+        Lcd_DisplayDir(SCREEN_HORIZONTAL);
+        Ramdisk_Create(0, 1024);
+        CHECK(f_mkfs("0:", FM_FAT | FM_SFD, RAMDISK_SECTOR_SIZE, work, sizeof(work)) == FR_OK &&
+              f_mount(&fs, "0:", 1) == FR_OK, "cannot format the ramdisk");
+        CHECK(write_image("0:RGB565.BMP", 16) == 0 && write_image("0:BGR888.BMP", 24) == 0 &&
+              write_image("0:RGB565.RAW", 0) == 0, "cannot write the images");
+
+        show_image("16-bit BMP (top-down)", "0:RGB565.BMP", 16);
+        show_image("24-bit BMP (bottom-up)", "0:BGR888.BMP", 24);
+        show_image("RGB565 raw", "0:RGB565.RAW", 0);
+        f_mount(NULL, "0:", 0);
+}
+
+/**
+ * @Description 向终端输出第first行开始的n行，格式与bsp_console.c中Console_Benchmark()相同
+ */
+static void console_lines(u16 first, u16 n)
+{
+        u16 i;
+
+        for(i = first; i < first + n; i++)
+        {
+                Console_Printf("\x1B[3%cmline %5u\x1B[0m the quick brown fox\r\n", '1' + i % 7, i);
+        }
+}
+
+/**
+ * @Description 在整个屏幕上打开终端输出CONSOLE_LINES行，与不滚动时直接输出最后一屏各行的结果比较
+ */
+static void console_run(const char *name)
+{
+        HOST_LcdStatTypeDef stat;
+        u16 rows = lcddev.height / CONSOLE_SIZE;
+        int diff;
+
+        /* 基准：只输出最后一屏的各行(最下面一行是光标所在的空行)，不滚动 */
+        CHECK(Console_Init(0, lcddev.height, CONSOLE_SIZE) == 0, "%s: Console_Init failed", name);
+        console_lines(CONSOLE_LINES - rows + 1, rows - 1);
+        take_snapshot();
+
+        CHECK(Console_Init(0, lcddev.height, CONSOLE_SIZE) == 0, "%s: Console_Init failed", name);
+        Host_LcdStat(NULL, 1);
+        console_lines(0, CONSOLE_LINES);
+        Host_LcdStat(&stat, 1);
+        printf("  %-24s %u lines  %8.1f writes/line  bus %9.1f us  %7.0f lines/s\n", name, CONSOLE_LINES,
+               (double)(stat.cmd + stat.wdata + stat.dma) / CONSOLE_LINES, bus_us(&stat), CONSOLE_LINES / (bus_us(&stat) / 1e6));
+
+        diff = snapshot_diff();
+        CHECK(diff == 0, "%s: scrolled console differs from the last screen in %d points", name, diff);
+}
+
+static void scene_console(void)
+{
+        /* 竖屏使用硬件滚动，每次换行后滚动起始行下移一行 */
+        Lcd_DisplayDir(SCREEN_VERTICAL);
+        console_run("portrait (hw scroll)");
+        CHECK(Host_LcdDisplayRow(0) == (CONSOLE_LINES - HOST_LCD_HEIGHT / CONSOLE_SIZE + 1) % (HOST_LCD_HEIGHT / CONSOLE_SIZE) * CONSOLE_SIZE,
+              "display row 0 shows GRAM row %u", Host_LcdDisplayRow(0));
+        Console_Close();
+        CHECK(Host_LcdDisplayRow(0) == 0, "Console_Close did not reset scrolling");
+
+        /* 横屏没有硬件滚动，换行时整个区域重画 */
+        Lcd_DisplayDir(SCREEN_HORIZONTAL);
+        console_run("landscape (redraw)");
+        Console_Close();
+}
+
+static void scene_landscape(void)
+{
+        Lcd_DisplayDir(SCREEN_HORIZONTAL);
+        Lcd_ClearScreen(WHITE);
+        print_stat("DisplayDir + clear");
+
+        CHECK(lcddev.width == 800 && lcddev.height == 480, "landscape screen %ux%u", lcddev.width, lcddev.height);
+        Lcd_Fill(0, 0, 99, 49, RED);
+        Lcd_Fill(700, 430, 799, 479, BLUE);
+        POINT_COLOR = BLACK;
+        Lcd_ShowString(120, 10, 560, 24, 24, "Landscape 800x480");
+        Lcd_DrawLine(0, 479, 799, 0);
+        Draw_FillCircle(400, 240, 80);
+        print_stat("landscape drawing");
+
+        CHECK(rect_is(0, 0, 99, 49, RED) && rect_is(700, 430, 799, 479, BLUE), "landscape fills");
+        CHECK(Host_LcdPixel(100, 0) == WHITE && Host_LcdPixel(0, 50) == WHITE, "landscape fill overrun");
+        CHECK(readback(9) == 0, "landscape readback");
+}
+
+static void scene_portrait(void)
+{
+        Lcd_DisplayDir(SCREEN_VERTICAL);
+        draw_panel();
+        print_stat("draw_panel direct");
+        CHECK(readback(11) == 0, "portrait readback after landscape");
+}
+
+static void scene_framebuffer(void)
+{
+        HOST_LcdStatTypeDef direct, fb;
+        int diff;
+
+        take_snapshot();
+
+        /* 同一个画面画到帧缓冲中再刷新，GRAM必须与直接绘制相同 */
+        Lcd_ClearScreen(BLACK);
+        Host_LcdStat(NULL, 1);
+        Lcd_FrameBufferCmd(ENABLE);
+        draw_panel();
+        Lcd_Flush();
+        print_stat("draw_panel + Lcd_Flush");
+        diff = snapshot_diff();
+        CHECK(diff == 0, "frame buffer result differs from direct drawing in %d points", diff);
+
+        /* 局部更新：只刷新变化的数字 */
+        Lcd_ShowInt(20, 370, 654321, 16);
+        Lcd_Flush();
+        Host_LcdStat(&fb, 1);
+        printf("  %-24s cmd %7u  cpu data %7u  dma data %7u  read %6u\n", "Lcd_ShowInt + Lcd_Flush", fb.cmd, fb.wdata, fb.dma, fb.rdata);
+        Lcd_FrameBufferCmd(DISABLE);
+        take_snapshot();
+
+        Lcd_ShowInt(20, 370, 123456, 16);
+        Host_LcdStat(NULL, 1);
+        Lcd_ShowInt(20, 370, 654321, 16);
+        Host_LcdStat(&direct, 1);
+        printf("  %-24s cmd %7u  cpu data %7u  dma data %7u  read %6u\n", "Lcd_ShowInt direct", direct.cmd, direct.wdata, direct.dma, direct.rdata);
+        diff = snapshot_diff();
+        CHECK(diff == 0, "partial flush differs from direct drawing in %d points", diff);
+        CHECK(fb.cmd < direct.cmd, "partial flush used %u commands, direct drawing %u", fb.cmd, direct.cmd);
+}
+
+static void scene_scroll(void)
+{
+        u16 y;
+
+        for(y = 0; y < 800; y += 100)
+        {
+                Lcd_Fill(0, y, 479, y + 99, (y / 100 & 1) ? CYAN : YELLOW);
+                POINT_COLOR = BLACK;
+                BACK_COLOR = (y / 100 & 1) ? CYAN : YELLOW;
+                Lcd_ShowInt(10, y + 40, y, 24);
+        }
+        BACK_COLOR = WHITE;
+        Host_LcdStat(NULL, 1);
+
+        Lcd_ScrollArea(100, 600);
+        Lcd_ScrollStart(300);
+        print_stat("Lcd_Scroll*");
+
+        CHECK(Host_LcdDisplayRow(99) == 99 && Host_LcdDisplayRow(700) == 700, "fixed areas scrolled");
+        CHECK(Host_LcdDisplayRow(100) == 300 && Host_LcdDisplayRow(499) == 699 && Host_LcdDisplayRow(500) == 100,
+              "scroll area shows GRAM rows %u..%u", Host_LcdDisplayRow(100), Host_LcdDisplayRow(699));
+        CHECK(Host_LcdPixel(0, 300) == CYAN, "scroll moved GRAM contents");
+}
+
+static const Scene scenes[] =
+{
+        { "init",        scene_init,        0 },
+        { "fill",        scene_fill,        0 },
+        { "fillrect",    scene_fillrect,    0 },
+        { "shapes",      scene_shapes,      0 },
+        { "text",        scene_text,        0 },
+        { "glyph",       scene_glyph,       0 },
+        { "widget",      scene_widget,      0 },
+        { "readback",    scene_readback,    0 },
+        { "blit",        scene_blit,        0 },
+        { "image",       scene_image,       1 },
+        { "console",     scene_console,     1 },
+        { "landscape",   scene_landscape,   1 },
+        { "portrait",    scene_portrait,    0 },
+        { "framebuffer", scene_framebuffer, 0 },
+        { "scroll",      scene_scroll,      0 },
+};
+
+/**
+ * @Description 把面板显示的内容转换为RGB888，横屏时逆时针旋转为800*480，与驱动的横屏方向相同
+ */
+static void render(u8 landscape, u16 *width, u16 *height)
+{
+        u16 x, y, col, row, color;
+        u8 *p = rgb;
+
+        *width = landscape ? HOST_LCD_HEIGHT : HOST_LCD_WIDTH;
+        *height = landscape ? HOST_LCD_WIDTH : HOST_LCD_HEIGHT;
+        for(y = 0; y < *height; y++)
+        {
+                for(x = 0; x < *width; x++)
+                {
+                        col = landscape ? y : x;
+                        row = landscape ? HOST_LCD_HEIGHT - 1 - x : y;
+                        color = Host_LcdDisplayOn() ? Host_LcdGram(col, Host_LcdDisplayRow(row)) : 0;
+                        *p++ = ((color >> 11) & 0x1F) * 255 / 31;
+                        *p++ = ((color >> 5) & 0x3F) * 255 / 63;
+                        *p++ = (color & 0x1F) * 255 / 31;
+                }
+        }
+}
+
+static u32 crc32(u32 crc, const u8 *p, u32 n)
+{
+        static u32 table[256];
+        u32 i, j, c;
+
+        if(table[1] == 0)
+        {
+                for(i = 0; i < 256; i++)
+                {
+                        for(c = i, j = 0; j < 8; j++)
+                        {
+                                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                        }
+                        table[i] = c;
+                }
+        }
+        crc = ~crc;
+        while(n--)
+        {
+                crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+}
+
+static void put_be32(u8 *p, u32 v)
+{
+        p[0] = v >> 24;
+        p[1] = v >> 16;
+        p[2] = v >> 8;
+        p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const u8 *data, u32 len)
+{
+        u8 head[8], tail[4];
+        u32 crc;
+
+        put_be32(head, len);
+        memcpy(head + 4, type, 4);
+        crc = crc32(crc32(0, head + 4, 4), data, len);
+        put_be32(tail, crc);
+        fwrite(head, 1, 8, f);
+        fwrite(data, 1, len, f);
+        fwrite(tail, 1, 4, f);
+}
+
+/**
+ * @Description 保存为PNG，zlib数据流只使用不压缩的存储块，不依赖zlib
+ */
+static int write_png(const char *path, u16 width, u16 height)
+{
+        u32 line = 1 + width * 3, raw_len = line * height;
+        u32 blocks = (raw_len + 65534) / 65535;
+        u8 *z = malloc(2 + raw_len + blocks * 5 + 4);
+        u8 ihdr[13];
+        u32 a = 1, b = 0, i, n, pos = 0, zlen = 0;
+        u8 byte;
+        FILE *f;
+
+        if(z == NULL || (f = fopen(path, "wb")) == NULL)
+        {
+                free(z);
+                return -1;
+        }
+
+        z[zlen++] = 0x78;
+        z[zlen++] = 0x01;
+        while(pos < raw_len)
+        {
+                n = (raw_len - pos > 65535) ? 65535 : raw_len - pos;
+                z[zlen++] = (pos + n == raw_len);
+                z[zlen++] = n & 0xFF;
+                z[zlen++] = n >> 8;
+                z[zlen++] = ~n & 0xFF;
+                z[zlen++] = (~n >> 8) & 0xFF;
+                for(i = 0; i < n; i++, pos++)
+                {
+                        /* 每行前面是过滤类型0 */
+                        byte = (pos % line == 0) ? 0 : rgb[pos / line * width * 3 + pos % line - 1];
+                        z[zlen++] = byte;
+                        a = (a + byte) % 65521;
+                        b = (b + a) % 65521;
+                }
+        }
+        put_be32(z + zlen, (b << 16) | a);
+        zlen += 4;
+
+        put_be32(ihdr, width);
+        put_be32(ihdr + 4, height);
+        ihdr[8] = 8;                                    // 每个分量8位
+        ihdr[9] = 2;                                    // RGB
+        ihdr[10] = 0;
+        ihdr[11] = 0;
+        ihdr[12] = 0;
+        fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+        png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+        png_chunk(f, "IDAT", z, zlen);
+        png_chunk(f, "IEND", NULL, 0);
+        fclose(f);
+        free(z);
+        return 0;
+}
+
+static int write_ppm(const char *path, u16 width, u16 height)
+{
+        FILE *f = fopen(path, "wb");
+
+        if(f == NULL)
+        {
+                return -1;
+        }
+        fprintf(f, "P6\n%u %u\n255\n", width, height);
+        fwrite(rgb, 3, (u32)width * height, f);
+        fclose(f);
+        return 0;
+}
+
+/**
+ * @Description 与基准图像比较
+ * @return int  不同的点数，-1表示基准图像不存在或尺寸不同
+ */
+static int compare_ppm(const char *path, u16 width, u16 height)
+{
+        static u8 ref[sizeof(rgb)];
+        unsigned int w, h, max;
+        u32 i, n = (u32)width * height;
+        int diff = 0;
+        FILE *f = fopen(path, "rb");
+
+        if(f == NULL)
+        {
+                return -1;
+        }
+        if(fscanf(f, "P6 %u %u %u", &w, &h, &max) != 3 || w != width || h != height || max != 255 ||
+           fgetc(f) == EOF || fread(ref, 3, n, f) != n)
+        {
+                fclose(f);
+                return -1;
+        }
+        fclose(f);
+
+        for(i = 0; i < n; i++)
+        {
+                if(memcmp(ref + i * 3, rgb + i * 3, 3) != 0)
+                {
+                        if(diff == 0)
+                        {
+                                printf("  first difference at (%u,%u)\n", i % width, i / width);
+                        }
+                        diff++;
+                }
+        }
+        return diff;
+}
+
+int main(int argc, char *argv[])
+{
+        const char *write_dir = NULL, *compare_dir = NULL;
+        char path[512];
+        u16 width, height;
+        int i, before, diff;
+
+        if(argc == 3 && strcmp(argv[1], "-w") == 0)
+        {
+                write_dir = argv[2];
+        }
+        else if(argc == 3 && strcmp(argv[1], "-c") == 0)
+        {
+                compare_dir = argv[2];
+        }
+        else if(argc != 1)
+        {
+                printf("usage: lcdsim [-w dir | -c dir]\n");
+                return 2;
+        }
+
+        for(i = 0; i < (int)(sizeof(scenes) / sizeof(scenes[0])); i++)
+        {
+                printf("%02d_%s\n", i, scenes[i].name);
+                before = failures;
+                Host_LcdStat(NULL, 1);
+                scenes[i].draw();
+                render(scenes[i].landscape, &width, &height);
+
+                if(write_dir)
+                {
+                        snprintf(path, sizeof(path), "%s/%02d_%s.ppm", write_dir, i, scenes[i].name);
+                        CHECK(write_ppm(path, width, height) == 0, "cannot write %s", path);
+                        snprintf(path, sizeof(path), "%s/%02d_%s.png", write_dir, i, scenes[i].name);
+                        CHECK(write_png(path, width, height) == 0, "cannot write %s", path);
+                }
+                if(compare_dir)
+                {
+                        snprintf(path, sizeof(path), "%s/%02d_%s.ppm", compare_dir, i, scenes[i].name);
+                        diff = compare_ppm(path, width, height);
+                        CHECK(diff == 0, "%s: %d points differ", path, diff);
+                }
+                printf("  %s\n", (failures == before) ? "ok" : "FAILED");
+        }
+
+        printf("%d failures\n", failures);
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,428 @@
+/**
+ * logdec.c 上位机日志解码工具，把bsp_log.c发送的延迟格式化日志还原为文本，格式见bsp_log.h
+ *
+ * 编译：gcc -O2 -o logdec logdec.c
+ * 用法：logdec STM32F4.axf /dev/ttyUSB0 115200         从串口接收，Ctrl+C结束
+ *       logdec STM32F4.axf capture.bin                 解码保存下来的原始数据
+ *
+ * axf文件必须与开发板上运行的程序是同一次编译生成的，格式字符串按地址从axf中取出。
+ * 每条日志前面加上DWT时间戳(按SYSTEM_CLOCK换算为毫秒)，串口上的printf文本原样输出。
+ * 支持的转换：%d %i %u %x %X %o %c %p %s(Flash中的字符串常量) %f %e %g(参数用LOG_FLOAT()转换)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <elf.h>
+
+/* 与bsp_telemetry.h、bsp_log.h、bsp_systick.h保持一致 */
+#define TELEMETRY_VALUE_MAX     64
+#define TELEMETRY_HEAD_SIZE     4
+#define TELEMETRY_U32           5
+#define LOG_TELEMETRY_ID        0xFF
+#define SYSTEM_CLOCK            168
+#define FRAME_MAX               (TELEMETRY_HEAD_SIZE + TELEMETRY_VALUE_MAX + 4 + 2)
+
+static unsigned char *image;                            // axf文件内容
+static Elf32_Shdr *sections;
+static unsigned section_num;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+        (void)sig;
+        stop = 1;
+}
+
+/**
+ * @Description 读入axf(ELF)文件，记下各段的位置
+ * @return int  0:成功
+ */
+static int load_elf(const char *path)
+{
+        FILE *fp = fopen(path, "rb");
+        Elf32_Ehdr *eh;
+        long size;
+
+        if(fp == NULL)
+        {
+                perror(path);
+                return -1;
+        }
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        image = malloc(size);
+        if(fread(image, 1, size, fp) != (size_t)size)
+        {
+                fclose(fp);
+                return -1;
+        }
+        fclose(fp);
+
+        eh = (Elf32_Ehdr *)image;
+        if(size < (long)sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS32 ||
+           eh->e_shoff + (long)eh->e_shnum * sizeof(Elf32_Shdr) > (unsigned long)size)
+        {
+                fprintf(stderr, "%s: not a 32-bit ELF file\n", path);
+                return -1;
+        }
+        sections = (Elf32_Shdr *)(image + eh->e_shoff);
+        section_num = eh->e_shnum;
+
+        return 0;
+}
+
+/**
+ * @Description 按开发板上的地址找到axf中的字符串
+ * @return const char* 字符串，不在任何有内容的段中时返回NULL
+ */
+static const char *elf_string(uint32_t addr)
+{
+        unsigned i;
+
+        for(i = 0; i < section_num; i++)
+        {
+                Elf32_Shdr *sh = &sections[i];
+                if(sh->sh_type == SHT_PROGBITS && (sh->sh_flags & SHF_ALLOC) && addr >= sh->sh_addr && addr - sh->sh_addr < sh->sh_size)
+                {
+                        return (const char *)image + sh->sh_offset + (addr - sh->sh_addr);
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * @Description 按格式字符串和u32参数格式化一条日志
+ */
+static void format_log(const char *fmt, const uint32_t *arg, unsigned argc)
+{
+        char spec[32];
+        unsigned k, a = 0;
+        const char *s;
+        float f;
+
+        while(*fmt != '\0')
+        {
+                if(*fmt != '%')
+                {
+                        if(*fmt != '\r')
+                        {
+                                putchar(*fmt);
+                        }
+                        fmt++;
+                        continue;
+                }
+                if(fmt[1] == '%')
+                {
+                        putchar('%');
+                        fmt += 2;
+                        continue;
+                }
+
+                /* 取出标志、宽度和精度，去掉长度修饰符 */
+                k = 0;
+                spec[k++] = *fmt++;
+                while(*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL && k < sizeof(spec) - 2)
+                {
+                        spec[k++] = *fmt++;
+                }
+                while(*fmt == 'l' || *fmt == 'h' || *fmt == 'z')
+                {
+                        fmt++;
+                }
+                if(*fmt == '\0')
+                {
+                        break;
+                }
+                spec[k++] = *fmt;
+                spec[k] = '\0';
+
+                if(a >= argc)
+                {
+                        printf("<missing>");
+                        fmt++;
+                        continue;
+                }
+
+                switch(*fmt++)
+                {
+                case 'd':
+                case 'i':
+                        printf(spec, (int)(int32_t)arg[a]);
+                        break;
+                case 'u':
+                case 'x':
+                case 'X':
+                case 'o':
+                case 'c':
+                        printf(spec, (unsigned)arg[a]);
+                        break;
+                case 'p':
+                        printf("0x%08X", (unsigned)arg[a]);
+                        break;
+                case 's':
+                        s = elf_string(arg[a]);
+                        if(s != NULL)
+                        {
+                                printf(spec, s);
+                        }
+                        else
+                        {
+                                printf("<0x%08X>", (unsigned)arg[a]);
+                        }
+                        break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                        memcpy(&f, &arg[a], 4);
+                        printf(spec, (double)f);
+                        break;
+                default:
+                        printf("<%s>", spec);
+                        break;
+                }
+                a++;
+        }
+}
+
+/**
+ * @Description 与STM32 CRC单元相同的CRC-32，见telrec.c
+ */
+static uint32_t crc32_stm32(const uint8_t *data, size_t len)
+{
+        uint32_t crc = 0xFFFFFFFF, word;
+        size_t i;
+        int bit;
+
+        for(i = 0; i < len; i += 4)
+        {
+                word = data[i];
+                word |= (i + 1 < len) ? (uint32_t)data[i + 1] << 8 : 0;
+                word |= (i + 2 < len) ? (uint32_t)data[i + 2] << 16 : 0;
+                word |= (i + 3 < len) ? (uint32_t)data[i + 3] << 24 : 0;
+
+                crc ^= word;
+                for(bit = 0; bit < 32; bit++)
+                {
+                        crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+                }
+        }
+
+        return crc;
+}
+
+/**
+ * @Description COBS解码，输入不含结束符
+ * @return long 解码后的字节数，格式错误时返回-1
+ */
+static long cobs_decode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+        size_t i = 0, n = 0;
+        unsigned code, j;
+
+        while(i < len)
+        {
+                code = src[i++];
+                if(code == 0 || i + code - 1 > len)
+                {
+                        return -1;
+                }
+                for(j = 1; j < code; j++)
+                {
+                        dst[n++] = src[i++];
+                }
+                if(code != 0xFF && i < len)
+                {
+                        dst[n++] = 0;
+                }
+        }
+
+        return n;
+}
+
+/**
+ * @Description 处理一个以0x00结束的帧，不是日志记录时如果是文本则原样输出
+ * @return int  1:日志 0:文本或其他遥测记录 -1:无法识别
+ */
+static int handle_frame(const uint8_t *frame, size_t flen, unsigned *lost)
+{
+        static unsigned last_seq;
+        static int have_seq = 0;
+        uint8_t record[FRAME_MAX];
+        uint32_t word[(FRAME_MAX + 3) / 4];
+        unsigned seq, i, argc;
+        const char *fmt;
+        long len;
+
+        len = (flen <= sizeof(record)) ? cobs_decode(frame, flen, record) : -1;
+        if(len >= TELEMETRY_HEAD_SIZE + 4 && crc32_stm32(record, len - 4) ==
+           (record[len - 4] | (uint32_t)record[len - 3] << 8 | (uint32_t)record[len - 2] << 16 | (uint32_t)record[len - 1] << 24))
+        {
+                seq = record[2] | (record[3] << 8);
+                if(have_seq)
+                {
+                        *lost += (seq - last_seq - 1) & 0xFFFF;
+                }
+                last_seq = seq;
+                have_seq = 1;
+
+                len -= TELEMETRY_HEAD_SIZE + 4;
+                if(record[0] != LOG_TELEMETRY_ID || record[1] != TELEMETRY_U32 || len < 8 || len % 4 != 0)
+                {
+                        return 0;
+                }
+
+                for(i = 0; i < len / 4; i++)
+                {
+                        const uint8_t *p = record + TELEMETRY_HEAD_SIZE + i * 4;
+                        word[i] = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+                }
+                argc = len / 4 - 2;
+
+                printf("[%10.3f] ", word[1] / (SYSTEM_CLOCK * 1000.0));
+                fmt = elf_string(word[0]);
+                if(fmt != NULL)
+                {
+                        format_log(fmt, word + 2, argc);
+                }
+                else
+                {
+                        printf("<unknown format 0x%08X>\n", (unsigned)word[0]);
+                }
+                return 1;
+        }
+
+        /* 不是有效的帧，可打印的按文本输出 */
+        for(i = 0; i < flen; i++)
+        {
+                if((frame[i] < 0x20 || frame[i] > 0x7E) && frame[i] != '\r' && frame[i] != '\n' && frame[i] != '\t')
+                {
+                        return -1;
+                }
+        }
+        for(i = 0; i < flen; i++)
+        {
+                if(frame[i] != '\r')
+                {
+                        putchar(frame[i]);
+                }
+        }
+        return 0;
+}
+
+static speed_t baud_speed(long baud)
+{
+        switch(baud)
+        {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+        default: return 0;
+        }
+}
+
+int main(int argc, char *argv[])
+{
+        static uint8_t text[4096];
+        uint8_t buf[4096];
+        size_t flen = 0;
+        unsigned long logs = 0, errors = 0;
+        unsigned lost = 0;
+        long n, i;
+        int fd, res;
+
+        if(argc != 3 && argc != 4)
+        {
+                fprintf(stderr, "usage: %s firmware.axf device baud\n       %s firmware.axf capture.bin\n", argv[0], argv[0]);
+                return 1;
+        }
+        if(load_elf(argv[1]) != 0)
+        {
+                return 1;
+        }
+
+        fd = open(argv[2], O_RDONLY | O_NOCTTY);
+        if(fd < 0)
+        {
+                perror(argv[2]);
+                return 1;
+        }
+
+        /* 串口设置为原始模式 */
+        if(argc == 4)
+        {
+                struct termios tio;
+                speed_t speed = baud_speed(atol(argv[3]));
+
+                if(speed == 0 || tcgetattr(fd, &tio) != 0)
+                {
+                        fprintf(stderr, "%s: unsupported device or baud rate\n", argv[2]);
+                        return 1;
+                }
+                cfmakeraw(&tio);
+                cfsetispeed(&tio, speed);
+                cfsetospeed(&tio, speed);
+                tio.c_cc[VMIN] = 1;
+                tio.c_cc[VTIME] = 0;
+                tcsetattr(fd, TCSANOW, &tio);
+        }
+
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+
+        /* 文本中没有0x00，一直收集到下一个0x00或缓冲满，日志帧前后都有0x00 */
+        while(!stop && (n = read(fd, buf, sizeof(buf))) > 0)
+        {
+                for(i = 0; i < n; i++)
+                {
+                        if(buf[i] != 0 && flen < sizeof(text))
+                        {
+                                text[flen++] = buf[i];
+                                continue;
+                        }
+
+                        if(flen != 0)
+                        {
+                                res = handle_frame(text, flen, &lost);
+                                logs += (res == 1);
+                                errors += (res < 0);
+                        }
+                        flen = 0;
+                        if(buf[i] != 0)
+                        {
+                                text[flen++] = buf[i];
+                        }
+                }
+                fflush(stdout);
+        }
+        if(flen != 0)
+        {
+                res = handle_frame(text, flen, &lost);
+                logs += (res == 1);
+                errors += (res < 0);
+        }
+
+        fflush(stdout);
+        fprintf(stderr, "%lu logs, %lu bad frames, %u records lost\n", logs, errors, lost);
+        close(fd);
+        return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * schedsim.c 上位机调度器测试，在串口模型和模拟时钟上运行stm32f4.library.usart-master的串口回显实验，
+ * 比较原来delay_ms(10)轮询的主循环和System/explore_sched.c协作式调度器的回显延迟
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -Wno-unknown-pragmas
+ *           "-DSYSTICK_CYCCNT()=Host_Cyccnt()" "-DSCHED_IDLE()=Host_Wfi()" -Dmain=demo_main -Dprintf=demo_printf
+ *           -I host -I ../User -I ../Libraries -I ../../stm32f4.library.usart-master/System
+ *           -I ../../stm32f4.library.usart-master/Driver -o schedsim schedsim.c
+ *           ../../stm32f4.library.usart-master/User/stm32f4xx_main.c ../../stm32f4.library.usart-master/System/explore_sched.c
+ *           ../../stm32f4.library.usart-master/System/explore_systick.c ../../stm32f4.library.usart-master/System/explore_usart.c
+ *           ../../stm32f4.library.usart-master/Driver/driver_led.c host/host.c host/periph.c host/usart.c
+ * 用法：schedsim
+ *
+ * 实验的main()编译为demo_main()，printf编译为demo_printf()，与Keil的printf一样格式化后每个字符调用一次实验中的fputc()。
+ * 主机在随机的时间从RX线上发送一行，收到回显后再发送下一行；回显延迟是这一行最后一个字节到达到
+ * 实验开始打印"Your input is: "的模拟时间。两种方式各在一个子进程中运行LINE_NUM行：
+ *       轮询：原来的主循环，每10ms查询一次接收完成标志，照原样写在本文件中(回显与现在的实验一样用一次printf)；
+ *       调度器：实验现在的demo_main()，回显任务由串口中断就绪，空闲时Host_Wfi()让时间前进到下一个中断。
+ * 两种方式的输出都经过同一个发送缓冲，每一行的回显都必须完整地出现在TX线上。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "explore_systick.h"
+#include "explore_usart.h"
+#include "driver_led.h"
+#include "usart.h"
+
+#undef main
+#undef printf
+
+/* stdio.h中的printf被-Dprintf换成了demo_printf，本文件自己的输出仍然用C库的printf */
+int printf(const char *fmt, ...);
+
+#define LINE_NUM                200
+#define LINE_GAP_MAX_MS         300                     // 收到回显后到发送下一行的最长间隔
+#define CYCLES_PER_US           (HOST_CLOCK_HZ / 1000000)
+
+int demo_main(void);
+
+static int failures;
+static uint64_t line_end;                               // 当前一行最后一个字节到达的时间，0表示没有等待回显的行
+static uint64_t line_next = UINT64_MAX;                 // 发送下一行的时间
+static u32 line_count;
+static uint64_t latency_sum, latency_max;
+static u32 latency_hist[4];                             // <100us, <1ms, <10ms, >=10ms
+static char expect[LINE_NUM * 32];
+static u32 expect_len;
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @Description 检查TX线上按顺序出现了每一行的回显，输出统计
+ * @notice      在时钟事件中调用，最后一行回显之后至少过了1ms，回显已经发完
+ */
+static void finish(const char *name)
+{
+        const u8 *wire;
+        const char *pos;
+        char *text;
+        u32 len, found = 0, reports = 0;
+        char line[32];
+        int i, off = 0;
+
+        wire = Host_UsartTxData(&len);
+        text = malloc(len + 1);
+        memcpy(text, wire, len);
+        text[len] = '\0';
+        pos = text;
+        for(i = 0; i < (int)line_count; i++)
+        {
+                sscanf(expect + off, "%31[^\n]\n", line);
+                off += strlen(line) + 1;
+                pos = strstr(pos, line);
+                if(pos == NULL)
+                {
+                        break;
+                }
+                found++;
+        }
+        for(pos = text; (pos = strstr(pos, "task      runs")) != NULL; pos++)
+        {
+                reports++;
+        }
+        free(text);
+
+        printf("  %-10s %u lines, echo latency avg %8.1f us, max %8.1f us; <100us %u, <1ms %u, <10ms %u, >=10ms %u\n",
+               name, line_count, (double)latency_sum / line_count / CYCLES_PER_US, (double)latency_max / CYCLES_PER_US,
+               latency_hist[0], latency_hist[1], latency_hist[2], latency_hist[3]);
+        CHECK(found == line_count, "%s: %u of %u echoes on the wire", name, found, line_count);
+        if(strcmp(name, "scheduler") == 0)
+        {
+                /* 回显任务优先级最高，只可能等待正在执行的任务，Sched_Report()写满发送缓冲时最长 */
+                CHECK(reports > 0, "no Sched_Report() table on the wire");
+                CHECK(latency_sum / line_count < 100 * CYCLES_PER_US, "average echo latency above 100 us");
+        }
+}
+
+/**
+ * @Description 实验中的printf，开始回显时记录延迟
+ */
+int demo_printf(const char *fmt, ...)
+{
+        char buf[256];
+        uint64_t latency;
+        va_list ap;
+        int i, n;
+
+        if(strncmp(fmt, "Your input is", 13) == 0 && line_end != 0)
+        {
+                latency = Host_Cycles() - line_end;
+                latency_sum += latency;
+                if(latency > latency_max)
+                {
+                        latency_max = latency;
+                }
+                latency_hist[latency < 100 * CYCLES_PER_US ? 0 : latency < 1000 * CYCLES_PER_US ? 1 :
+                             latency < 10000 * CYCLES_PER_US ? 2 : 3]++;
+                line_end = 0;
+                line_next = Host_Cycles() + (uint64_t)(rand() % (LINE_GAP_MAX_MS * 1000) + 1) * CYCLES_PER_US;
+        }
+
+        va_start(ap, fmt);
+        n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        for(i = 0; i < n && i < (int)sizeof(buf) - 1; i++)
+        {
+                fputc(buf[i], stdout);
+        }
+        return n;
+}
+
+static uint64_t host_next(void)
+{
+        return line_next;
+}
+
+/**
+ * @Description 主机从RX线上发送一行，LINE_NUM行都回显之后结束
+ */
+static void host_event(void)
+{
+        char line[32];
+        int n;
+
+        line_next = UINT64_MAX;
+        if(line_count == LINE_NUM)
+        {
+                finish(getenv("SCHEDSIM_MODE"));
+                fflush(stdout);
+                exit(failures ? 1 : 0);
+        }
+        n = sprintf(line, "line %u %08x\r\n", line_count, (u32)rand());
+        Host_UsartReceive((const u8 *)line, n);
+        line_end = Host_Cycles() + (uint64_t)n * Host_UsartByteCycles();
+        line[n - 2] = '\n';
+        line[n - 1] = '\0';
+        memcpy(expect + expect_len, line, n - 1);
+        expect_len += n - 1;
+        line_count++;
+}
+
+/**
+ * @Description 原来的主循环，每10ms查询一次接收完成标志，每2秒打印提示，每300ms闪烁LED
+ */
+static void poll_main(void)
+{
+        u16 times = 0;
+        u8 len;
+
+        NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+        Systick_Init(168);
+        Usart_Init(115200);
+        LED_Init();
+
+        while(1)
+        {
+                if(USART_RX_STA & 0x8000)
+                {
+                        len = USART_RX_STA & 0x3fff;
+                        demo_printf("Your input is: %.*s\r\n", len, (char *)USART_RX_BUF);
+                        USART_RX_STA = 0;
+                }
+                else
+                {
+                        times++;
+                        if(times % 200 == 0)
+                        {
+                                demo_printf("I can output your input.\r\n");
+                        }
+                        if(times % 30 == 0)
+                        {
+                                DS0 = !DS0;
+                        }
+                        delay_ms(10);
+                }
+        }
+}
+
+/**
+ * @Description 在子进程中运行一种方式，返回子进程的结果
+ */
+static int run(const char *mode, void (*entry)(void))
+{
+        pid_t pid;
+        int status;
+
+        fflush(stdout);
+        pid = fork();
+        if(pid == 0)
+        {
+                setenv("SCHEDSIM_MODE", mode, 1);
+                srand(1);
+                Host_UsartAttach(USART1, NULL, NULL, USART1_IRQn);
+                Host_AddClockDevice(host_next, host_event);
+                line_next = 100 * 1000 * CYCLES_PER_US;
+                entry();
+                exit(2);
+        }
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 3;
+}
+
+static void sched_main(void)
+{
+        demo_main();
+}
+
+int main(int argc, char *argv[])
+{
+        printf("schedsim: usart demo, %u lines at 115200 baud, 0~%u ms apart\n", LINE_NUM, LINE_GAP_MAX_MS);
+        CHECK(run("poll", poll_main) == 0, "poll loop failed");
+        CHECK(run("scheduler", sched_main) == 0, "scheduler failed");
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * systicksim.c 上位机时间基准测试，在模拟的周期计数器和滴答定时器上运行User/bsp_systick.c，
+ * 检查64位周期数跨越32位溢出时单调连续、滴答中断推迟时跨越溢出不倒退，以及延时的精度
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER "-DSYSTICK_CYCCNT()=Host_Cyccnt()" -Wno-pointer-to-int-cast
+ *           -I host -I ../User -I ../Libraries -o systicksim systicksim.c ../User/bsp_systick.c host/host.c host/periph.c
+ * 用法：systicksim
+ *
+ * 时间是host.c中的模拟时间(168MHz周期)，SYSTICK_CYCCNT()编译为Host_Cyccnt()，每次读取时间前进一次查询循环。
+ * 溢出测试每隔一段时间读一次cycles()，跑过3次32位溢出，每次读到的值都必须在调用前后的模拟时间之间；
+ * 推迟的滴答中断用关中断模拟(相当于在更高优先级的中断中)，关中断期间计数器溢出，滴答中断挂起到开中断后才执行。
+ * 延时测试在主循环中delay_ms()/delay_us()的同时，EXTI0每3ms产生一次中断并在中断中delay_us()，
+ * 主循环的延时只多出被打断的最后一次中断的时间。
+ */
+
+#include <stdio.h>
+#include "bsp_systick.h"
+
+#define CYCLES_PER_US           (HOST_CLOCK_HZ / 1000000)
+#define WRAP                    ((uint64_t)1 << 32)
+#define SAMPLE_CYCLES           100003                  // 溢出测试读cycles()的间隔，与1ms的滴答错开
+#define EXTI_PERIOD             (3000 * CYCLES_PER_US)
+#define EXTI_DELAY_US           200
+#define READ_CYCLES             64                      // 一次cycles()经过的模拟时间的上限(读计数器和开关中断)
+
+static int failures;
+static u32 ticks;
+static uint64_t exti_next = UINT64_MAX;
+static u32 exti_count;
+static u32 exti_max_us;
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static void tick(void)
+{
+        ticks++;
+}
+
+static uint64_t exti_next_event(void)
+{
+        return exti_next;
+}
+
+static void exti_event(void)
+{
+        exti_next += EXTI_PERIOD;
+        Host_IrqRaise(EXTI0_IRQn);
+}
+
+/**
+ * @Description 比主循环和滴答中断优先级高的中断，在中断中延时
+ */
+void EXTI0_IRQHandler(void)
+{
+        uint64_t start = Host_Cycles();
+        u32 us;
+
+        delay_us(EXTI_DELAY_US);
+        us = (u32)((Host_Cycles() - start) / CYCLES_PER_US);
+        if(us > exti_max_us)
+        {
+                exti_max_us = us;
+        }
+        exti_count++;
+}
+
+/**
+ * @Description 读cycles()，检查读到的值在调用前后的模拟时间之间
+ */
+static uint64_t read_cycles(u8 *ok)
+{
+        uint64_t start = Host_Cycles();
+        uint64_t c = cycles();
+
+        *ok = (c > start && c <= Host_Cycles() && Host_Cycles() - start <= READ_CYCLES);
+        return c;
+}
+
+/**
+ * @Description 跑过3次溢出，cycles()跟随模拟时间，滴答中断次数等于经过的毫秒数
+ */
+static void test_wrap(void)
+{
+        uint64_t prev = 0, c;
+        u32 error = 0, back = 0;
+        u8 ok;
+
+        while(Host_Cycles() < 3 * WRAP + SAMPLE_CYCLES)
+        {
+                Host_Run(SAMPLE_CYCLES);
+                c = read_cycles(&ok);
+                if(!ok)
+                {
+                        error++;
+                }
+                if(c < prev)
+                {
+                        back++;
+                }
+                prev = c;
+        }
+        printf("  %.1f s, 3 wraps: cycles() %u mismatches, %u backwards, %u ticks\n",
+               (double)Host_Cycles() / HOST_CLOCK_HZ, error, back, ticks);
+        CHECK(error == 0 && back == 0, "cycles() does not follow the counter across wraps");
+        CHECK(ticks == Host_Cycles() / (HOST_CLOCK_HZ / SYSTICK_RATE), "%u ticks", ticks);
+        CHECK(millis() == Host_Cycles() / (HOST_CLOCK_HZ / 1000), "millis() %u", millis());
+        CHECK(micros() == (u32)(Host_Cycles() / CYCLES_PER_US), "micros() %u", micros());
+}
+
+/**
+ * @Description 关中断期间计数器溢出，滴答中断执行前后cycles()都连续
+ */
+static void test_late_tick(void)
+{
+        uint64_t wrap = (Host_Cycles() / WRAP + 1) * WRAP;
+        uint64_t before, during, after;
+        u32 ticks_before;
+        u8 ok;
+
+        Host_Run((u32)(wrap - Host_Cycles() - 1000));
+        before = cycles();
+
+        /* 溢出后5ms才开中断，其间的滴答中断挂起 */
+        __disable_irq();
+        ticks_before = ticks;
+        Host_Run(1000 + 5 * (HOST_CLOCK_HZ / 1000));
+        during = read_cycles(&ok);
+        CHECK(ticks == ticks_before, "tick ran with interrupts disabled");
+        CHECK(ok && during > before, "cycles() %llu before the late tick at %llu",
+              (unsigned long long)during, (unsigned long long)Host_Cycles());
+        __enable_irq();
+
+        after = read_cycles(&ok);
+        CHECK(ticks == ticks_before + 1, "%u pending ticks ran", ticks - ticks_before);
+        CHECK(ok && after > during, "cycles() %llu after the late tick at %llu",
+              (unsigned long long)after, (unsigned long long)Host_Cycles());
+        printf("  late tick across wrap %u: %llu -> %llu -> %llu\n", (u32)(wrap / WRAP),
+               (unsigned long long)before, (unsigned long long)during, (unsigned long long)after);
+}
+
+/**
+ * @Description 主循环延时，测量经过的模拟时间
+ * @return u32  实际延时的微秒数
+ */
+static u32 measure_us(u32 us)
+{
+        uint64_t start = Host_Cycles();
+
+        if(us % 1000 == 0 && us / 1000 <= 65535)
+        {
+                delay_ms((u16)(us / 1000));
+        }
+        else
+        {
+                delay_us(us);
+        }
+        return (u32)((Host_Cycles() - start) / CYCLES_PER_US);
+}
+
+/**
+ * @Description 延时不短于要求，多出的时间不超过一次查询，中断中的延时被打断的部分
+ */
+static void test_delay(const char *name, u32 us, u32 slack_us)
+{
+        u32 n = exti_count;
+        u32 got = measure_us(us);
+
+        printf("  %-24s %10u us, %3u EXTI0 interrupts\n", name, got, exti_count - n);
+        CHECK(got >= us && got <= us + 1 + slack_us, "%s took %u us", name, got);
+}
+
+int main(int argc, char *argv[])
+{
+        NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+        Systick_Init();
+        Systick_SetTickHandler(tick);
+        Host_AddClockDevice(exti_next_event, exti_event);
+
+        printf("systicksim: %u MHz, %u Hz tick\n", SYSTEM_CLOCK, SYSTICK_RATE);
+        test_wrap();
+        test_late_tick();
+
+        test_delay("delay_us(7)", 7, 0);
+        test_delay("delay_ms(1500)", 1500000, 0);
+        test_delay("delay_us(3000000)", 3000000, 0);
+
+        /* EXTI0比滴答中断优先级高 */
+        Host_IrqConfig(EXTI0_IRQn, 0x04, 1);
+        exti_next = Host_Cycles() + EXTI_PERIOD / 2;
+        test_delay("delay_ms(100) with EXTI0", 100000, EXTI_DELAY_US);
+        test_delay("delay_us(2500000) with EXTI0", 2500000, EXTI_DELAY_US);
+        exti_next = UINT64_MAX;
+        printf("  EXTI0 delay_us(%u): max %u us\n", EXTI_DELAY_US, exti_max_us);
+        CHECK(exti_max_us >= EXTI_DELAY_US && exti_max_us <= EXTI_DELAY_US + 1, "EXTI0 delay %u us", exti_max_us);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
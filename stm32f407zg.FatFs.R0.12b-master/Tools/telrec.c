@@ -0,0 +1,232 @@
+/**
+ * telrec.c 上位机遥测数据接收工具，把bsp_telemetry.c发送的二进制记录解码为CSV，格式见bsp_telemetry.h
+ *
+ * 编译：gcc -O2 -o telrec telrec.c
+ * 用法：telrec /dev/ttyUSB0 921600 > data.csv        从串口接收，Ctrl+C结束
+ *       telrec capture.bin > data.csv                 解码保存下来的原始数据
+ *
+ * 每条记录输出一行：id,seq,数值1,数值2,...
+ * 结束时在标准错误上输出帧数、校验错误数和按序号统计的丢失记录数。
+ * 串口上的printf文本与二进制帧混在一起时，文本会作为校验错误的帧丢弃，不影响后面的帧。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+/* 与bsp_telemetry.h保持一致 */
+#define TELEMETRY_VALUE_MAX     64
+#define TELEMETRY_HEAD_SIZE     4
+#define FRAME_MAX               (TELEMETRY_HEAD_SIZE + TELEMETRY_VALUE_MAX + 4 + 2)
+
+static const unsigned value_size[] = { 0, 1, 2, 2, 4, 4, 4 };
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+        (void)sig;
+        stop = 1;
+}
+
+/**
+ * @Description 与STM32 CRC单元相同的CRC-32：多项式0x04C11DB7，初值0xFFFFFFFF，不反转，
+ *              数据按u32小端分组，每个字从最高位开始计算，最后不足4字节的部分补0
+ */
+static uint32_t crc32_stm32(const uint8_t *data, size_t len)
+{
+        uint32_t crc = 0xFFFFFFFF, word;
+        size_t i;
+        int bit;
+
+        for(i = 0; i < len; i += 4)
+        {
+                word = data[i];
+                word |= (i + 1 < len) ? (uint32_t)data[i + 1] << 8 : 0;
+                word |= (i + 2 < len) ? (uint32_t)data[i + 2] << 16 : 0;
+                word |= (i + 3 < len) ? (uint32_t)data[i + 3] << 24 : 0;
+
+                crc ^= word;
+                for(bit = 0; bit < 32; bit++)
+                {
+                        crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+                }
+        }
+
+        return crc;
+}
+
+/**
+ * @Description COBS解码，输入不含结束符
+ * @return long 解码后的字节数，格式错误时返回-1
+ */
+static long cobs_decode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+        size_t i = 0, n = 0;
+        unsigned code, j;
+
+        while(i < len)
+        {
+                code = src[i++];
+                if(code == 0 || i + code - 1 > len)
+                {
+                        return -1;
+                }
+                for(j = 1; j < code; j++)
+                {
+                        dst[n++] = src[i++];
+                }
+                if(code != 0xFF && i < len)
+                {
+                        dst[n++] = 0;
+                }
+        }
+
+        return n;
+}
+
+static speed_t baud_speed(long baud)
+{
+        switch(baud)
+        {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+        default: return 0;
+        }
+}
+
+int main(int argc, char *argv[])
+{
+        uint8_t frame[FRAME_MAX], record[FRAME_MAX], buf[4096];
+        size_t flen = 0;
+        unsigned long frames = 0, errors = 0, lost = 0;
+        long n, len, i;
+        unsigned format, count, k, seq, last_seq = 0;
+        int fd, have_seq = 0;
+        const uint8_t *v;
+
+        if(argc != 2 && argc != 3)
+        {
+                fprintf(stderr, "usage: %s device baud > out.csv\n       %s capture.bin > out.csv\n", argv[0], argv[0]);
+                return 1;
+        }
+
+        fd = open(argv[1], O_RDONLY | O_NOCTTY);
+        if(fd < 0)
+        {
+                perror(argv[1]);
+                return 1;
+        }
+
+        /* 串口设置为原始模式 */
+        if(argc == 3)
+        {
+                struct termios tio;
+                speed_t speed = baud_speed(atol(argv[2]));
+
+                if(speed == 0 || tcgetattr(fd, &tio) != 0)
+                {
+                        fprintf(stderr, "%s: unsupported device or baud rate\n", argv[1]);
+                        return 1;
+                }
+                cfmakeraw(&tio);
+                cfsetispeed(&tio, speed);
+                cfsetospeed(&tio, speed);
+                tio.c_cc[VMIN] = 1;
+                tio.c_cc[VTIME] = 0;
+                tcsetattr(fd, TCSANOW, &tio);
+        }
+
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+
+        while(!stop && (n = read(fd, buf, sizeof(buf))) > 0)
+        {
+                for(i = 0; i < n; i++)
+                {
+                        if(buf[i] != 0)
+                        {
+                                /* 太长的不是有效的帧，丢弃到下一个结束符 */
+                                if(flen < sizeof(frame))
+                                {
+                                        frame[flen] = buf[i];
+                                }
+                                flen++;
+                                continue;
+                        }
+
+                        /* 连续的结束符 */
+                        if(flen == 0)
+                        {
+                                continue;
+                        }
+
+                        len = (flen <= sizeof(frame)) ? cobs_decode(frame, flen, record) : -1;
+                        flen = 0;
+                        if(len < TELEMETRY_HEAD_SIZE + 4 || crc32_stm32(record, len - 4) !=
+                           (record[len - 4] | (uint32_t)record[len - 3] << 8 | (uint32_t)record[len - 2] << 16 | (uint32_t)record[len - 1] << 24))
+                        {
+                                errors++;
+                                continue;
+                        }
+
+                        format = record[1];
+                        len -= TELEMETRY_HEAD_SIZE + 4;
+                        if(format == 0 || format >= sizeof(value_size) / sizeof(value_size[0]) || len % value_size[format] != 0)
+                        {
+                                errors++;
+                                continue;
+                        }
+
+                        /* 按序号统计丢失的记录 */
+                        seq = record[2] | (record[3] << 8);
+                        if(have_seq)
+                        {
+                                lost += (seq - last_seq - 1) & 0xFFFF;
+                        }
+                        last_seq = seq;
+                        have_seq = 1;
+                        frames++;
+
+                        printf("%u,%u", record[0], seq);
+                        count = len / value_size[format];
+                        v = record + TELEMETRY_HEAD_SIZE;
+                        for(k = 0; k < count; k++, v += value_size[format])
+                        {
+                                uint32_t u32 = v[0] | (uint32_t)v[1] << 8 | (uint32_t)v[2] << 16 | (uint32_t)v[3] << 24;
+                                uint16_t u16 = v[0] | (v[1] << 8);
+                                float f;
+
+                                switch(format)
+                                {
+                                case 1: printf(",%u", v[0]); break;
+                                case 2: printf(",%d", (int16_t)u16); break;
+                                case 3: printf(",%u", u16); break;
+                                case 4: printf(",%ld", (long)(int32_t)u32); break;
+                                case 5: printf(",%lu", (unsigned long)u32); break;
+                                default: memcpy(&f, &u32, 4); printf(",%g", f); break;
+                                }
+                        }
+                        printf("\n");
+                }
+        }
+
+        fflush(stdout);
+        fprintf(stderr, "%lu records, %lu bad frames, %lu lost\n", frames, errors, lost);
+        close(fd);
+        return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * timerbench.c 上位机软件定时器测试，用10000个同时运行的定时器测试User/bsp_timer.c的时间轮，
+ * 检查每次到期都在正确的滴答，测量启动、停止和每个滴答处理的耗时
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -I host -I ../User -I ../Libraries
+ *           -o timerbench timerbench.c ../User/bsp_timer.c ../User/bsp_systick.c host/host.c host/periph.c
+ * 用法：timerbench
+ *
+ * 滴答由测试程序直接调用SysTick_Handler()产生，每个滴答之后调用一次Timer_Process()，
+ * 耗时是主机上的时间，包括host.c模拟开关中断的开销，只用来比较修改前后；芯片上的耗时用TIMER_BENCH测量。
+ * 10%的定时器第一次到期在5000秒以内(放在时间轮的上层，要经过多次级联)，其余在20秒以内；三分之二是周期定时器。
+ * 运行中每个滴答平均有TIMER_RESTARTS_PER_KTICK/1000次随机重新启动或停止一个定时器，相当于中断中的超时重置。
+ * 测试程序为每个定时器记录应该到期的滴答，回调函数检查到期时的滴答数，定期检查没有漏掉的定时器，
+ * 另有EVENT_NUM个事件定时器，每个滴答检查事件标志。最后让主循环每50个滴答才处理一次，检查推迟的统计。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bsp_timer.h"
+
+#define TIMER_NUM               10000
+#define EVENT_NUM               64                      // 事件定时器个数，编号在回调定时器之后
+#define TICKS                   6000000                 // 运行的滴答数(100分钟)
+#define TIMER_RESTARTS_PER_KTICK 1
+#define CHECK_EVERY             100000                  // 每隔多少滴答检查一次没有漏掉到期的定时器
+#define LAG_TICKS               50                      // 推迟测试中主循环处理的间隔
+
+void SysTick_Handler(void);                             // bsp_systick.c中的滴答中断服务函数
+
+static int failures;
+static TIMER_TypeDef timers[TIMER_NUM + EVENT_NUM];
+static u32 due[TIMER_NUM + EVENT_NUM];                  // 下一次应该到期的滴答
+static u32 period[TIMER_NUM + EVENT_NUM];
+static u8 active[TIMER_NUM + EVENT_NUM];
+static volatile u32 event_flags[EVENT_NUM];
+static u8 lag_mode;                                     // 1:允许推迟，回调只检查不早于应该到期的滴答
+static u32 fired, wrong, missed;
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @Description 记录一次到期，检查到期的滴答
+ */
+static void expire(u32 i)
+{
+        u32 now = Timer_Ticks();
+
+        if(!active[i] || (lag_mode ? (s32)(now - due[i]) < 0 || now - due[i] >= LAG_TICKS : now != due[i]))
+        {
+                if(wrong++ < 5)
+                {
+                        printf("  timer %u fired at %u, due %u, active %u\n", i, now, due[i], active[i]);
+                }
+        }
+        fired++;
+        if(period[i] != 0)
+        {
+                due[i] += period[i];
+        }
+        else
+        {
+                active[i] = 0;
+        }
+}
+
+static void callback(void *arg)
+{
+        expire((u32)(long)arg);
+}
+
+/**
+ * @Description 启动一个定时器并记录应该到期的滴答
+ */
+static void start(u32 i, u32 delay, u32 per)
+{
+        Timer_Start(&timers[i], delay, per);
+        due[i] = Timer_Ticks() + (delay ? delay : 1);
+        period[i] = per;
+        active[i] = 1;
+}
+
+/**
+ * @Description 处理事件定时器置位的标志
+ */
+static void check_events(void)
+{
+        u32 i;
+
+        for(i = 0; i < EVENT_NUM; i++)
+        {
+                if(event_flags[i] != 0)
+                {
+                        event_flags[i] = 0;
+                        expire(TIMER_NUM + i);
+                }
+        }
+}
+
+/**
+ * @Description 检查所有应该已经到期的定时器都执行过，运行状态与记录一致
+ */
+static void check_missed(void)
+{
+        u32 i, now = Timer_Ticks();
+
+        for(i = 0; i < TIMER_NUM + EVENT_NUM; i++)
+        {
+                if(active[i] != Timer_IsActive(&timers[i]) || (active[i] && (s32)(now - due[i]) >= 0))
+                {
+                        if(missed++ < 5)
+                        {
+                                printf("  timer %u at %u: due %u, active %u, wheel %u\n", i, now, due[i], active[i],
+                                       Timer_IsActive(&timers[i]));
+                        }
+                }
+        }
+}
+
+/**
+ * @Description 随机的初始延迟：10%在5000秒以内，其余在20秒以内
+ */
+static u32 random_delay(u32 i)
+{
+        return (i % 10 == 0) ? 1 + rand() % 5000000 : 1 + rand() % 20000;
+}
+
+int main(int argc, char *argv[])
+{
+        double t0, t1, process_ns = 0, process_max = 0;
+        u32 i, k, n, active_num = 0;
+
+        printf("timerbench: %u callback timers + %u event timers, %u levels x %u slots\n", TIMER_NUM, EVENT_NUM,
+               TIMER_WHEEL_LEVELS, TIMER_WHEEL_SIZE);
+        Timer_Init();
+        srand(1);
+        for(i = 0; i < TIMER_NUM; i++)
+        {
+                Timer_Create(&timers[i], callback, (void *)(long)i);
+        }
+        for(i = 0; i < EVENT_NUM; i++)
+        {
+                Timer_CreateEvent(&timers[TIMER_NUM + i], &event_flags[i], 1);
+        }
+
+        /* 启动 */
+        t0 = now_ns();
+        for(i = 0; i < TIMER_NUM + EVENT_NUM; i++)
+        {
+                start(i, random_delay(i), (i % 3) ? 1 + rand() % 3000 : 0);
+        }
+        t1 = now_ns();
+        printf("  start    %6.1f ns per timer, %u active\n", (t1 - t0) / (TIMER_NUM + EVENT_NUM), timer_stat.active);
+        CHECK(timer_stat.active == TIMER_NUM + EVENT_NUM, "%u active after start", timer_stat.active);
+
+        /* 运行，随机重新启动或停止 */
+        for(k = 1; k <= TICKS; k++)
+        {
+                SysTick_Handler();
+                for(n = 0; n < TIMER_RESTARTS_PER_KTICK; n++)
+                {
+                        if(rand() % 1000 == 0)
+                        {
+                                i = rand() % (TIMER_NUM + EVENT_NUM);
+                                if(rand() % 4 == 0)
+                                {
+                                        Timer_Stop(&timers[i]);
+                                        active[i] = 0;
+                                }
+                                else
+                                {
+                                        start(i, 1 + rand() % 100000, period[i]);
+                                }
+                        }
+                }
+
+                t0 = now_ns();
+                Timer_Process();
+                t1 = now_ns();
+                process_ns += t1 - t0;
+                if(t1 - t0 > process_max)
+                {
+                        process_max = t1 - t0;
+                }
+                check_events();
+
+                if(k % CHECK_EVERY == 0)
+                {
+                        check_missed();
+                }
+        }
+        for(i = 0; i < TIMER_NUM + EVENT_NUM; i++)
+        {
+                active_num += active[i];
+        }
+        printf("  process  %6.1f ns per tick (max %.1f us), %u ticks, %u expirations, %u cascaded, %u still active\n",
+               process_ns / TICKS, process_max / 1000, TICKS, timer_stat.fired, timer_stat.cascaded, timer_stat.active);
+        CHECK(wrong == 0, "%u expirations on the wrong tick", wrong);
+        CHECK(missed == 0, "%u timers missed or out of sync", missed);
+        CHECK(fired == timer_stat.fired && timer_stat.late_max == 0, "fired %u/%u, late max %u", fired, timer_stat.fired,
+              timer_stat.late_max);
+        CHECK(timer_stat.active == active_num, "timer_stat.active %u, expected %u", timer_stat.active, active_num);
+
+        /* 停止 */
+        t0 = now_ns();
+        for(i = 0; i < TIMER_NUM + EVENT_NUM; i++)
+        {
+                Timer_Stop(&timers[i]);
+                active[i] = 0;
+        }
+        t1 = now_ns();
+        printf("  stop     %6.1f ns per timer, %u active\n", (t1 - t0) / (TIMER_NUM + EVENT_NUM), timer_stat.active);
+        CHECK(timer_stat.active == 0, "%u active after stop", timer_stat.active);
+
+        /* 主循环每LAG_TICKS个滴答才处理一次，单次定时器都在5秒内到期 */
+        memset(&timer_stat, 0, sizeof(timer_stat));
+        lag_mode = 1;
+        for(i = 0; i < TIMER_NUM + EVENT_NUM; i++)
+        {
+                start(i, 1 + rand() % 5000, 0);
+        }
+        for(k = 1; k <= 6000; k++)
+        {
+                SysTick_Handler();
+                if(k % LAG_TICKS == 0)
+                {
+                        Timer_Process();
+                        check_events();
+                }
+        }
+        Timer_Process();
+        check_events();
+        check_missed();
+        printf("  lag      processed every %u ticks: %u expirations, late avg %.1f max %u ticks, %u active\n", LAG_TICKS,
+               timer_stat.fired, (double)timer_stat.late_total / timer_stat.fired, timer_stat.late_max, timer_stat.active);
+        CHECK(wrong == 0 && missed == 0, "%u wrong, %u missed with a blocked main loop", wrong, missed);
+        CHECK(timer_stat.fired == TIMER_NUM + EVENT_NUM && timer_stat.active == 0, "%u fired, %u active",
+              timer_stat.fired, timer_stat.active);
+        CHECK(timer_stat.late_max < LAG_TICKS, "late max %u", timer_stat.late_max);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,546 @@
+/**
+ * usartsim.c 上位机串口收发测试，在串口和DMA模型上运行User/bsp_usart.c，比较两种printf方式占用主循环和中断的时间，
+ * 测试DMA循环接收在921600和2M波特率下的吞吐量，以及按帧、按行读出
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER -Wno-pointer-to-int-cast -I host -I ../User -I ../Libraries -o usartsim usartsim.c
+ *           ../User/bsp_usart.c host/host.c host/periph.c host/usart.c
+ *       发送缓冲满时的处理方式默认为USART_TX_BLOCK，加-DUSART_TX_POLICY=0(丢弃)或-DUSART_TX_POLICY=2(覆盖)测试另外两种
+ * 用法：usartsim
+ *
+ * 时间是host.c中的模拟时间(168MHz周期)，串口模型按115200波特率把字节移出TX线，DMA在DR空时写入下一个字节。
+ * 原来的方式(逐字节等待TC后写DR)写在本文件中，每次查询标志让模拟时间前进一次轮询的周期数；
+ * 新的方式调用驱动中的fputc()，与Keil的printf一样每个字符调用一次。
+ * 主循环占用的时间是一行printf返回前经过的模拟时间，进出临界区按Host_IrqEnable()的周期数计入。
+ * TIM3_IRQHandler()与定时器实验一样在中断中printf，检查中断的输出完整地插入到主循环的输出中，没有丢失和交错。
+ * 然后按编译时选择的USART_TX_POLICY在主循环和中断中各写入超过发送缓冲的数据，检查TX线上的数据和丢弃计数。
+ * 接收时RX线上连续到达递增的数据，主循环每隔一段时间读一次接收缓冲，检查数据连续，统计每KB产生的中断次数
+ * (原来的接收方式每个字节一次中断)；再在主循环不读的时候连续收到多帧文本和含\r\n、0x00的二进制数据，
+ * 之后按帧读出，每一帧都必须与发送的相同。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "bsp_usart.h"
+#include "usart.h"
+
+#define LINE_NUM                100
+#define BURST_SIZE              3000
+#define RX_BYTES                (256 * 1024)
+#define RX_FRAME_NUM            12
+#define CYCLES_PER_US           (HOST_CLOCK_HZ / 1000000)
+
+static const char line[] = "usart benchmark 0123456789 abcdefghijklmnopqrstuvwxyz ABCD\r\n";
+
+static int failures;
+static u8 use_poll;                                     // 1:原来的逐字节等待方式 0:驱动的fputc()
+static u32 irq_every;                                   // 每输出多少个字符产生一次TIM3中断，0为不产生
+static u32 irq_count;
+static uint64_t irq_cycles;                                  // TIM3中断中printf经过的模拟时间
+static u8 burst[BURST_SIZE];
+static u8 burst_in_irq;
+static u16 burst_written;
+static char expect[1 << 20];
+static u32 expect_len;
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+/**
+ * @Description 原来的fputc：等待上一个字节发送完毕后写DR
+ */
+static void poll_fputc(int ch)
+{
+        while(USART_GetFlagStatus(USART, USART_FLAG_TC) == RESET)
+        {
+        }
+        USART_SendData(USART, (u8)ch);
+}
+
+/**
+ * @Description 相当于目标板上的printf，格式化后每个字符调用一次fputc
+ */
+static void target_printf(const char *fmt, ...)
+{
+        static u32 chars = 0;
+        char buf[512];
+        va_list ap;
+        int i, n;
+
+        va_start(ap, fmt);
+        n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+
+        for(i = 0; i < n; i++)
+        {
+                if(use_poll)
+                {
+                        poll_fputc(buf[i]);
+                }
+                else
+                {
+                        fputc(buf[i], stdout);
+                }
+
+                /* 在一行中间产生中断，只在主循环中计数 */
+                if(irq_every != 0 && __get_IPSR() == 0 && ++chars % irq_every == 0)
+                {
+                        Host_IrqRaise(TIM3_IRQn);
+                }
+        }
+}
+
+void TIM3_IRQHandler(void)
+{
+        uint64_t start = Host_Cycles();
+
+        if(burst_in_irq)
+        {
+                burst_written = Usart_Write(burst, BURST_SIZE);
+                return;
+        }
+        target_printf("tim3 %u\r\n", irq_count++);
+        irq_cycles += Host_Cycles() - start;
+}
+
+/**
+ * @Description 等待发送缓冲为空并且最后一个字节移出移位寄存器
+ */
+static void drain(void)
+{
+        while(Usart_TxFree() != USART_TX_BUF_SIZE || USART_GetFlagStatus(USART, USART_FLAG_TC) == RESET)
+        {
+                Host_Run(Host_UsartByteCycles());
+        }
+}
+
+static void expect_add(const char *s, u32 n)
+{
+        memcpy(expect + expect_len, s, n);
+        expect_len += n;
+}
+
+/**
+ * @Description 每行之间主循环做10ms别的事情，比较一行printf占用主循环的时间
+ */
+static void test_line(u8 poll)
+{
+        uint64_t cycles = 0, start;
+        u32 len, i;
+        const u8 *wire;
+
+        use_poll = poll;
+        drain();
+        Host_UsartTxClear();
+        for(i = 0; i < LINE_NUM; i++)
+        {
+                start = Host_Cycles();
+                target_printf("%s", line);
+                cycles += Host_Cycles() - start;
+                Host_Run(HOST_CLOCK_HZ / 100);
+        }
+        drain();
+
+        wire = Host_UsartTxData(&len);
+        printf("  %-12s %3u bytes/line: main loop held %7.1f us/line\n", poll ? "poll" : "tx buffer",
+               (u32)sizeof(line) - 1, (double)cycles / LINE_NUM / CYCLES_PER_US);
+        CHECK(len == LINE_NUM * (sizeof(line) - 1), "%u bytes on the wire", len);
+        for(i = 0; i < len / (sizeof(line) - 1); i++)
+        {
+                if(memcmp(wire + i * (sizeof(line) - 1), line, sizeof(line) - 1) != 0)
+                {
+                        CHECK(0, "line %u corrupted", i);
+                        break;
+                }
+        }
+}
+
+/**
+ * @Description 连续输出LINE_NUM行，中间不做别的事情，发送缓冲满后主循环也要等待
+ */
+static void test_back_to_back(u8 poll)
+{
+        uint64_t start;
+        u32 i, drop = usart_tx_drop;
+
+        use_poll = poll;
+        drain();
+        start = Host_Cycles();
+        for(i = 0; i < LINE_NUM; i++)
+        {
+                target_printf("%s", line);
+        }
+        printf("  %-12s %u lines back to back: main loop held %8.1f us, %u bytes dropped\n", poll ? "poll" : "tx buffer",
+               LINE_NUM, (double)(Host_Cycles() - start) / CYCLES_PER_US, usart_tx_drop - drop);
+        drain();
+}
+
+/**
+ * @Description 主循环输出时TIM3中断也在输出，中断的每一行都必须完整地出现在TX线上，去掉后与主循环的输出相同
+ */
+static void test_irq(u8 poll)
+{
+        char buf[32];
+        const u8 *wire;
+        u32 len, i, n, pos, out, drop = usart_tx_drop;
+        char *main_text;
+
+        use_poll = poll;
+        drain();
+        Host_UsartTxClear();
+        expect_len = 0;
+        irq_count = 0;
+        irq_cycles = 0;
+        irq_every = 23;
+
+        for(i = 0; i < LINE_NUM; i++)
+        {
+                n = snprintf(buf, sizeof(buf), "main line %u ........\r\n", i);
+                target_printf("%s", buf);
+                expect_add(buf, n);
+
+                /* 留出发送的时间，不让发送缓冲溢出 */
+                Host_Run(Host_UsartByteCycles() * 40);
+        }
+        irq_every = 0;
+        drain();
+
+        wire = Host_UsartTxData(&len);
+        printf("  %-12s %u irq lines: irq held %7.1f us/line, %u bytes dropped\n", poll ? "poll" : "tx buffer",
+               irq_count, irq_count ? (double)irq_cycles / irq_count / CYCLES_PER_US : 0.0, usart_tx_drop - drop);
+
+        /* 依次去掉中断输出的行 */
+        main_text = malloc(len + 1);
+        out = 0;
+        n = 0;
+        for(pos = 0; pos < len; )
+        {
+                i = snprintf(buf, sizeof(buf), "tim3 %u\r\n", n);
+                if(n < irq_count && pos + i <= len && memcmp(wire + pos, buf, i) == 0)
+                {
+                        pos += i;
+                        n++;
+                }
+                else
+                {
+                        main_text[out++] = wire[pos++];
+                }
+        }
+        CHECK(n == irq_count, "found %u of %u irq lines", n, irq_count);
+        CHECK(out == expect_len && memcmp(main_text, expect, out) == 0, "main output differs (%u/%u bytes)", out, expect_len);
+        free(main_text);
+}
+
+/**
+ * @Description 一次写入超过发送缓冲的数据，按USART_TX_POLICY检查写入的字节数、丢弃计数和TX线上的数据
+ */
+static void test_burst(u8 in_irq)
+{
+        const u8 *wire;
+        u32 len, drop, prefix;
+        uint64_t start;
+        u16 written;
+
+        use_poll = 0;
+        drain();
+        Host_UsartTxClear();
+        drop = usart_tx_drop;
+        start = Host_Cycles();
+        if(in_irq)
+        {
+                burst_in_irq = 1;
+                Host_IrqRaise(TIM3_IRQn);
+                burst_in_irq = 0;
+                written = burst_written;
+        }
+        else
+        {
+                written = Usart_Write(burst, BURST_SIZE);
+        }
+        printf("  burst %u bytes in %s: %u written, %u dropped, held %.1f us\n", BURST_SIZE, in_irq ? "irq " : "main",
+               written, usart_tx_drop - drop, (double)(Host_Cycles() - start) / CYCLES_PER_US);
+        drop = usart_tx_drop - drop;
+        drain();
+        wire = Host_UsartTxData(&len);
+
+        for(prefix = 0; prefix < len && wire[prefix] == burst[prefix]; prefix++)
+        {
+        }
+
+#if USART_TX_POLICY == USART_TX_OVERWRITE
+        /* 已经交给DMA的开头部分加上最新的数据 */
+        CHECK(written == BURST_SIZE && len + drop == BURST_SIZE, "written %u, wire %u, dropped %u", written, len, drop);
+        CHECK(len >= USART_TX_BUF_SIZE && memcmp(wire + prefix, burst + BURST_SIZE - (len - prefix), len - prefix) == 0,
+              "wire is not the oldest bytes followed by the newest");
+#else
+        if(USART_TX_POLICY == USART_TX_BLOCK && !in_irq)
+        {
+                CHECK(written == BURST_SIZE && drop == 0, "written %u, dropped %u", written, drop);
+        }
+        else
+        {
+                CHECK(written == USART_TX_BUF_SIZE && drop == BURST_SIZE - USART_TX_BUF_SIZE, "written %u, dropped %u", written, drop);
+        }
+        CHECK(len == written && prefix == len, "wire %u bytes, %u match", len, prefix);
+#endif
+}
+
+/**
+ * @Description 随机长度和间隔的输出，经过多次缓冲区绕回和DMA分段，TX线上的数据必须与写入的相同
+ */
+static void test_random(void)
+{
+        static char buf[256];
+        const u8 *wire;
+        u32 len, i, n, j;
+        u32 drop = usart_tx_drop;
+
+        use_poll = 0;
+        drain();
+        Host_UsartTxClear();
+        expect_len = 0;
+        srand(1);
+        for(i = 0; i < 2000; i++)
+        {
+                n = 1 + rand() % 200;
+                for(j = 0; j < n; j++)
+                {
+                        buf[j] = 'a' + (i + j) % 26;
+                }
+                n = Usart_Write((u8 *)buf, n);
+                expect_add(buf, n);
+                Host_Run(rand() % (Host_UsartByteCycles() * 200));
+        }
+        drain();
+        wire = Host_UsartTxData(&len);
+        printf("  random writes: %u bytes, %u dropped\n", expect_len, usart_tx_drop - drop);
+        if(usart_tx_drop == drop)
+        {
+                CHECK(len == expect_len && memcmp(wire, expect, len) == 0, "wire differs from the written data");
+        }
+}
+
+/**
+ * @Description 等待RX线上的数据全部到达并且总线空闲，然后丢掉接收缓冲中的数据和帧边界
+ */
+static void rx_discard(void)
+{
+        static u8 buf[USART_RX_BUF_SIZE];
+
+        while(Host_UsartRxPending() != 0)
+        {
+                Host_Run(Host_UsartByteCycles() * 16);
+        }
+        Host_Run(Host_UsartByteCycles() * 2);
+        while(Usart_Read(buf, sizeof(buf)) != 0)
+        {
+        }
+        while(Usart_ReadFrame(buf, sizeof(buf)) != 0)
+        {
+        }
+}
+
+/**
+ * @Description 以baudrate连续接收RX_BYTES字节递增的数据，主循环每隔work_us微秒读一次接收缓冲
+ * @return u32  丢失的字节数
+ */
+static u32 test_rx_stream(u32 baudrate, u32 work_us)
+{
+        static u8 data[RX_BYTES];
+        static u8 buf[USART_RX_BUF_SIZE];
+        HOST_UsartStatTypeDef stat;
+        u32 i, n, recv = 0, error = 0, drop;
+        uint64_t start;
+        u8 expect = 0;
+
+        drain();
+        Usart_SetBaudrate(baudrate);
+        rx_discard();
+        drop = usart_rx_drop;
+        Host_UsartStat(NULL, 1);
+
+        for(i = 0; i < RX_BYTES; i++)
+        {
+                data[i] = (u8)i;
+        }
+        start = Host_Cycles();
+        Host_UsartReceive(data, RX_BYTES);
+
+        /* 最后不足半个DMA缓冲的数据在总线空闲后取走 */
+        while(Host_UsartRxPending() != 0 || Usart_Available() != 0 || Host_Cycles() - start < (uint64_t)Host_UsartByteCycles() * (RX_BYTES + 2))
+        {
+                Host_Run(work_us * CYCLES_PER_US);
+                n = Usart_Read(buf, sizeof(buf));
+                for(i = 0; i < n; i++)
+                {
+                        if(buf[i] != expect)
+                        {
+                                error++;
+                        }
+                        expect = buf[i] + 1;
+                }
+                recv += n;
+        }
+        Host_UsartStat(&stat, 0);
+
+        printf("  %7u baud, read every %5u us: %u bytes, %u lost, %.1f irq/KB (%u dma, %u idle)\n", baudrate, work_us,
+               recv, RX_BYTES - recv, (double)(stat.rx_dma_irq + stat.rx_idle_irq) * 1024 / RX_BYTES, stat.rx_dma_irq, stat.rx_idle_irq);
+        CHECK(stat.rx_bytes == RX_BYTES, "%u bytes arrived", stat.rx_bytes);
+        CHECK(RX_BYTES - recv == usart_rx_drop - drop, "lost %u, usart_rx_drop %u", RX_BYTES - recv, usart_rx_drop - drop);
+        if(recv == RX_BYTES)
+        {
+                CHECK(error == 0, "%u bytes out of sequence", error);
+        }
+
+        return RX_BYTES - recv;
+}
+
+/**
+ * @Description 主循环忙的时候连续收到多帧，之后按帧读出；帧中的\r、\n和0x00都按原样保留
+ */
+static void test_rx_frames(u32 baudrate)
+{
+        static u8 frame[RX_FRAME_NUM][128];
+        static u16 frame_len[RX_FRAME_NUM];
+        u8 buf[256];
+        u32 i, j, n;
+
+        drain();
+        Usart_SetBaudrate(baudrate);
+        rx_discard();
+
+        srand(2);
+        for(i = 0; i < RX_FRAME_NUM; i++)
+        {
+                switch(i % 4)
+                {
+                case 0:
+                        frame_len[i] = snprintf((char *)frame[i], sizeof(frame[i]), "AT+SET=%u\r\n", i);
+                        break;
+                case 1:
+                        /* 二进制数据，包含\r\n和0x00 */
+                        frame_len[i] = 1 + rand() % sizeof(frame[i]);
+                        for(j = 0; j < frame_len[i]; j++)
+                        {
+                                frame[i][j] = (j % 5 == 0) ? "\r\n\0\n\r"[j % 3] : (u8)rand();
+                        }
+                        break;
+                case 2:
+                        frame[i][0] = '\n';
+                        frame_len[i] = 1;
+                        break;
+                default:
+                        memcpy(frame[i], "\r\n\0\r\n", 5);
+                        frame_len[i] = 5;
+                        break;
+                }
+
+                /* 帧之间空闲3个字节的时间 */
+                Host_UsartReceive(frame[i], frame_len[i]);
+                Host_Run(Host_UsartByteCycles() * (frame_len[i] + 3));
+        }
+
+        for(i = 0; i < RX_FRAME_NUM; i++)
+        {
+                n = Usart_ReadFrame(buf, sizeof(buf));
+                if(n != frame_len[i] || memcmp(buf, frame[i], n) != 0)
+                {
+                        CHECK(0, "frame %u: %u bytes, expected %u", i, n, frame_len[i]);
+                        break;
+                }
+        }
+        CHECK(Usart_ReadFrame(buf, sizeof(buf)) == 0 && Usart_Available() == 0, "extra data after the last frame");
+        printf("  %7u baud, %u frames received while busy, read back by frame\n", baudrate, RX_FRAME_NUM);
+}
+
+/**
+ * @Description 按行读出：\r\n和\n都作为行尾，不完整的行等到换行符到达，太长的行截断
+ */
+static void test_rx_lines(void)
+{
+        static const char text[] = "hello\r\nset 1 2\n\r\npart";
+        char line[128], buf[300];
+        s16 n;
+
+        drain();
+        Usart_SetBaudrate(USART_BAUDRATE);
+        rx_discard();
+
+        Host_UsartReceive((const u8 *)text, sizeof(text) - 1);
+        Host_Run(Host_UsartByteCycles() * sizeof(text));
+        n = Usart_ReadLine(line, sizeof(line));
+        CHECK(n == 5 && strcmp(line, "hello") == 0, "line 1: %d \"%s\"", n, line);
+        n = Usart_ReadLine(line, sizeof(line));
+        CHECK(n == 7 && strcmp(line, "set 1 2") == 0, "line 2: %d \"%s\"", n, line);
+        n = Usart_ReadLine(line, sizeof(line));
+        CHECK(n == 0 && line[0] == '\0', "empty line: %d", n);
+        CHECK(Usart_ReadLine(line, sizeof(line)) == -1, "incomplete line returned");
+
+        Host_UsartReceive((const u8 *)"ial\r\n", 5);
+        Host_Run(Host_UsartByteCycles() * 7);
+        n = Usart_ReadLine(line, sizeof(line));
+        CHECK(n == 7 && strcmp(line, "partial") == 0, "line 4: %d \"%s\"", n, line);
+
+        memset(buf, 'x', sizeof(buf));
+        Host_UsartReceive((const u8 *)buf, sizeof(buf));
+        Host_Run(Host_UsartByteCycles() * (sizeof(buf) + 2));
+        n = Usart_ReadLine(line, sizeof(line));
+        CHECK(n == sizeof(line) - 1, "long line: %d", n);
+        printf("  read by line\n");
+}
+
+int main(int argc, char *argv[])
+{
+        NVIC_InitTypeDef NVIC_InitStructure;
+        u32 i;
+
+        NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+        Host_UsartAttach(USART, USART_TX_DMA_STREAM, USART_RX_DMA_STREAM, USART_IRQ);
+        Usart_Init();
+
+        /* 与定时器实验相同，TIM3中断的优先级高于串口 */
+        NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+
+        for(i = 0; i < BURST_SIZE; i++)
+        {
+                burst[i] = (u8)(i * 7 + i / 251);
+        }
+
+        printf("usartsim: %u baud, tx buffer %u bytes, policy %s\n", USART_BAUDRATE, USART_TX_BUF_SIZE,
+               USART_TX_POLICY == USART_TX_DROP ? "drop" : USART_TX_POLICY == USART_TX_BLOCK ? "block" : "overwrite");
+
+        printf("printf one line every 10 ms:\n");
+        test_line(1);
+        test_line(0);
+
+        printf("printf back to back:\n");
+        test_back_to_back(1);
+        test_back_to_back(0);
+
+        printf("printf in TIM3_IRQHandler:\n");
+        test_irq(1);
+        test_irq(0);
+
+        printf("overflow:\n");
+        test_burst(0);
+        test_burst(1);
+        test_random();
+
+        printf("receive (one interrupt per byte, 1024 irq/KB, before DMA):\n");
+        CHECK(test_rx_stream(921600, 1000) == 0, "bytes lost at 921600");
+        CHECK(test_rx_stream(921600, 10000) == 0, "bytes lost at 921600");
+        CHECK(test_rx_stream(2000000, 1000) == 0, "bytes lost at 2000000");
+        CHECK(test_rx_stream(2000000, 5000) == 0, "bytes lost at 2000000");
+        test_rx_stream(2000000, 20000);
+        test_rx_frames(921600);
+        test_rx_frames(2000000);
+        test_rx_lines();
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
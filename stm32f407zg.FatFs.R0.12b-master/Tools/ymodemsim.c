@@ -0,0 +1,467 @@
+/**
+ * ymodemsim.c 上位机YMODEM接收测试，在串口、DMA和W25Q128模型上运行User/bsp_ymodem.c、bsp_usart.c和FatFs，
+ * 模拟ysend.c上传一组文件，统计吞吐率，检查Flash擦除和编程期间接收不停顿
+ *
+ * 编译(在Tools目录下)：
+ *       gcc -O2 -pthread -fno-pie -no-pie -DUSE_STDPERIPH_DRIVER "-DSYSTICK_CYCCNT()=Host_Cyccnt()" -Wno-pointer-to-int-cast
+ *           -I host -I ../User -I ../Libraries -I ../FatFs -o ymodemsim ymodemsim.c ../User/bsp_ymodem.c
+ *           ../User/bsp_usart.c ../User/bsp_systick.c ../FatFs/diskio.c ../FatFs/ff.c ../FatFs/syscall.c
+ *           host/host.c host/periph.c host/usart.c host/w25qxx.c
+ * 用法：ymodemsim
+ *
+ * 时间是host.c中的模拟时间。发送方是登记在模拟时钟上的设备，与ysend.c的协议流程相同：
+ * 每个字节时间查看一次开发板在TX线上的应答，在下一个1ms的USB帧发出下一个数据包(USB串口的延迟)。
+ * Flash按W25Q128的典型时间(页编程0.7ms、扇区擦除45ms、块擦除150ms)和最长时间计时，
+ * 主循环在f_write中等待Flash时模拟时间继续前进，接收中断照常解析数据包和应答。
+ * 每次上传后从FatFs读回文件与发送的内容比较，并统计：
+ *       应答延迟：数据包最后一个字节到达到应答出现在TX线上的时间，两个缓冲都在等待Flash时才会推迟应答；
+ *       Flash忙时的应答：应答时主循环正在等待Flash的数据包个数，说明接收没有因为Flash忙而停顿。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_ymodem.h"
+#include "bsp_systick.h"
+#include "bsp_w25qxx.h"
+#include "bsp_log.h"
+#include "ff.h"
+#include "usart.h"
+#include "w25qxx.h"
+
+#define SOH                     0x01
+#define STX                     0x02
+#define EOT                     0x04
+#define ACK                     0x06
+#define NAK                     0x15
+#define CAN                     0x18
+#define CRC16                   'C'
+
+#define FILE_NUM                4
+#define SEND_FRAME              (HOST_CLOCK_HZ / 1000)  // USB串口每1ms发出一次数据
+#define SEND_TIMEOUT            ((uint64_t)HOST_CLOCK_HZ * 5)   // 与ysend.c相同，等待应答5秒后重发
+#define SEND_RETRY_MAX          10
+#define CYCLES_PER_US           (HOST_CLOCK_HZ / 1000000)
+
+/* 发送方的状态 */
+#define SEND_WAIT_HEADER        0                       // 等待'C'，发送文件头
+#define SEND_WAIT_HEADER_ACK    1
+#define SEND_WAIT_DATA          2                       // 等待'C'，发送第一个数据包
+#define SEND_WAIT_DATA_ACK      3
+#define SEND_WAIT_EOT_ACK       4                       // 第一个EOT回复NAK，再发送一次
+#define SEND_DONE               5
+#define SEND_FAILED             6
+
+typedef struct
+{
+        const char *name;
+        u32 size;
+        u8 *data;
+} SendFile;
+
+static SendFile files[FILE_NUM] =
+{
+        { "FONT.BIN", 131072 + 77 },
+        { "LOGO.IMZ", 38913 },
+        { "CONFIG.TXT", 300 },
+        { "EMPTY.DAT", 0 },
+};
+
+static struct
+{
+        u8 state;
+        u8 file;                                        // 正在发送的文件，FILE_NUM表示发送结束的空文件头
+        u32 offset;                                     // 下一个数据包在文件中的位置
+        u8 block;
+        u8 packet[3 + 1024 + 2];
+        u16 packet_len;
+        u8 pending;                                     // 数据包等待下一个USB帧发出
+        u8 retry;
+        uint64_t next_poll;
+        uint64_t send_at;
+        uint64_t sent_end;                              // 上一个数据包最后一个字节到达开发板的时间
+        u32 tx_pos;                                     // TX线上已经处理的字节数
+        u8 data_packet;                                 // 上一个数据包是文件数据
+
+        /* 统计 */
+        uint64_t start, end;
+        u32 packets;
+        u32 acks_busy;                                  // 应答时主循环正在等待Flash
+        u32 ack_delayed;                                // 应答延迟超过1ms
+        uint64_t ack_max;                               // 没有推迟的应答中最长的延迟
+        u32 resend;
+} send;
+
+static FATFS fs;
+static int failures;
+
+/* diskio.c中的日志，传输过程中串口被协议占用，不输出 */
+void Log_Write(const char *fmt, u32 n, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+}
+
+#define CHECK(cond, ...)        do { if(!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static u16 crc16(const u8 *data, u32 len)
+{
+        u16 crc = 0;
+        int i;
+
+        while(len--)
+        {
+                crc ^= (u16)*data++ << 8;
+                for(i = 0; i < 8; i++)
+                {
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+                }
+        }
+        return crc;
+}
+
+/**
+ * @Description 在下一个USB帧发出准备好的数据，NAK时重发也调用
+ */
+static void send_queue(void)
+{
+        send.pending = 1;
+        send.send_at = (Host_Cycles() / SEND_FRAME + 1) * SEND_FRAME;
+}
+
+/**
+ * @Description 组成一个数据包，在下一个USB帧发出
+ */
+static void send_packet(u8 block, const u8 *data, u32 size)
+{
+        u16 crc = crc16(data, size);
+
+        send.packet[0] = (size == 1024) ? STX : SOH;
+        send.packet[1] = block;
+        send.packet[2] = ~block;
+        memcpy(send.packet + 3, data, size);
+        send.packet[3 + size] = crc >> 8;
+        send.packet[4 + size] = crc & 0xFF;
+        send.packet_len = size + 5;
+        send.retry = 0;
+        send_queue();
+}
+
+static void send_byte(u8 c)
+{
+        send.packet[0] = c;
+        send.packet_len = 1;
+        send.retry = 0;
+        send_queue();
+}
+
+/**
+ * @Description 文件头：文件名和十进制的文件大小，全部文件发送完后是空文件头
+ */
+static void send_header(void)
+{
+        u8 data[128];
+
+        memset(data, 0, sizeof(data));
+        if(send.file < FILE_NUM)
+        {
+                snprintf((char *)data, sizeof(data), "%s", files[send.file].name);
+                snprintf((char *)data + strlen(files[send.file].name) + 1, sizeof(data) - strlen(files[send.file].name) - 1,
+                         "%u", files[send.file].size);
+        }
+        send_packet(0, data, 128);
+        send.data_packet = 0;
+}
+
+/**
+ * @Description 发送下一个数据包，文件结束时发送EOT，最后不满的部分用0x1A填充
+ */
+static void send_data(void)
+{
+        SendFile *f = &files[send.file];
+        u8 data[1024];
+        u32 n = f->size - send.offset, size;
+
+        if(n == 0)
+        {
+                send_byte(EOT);
+                send.state = SEND_WAIT_EOT_ACK;
+                send.data_packet = 0;
+                return;
+        }
+        if(n > 1024)
+        {
+                n = 1024;
+        }
+        size = (n <= 128) ? 128 : 1024;
+        memcpy(data, f->data + send.offset, n);
+        memset(data + n, 0x1A, size - n);
+        send_packet(send.block, data, size);
+        send.offset += n;
+        send.state = SEND_WAIT_DATA_ACK;
+        send.data_packet = 1;
+}
+
+/**
+ * @Description 处理开发板的一个应答字节
+ */
+static void send_reply(u8 c)
+{
+        uint64_t delay;
+
+        if(c == CAN)
+        {
+                send.state = SEND_FAILED;
+                return;
+        }
+
+        /* 应答延迟只统计文件数据包 */
+        if(send.data_packet && (c == ACK || c == NAK))
+        {
+                delay = Host_Cycles() - send.sent_end;
+                if(c == ACK && Host_FlashBusyNow())
+                {
+                        send.acks_busy++;
+                }
+                if(delay > SEND_FRAME)
+                {
+                        send.ack_delayed++;
+                }
+                else if(delay > send.ack_max)
+                {
+                        send.ack_max = delay;
+                }
+                send.data_packet = 0;
+        }
+
+        switch(send.state)
+        {
+        case SEND_WAIT_HEADER:
+                if(c == CRC16)
+                {
+                        if(send.start == 0)
+                        {
+                                send.start = Host_Cycles();
+                        }
+                        send_header();
+                        send.state = SEND_WAIT_HEADER_ACK;
+                }
+                break;
+        case SEND_WAIT_HEADER_ACK:
+                if(c == ACK)
+                {
+                        if(send.file == FILE_NUM)
+                        {
+                                send.end = Host_Cycles();
+                                send.state = SEND_DONE;
+                        }
+                        else
+                        {
+                                send.state = SEND_WAIT_DATA;
+                        }
+                }
+                else if(c == NAK)
+                {
+                        send_queue();
+                }
+                break;
+        case SEND_WAIT_DATA:
+                if(c == CRC16)
+                {
+                        send.offset = 0;
+                        send.block = 1;
+                        send_data();
+                }
+                break;
+        case SEND_WAIT_DATA_ACK:
+                if(c == ACK)
+                {
+                        send.block++;
+                        send_data();
+                }
+                else if(c == NAK)
+                {
+                        send.resend++;
+                        send_queue();
+                }
+                break;
+        case SEND_WAIT_EOT_ACK:
+                if(c == NAK)
+                {
+                        send_byte(EOT);
+                }
+                else if(c == ACK)
+                {
+                        send.file++;
+                        send.state = SEND_WAIT_HEADER;
+                }
+                break;
+        }
+}
+
+static uint64_t send_next(void)
+{
+        if(send.state >= SEND_DONE)
+        {
+                return UINT64_MAX;
+        }
+        return (send.pending && send.send_at < send.next_poll) ? send.send_at : send.next_poll;
+}
+
+/**
+ * @Description 发送方：查看TX线上新的应答，到了USB帧的时间发出数据包，超时重发
+ */
+static void send_event(void)
+{
+        const u8 *wire;
+        u32 len;
+        uint64_t now = Host_Cycles();
+
+        if(now >= send.next_poll)
+        {
+                send.next_poll = now + Host_UsartByteCycles();
+                wire = Host_UsartTxData(&len);
+                while(send.tx_pos < len && send.state < SEND_DONE)
+                {
+                        send_reply(wire[send.tx_pos++]);
+                }
+
+                /* 没有应答 */
+                if(!send.pending && send.state != SEND_WAIT_HEADER && send.state != SEND_WAIT_DATA &&
+                   send.state < SEND_DONE && now > send.sent_end + SEND_TIMEOUT)
+                {
+                        if(++send.retry > SEND_RETRY_MAX)
+                        {
+                                send.state = SEND_FAILED;
+                                return;
+                        }
+                        send.resend++;
+                        send.pending = 1;
+                        send.send_at = now;
+                }
+        }
+
+        if(send.pending && now >= send.send_at)
+        {
+                send.pending = 0;
+                Host_UsartReceive(send.packet, send.packet_len);
+                send.sent_end = now + (uint64_t)Host_UsartByteCycles() * send.packet_len;
+                send.packets++;
+        }
+}
+
+/**
+ * @Description 从FatFs读回文件，与发送的内容比较
+ */
+static void check_files(void)
+{
+        static u8 buf[4096];
+        char path[32];
+        FIL fil;
+        UINT br;
+        u32 i, pos;
+
+        for(i = 0; i < FILE_NUM; i++)
+        {
+                snprintf(path, sizeof(path), "0:/%s", files[i].name);
+                if(f_open(&fil, path, FA_READ) != FR_OK)
+                {
+                        CHECK(0, "%s not found", path);
+                        continue;
+                }
+                CHECK(f_size(&fil) == files[i].size, "%s: %u bytes, sent %u", path, (u32)f_size(&fil), files[i].size);
+                for(pos = 0; f_read(&fil, buf, sizeof(buf), &br) == FR_OK && br > 0; pos += br)
+                {
+                        if(pos + br > files[i].size || memcmp(buf, files[i].data + pos, br) != 0)
+                        {
+                                CHECK(0, "%s differs near offset %u", path, pos);
+                                break;
+                        }
+                }
+                f_close(&fil);
+        }
+}
+
+/**
+ * @Description 上传一次全部文件
+ * @param page_us/sector_us/block_us Flash编程和擦除时间
+ */
+static void upload(u32 baudrate, const char *timing, u32 page_us, u32 sector_us, u32 block_us)
+{
+        HOST_FlashStatTypeDef flash;
+        u32 drop, total = 0, i;
+        double seconds;
+        u8 result;
+
+        Usart_SetBaudrate(baudrate);
+        Host_FlashSetTiming(page_us, sector_us, block_us);
+        Host_FlashStat(NULL, 1);
+        for(i = 0; i < FILE_NUM; i++)
+        {
+                total += files[i].size;
+        }
+
+        memset(&send, 0, sizeof(send));
+        Host_UsartTxClear();
+        send.next_poll = Host_Cycles();
+        drop = usart_rx_drop;
+
+        result = Ymodem_Receive("0:/");
+
+        /* 最后的应答发送完，发送方收到后结束；Usart_SetBaudrate()中的Usart_Flush()不推进模拟时间，先等发送缓冲空 */
+        while(Usart_TxFree() != USART_TX_BUF_SIZE || USART_GetFlagStatus(USART, USART_FLAG_TC) == RESET)
+        {
+                Host_Run(Host_UsartByteCycles());
+        }
+        Host_Run(SEND_FRAME * 2);
+        Host_FlashStat(&flash, 0);
+        Host_FlashSetTiming(0, 0, 0);
+
+        seconds = (double)(send.end - send.start) / HOST_CLOCK_HZ;
+        printf("  %7u baud, %s flash: %u KB in %.2f s, %.2f KB/s (line %.1f KB/s), flash busy %.0f%%\n", baudrate, timing,
+               total / 1024, seconds, total / 1024.0 / seconds, baudrate / 10 / 1024.0,
+               flash.busy_us / 1e4 / seconds);
+        printf("    %u packets, %u acked during flash busy, ack latency max %.0f us, %u acks delayed > 1 ms, %u resent\n",
+               send.packets, send.acks_busy, (double)send.ack_max / CYCLES_PER_US, send.ack_delayed, send.resend);
+
+        CHECK(result == YMODEM_OK && send.state == SEND_DONE, "result %u, sender state %u", result, send.state);
+        CHECK(usart_rx_drop == drop, "%u bytes dropped", usart_rx_drop - drop);
+        check_files();
+}
+
+int main(int argc, char *argv[])
+{
+        static BYTE work[4096];
+        u32 i, j, seed = 1;
+
+        NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
+        Systick_Init();
+        Host_UsartAttach(USART, USART_TX_DMA_STREAM, USART_RX_DMA_STREAM, USART_IRQ);
+        Usart_Init();
+        Host_AddClockDevice(send_next, send_event);
+
+        W25QXX_Init();
+        if(f_mkfs("0:", FM_FAT, 0, work, sizeof(work)) != FR_OK || f_mount(&fs, "0:", 1) != FR_OK)
+        {
+                printf("ymodemsim: cannot format the flash volume\n");
+                return 1;
+        }
+
+        /* 字库和图像是随机数据，配置文件是文本 */
+        for(i = 0; i < FILE_NUM; i++)
+        {
+                files[i].data = malloc(files[i].size + 1);
+                for(j = 0; j < files[i].size; j++)
+                {
+                        seed = seed * 1103515245 + 12345;
+                        files[i].data[j] = (i == 2) ? "key = value\r\n"[j % 13] : (u8)(seed >> 16);
+                }
+        }
+
+        printf("ymodemsim: %u files, YMODEM-1K, %u KB ping-pong buffers\n", FILE_NUM, YMODEM_CHUNK_SIZE / 1024);
+        upload(115200, "typical", 700, 45000, 150000);
+        upload(921600, "typical", 700, 45000, 150000);
+        upload(2000000, "typical", 700, 45000, 150000);
+        upload(921600, "slowest", 3000, 400000, 2000000);
+
+        printf(failures ? "FAILED\n" : "passed\n");
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,322 @@
+/**
+ * ysend.c 上位机YMODEM-1K文件发送工具，把文件上传到开发板的文件系统中，接收端见bsp_ymodem.c
+ *
+ * 编译：gcc -O2 -o ysend ysend.c
+ * 用法：ysend /dev/ttyUSB0 115200 GBK.FON LOGO.IMZ ...
+ *
+ * 先发送"rz"命令让开发板进入接收状态，再依次发送各个文件，文件名取路径的最后一部分，
+ * 必须符合8.3格式。每个文件发送完后在标准错误上输出吞吐率，全部结束后显示开发板输出的统计结果。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+#define SOH             0x01
+#define STX             0x02
+#define EOT             0x04
+#define ACK             0x06
+#define NAK             0x15
+#define CAN             0x18
+#define CRC16           'C'
+
+#define RETRY_MAX       10
+#define ACK_TIMEOUT     5000                            // 等待应答的时间，单位毫秒，要大于Flash擦除的最长时间
+#define START_TIMEOUT   10000                           // 等待接收方开始的时间，单位毫秒
+
+static int fd;
+
+static double now_ms(void)
+{
+        struct timeval tv;
+
+        gettimeofday(&tv, NULL);
+        return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/**
+ * @Description 读一个字节
+ * @return int  读到的字节，超时返回-1
+ */
+static int read_byte(int timeout_ms)
+{
+        struct timeval tv;
+        fd_set set;
+        unsigned char c;
+
+        FD_ZERO(&set);
+        FD_SET(fd, &set);
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        if(select(fd + 1, &set, NULL, NULL, &tv) <= 0 || read(fd, &c, 1) != 1)
+        {
+                return -1;
+        }
+
+        return c;
+}
+
+static void write_all(const void *buf, size_t len)
+{
+        const unsigned char *p = buf;
+        ssize_t n;
+
+        while(len > 0)
+        {
+                n = write(fd, p, len);
+                if(n <= 0)
+                {
+                        perror("write");
+                        exit(1);
+                }
+                p += n;
+                len -= n;
+        }
+}
+
+/**
+ * @Description 等待某个控制字符，忽略其他字节
+ * @return int  0:收到 -1:超时或被取消
+ */
+static int wait_for(int want, int timeout_ms)
+{
+        double end = now_ms() + timeout_ms;
+        int c;
+
+        while(now_ms() < end)
+        {
+                c = read_byte((int)(end - now_ms()) + 1);
+                if(c == want)
+                {
+                        return 0;
+                }
+                if(c == CAN)
+                {
+                        fprintf(stderr, "cancelled by receiver\n");
+                        return -1;
+                }
+        }
+
+        return -1;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t len)
+{
+        uint16_t crc = 0;
+        int bit;
+
+        while(len--)
+        {
+                crc ^= *data++ << 8;
+                for(bit = 0; bit < 8; bit++)
+                {
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+                }
+        }
+
+        return crc;
+}
+
+/**
+ * @Description 发送一个数据包并等待应答，收到NAK或超时时重发
+ * @return int  0:成功 -1:失败
+ */
+static int send_packet(uint8_t block, const uint8_t *data, size_t size)
+{
+        uint8_t packet[3 + 1024 + 2];
+        uint16_t crc = crc16(data, size);
+        int retry, c;
+
+        packet[0] = (size == 1024) ? STX : SOH;
+        packet[1] = block;
+        packet[2] = ~block;
+        memcpy(packet + 3, data, size);
+        packet[3 + size] = crc >> 8;
+        packet[4 + size] = crc & 0xFF;
+
+        for(retry = 0; retry < RETRY_MAX; retry++)
+        {
+                write_all(packet, size + 5);
+                do
+                {
+                        c = read_byte(ACK_TIMEOUT);
+                }
+                while(c != ACK && c != NAK && c != CAN && c != -1);
+
+                if(c == ACK)
+                {
+                        return 0;
+                }
+                if(c == CAN)
+                {
+                        fprintf(stderr, "cancelled by receiver\n");
+                        return -1;
+                }
+        }
+
+        fprintf(stderr, "block %u: too many retries\n", block);
+        return -1;
+}
+
+/**
+ * @Description 发送一个文件
+ * @return int  0:成功 -1:失败
+ */
+static int send_file(const char *path)
+{
+        uint8_t data[1024];
+        const char *name = strrchr(path, '/');
+        FILE *fp = fopen(path, "rb");
+        long size, sent = 0;
+        size_t n, size_block;
+        uint8_t block = 1;
+        double start;
+        int retry, c;
+
+        if(fp == NULL)
+        {
+                perror(path);
+                return -1;
+        }
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        /* 文件头：文件名和十进制的文件大小 */
+        name = (name != NULL) ? name + 1 : path;
+        memset(data, 0, 128);
+        snprintf((char *)data, 128, "%s", name);
+        snprintf((char *)data + strlen(name) + 1, 128 - strlen(name) - 1, "%ld", size);
+
+        if(wait_for(CRC16, START_TIMEOUT) != 0 || send_packet(0, data, 128) != 0 || wait_for(CRC16, ACK_TIMEOUT) != 0)
+        {
+                fprintf(stderr, "%s: receiver did not accept the file\n", name);
+                fclose(fp);
+                return -1;
+        }
+
+        start = now_ms();
+        while((n = fread(data, 1, sizeof(data), fp)) > 0)
+        {
+                /* 最后不满的部分用0x1A填充，128字节以内使用短数据包 */
+                size_block = (n <= 128) ? 128 : 1024;
+                memset(data + n, 0x1A, size_block - n);
+                if(send_packet(block++, data, size_block) != 0)
+                {
+                        fclose(fp);
+                        return -1;
+                }
+                sent += n;
+                fprintf(stderr, "\r%s: %ld/%ld", name, sent, size);
+        }
+        fclose(fp);
+
+        /* 第一个EOT通常回复NAK，再发送一次 */
+        for(retry = 0; retry < RETRY_MAX; retry++)
+        {
+                write_all("\x04", 1);
+                do
+                {
+                        c = read_byte(ACK_TIMEOUT);
+                }
+                while(c != ACK && c != NAK && c != -1);
+
+                if(c == ACK)
+                {
+                        break;
+                }
+        }
+        if(retry == RETRY_MAX)
+        {
+                fprintf(stderr, "\n%s: no response to EOT\n", name);
+                return -1;
+        }
+
+        fprintf(stderr, "\r%s: %ld bytes in %.2f s, %.2f KB/s\n", name, size, (now_ms() - start) / 1000.0,
+                size / 1024.0 / ((now_ms() - start) / 1000.0));
+        return 0;
+}
+
+static speed_t baud_speed(long baud)
+{
+        switch(baud)
+        {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+        default: return 0;
+        }
+}
+
+int main(int argc, char *argv[])
+{
+        uint8_t data[128];
+        struct termios tio;
+        speed_t speed;
+        int i, c;
+
+        if(argc < 4)
+        {
+                fprintf(stderr, "usage: %s device baud file...\n", argv[0]);
+                return 1;
+        }
+
+        fd = open(argv[1], O_RDWR | O_NOCTTY);
+        speed = baud_speed(atol(argv[2]));
+        if(fd < 0 || speed == 0 || tcgetattr(fd, &tio) != 0)
+        {
+                fprintf(stderr, "%s: unsupported device or baud rate\n", argv[1]);
+                return 1;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+
+        /* 让开发板进入接收状态，丢弃之前的输出，其中可能含有字符'C' */
+        write_all("rz\r\n", 4);
+        usleep(200000);
+        tcflush(fd, TCIFLUSH);
+
+        for(i = 3; i < argc; i++)
+        {
+                if(send_file(argv[i]) != 0)
+                {
+                        write_all("\x18\x18\x18", 3);
+                        return 1;
+                }
+        }
+
+        /* 文件名为空的文件头结束传输 */
+        memset(data, 0, sizeof(data));
+        if(wait_for(CRC16, ACK_TIMEOUT) != 0 || send_packet(0, data, 128) != 0)
+        {
+                fprintf(stderr, "receiver did not finish the session\n");
+                return 1;
+        }
+
+        /* 显示开发板输出的统计结果 */
+        while((c = read_byte(500)) != -1)
+        {
+                putchar(c);
+        }
+
+        close(fd);
+        return 0;
+}
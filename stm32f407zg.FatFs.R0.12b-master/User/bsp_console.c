@@ -0,0 +1,506 @@
+#include "bsp_console.h"
+#include "stdarg.h"
+
+/* 驱动版本号：bsp_console v1.0 */
+
+/* ANSI颜色，0~7为普通颜色，8~15为加亮颜色，RGB565格式 */
+static const u16 console_palette[16] =
+{
+        0x0000, 0xA800, 0x0540, 0xAAA0, 0x0015, 0xA815, 0x0555, 0xAD55,
+        0x52AA, 0xFAAA, 0x57EA, 0xFFEA, 0x52BF, 0xFABF, 0x57FF, 0xFFFF
+};
+
+static u8 console_open = 0;                                     // 终端是否已经初始化
+static u8 console_hwscroll;                                     // 1:硬件滚动 0:换行时整个区域重画
+static u16 console_top;                                         // 区域第一行的坐标
+static u8 console_size;                                         // 字号 12/16/24
+static u8 console_cols, console_rows;                           // 列数和行数
+static u8 console_first;                                        // 显示在最上面的一行在缓冲区中的序号
+static u8 console_col, console_row;                             // 光标位置，col等于列数时下一个字符先换行
+static u8 console_fg, console_bg;                               // 当前的文字和背景颜色，调色板序号
+
+static u8 console_esc;                                          // ANSI序列解析状态 0:普通字符 1:收到ESC 2:收到ESC[
+static u16 console_param[4];                                    // ANSI序列的参数
+static u8 console_nparam;                                       // 参数个数
+
+/* 文本缓冲，按行环形存放，每个字符格记录字符和颜色(高4位背景 低4位文字) */
+static char console_text[CONSOLE_ROWS_MAX][CONSOLE_COLS_MAX];
+static u8 console_color[CONSOLE_ROWS_MAX][CONSOLE_COLS_MAX];
+
+/**
+ * @Description 屏幕上第row行在文本缓冲中的序号
+ */
+static u8 Console_Line(u8 row)
+{
+        u16 line = console_first + row;
+
+        return (line >= console_rows) ? line - console_rows : line;
+}
+
+/**
+ * @Description 屏幕上第row行在GRAM中的纵坐标
+ * @notice      硬件滚动时缓冲区第i行固定画在GRAM的第i行字符位置上，由滚动起始行决定显示在哪里
+ */
+static u16 Console_RowY(u8 row)
+{
+        return console_top + (console_hwscroll ? Console_Line(row) : row) * console_size;
+}
+
+/**
+ * @Description 按文本缓冲中的内容画一个字符格
+ */
+static void Console_DrawCell(u8 row, u8 col)
+{
+        u8 line = Console_Line(row);
+        u16 point = POINT_COLOR;
+        u16 back = BACK_COLOR;
+
+        POINT_COLOR = console_palette[console_color[line][col] & 0x0F];
+        BACK_COLOR = console_palette[console_color[line][col] >> 4];
+        Lcd_ShowChar(col * (console_size / 2), Console_RowY(row), console_text[line][col], console_size, DRAW_REDRAW);
+
+        POINT_COLOR = point;
+        BACK_COLOR = back;
+}
+
+/**
+ * @Description 画出整行
+ */
+static void Console_DrawLine(u8 row)
+{
+        u8 col;
+
+        for(col = 0; col < console_cols; col++)
+        {
+                Console_DrawCell(row, col);
+        }
+}
+
+/**
+ * @Description 用当前背景色清除第row行从col列到行尾的部分，包括最后一列右边不够一个字符宽的部分
+ */
+static void Console_ClearLine(u8 row, u8 col)
+{
+        u8 line = Console_Line(row);
+        u16 y = Console_RowY(row);
+
+        if(col >= console_cols)
+        {
+                return;
+        }
+
+        memset(&console_text[line][col], ' ', console_cols - col);
+        memset(&console_color[line][col], (console_bg << 4) | console_fg, console_cols - col);
+        Lcd_Fill(col * (console_size / 2), y, lcddev.width - 1, y + console_size - 1, console_palette[console_bg]);
+}
+
+/**
+ * @Description 换行，光标已经在最后一行时向上滚动一行
+ * @notice      硬件滚动时先清除最上面的一行，再把滚动起始行下移一行，清除的这一行就出现在最下面，
+ *              每次换行只写一行的背景色和两个寄存器
+ */
+static void Console_NewLine(void)
+{
+        u8 row;
+
+        console_col = 0;
+        if(console_row + 1 < console_rows)
+        {
+                console_row++;
+                return;
+        }
+
+        if(console_hwscroll)
+        {
+                Console_ClearLine(0, 0);
+                console_first = Console_Line(1);
+                Lcd_ScrollStart(console_top + console_first * console_size);
+        }
+        else
+        {
+                console_first = Console_Line(1);
+                for(row = 0; row + 1 < console_rows; row++)
+                {
+                        Console_DrawLine(row);
+                }
+                Console_ClearLine(console_rows - 1, 0);
+        }
+}
+
+/**
+ * @Description 在光标处写入一个可显示字符，光标右移
+ */
+static void Console_PutCell(char ch)
+{
+        u8 line;
+
+        if(console_col >= console_cols)
+        {
+                Console_NewLine();
+        }
+
+        line = Console_Line(console_row);
+        console_text[line][console_col] = ch;
+        console_color[line][console_col] = (console_bg << 4) | console_fg;
+        Console_DrawCell(console_row, console_col);
+        console_col++;
+}
+
+/**
+ * @Description 执行收到的ANSI控制序列ESC[...
+ * @param cmd   序列的最后一个字符
+ */
+static void Console_Csi(char cmd)
+{
+        u16 p;
+        u8 i;
+
+        switch(cmd)
+        {
+        case 'm':
+                for(i = 0; i < console_nparam; i++)
+                {
+                        p = console_param[i];
+                        if(p == 0)
+                        {
+                                console_fg = CONSOLE_FG_DEFAULT;
+                                console_bg = CONSOLE_BG_DEFAULT;
+                        }
+                        else if(p == 1)
+                        {
+                                console_fg |= 0x08;
+                        }
+                        else if(p == 22)
+                        {
+                                console_fg &= 0x07;
+                        }
+                        else if(p >= 30 && p <= 37)
+                        {
+                                console_fg = (console_fg & 0x08) | (p - 30);
+                        }
+                        else if(p == 39)
+                        {
+                                console_fg = CONSOLE_FG_DEFAULT;
+                        }
+                        else if(p >= 40 && p <= 47)
+                        {
+                                console_bg = p - 40;
+                        }
+                        else if(p == 49)
+                        {
+                                console_bg = CONSOLE_BG_DEFAULT;
+                        }
+                        else if(p >= 90 && p <= 97)
+                        {
+                                console_fg = p - 90 + 8;
+                        }
+                        else if(p >= 100 && p <= 107)
+                        {
+                                console_bg = p - 100 + 8;
+                        }
+                }
+                break;
+        case 'J':
+                if(console_param[0] == 2)
+                {
+                        Console_Clear();
+                }
+                break;
+        case 'K':
+                if(console_param[0] == 0)
+                {
+                        Console_ClearLine(console_row, console_col);
+                }
+                break;
+        default:
+                break;
+        }
+}
+
+/**
+ * @Description 初始化终端，清除终端区域并把光标放在左上角
+ * @param top   区域第一行的纵坐标
+ * @param height 区域高度，按字号向下取整为整行
+ * @param size  字号 12/16/24
+ * @return u8   0:成功 1:参数错误
+ * @notice      竖屏时设置硬件滚动区域，区域内的GRAM由终端管理，不能再用其他绘图函数画在区域内，
+ *              区域上面和下面的部分不受影响
+ */
+u8 Console_Init(u16 top, u16 height, u8 size)
+{
+        if((size != 12 && size != 16 && size != 24) || top >= lcddev.height || height > lcddev.height - top)
+        {
+                return 1;
+        }
+
+        console_size = size;
+        console_top = top;
+        console_cols = lcddev.width / (size / 2);
+        console_rows = height / size;
+        if(console_cols > CONSOLE_COLS_MAX)
+        {
+                console_cols = CONSOLE_COLS_MAX;
+        }
+        if(console_rows > CONSOLE_ROWS_MAX)
+        {
+                console_rows = CONSOLE_ROWS_MAX;
+        }
+        if(console_rows == 0)
+        {
+                return 1;
+        }
+
+        console_hwscroll = (lcddev.dir == SCREEN_VERTICAL);
+        if(console_hwscroll)
+        {
+                Lcd_ScrollArea(console_top, console_rows * console_size);
+        }
+
+        console_fg = CONSOLE_FG_DEFAULT;
+        console_bg = CONSOLE_BG_DEFAULT;
+        console_esc = 0;
+        console_open = 1;
+        Console_Clear();
+
+        return 0;
+}
+
+/**
+ * @Description 关闭终端，恢复为不滚动的整屏显示，之后Console_PutChar()不再输出
+ * @notice      关闭后区域内按GRAM中的顺序显示，行的顺序可能是乱的，需要由调用者重画
+ */
+void Console_Close(void)
+{
+        if(!console_open)
+        {
+                return;
+        }
+
+        if(console_hwscroll)
+        {
+                Lcd_ScrollArea(0, LCD_SCROLL_LINES);
+                Lcd_ScrollStart(0);
+        }
+        console_open = 0;
+}
+
+/**
+ * @Description 用当前背景色清除终端，光标回到左上角
+ */
+void Console_Clear(void)
+{
+        u8 line;
+
+        if(!console_open)
+        {
+                return;
+        }
+
+        console_first = 0;
+        console_row = 0;
+        console_col = 0;
+        if(console_hwscroll)
+        {
+                Lcd_ScrollStart(console_top);
+        }
+
+        for(line = 0; line < console_rows; line++)
+        {
+                memset(console_text[line], ' ', console_cols);
+                memset(console_color[line], (console_bg << 4) | console_fg, console_cols);
+        }
+        Lcd_Fill(0, console_top, lcddev.width - 1, console_top + console_rows * console_size - 1, console_palette[console_bg]);
+}
+
+/**
+ * @Description 按文本缓冲重画整个终端，用于终端区域被其他绘图覆盖之后
+ */
+void Console_Redraw(void)
+{
+        u8 row;
+
+        if(!console_open)
+        {
+                return;
+        }
+
+        if(console_hwscroll)
+        {
+                Lcd_ScrollArea(console_top, console_rows * console_size);
+                Lcd_ScrollStart(console_top + console_first * console_size);
+        }
+        for(row = 0; row < console_rows; row++)
+        {
+                Console_DrawLine(row);
+        }
+}
+
+/**
+ * @Description 向终端输出一个字符，可以作为printf的输出(见bsp_usart.h中的USART_CONSOLE_MIRROR)
+ * @param ch    字符，控制字符和ANSI序列见bsp_console.h
+ * @notice      \n同时回到行首；UTF-8多字节字符显示为一个'?'
+ */
+void Console_PutChar(char ch)
+{
+        u8 c = ch;
+
+        if(!console_open)
+        {
+                return;
+        }
+
+        if(console_esc == 1)
+        {
+                console_esc = (c == '[') ? 2 : 0;
+                console_nparam = 0;
+                console_param[0] = 0;
+                return;
+        }
+        if(console_esc == 2)
+        {
+                if(c >= '0' && c <= '9')
+                {
+                        if(console_param[console_nparam] < 1000)
+                        {
+                                console_param[console_nparam] = console_param[console_nparam] * 10 + (c - '0');
+                        }
+                }
+                else if(c == ';')
+                {
+                        if(console_nparam < 3)
+                        {
+                                console_param[++console_nparam] = 0;
+                        }
+                }
+                else
+                {
+                        console_nparam++;
+                        Console_Csi(c);
+                        console_esc = 0;
+                }
+                return;
+        }
+
+        if(c >= ' ' && c < 0x7F)
+        {
+                Console_PutCell(c);
+        }
+        else if(c == '\n')
+        {
+                Console_NewLine();
+        }
+        else if(c == '\r')
+        {
+                console_col = 0;
+        }
+        else if(c == '\b')
+        {
+                if(console_col > 0)
+                {
+                        console_col--;
+                }
+        }
+        else if(c == '\t')
+        {
+                do
+                {
+                        Console_PutCell(' ');
+                } while((console_col & 0x07) && console_col < console_cols);
+        }
+        else if(c == 0x1B)
+        {
+                console_esc = 1;
+        }
+        else if(c >= 0xC0)
+        {
+                /* 多字节字符的第一个字节，后续字节(0x80~0xBF)直接丢弃 */
+                Console_PutCell('?');
+        }
+}
+
+/**
+ * @Description 向终端输出字符串
+ * @param str   字符串
+ */
+void Console_Write(const char *str)
+{
+        while(*str != '\0')
+        {
+                Console_PutChar(*str++);
+        }
+}
+
+/**
+ * @Description 格式化输出到终端，不经过串口
+ * @param fmt   格式字符串，与printf相同
+ * @return int  格式化后的长度，超过CONSOLE_PRINTF_MAX-1的部分被截断
+ */
+int Console_Printf(const char *fmt, ...)
+{
+        static char buf[CONSOLE_PRINTF_MAX];
+        va_list ap;
+        int len;
+
+        va_start(ap, fmt);
+        len = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+
+        Console_Write(buf);
+
+        return len;
+}
+
+#if CONSOLE_BENCH
+/**
+ * @Description 比较硬件滚动和整个区域重画两种方式的换行速度，结果通过串口输出
+ * @param lines 每种方式输出的行数，超过终端行数的部分才会滚动
+ * @notice      使用DWT周期计数器计时，LCD_BUS_STAT为1时同时统计每行的总线写入次数，
+ *              横屏时只有重画方式
+ */
+void Console_Benchmark(u16 lines)
+{
+        u32 start, cycles;
+        u8 hwscroll = console_hwscroll;
+        u8 mode;
+        u16 i;
+
+        if(!console_open || lines == 0)
+        {
+                return;
+        }
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        for(mode = hwscroll ? 0 : 1; mode < 2; mode++)
+        {
+                /* 清屏时滚动起始行回到区域顶部，之后重画方式不再移动滚动起始行 */
+                console_hwscroll = hwscroll;
+                Console_Clear();
+                console_hwscroll = (mode == 0);
+
+#if LCD_BUS_STAT
+                Lcd_BusStatReset();
+#endif
+                start = DWT->CYCCNT;
+                for(i = 0; i < lines; i++)
+                {
+                        Console_Printf("\x1B[3%cmline %5u\x1B[0m the quick brown fox\r\n", '1' + i % 7, i);
+#if LCD_USE_FB
+                        Lcd_Flush();
+#endif
+                }
+                cycles = DWT->CYCCNT - start;
+
+                printf("bsp_console:\t%s %u lines, %u lines/s\r\n", mode ? "redraw" : "hw scroll", lines,
+                       (u32)((uint64_t)lines * SYSTEM_CLOCK * 1000000 / cycles));
+#if LCD_BUS_STAT
+                printf("bsp_console:\t%s bus writes/line = %u\r\n", mode ? "redraw" : "hw scroll",
+                       (lcd_bus_stat.cmd + lcd_bus_stat.wdata) / lines);
+#endif
+        }
+
+        console_hwscroll = hwscroll;
+        Console_Clear();
+}
+#endif /* CONSOLE_BENCH */
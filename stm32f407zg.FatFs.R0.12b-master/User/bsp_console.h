@@ -0,0 +1,34 @@
+#ifndef __BSP_CONSOLE_H
+#define __BSP_CONSOLE_H
+
+#include "stm32f4xx.h"
+#include "bsp_lcd.h"
+
+/**
+ * LCD文本终端，竖屏时使用NT35510的垂直滚动功能，换行时只修改滚动起始行并清除新露出的一行，
+ * 不重画其他行；横屏时硬件滚动方向不对，退回到整个区域重画。
+ * 支持\r \n \b \t和ANSI颜色序列ESC[...m(30~37 40~47 90~97 100~107 0 1 22 39 49)，
+ * 以及ESC[2J清屏、ESC[K清除到行尾
+ */
+#define CONSOLE_COLS_MAX        80                      // 最多列数，480/6
+#define CONSOLE_ROWS_MAX        66                      // 最多行数，800/12
+#define CONSOLE_PRINTF_MAX      128                     // Console_Printf()一次最多输出的字符数
+#define CONSOLE_FG_DEFAULT      7                       // 默认文字颜色，调色板序号
+#define CONSOLE_BG_DEFAULT      0                       // 默认背景颜色，调色板序号
+
+/* 1:编译换行速度测试函数Console_Benchmark() 0:不编译 */
+#define CONSOLE_BENCH           0
+
+u8 Console_Init(u16 top, u16 height, u8 size);
+void Console_Close(void);
+void Console_Clear(void);
+void Console_Redraw(void);
+void Console_PutChar(char ch);
+void Console_Write(const char *str);
+int Console_Printf(const char *fmt, ...);
+
+#if CONSOLE_BENCH
+void Console_Benchmark(u16 lines);
+#endif
+
+#endif /* __BSP_CONSOLE_H */
@@ -0,0 +1,525 @@
+#include "bsp_draw.h"
+#include "math.h"
+
+/* 驱动版本号：bsp_draw v1.0 */
+
+/**
+ * 所有图形都拆分成水平或垂直的线段(span)输出，每条线段只设置一次光标或窗口，
+ * 不再对每个点单独设置光标，画一条长度为n的水平线由约9n次总线写入降到约n+9次
+ */
+
+/**
+ * @Description 输出一个矩形线段，裁剪掉超出屏幕左边和上边的部分
+ * @param x,y   左上角坐标，可以为负数
+ * @param w,h   宽度和高度
+ */
+static void Draw_Span(int x, int y, int w, int h)
+{
+        if(x < 0)
+        {
+                w += x;
+                x = 0;
+        }
+        if(y < 0)
+        {
+                h += y;
+                y = 0;
+        }
+        if(w <= 0 || h <= 0 || x >= lcddev.width || y >= lcddev.height)
+        {
+                return;
+        }
+
+        /* 超出屏幕右边和下边的部分由Lcd_FillRect()裁剪 */
+        Lcd_FillRect(x, y, w > 0xFFFF ? 0xFFFF : w, h > 0xFFFF ? 0xFFFF : h, POINT_COLOR);
+}
+
+/**
+ * @Description 画水平线
+ * @param x,y   起点坐标
+ * @param len   长度
+ */
+void Draw_HLine(u16 x, u16 y, u16 len)
+{
+        Draw_Span(x, y, len, 1);
+}
+
+/**
+ * @Description 画垂直线
+ * @param x,y   起点坐标
+ * @param len   长度
+ */
+void Draw_VLine(u16 x, u16 y, u16 len)
+{
+        Draw_Span(x, y, 1, len);
+}
+
+/**
+ * @Description 画线段，水平线和垂直线直接输出一条线段，斜线用Bresenham算法，
+ *              同一行(x方向为主)或同一列(y方向为主)上连续的点合并成一条线段输出
+ * @param x1,y1 起点坐标
+ * @param x2,y2 终点坐标
+ */
+void Draw_Line(u16 x1, u16 y1, u16 x2, u16 y2)
+{
+        int x = x1;
+        int y = y1;
+        int dx, dy, sx, sy, err, start;
+
+        dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+        dy = (y2 > y1) ? y2 - y1 : y1 - y2;
+        sx = (x2 > x1) ? 1 : -1;
+        sy = (y2 > y1) ? 1 : -1;
+
+        if(dy == 0)
+        {
+                Draw_Span((x1 < x2) ? x1 : x2, y1, dx + 1, 1);
+                return;
+        }
+        if(dx == 0)
+        {
+                Draw_Span(x1, (y1 < y2) ? y1 : y2, 1, dy + 1);
+                return;
+        }
+
+        if(dx >= dy)
+        {
+                /* x方向为主，每行输出一条水平线段 */
+                err = dx / 2;
+                start = x;
+                while(x != x2)
+                {
+                        err -= dy;
+                        if(err < 0)
+                        {
+                                Draw_Span((sx > 0) ? start : x, y, (x - start) * sx + 1, 1);
+                                y += sy;
+                                err += dx;
+                                start = x + sx;
+                        }
+                        x += sx;
+                }
+                Draw_Span((sx > 0) ? start : x, y, (x - start) * sx + 1, 1);
+        }
+        else
+        {
+                /* y方向为主，每列输出一条垂直线段 */
+                err = dy / 2;
+                start = y;
+                while(y != y2)
+                {
+                        err -= dx;
+                        if(err < 0)
+                        {
+                                Draw_Span(x, (sy > 0) ? start : y, 1, (y - start) * sy + 1);
+                                x += sx;
+                                err += dy;
+                                start = y + sy;
+                        }
+                        y += sy;
+                }
+                Draw_Span(x, (sy > 0) ? start : y, 1, (y - start) * sy + 1);
+        }
+}
+
+/**
+ * @Description 画矩形
+ * @param (x1,y1),(x2,y2) 矩形的对角坐标
+ */
+void Draw_Rect(u16 x1, u16 y1, u16 x2, u16 y2)
+{
+        u16 t;
+
+        if(x1 > x2)
+        {
+                t = x1;
+                x1 = x2;
+                x2 = t;
+        }
+        if(y1 > y2)
+        {
+                t = y1;
+                y1 = y2;
+                y2 = t;
+        }
+
+        Draw_Span(x1, y1, x2 - x1 + 1, 1);
+        Draw_Span(x1, y2, x2 - x1 + 1, 1);
+        if(y2 - y1 > 1)
+        {
+                Draw_Span(x1, y1 + 1, 1, y2 - y1 - 1);
+                Draw_Span(x2, y1 + 1, 1, y2 - y1 - 1);
+        }
+}
+
+/**
+ * @Description 画实心矩形，面积较大时使用DMA填充
+ * @param (x1,y1),(x2,y2) 矩形的对角坐标
+ */
+void Draw_FillRect(u16 x1, u16 y1, u16 x2, u16 y2)
+{
+        u16 t;
+
+        if(x1 > x2)
+        {
+                t = x1;
+                x1 = x2;
+                x2 = t;
+        }
+        if(y1 > y2)
+        {
+                t = y1;
+                y1 = y2;
+                y2 = t;
+        }
+
+        if((u32)(x2 - x1 + 1) * (y2 - y1 + 1) >= DRAW_DMA_MIN && x2 < lcddev.width && y2 < lcddev.height)
+        {
+                Lcd_Fill(x1, y1, x2, y2, POINT_COLOR);
+        }
+        else
+        {
+                Draw_Span(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+        }
+}
+
+/**
+ * @Description 画四个角的圆弧，左右两侧的圆心横坐标分别为xl和xr，上下两侧的圆心纵坐标分别为yt和yb，
+ *              xl=xr且yt=yb时就是一个完整的圆
+ * @param xl,xr 左右圆心的横坐标
+ * @param yt,yb 上下圆心的纵坐标
+ * @param r     半径
+ * @notice      圆弧上纵坐标相同的点合并成水平线段，横坐标相同的点合并成垂直线段
+ */
+static void Draw_Arcs(int xl, int xr, int yt, int yb, int r)
+{
+        int a = 0;
+        int b = r;
+        int di = 3 - (r << 1);
+        int as = 0;
+        int ae = 0;
+        int n;
+
+        while(a <= b)
+        {
+                ae = a;
+                a++;
+
+                /* 使用Bresenham算法画圆，b变化前把当前这一段输出 */
+                if(di < 0)
+                {
+                        di += 4 * a + 6;
+                        if(a <= b)
+                        {
+                                continue;
+                        }
+                }
+                else
+                {
+                        di += 10 + 4 * (a - b);
+                }
+
+                n = ae - as + 1;
+
+                /* 上下两侧的水平线段 */
+                Draw_Span(xr + as, yt - b, n, 1);
+                Draw_Span(xl - ae, yt - b, n, 1);
+                Draw_Span(xr + as, yb + b, n, 1);
+                Draw_Span(xl - ae, yb + b, n, 1);
+
+                /* 左右两侧的垂直线段 */
+                Draw_Span(xr + b, yb + as, 1, n);
+                Draw_Span(xr + b, yt - ae, 1, n);
+                Draw_Span(xl - b, yb + as, 1, n);
+                Draw_Span(xl - b, yt - ae, 1, n);
+
+                b--;
+                as = a;
+        }
+}
+
+/**
+ * @Description 填充四个角的圆弧之间的区域，参数同Draw_Arcs()，每一行只输出一条水平线段
+ * @notice      圆心之间(yt和yb之间)的部分由调用者填充
+ */
+static void Draw_FillArcs(int xl, int xr, int yt, int yb, int r)
+{
+        int a = 0;
+        int b = r;
+        int di = 3 - (r << 1);
+        int ae;
+
+        while(a <= b)
+        {
+                /* 纵坐标为yb+a和yt-a的行 */
+                Draw_Span(xl - b, yb + a, xr - xl + 2 * b + 1, 1);
+                if(a != 0 || yt != yb)
+                {
+                        Draw_Span(xl - b, yt - a, xr - xl + 2 * b + 1, 1);
+                }
+
+                ae = a;
+                a++;
+                if(di < 0)
+                {
+                        di += 4 * a + 6;
+                }
+                else
+                {
+                        /* b变化前输出纵坐标为yb+b和yt-b的行，与上面已经画过的行重合时不再输出 */
+                        if(ae != b)
+                        {
+                                Draw_Span(xl - ae, yb + b, xr - xl + 2 * ae + 1, 1);
+                                Draw_Span(xl - ae, yt - b, xr - xl + 2 * ae + 1, 1);
+                        }
+                        di += 10 + 4 * (a - b);
+                        b--;
+                }
+        }
+}
+
+/**
+ * @Description 画圆
+ * @param x0,y0 圆心坐标
+ * @param r     半径
+ */
+void Draw_Circle(u16 x0, u16 y0, u16 r)
+{
+        Draw_Arcs(x0, x0, y0, y0, r);
+}
+
+/**
+ * @Description 画实心圆
+ * @param x0,y0 圆心坐标
+ * @param r     半径
+ */
+void Draw_FillCircle(u16 x0, u16 y0, u16 r)
+{
+        Draw_FillArcs(x0, x0, y0, y0, r);
+}
+
+/**
+ * @Description 画圆角矩形
+ * @param (x1,y1),(x2,y2) 矩形的对角坐标
+ * @param r               圆角半径，超过短边的一半时按短边的一半处理
+ */
+void Draw_RoundRect(u16 x1, u16 y1, u16 x2, u16 y2, u16 r)
+{
+        u16 t;
+
+        if(x1 > x2)
+        {
+                t = x1;
+                x1 = x2;
+                x2 = t;
+        }
+        if(y1 > y2)
+        {
+                t = y1;
+                y1 = y2;
+                y2 = t;
+        }
+        if(r > (x2 - x1) / 2)
+        {
+                r = (x2 - x1) / 2;
+        }
+        if(r > (y2 - y1) / 2)
+        {
+                r = (y2 - y1) / 2;
+        }
+
+        /* 四个角的圆弧 */
+        Draw_Arcs(x1 + r, x2 - r, y1 + r, y2 - r, r);
+
+        /* 圆弧之间的四条边 */
+        if(x2 - x1 > 2 * r + 1)
+        {
+                Draw_Span(x1 + r + 1, y1, x2 - x1 - 2 * r - 1, 1);
+                Draw_Span(x1 + r + 1, y2, x2 - x1 - 2 * r - 1, 1);
+        }
+        if(y2 - y1 > 2 * r + 1)
+        {
+                Draw_Span(x1, y1 + r + 1, 1, y2 - y1 - 2 * r - 1);
+                Draw_Span(x2, y1 + r + 1, 1, y2 - y1 - 2 * r - 1);
+        }
+}
+
+/**
+ * @Description 画实心圆角矩形
+ * @param (x1,y1),(x2,y2) 矩形的对角坐标
+ * @param r               圆角半径，超过短边的一半时按短边的一半处理
+ */
+void Draw_FillRoundRect(u16 x1, u16 y1, u16 x2, u16 y2, u16 r)
+{
+        u16 t;
+
+        if(x1 > x2)
+        {
+                t = x1;
+                x1 = x2;
+                x2 = t;
+        }
+        if(y1 > y2)
+        {
+                t = y1;
+                y1 = y2;
+                y2 = t;
+        }
+        if(r > (x2 - x1) / 2)
+        {
+                r = (x2 - x1) / 2;
+        }
+        if(r > (y2 - y1) / 2)
+        {
+                r = (y2 - y1) / 2;
+        }
+
+        /* 上下两端带圆角的部分 */
+        Draw_FillArcs(x1 + r, x2 - r, y1 + r, y2 - r, r);
+
+        /* 中间的矩形部分 */
+        if(y2 - y1 > 2 * r + 1)
+        {
+                Draw_FillRect(x1, y1 + r + 1, x2, y2 - r - 1);
+        }
+}
+
+/**
+ * @Description 画三角形
+ * @param (x1,y1),(x2,y2),(x3,y3) 三个顶点坐标
+ */
+void Draw_Triangle(u16 x1, u16 y1, u16 x2, u16 y2, u16 x3, u16 y3)
+{
+        Draw_Line(x1, y1, x2, y2);
+        Draw_Line(x2, y2, x3, y3);
+        Draw_Line(x3, y3, x1, y1);
+}
+
+/**
+ * @Description 填充三角形，坐标可以为负数
+ * @param (x1,y1),(x2,y2),(x3,y3) 三个顶点坐标
+ * @notice      按顶点纵坐标排序后逐行计算左右边界，每行输出一条水平线段
+ */
+static void Draw_FillTriangleInt(int x1, int y1, int x2, int y2, int x3, int y3)
+{
+        int t, y, xa, xb, last;
+        int dx12, dy12, dx13, dy13, dx23, dy23;
+        int sa = 0;
+        int sb = 0;
+
+        /* 按纵坐标从小到大排序 y1 <= y2 <= y3 */
+        if(y1 > y2)
+        {
+                t = y1; y1 = y2; y2 = t;
+                t = x1; x1 = x2; x2 = t;
+        }
+        if(y2 > y3)
+        {
+                t = y2; y2 = y3; y3 = t;
+                t = x2; x2 = x3; x3 = t;
+        }
+        if(y1 > y2)
+        {
+                t = y1; y1 = y2; y2 = t;
+                t = x1; x1 = x2; x2 = t;
+        }
+
+        /* 三个点在同一行 */
+        if(y1 == y3)
+        {
+                xa = xb = x1;
+                if(x2 < xa) xa = x2;
+                if(x2 > xb) xb = x2;
+                if(x3 < xa) xa = x3;
+                if(x3 > xb) xb = x3;
+                Draw_Span(xa, y1, xb - xa + 1, 1);
+                return;
+        }
+
+        dx12 = x2 - x1;
+        dy12 = y2 - y1;
+        dx13 = x3 - x1;
+        dy13 = y3 - y1;
+        dx23 = x3 - x2;
+        dy23 = y3 - y2;
+
+        /* 上半部分：边1-2和边1-3，y2==y3时包含最后一行，否则最后一行由下半部分画 */
+        last = (y2 == y3) ? y2 : y2 - 1;
+        for(y = y1; y <= last; y++)
+        {
+                xa = x1 + (dy12 ? sa / dy12 : 0);
+                xb = x1 + sb / dy13;
+                sa += dx12;
+                sb += dx13;
+                if(xa > xb)
+                {
+                        t = xa; xa = xb; xb = t;
+                }
+                Draw_Span(xa, y, xb - xa + 1, 1);
+        }
+
+        /* 下半部分：边2-3和边1-3 */
+        sa = dx23 * (y - y2);
+        sb = dx13 * (y - y1);
+        for(; y <= y3; y++)
+        {
+                xa = x2 + sa / dy23;
+                xb = x1 + sb / dy13;
+                sa += dx23;
+                sb += dx13;
+                if(xa > xb)
+                {
+                        t = xa; xa = xb; xb = t;
+                }
+                Draw_Span(xa, y, xb - xa + 1, 1);
+        }
+}
+
+/**
+ * @Description 画实心三角形
+ * @param (x1,y1),(x2,y2),(x3,y3) 三个顶点坐标
+ */
+void Draw_FillTriangle(u16 x1, u16 y1, u16 x2, u16 y2, u16 x3, u16 y3)
+{
+        Draw_FillTriangleInt(x1, y1, x2, y2, x3, y3);
+}
+
+/**
+ * @Description 画粗线
+ * @param x1,y1 起点坐标
+ * @param x2,y2 终点坐标
+ * @param width 线宽
+ * @notice      水平线和垂直线直接填充矩形，斜线按两侧各偏移半个线宽得到的四边形拆成两个三角形填充
+ */
+void Draw_ThickLine(u16 x1, u16 y1, u16 x2, u16 y2, u8 width)
+{
+        int dx = x2 - x1;
+        int dy = y2 - y1;
+        int ox, oy;
+        float len;
+
+        if(width <= 1)
+        {
+                Draw_Line(x1, y1, x2, y2);
+                return;
+        }
+
+        if(dy == 0)
+        {
+                Draw_Span((x1 < x2) ? x1 : x2, y1 - width / 2, (dx > 0 ? dx : -dx) + 1, width);
+                return;
+        }
+        if(dx == 0)
+        {
+                Draw_Span(x1 - width / 2, (y1 < y2) ? y1 : y2, width, (dy > 0 ? dy : -dy) + 1);
+                return;
+        }
+
+        /* 垂直于线段方向的半个线宽偏移量 */
+        len = sqrtf((float)dx * dx + (float)dy * dy);
+        ox = (int)(-dy * (width - 1) / (2 * len) + ((dy > 0) ? -0.5f : 0.5f));
+        oy = (int)(dx * (width - 1) / (2 * len) + ((dx > 0) ? 0.5f : -0.5f));
+
+        Draw_FillTriangleInt(x1 + ox, y1 + oy, x2 + ox, y2 + oy, x2 - ox, y2 - oy);
+        Draw_FillTriangleInt(x1 + ox, y1 + oy, x2 - ox, y2 - oy, x1 - ox, y1 - oy);
+}
@@ -0,0 +1,24 @@
+#ifndef __BSP_DRAW_H
+#define __BSP_DRAW_H
+
+#include "stm32f4xx.h"
+#include "bsp_lcd.h"
+
+/* 填充面积超过该点数时使用DMA填充，较小的区域用CPU写入更快 */
+#define DRAW_DMA_MIN    1024
+
+/* 所有图形都使用画笔颜色POINT_COLOR绘制，坐标允许部分超出屏幕，超出的部分不绘制 */
+void Draw_HLine(u16 x, u16 y, u16 len);
+void Draw_VLine(u16 x, u16 y, u16 len);
+void Draw_Line(u16 x1, u16 y1, u16 x2, u16 y2);
+void Draw_ThickLine(u16 x1, u16 y1, u16 x2, u16 y2, u8 width);
+void Draw_Rect(u16 x1, u16 y1, u16 x2, u16 y2);
+void Draw_FillRect(u16 x1, u16 y1, u16 x2, u16 y2);
+void Draw_RoundRect(u16 x1, u16 y1, u16 x2, u16 y2, u16 r);
+void Draw_FillRoundRect(u16 x1, u16 y1, u16 x2, u16 y2, u16 r);
+void Draw_Circle(u16 x0, u16 y0, u16 r);
+void Draw_FillCircle(u16 x0, u16 y0, u16 r);
+void Draw_Triangle(u16 x1, u16 y1, u16 x2, u16 y2, u16 x3, u16 y3);
+void Draw_FillTriangle(u16 x1, u16 y1, u16 x2, u16 y2, u16 x3, u16 y3);
+
+#endif /* __BSP_DRAW_H */
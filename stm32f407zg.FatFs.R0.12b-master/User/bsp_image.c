@@ -0,0 +1,486 @@
+#include "bsp_image.h"
+#include "ff.h"
+
+/* 驱动版本号：bsp_image v1.1 */
+
+/**
+ * 图片从文件系统中一行一行读出，在行缓冲区中原地转换为RGB565后写入GRAM，
+ * 整张图片只设置一次窗口，不需要整帧的缓冲区
+ */
+
+/* 行缓冲区中像素的格式 */
+#define IMAGE_RGB565            0
+#define IMAGE_RGB555            1
+#define IMAGE_RGB888            2
+
+static FIL image_file;
+static u32 image_buf[(IMAGE_WIDTH_MAX * 3 + 3) / 4];            // 行缓冲区，按字对齐，便于一次处理两个像素
+
+static u16 image_hist[IMAGE_IMZ_WINDOW];                        // IMZ解码时最近输出的像素
+static u16 image_in_pos, image_in_len;                          // IMZ解码时输入缓冲区(image_buf)的读取位置和数据长度
+static u16 image_out[64];                                       // IMZ解码时攒够一批再写入GRAM的像素
+static u8 image_out_num;
+
+/**
+ * @Description 读取小端的16位数
+ */
+static u16 Image_Get16(const u8 *p)
+{
+        return p[0] | (p[1] << 8);
+}
+
+/**
+ * @Description 读取小端的32位数
+ */
+static u32 Image_Get32(const u8 *p)
+{
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/**
+ * @Description 把一行BGR888像素原地转换为RGB565
+ * @param buf   行缓冲区，转换后前n个半字为RGB565像素
+ * @param n     像素个数
+ * @notice      每次读入3个字(4个像素)，用UXTB16一次取出两个字节，PKHBT/PKHTB把两个像素的
+ *              同一分量拼到一个字中，一次移位和掩码同时处理两个像素，写出2个字。
+ *              输出总是在输入之前，可以原地转换
+ */
+static void Image_Rgb888To565(u32 *buf, u16 n)
+{
+        const u32 *src = buf;
+        u32 *dst = buf;
+        const u8 *s;
+        u16 *d;
+        u32 w0, w1, w2;
+        u32 t0, t1, t2, t3, t4, t5;
+        u32 r, g, b;
+        u16 i;
+
+        for(i = n / 4; i; i--)
+        {
+                /* w0=B0G0R0B1 w1=G1R1B2G2 w2=R2B3G3R3(从低字节到高字节) */
+                w0 = src[0];
+                w1 = src[1];
+                w2 = src[2];
+                src += 3;
+
+                t0 = __UXTB16(w0);                      // B0 | R0 << 16
+                t1 = __UXTB16(__ROR(w0, 8));            // G0 | B1 << 16
+                t2 = __UXTB16(w1);                      // G1 | B2 << 16
+                t3 = __UXTB16(__ROR(w1, 8));            // R1 | G2 << 16
+                t4 = __UXTB16(w2);                      // R2 | G3 << 16
+                t5 = __UXTB16(__ROR(w2, 8));            // B3 | R3 << 16
+
+                /* 像素0、1 */
+                b = __PKHBT(t0, t1, 0);
+                g = __PKHBT(t1, t2, 16);
+                r = __PKHBT(t0 >> 16, t3, 16);
+                dst[0] = ((r & 0x00F800F8) << 8) | ((g & 0x00FC00FC) << 3) | ((b & 0x00F800F8) >> 3);
+
+                /* 像素2、3 */
+                b = __PKHBT(t2 >> 16, t5, 16);
+                g = __PKHTB(t4, t3, 16);
+                r = __PKHBT(t4, t5, 0);
+                dst[1] = ((r & 0x00F800F8) << 8) | ((g & 0x00FC00FC) << 3) | ((b & 0x00F800F8) >> 3);
+                dst += 2;
+        }
+
+        /* 剩下不足4个的像素逐个转换 */
+        s = (const u8 *)src;
+        d = (u16 *)dst;
+        for(i = n % 4; i; i--)
+        {
+                *d++ = ((s[2] & 0xF8) << 8) | ((s[1] & 0xFC) << 3) | (s[0] >> 3);
+                s += 3;
+        }
+}
+
+/**
+ * @Description 把一行RGB555像素原地转换为RGB565，一次处理两个像素
+ * @param buf   行缓冲区
+ * @param n     像素个数
+ * @notice      红色和绿色左移一位，绿色的最低位用最高位填充，白色转换后仍为0xFFFF
+ */
+static void Image_Rgb555To565(u32 *buf, u16 n)
+{
+        u32 w;
+        u16 i;
+
+        for(i = (n + 1) / 2; i; i--)
+        {
+                w = *buf;
+                *buf++ = ((w & 0x7FE07FE0) << 1) | ((w & 0x02000200) >> 4) | (w & 0x001F001F);
+        }
+}
+
+/**
+ * @Description 逐行读取图片数据并显示
+ * @param x,y   左上角坐标
+ * @param width,height 图片大小
+ * @param stride 文件中每行的字节数
+ * @param format 像素格式
+ * @param bottomup 文件中的行是否从下到上存放
+ * @return u8   IMAGE_OK或IMAGE_ERR_FILE
+ */
+static u8 Image_Stream(u16 x, u16 y, u16 width, u16 height, u32 stride, u8 format, u8 bottomup)
+{
+        UINT br;
+        u16 i;
+        u8 res = IMAGE_OK;
+
+        Lcd_BlitBegin(x, y, width, height, bottomup);
+
+        for(i = 0; i < height; i++)
+        {
+                if(f_read(&image_file, image_buf, stride, &br) != FR_OK || br != stride)
+                {
+                        res = IMAGE_ERR_FILE;
+                        break;
+                }
+
+                if(format == IMAGE_RGB888)
+                {
+                        Image_Rgb888To565(image_buf, width);
+                }
+                else if(format == IMAGE_RGB555)
+                {
+                        Image_Rgb555To565(image_buf, width);
+                }
+
+                Lcd_BlitRow((const u16 *)image_buf);
+        }
+
+        Lcd_BlitEnd();
+
+        return res;
+}
+
+/**
+ * @Description 显示BMP图片，支持24位、16位(RGB555)和BITFIELDS格式的16位(RGB565/RGB555)
+ * @param path  文件路径
+ * @param x,y   左上角坐标，超出屏幕的部分不显示
+ * @return u8   IMAGE_OK:成功 IMAGE_ERR_FILE:文件错误 IMAGE_ERR_FORMAT:不支持的格式
+ * @notice      BMP通常从最下面一行开始存放，显示时临时反转LCD的行扫描方向，
+ *              按文件顺序读取，不需要在文件中来回移动读写指针
+ */
+u8 Image_ShowBmp(const char *path, u16 x, u16 y)
+{
+        const u8 *head = (const u8 *)image_buf;
+        u32 offset, compression, mask;
+        s32 width, height;
+        u16 bpp;
+        u8 format, bottomup;
+        UINT br;
+        u8 res;
+
+        if(f_open(&image_file, path, FA_READ) != FR_OK)
+        {
+                return IMAGE_ERR_FILE;
+        }
+
+        /* 文件头14字节，信息头至少40字节，BITFIELDS格式的颜色掩码紧跟在后面 */
+        if(f_read(&image_file, image_buf, 70, &br) != FR_OK || br < 54)
+        {
+                f_close(&image_file);
+                return IMAGE_ERR_FILE;
+        }
+
+        offset = Image_Get32(head + 10);
+        width = Image_Get32(head + 18);
+        height = Image_Get32(head + 22);
+        bpp = Image_Get16(head + 28);
+        compression = Image_Get32(head + 30);
+        mask = (br >= 58) ? Image_Get32(head + 54) : 0;
+
+        /* 高度为负数表示从上到下存放 */
+        bottomup = (height > 0);
+        if(height < 0)
+        {
+                height = -height;
+        }
+
+        if(bpp == 24 && compression == 0)
+        {
+                format = IMAGE_RGB888;
+        }
+        else if(bpp == 16 && compression == 0)
+        {
+                format = IMAGE_RGB555;
+        }
+        else if(bpp == 16 && compression == 3 && (mask == 0xF800 || mask == 0x7C00))
+        {
+                format = (mask == 0xF800) ? IMAGE_RGB565 : IMAGE_RGB555;
+        }
+        else
+        {
+                format = 0xFF;
+        }
+
+        if(head[0] != 'B' || head[1] != 'M' || format == 0xFF ||
+           width <= 0 || width > IMAGE_WIDTH_MAX || height == 0 || height > 0xFFFF)
+        {
+                f_close(&image_file);
+                return IMAGE_ERR_FORMAT;
+        }
+
+        if(f_lseek(&image_file, offset) != FR_OK)
+        {
+                f_close(&image_file);
+                return IMAGE_ERR_FILE;
+        }
+
+        /* 每行的字节数按4字节对齐 */
+        res = Image_Stream(x, y, width, height, ((u32)width * (bpp / 8) + 3) & ~3u, format, bottomup);
+        f_close(&image_file);
+
+        return res;
+}
+
+/**
+ * @Description 显示没有文件头的RGB565图片，像素按行从上到下存放，每个像素2字节小端
+ * @param path  文件路径
+ * @param x,y   左上角坐标，超出屏幕的部分不显示
+ * @param width,height 图片大小
+ * @return u8   IMAGE_OK:成功 IMAGE_ERR_FILE:文件错误 IMAGE_ERR_FORMAT:宽度超出IMAGE_WIDTH_MAX
+ */
+u8 Image_ShowRaw(const char *path, u16 x, u16 y, u16 width, u16 height)
+{
+        u8 res;
+
+        if(width == 0 || width > IMAGE_WIDTH_MAX)
+        {
+                return IMAGE_ERR_FORMAT;
+        }
+
+        if(f_open(&image_file, path, FA_READ) != FR_OK)
+        {
+                return IMAGE_ERR_FILE;
+        }
+
+        res = Image_Stream(x, y, width, height, (u32)width * 2, IMAGE_RGB565, 0);
+        f_close(&image_file);
+
+        return res;
+}
+
+/**
+ * @Description 从文件中读取一个字节，image_buf作为输入缓冲区
+ * @param v     返回读到的字节
+ * @return u8   1:成功 0:读取失败或者文件结束
+ */
+static u8 Image_ReadByte(u8 *v)
+{
+        UINT br;
+
+        if(image_in_pos == image_in_len)
+        {
+                if(f_read(&image_file, image_buf, sizeof(image_buf), &br) != FR_OK || br == 0)
+                {
+                        return 0;
+                }
+                image_in_len = br;
+                image_in_pos = 0;
+        }
+
+        *v = ((const u8 *)image_buf)[image_in_pos++];
+        return 1;
+}
+
+/**
+ * @Description 从文件中读取一个小端的16位数
+ * @param v     返回读到的数
+ * @return u8   1:成功 0:读取失败或者文件结束
+ */
+static u8 Image_ReadWord(u16 *v)
+{
+        u8 lo, hi;
+
+        if(!Image_ReadByte(&lo) || !Image_ReadByte(&hi))
+        {
+                return 0;
+        }
+
+        *v = lo | (hi << 8);
+        return 1;
+}
+
+/**
+ * @Description 把攒下的像素写入GRAM
+ */
+static void Image_Flush(void)
+{
+        if(image_out_num)
+        {
+                Lcd_BlitPixels(image_out, image_out_num, 1);
+                image_out_num = 0;
+        }
+}
+
+/**
+ * @Description 输出一个像素，攒够一批后一起写入GRAM
+ * @param pixel 颜色值
+ */
+static void Image_Output(u16 pixel)
+{
+        image_out[image_out_num++] = pixel;
+        if(image_out_num == sizeof(image_out) / sizeof(image_out[0]))
+        {
+                Image_Flush();
+        }
+}
+
+/**
+ * @Description 显示IMZ压缩图片，格式见bsp_image.h
+ * @param path  文件路径
+ * @param x,y   左上角坐标，超出屏幕的部分不显示
+ * @return u8   IMAGE_OK:成功 IMAGE_ERR_FILE:文件错误 IMAGE_ERR_FORMAT:格式错误
+ * @notice      解码结果直接写入GRAM窗口，连续相同的长段由DMA填充，同时CPU继续从Flash读取后面的数据
+ */
+u8 Image_ShowImz(const char *path, u16 x, u16 y)
+{
+        const u8 *head = (const u8 *)image_buf;
+        u32 pos, total;
+        u16 width, height;
+        u16 len, dist, pixel, i;
+        u8 op;
+        UINT br;
+        u8 res = IMAGE_OK;
+
+        if(f_open(&image_file, path, FA_READ) != FR_OK)
+        {
+                return IMAGE_ERR_FILE;
+        }
+
+        if(f_read(&image_file, image_buf, 12, &br) != FR_OK || br != 12)
+        {
+                f_close(&image_file);
+                return IMAGE_ERR_FILE;
+        }
+
+        width = Image_Get16(head + 4);
+        height = Image_Get16(head + 6);
+        if(Image_Get32(head) != IMAGE_IMZ_MAGIC || width == 0 || height == 0)
+        {
+                f_close(&image_file);
+                return IMAGE_ERR_FORMAT;
+        }
+
+        image_in_pos = 0;
+        image_in_len = 0;
+        image_out_num = 0;
+        total = (u32)width * height;
+        pos = 0;
+
+        Lcd_BlitBegin(x, y, width, height, 0);
+
+        while(pos < total)
+        {
+                /* 记录头，长度超过63时由后面的u16给出 */
+                if(!Image_ReadByte(&op))
+                {
+                        res = IMAGE_ERR_FILE;
+                        break;
+                }
+                len = (op & 0x3F) + 1;
+                if((op & 0x3F) == 0x3F && !Image_ReadWord(&len))
+                {
+                        res = IMAGE_ERR_FILE;
+                        break;
+                }
+                if(len == 0 || len > total - pos)
+                {
+                        res = IMAGE_ERR_FORMAT;
+                        break;
+                }
+
+                if((op >> 6) == 0)
+                {
+                        /* 直接像素 */
+                        for(i = 0; i < len; i++)
+                        {
+                                if(!Image_ReadWord(&pixel))
+                                {
+                                        break;
+                                }
+                                image_hist[pos++ & (IMAGE_IMZ_WINDOW - 1)] = pixel;
+                                Image_Output(pixel);
+                        }
+                        if(i < len)
+                        {
+                                res = IMAGE_ERR_FILE;
+                                break;
+                        }
+                }
+                else if((op >> 6) == 1)
+                {
+                        /* 连续相同的像素，长段由DMA填充 */
+                        if(!Image_ReadWord(&pixel))
+                        {
+                                res = IMAGE_ERR_FILE;
+                                break;
+                        }
+                        Image_Flush();
+                        Lcd_BlitPixels(&pixel, len, 0);
+
+                        /* 只有最后IMAGE_IMZ_WINDOW个像素可能被后面复制 */
+                        for(i = (len > IMAGE_IMZ_WINDOW) ? len - IMAGE_IMZ_WINDOW : 0; i < len; i++)
+                        {
+                                image_hist[(pos + i) & (IMAGE_IMZ_WINDOW - 1)] = pixel;
+                        }
+                        pos += len;
+                }
+                else if((op >> 6) == 2)
+                {
+                        /* 复制前面的像素，距离可以小于长度(重复的图案) */
+                        if(!Image_ReadWord(&dist))
+                        {
+                                res = IMAGE_ERR_FILE;
+                                break;
+                        }
+                        if(dist == 0 || dist > IMAGE_IMZ_WINDOW || dist > pos)
+                        {
+                                res = IMAGE_ERR_FORMAT;
+                                break;
+                        }
+                        for(i = 0; i < len; i++)
+                        {
+                                pixel = image_hist[(pos - dist) & (IMAGE_IMZ_WINDOW - 1)];
+                                image_hist[pos++ & (IMAGE_IMZ_WINDOW - 1)] = pixel;
+                                Image_Output(pixel);
+                        }
+                }
+                else
+                {
+                        res = IMAGE_ERR_FORMAT;
+                        break;
+                }
+        }
+
+        Image_Flush();
+        Lcd_BlitEnd();
+        f_close(&image_file);
+
+        return res;
+}
+
+#if IMAGE_BENCH
+/**
+ * @Description 测试显示一张BMP或IMZ图片的耗时，结果通过串口输出
+ * @param path  文件路径，扩展名为.IMZ时按IMZ格式解码
+ * @notice      使用DWT周期计数器计时，包括读取文件、格式转换和写入GRAM的全部时间
+ */
+void Image_Benchmark(const char *path)
+{
+        u32 start, cycles;
+        u8 res;
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        start = DWT->CYCCNT;
+        res = (strstr(path, ".IMZ") || strstr(path, ".imz")) ? Image_ShowImz(path, 0, 0) : Image_ShowBmp(path, 0, 0);
+        cycles = DWT->CYCCNT - start;
+
+        printf("bsp_image:\t%s return = %d, %u ms\r\n", path, res, cycles / (SYSTEM_CLOCK * 1000));
+}
+#endif /* IMAGE_BENCH */
@@ -0,0 +1,38 @@
+#ifndef __BSP_IMAGE_H
+#define __BSP_IMAGE_H
+
+#include "stm32f4xx.h"
+#include "bsp_lcd.h"
+
+/* 支持的最大图片宽度，决定行缓冲区的大小(IMAGE_WIDTH_MAX*3字节) */
+#define IMAGE_WIDTH_MAX         800
+
+/**
+ * IMZ压缩图片格式，由上位机工具Tools/imzpack.c生成(小端)：
+ *      文件头12字节            magic(u32) width(u16) height(u16) size(u32，数据部分字节数)
+ *      数据                    一串记录，每条记录第一个字节高2位为类型，低6位为长度-1，
+ *                              低6位全为1时长度由后面的u16给出
+ *      类型0 直接像素          后跟长度个RGB565像素
+ *      类型1 连续相同像素      后跟1个RGB565像素
+ *      类型2 复制前面的像素    后跟u16距离(1~IMAGE_IMZ_WINDOW)，从已输出的像素中往回复制
+ */
+#define IMAGE_IMZ_MAGIC         0x315A4D49              // "IMZ1"
+#define IMAGE_IMZ_WINDOW        2048                    // 复制距离的上限，解码时保存最近输出的像素，必须为2的幂
+
+/* 1:编译显示耗时测试函数Image_Benchmark() 0:不编译 */
+#define IMAGE_BENCH             0
+
+/* 返回值 */
+#define IMAGE_OK                0                       // 成功
+#define IMAGE_ERR_FILE          1                       // 文件打开或读取失败
+#define IMAGE_ERR_FORMAT        2                       // 不支持的图片格式
+
+u8 Image_ShowBmp(const char *path, u16 x, u16 y);
+u8 Image_ShowRaw(const char *path, u16 x, u16 y, u16 width, u16 height);
+u8 Image_ShowImz(const char *path, u16 x, u16 y);
+
+#if IMAGE_BENCH
+void Image_Benchmark(const char *path);
+#endif
+
+#endif /* __BSP_IMAGE_H */
@@ -1,13 +1,186 @@
 #include "bsp_lcd.h"
 #include "bsp_font.h"
+#include "bsp_draw.h"
+#include "bsp_text.h"
 
-/* 驱动版本号：bsp_lcd v1.3 */
+/* 驱动版本号：bsp_lcd v2.4 */
 
 u16 POINT_COLOR = 0x0000;                                       // LCD的画笔颜色
 u16 BACK_COLOR = 0xFFFF;                                        // LCD的背景颜色
 
 LCD_InfoTypeDef lcddev;                                         // 储存LCD重要参数集的结构体对象
 
+#if LCD_BUS_STAT
+LCD_BusStatTypeDef lcd_bus_stat;                                // LCD总线访问次数统计
+#endif
+
+static volatile u8 lcd_dma_busy = 0;                            // DMA正在向GRAM传输数据的标志
+static u16 lcd_dma_color;                                       // 纯色填充时DMA的源数据
+static const u16 *lcd_dma_src;                                  // 下一段传输的源地址
+static u8 lcd_dma_srcinc;                                       // 源地址是否递增，纯色填充时源地址固定
+static u32 lcd_dma_remain;                                      // 还没有开始传输的点数
+static void (*lcd_dma_callback)(void);                          // 传输完成回调函数
+
+static u8 lcd_dma_keepwin;                                       // 传输完成后不恢复全屏窗口，后面还要接着写
+
+static u16 lcd_blit_x, lcd_blit_y;                              // 顺序写入区域的左上角坐标
+static u16 lcd_blit_width, lcd_blit_height;                     // 区域大小
+static u16 lcd_blit_vwidth, lcd_blit_vheight;                   // 在屏幕内的部分的大小
+static u16 lcd_blit_col, lcd_blit_row;                          // 下一个点在区域中的位置
+static u8 lcd_blit_bottomup;                                    // 是否从最下面一行开始写入
+
+#if LCD_USE_FB
+static u8 lcd_fb_enable = 0;                                    // 绘图是否画到帧缓冲中
+static LCD_RectTypeDef lcd_dirty[LCD_FB_DIRTY_MAX];             // 还没有写入GRAM的脏矩形列表
+static u8 lcd_dirty_num = 0;                                    // 脏矩形个数
+
+/* 帧缓冲，按行存放，每行lcddev.width个点 */
+#define LCD_FB ((u16 *)LCD_FB_ADDR)
+
+/**
+ * @Description 计算矩形面积
+ * @param r     矩形
+ * @return u32  点数
+ */
+static u32 Lcd_RectArea(const LCD_RectTypeDef *r)
+{
+        return (u32)(r->ex - r->sx + 1) * (r->ey - r->sy + 1);
+}
+
+/**
+ * @Description 把矩形a扩大到同时包含矩形b
+ * @param a,b   矩形
+ */
+static void Lcd_RectUnion(LCD_RectTypeDef *a, const LCD_RectTypeDef *b)
+{
+        if(b->sx < a->sx) a->sx = b->sx;
+        if(b->sy < a->sy) a->sy = b->sy;
+        if(b->ex > a->ex) a->ex = b->ex;
+        if(b->ey > a->ey) a->ey = b->ey;
+}
+
+/**
+ * @Description 把一个区域加入脏矩形列表
+ * @param sx,sy 区域左上角坐标
+ * @param ex,ey 区域右下角坐标
+ * @notice      与已有矩形相交或相邻时合并，列表满时与合并后面积增加最少的矩形合并，
+ *              合并出的矩形会再和其他矩形比较，保证列表中的矩形互不相交
+ */
+static void Lcd_FbMark(u16 sx, u16 sy, u16 ex, u16 ey)
+{
+        LCD_RectTypeDef r, u;
+        u32 cost, best;
+        u8 i, j, merged;
+
+        r.sx = sx;
+        r.sy = sy;
+        r.ex = ex;
+        r.ey = ey;
+
+        do
+        {
+                merged = 0;
+
+                /* 找出相交或相邻的矩形 */
+                for(i = 0; i < lcd_dirty_num; i++)
+                {
+                        if(r.sx <= lcd_dirty[i].ex + 1 && lcd_dirty[i].sx <= r.ex + 1 &&
+                           r.sy <= lcd_dirty[i].ey + 1 && lcd_dirty[i].sy <= r.ey + 1)
+                        {
+                                break;
+                        }
+                }
+
+                /* 列表已满，找出合并后多出面积最少的矩形 */
+                if(i == lcd_dirty_num && lcd_dirty_num == LCD_FB_DIRTY_MAX)
+                {
+                        best = 0xFFFFFFFF;
+                        for(j = 0; j < lcd_dirty_num; j++)
+                        {
+                                u = r;
+                                Lcd_RectUnion(&u, &lcd_dirty[j]);
+                                cost = Lcd_RectArea(&u) - Lcd_RectArea(&lcd_dirty[j]) - Lcd_RectArea(&r);
+                                if(cost < best)
+                                {
+                                        best = cost;
+                                        i = j;
+                                }
+                        }
+                }
+
+                /* 合并后从列表中删除，合并出的矩形重新检查 */
+                if(i < lcd_dirty_num)
+                {
+                        Lcd_RectUnion(&r, &lcd_dirty[i]);
+                        lcd_dirty[i] = lcd_dirty[--lcd_dirty_num];
+                        merged = 1;
+                }
+        } while(merged);
+
+        lcd_dirty[lcd_dirty_num++] = r;
+}
+
+/**
+ * @Description 在帧缓冲中画点
+ * @param x,y   点的坐标
+ * @param color 点的颜色
+ */
+static void Lcd_FbDrawPoint(u16 x, u16 y, u16 color)
+{
+        /* 超出屏幕的点直接丢弃，避免写到帧缓冲以外 */
+        if(x >= lcddev.width || y >= lcddev.height)
+        {
+                return;
+        }
+
+        LCD_FB[(u32)y * lcddev.width + x] = color;
+        Lcd_FbMark(x, y, x, y);
+}
+
+/**
+ * @Description 在帧缓冲中填充区域，超出屏幕的部分不填充
+ * @param sx,sy 区域左上角坐标
+ * @param ex,ey 区域右下角坐标
+ * @param color 颜色块(按行存放)或单个颜色
+ * @param inc   1:color为颜色块 0:color为单个颜色
+ */
+static void Lcd_FbFill(u16 sx, u16 sy, u16 ex, u16 ey, const u16 *color, u8 inc)
+{
+        u16 *dst;
+        u16 i, j;
+        u16 stride = ex - sx + 1;
+
+        if(sx > ex || sy > ey || sx >= lcddev.width || sy >= lcddev.height)
+        {
+                return;
+        }
+        if(ex >= lcddev.width)
+        {
+                ex = lcddev.width - 1;
+        }
+        if(ey >= lcddev.height)
+        {
+                ey = lcddev.height - 1;
+        }
+
+        dst = LCD_FB + (u32)sy * lcddev.width + sx;
+        for(i = sy; i <= ey; i++)
+        {
+                for(j = 0; j <= ex - sx; j++)
+                {
+                        dst[j] = inc ? color[j] : *color;
+                }
+                dst += lcddev.width;
+                if(inc)
+                {
+                        color += stride;
+                }
+        }
+
+        Lcd_FbMark(sx, sy, ex, ey);
+}
+#endif /* LCD_USE_FB */
+
 /**
  * @Description 向LCD写命令
  * @param cmd   命令值
@@ -15,7 +188,7 @@ LCD_InfoTypeDef lcddev;                                         // 储存LCD重
 void Lcd_WriteCmd(vu16 cmd)
 {
         cmd = cmd;
-        LCD->LCD_REG = cmd;
+        LCD_WR_REG(cmd);
 }
 
 /**
@@ -25,7 +198,7 @@ void Lcd_WriteCmd(vu16 cmd)
 void Lcd_WriteData(vu16 data)
 {
         data = data;
-        LCD->LCD_RAM = data;
+        LCD_WR_DATA(data);
 }
 
 /**
@@ -35,7 +208,7 @@ void Lcd_WriteData(vu16 data)
 u16 Lcd_ReadData(void)
 {
         vu16 data;
-        data = LCD->LCD_RAM;
+        data = LCD_RD_DATA();
         return data;
 }
 
@@ -46,8 +219,8 @@ u16 Lcd_ReadData(void)
  */
 void Lcd_WriteReg(u16 cmd, u16 data)
 {
-        LCD->LCD_REG = cmd;
-        LCD->LCD_RAM = data;
+        LCD_WR_REG(cmd);
+        LCD_WR_DATA(data);
 }
 
 /**
@@ -67,7 +240,7 @@ u16 Lcd_ReadReg(u16 reg)
  */
 void Lcd_WriteRamPrepare(void)
 {
-        LCD->LCD_REG = lcddev.wramcmd;
+        LCD_WR_REG(lcddev.wramcmd);
 }
 
 /**
@@ -76,7 +249,7 @@ void Lcd_WriteRamPrepare(void)
  */
 void Lcd_WriteRam(u16 color)
 {
-        LCD->LCD_RAM = color;
+        LCD_WR_DATA(color);
 }
 
 /**
@@ -95,6 +268,39 @@ void Lcd_DisplayOff(void)
         Lcd_WriteCmd(0X2800);
 }
 
+/**
+ * @Description 设置垂直滚动区域，区域上面和下面的行固定不动
+ * @param top   滚动区域第一行在GRAM中的行号
+ * @param height 滚动区域的行数，top+height不能超过LCD_SCROLL_LINES
+ * @notice      NT35510沿GRAM的行方向滚动，只有竖屏时才是屏幕上的上下滚动
+ */
+void Lcd_ScrollArea(u16 top, u16 height)
+{
+        u16 bottom = LCD_SCROLL_LINES - top - height;
+
+        /* DMA正在写GRAM时不能插入命令 */
+        Lcd_DmaWait();
+
+        Lcd_WriteReg(0X3300, top >> 8);
+        Lcd_WriteReg(0X3301, top & 0xFF);
+        Lcd_WriteReg(0X3302, height >> 8);
+        Lcd_WriteReg(0X3303, height & 0xFF);
+        Lcd_WriteReg(0X3304, bottom >> 8);
+        Lcd_WriteReg(0X3305, bottom & 0xFF);
+}
+
+/**
+ * @Description 设置滚动区域顶部显示的GRAM行号，只改变显示的映射，不搬运GRAM中的数据
+ * @param line  GRAM行号，在Lcd_ScrollArea()设置的区域内，等于top时不滚动
+ */
+void Lcd_ScrollStart(u16 line)
+{
+        Lcd_DmaWait();
+
+        Lcd_WriteReg(0X3700, line >> 8);
+        Lcd_WriteReg(0X3701, line & 0xFF);
+}
+
 /**
  * @Description 简单的延时函数，延时i
  * @notice 当mdk -O1时间优化时需要设置
@@ -117,6 +323,14 @@ u16 Lcd_ReadPoint(u16 x, u16 y)
         u16 g = 0;
         u16 b = 0;
 
+#if LCD_USE_FB
+        /* 帧缓冲中的内容就是屏幕最终的内容，不需要读GRAM */
+        if(lcd_fb_enable)
+        {
+                return (x < lcddev.width && y < lcddev.height) ? LCD_FB[(u32)y * lcddev.width + x] : 0;
+        }
+#endif
+
         /* 判断有没有超出屏幕范围，如果超出屏幕范围，则函数直接返回 */
         if(x >= lcddev.width || y >= lcddev.height)
         {
@@ -161,6 +375,9 @@ u16 Lcd_ReadPoint(u16 x, u16 y)
  */
 void Lcd_SetCursor(u16 x, u16 y)
 {
+        /* 等待DMA传输完成，否则会打断正在写入的GRAM */
+        Lcd_DmaWait();
+
         /* 设置光标x坐标 */
         Lcd_WriteCmd(lcddev.setxcmd);
         Lcd_WriteData(x >> 8);
@@ -276,9 +493,17 @@ void Lcd_ScanDir(u8 dir)
  */
 void Lcd_DrawPoint(u16 x, u16 y)
 {
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbDrawPoint(x, y, POINT_COLOR);
+                return;
+        }
+#endif
+
         Lcd_SetCursor(x, y);
         Lcd_WriteRamPrepare();
-        LCD->LCD_RAM = POINT_COLOR;
+        LCD_WR_DATA(POINT_COLOR);
 }
 
 /**
@@ -288,6 +513,16 @@ void Lcd_DrawPoint(u16 x, u16 y)
  */
 void Lcd_FastDrawPoint(u16 x, u16 y, u16 color)
 {
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbDrawPoint(x, y, color);
+                return;
+        }
+#endif
+
+        Lcd_DmaWait();
+
         /* 设置光标x坐标 */
         Lcd_WriteCmd(lcddev.setxcmd);
         Lcd_WriteData(x >> 8);
@@ -300,8 +535,8 @@ void Lcd_FastDrawPoint(u16 x, u16 y, u16 color)
         Lcd_WriteCmd(lcddev.setycmd + 1);
         Lcd_WriteData(y & 0xFF);
 
-        LCD->LCD_REG = lcddev.wramcmd;
-        LCD->LCD_RAM = color;
+        LCD_WR_REG(lcddev.wramcmd);
+        LCD_WR_DATA(color);
 }
 
 /**
@@ -351,6 +586,8 @@ void Lcd_SetWindow(u16 sx, u16 sy, u16 width, u16 height)
         ex = sx + width - 1;
         ey = sy + height - 1;
 
+        Lcd_DmaWait();
+
         Lcd_WriteCmd(lcddev.setxcmd);
         Lcd_WriteData(sx >> 8);
         Lcd_WriteCmd(lcddev.setxcmd + 1);
@@ -376,23 +613,8 @@ void Lcd_SetWindow(u16 sx, u16 sy, u16 width, u16 height)
  */
 void Lcd_ClearScreen(u16 color)
 {
-        /* for循环要使用的变量 */
-        u32 index = 0;
-
-        /* 得到总点数 */
-        u32 total = lcddev.width * lcddev.height;
-
-        /* 设置光标位置从 坐标(0,0) 处开始绘点 */
-        Lcd_SetCursor(0, 0);
-
-        /* 开始写入GRAM */
-        Lcd_WriteRamPrepare();
-
-        /* 开始清屏，绘制所有的点的颜色 */
-        for(index = 0; index < total; index++)
-        {
-                LCD->LCD_RAM = color;
-        }
+        Lcd_DmaFill(0, 0, lcddev.width - 1, lcddev.height - 1, color, NULL);
+        Lcd_DmaWait();
 }
 
 /**
@@ -403,22 +625,62 @@ void Lcd_ClearScreen(u16 color)
  */
 void Lcd_Fill(u16 sx, u16 sy, u16 ex, u16 ey, u16 color)
 {
-        /* 循环变量i, j */
-        u16 i, j;
+        Lcd_DmaFill(sx, sy, ex, ey, color, NULL);
+        Lcd_DmaWait();
+}
 
-        /* 计算一行点的个数 */
-        u16 xlen = ex - sx + 1;
+/**
+ * @Description 用CPU填充一个矩形，整个矩形只设置一次窗口，超出屏幕的部分不填充
+ * @param x,y           矩形左上角坐标
+ * @param width,height  矩形宽度和高度
+ * @param color         要填充的颜色
+ * @notice              只有一行时不改变窗口，设置光标后连续写入即可，
+ *                      适合绘图函数输出的短线段，大面积填充使用Lcd_Fill()
+ */
+void Lcd_FillRect(u16 x, u16 y, u16 width, u16 height, u16 color)
+{
+        u32 n;
 
-        /* 因为默认的扫描方向 L2R_U2D，因此可以设置一次绘制一行 */
-        for(i = sy; i <= ey; i++)
+        if(width == 0 || height == 0 || x >= lcddev.width || y >= lcddev.height)
         {
-                /* 设置光标位置(一行的起始位置，指定哪一列) */
-                Lcd_SetCursor(sx, i);
-                Lcd_WriteRamPrepare();
+                return;
+        }
+        if(width > lcddev.width - x)
+        {
+                width = lcddev.width - x;
+        }
+        if(height > lcddev.height - y)
+        {
+                height = lcddev.height - y;
+        }
+
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbFill(x, y, x + width - 1, y + height - 1, &color, 0);
+                return;
+        }
+#endif
+
+        if(height == 1)
+        {
+                Lcd_SetCursor(x, y);
+        }
+        else
+        {
+                Lcd_SetWindow(x, y, width, height);
+        }
+        Lcd_WriteRamPrepare();
+
+        for(n = (u32)width * height; n; n--)
+        {
+                LCD_WR_DATA(color);
+        }
 
-                /* 绘制一行的点 */
-                for(j = 0; j < xlen; j++)
-                        LCD->LCD_RAM = color;
+        /* 恢复全屏窗口 */
+        if(height != 1)
+        {
+                Lcd_SetWindow(0, 0, lcddev.width, lcddev.height);
         }
 }
 
@@ -430,74 +692,437 @@ void Lcd_Fill(u16 sx, u16 sy, u16 ex, u16 ey, u16 color)
  */
 void Lcd_ColorFill(u16 sx, u16 sy, u16 ex, u16 ey, u16 *color)
 {
-        u16 i, j;
-        u16 width = ex - sx + 1;
-        u16 height = ey - sy + 1;
-        for(i = 0; i < height; i++)
+        Lcd_DmaColorFill(sx, sy, ex, ey, color, NULL);
+        Lcd_DmaWait();
+}
+
+/**
+ * @Description 启动DMA传输下一段数据，一段最多LCD_DMA_MAX个点
+ * @notice      存储器到存储器模式下外设地址为源地址，存储器地址为目标地址(LCD_RAM)
+ */
+static void Lcd_DmaNext(void)
+{
+        DMA_InitTypeDef DMA_InitStructure;
+        u32 count;
+
+        count = (lcd_dma_remain > LCD_DMA_MAX) ? LCD_DMA_MAX : lcd_dma_remain;
+
+        DMA_InitStructure.DMA_Channel = LCD_DMA_CHANNEL;
+        DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)lcd_dma_src;                   // 源地址
+        DMA_InitStructure.DMA_Memory0BaseAddr = (u32)&LCD->LCD_RAM;                     // 目标地址固定为LCD数据地址
+        DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToMemory;
+        DMA_InitStructure.DMA_BufferSize = count;
+        DMA_InitStructure.DMA_PeripheralInc = lcd_dma_srcinc ? DMA_PeripheralInc_Enable : DMA_PeripheralInc_Disable;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+        DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+        DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+        DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+        DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Enable;                           // 存储器到存储器模式不能使用直接模式
+        DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_Full;
+        DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+        DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+        DMA_Init(LCD_DMA_STREAM, &DMA_InitStructure);
+
+        if(lcd_dma_srcinc)
         {
-                Lcd_SetCursor(sx, sy + i);
-                Lcd_WriteRamPrepare();
-                for(j = 0; j < width; j++)
-                        LCD->LCD_RAM = color[i * width + j];
+                lcd_dma_src += count;
         }
+        lcd_dma_remain -= count;
+
+        DMA_ITConfig(LCD_DMA_STREAM, DMA_IT_TC, ENABLE);
+        DMA_Cmd(LCD_DMA_STREAM, ENABLE);
 }
 
 /**
- * @Description 根据起始坐标绘制一条线段
- * @param x1,y1 起点坐标
- * @param x2,y2 终点坐标
+ * @Description 设置一次窗口，然后用DMA把整个区域写入GRAM
+ * @param sx,sy    区域左上角坐标
+ * @param ex,ey    区域右下角坐标
+ * @param src      源数据地址
+ * @param srcinc   源地址是否递增
+ * @param callback 传输完成回调函数，在DMA中断中调用，不需要时为NULL
  */
-void Lcd_DrawLine(u16 x1, u16 y1, u16 x2, u16 y2)
+static void Lcd_DmaStart(u16 sx, u16 sy, u16 ex, u16 ey, const u16 *src, u8 srcinc, void (*callback)(void))
 {
-        u16 t;
-        int xerr = 0;
-        int yerr = 0;
-        int delta_x;
-        int delta_y;
-        int distance;
-        int incx, incy, uRow, uCol;
-        delta_x = x2 - x1;
-        delta_y = y2 - y1;
-        uRow = x1;
-        uCol = y1;
-        if(delta_x > 0)
-                incx = 1;
-        else if(delta_x == 0)
-                incx = 0;
-        else
+        /* 窗口内写GRAM时LCD会自动换行，不需要每行重新设置光标 */
+        Lcd_SetWindow(sx, sy, ex - sx + 1, ey - sy + 1);
+        Lcd_WriteRamPrepare();
+
+        lcd_dma_src = src;
+        lcd_dma_srcinc = srcinc;
+        lcd_dma_remain = (u32)(ex - sx + 1) * (ey - sy + 1);
+        lcd_dma_callback = callback;
+        lcd_dma_keepwin = 0;
+        lcd_dma_busy = 1;
+
+#if LCD_BUS_STAT
+        lcd_bus_stat.wdata += lcd_dma_remain;
+#endif
+
+        Lcd_DmaNext();
+}
+
+/**
+ * @Description 用DMA在指定区域内填充单个颜色，函数启动传输后立即返回
+ * @param sx,sy    将要被填充的矩形左上角坐标
+ * @param ex,ey    将要被填充的矩形右下角坐标
+ * @param color    要填充的颜色
+ * @param callback 填充完成回调函数，在DMA中断中调用，不需要时为NULL
+ */
+void Lcd_DmaFill(u16 sx, u16 sy, u16 ex, u16 ey, u16 color, void (*callback)(void))
+{
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbFill(sx, sy, ex, ey, &color, 0);
+                if(callback)
+                {
+                        callback();
+                }
+                return;
+        }
+#endif
+
+        /* 上一次传输可能还在使用lcd_dma_color */
+        Lcd_DmaWait();
+
+        lcd_dma_color = color;
+        Lcd_DmaStart(sx, sy, ex, ey, &lcd_dma_color, 0, callback);
+}
+
+/**
+ * @Description 用DMA在指定区域内填充指定颜色块，函数启动传输后立即返回
+ * @param sx,sy    将要被填充的矩形左上角坐标
+ * @param ex,ey    将要被填充的矩形右下角坐标
+ * @param color    颜色块，按行存放，传输完成前不能修改
+ * @param callback 填充完成回调函数，在DMA中断中调用，不需要时为NULL
+ * @notice         颜色块不能放在CCM RAM(0x10000000)中，DMA访问不到
+ */
+void Lcd_DmaColorFill(u16 sx, u16 sy, u16 ex, u16 ey, const u16 *color, void (*callback)(void))
+{
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbFill(sx, sy, ex, ey, color, 1);
+                if(callback)
+                {
+                        callback();
+                }
+                return;
+        }
+#endif
+
+        Lcd_DmaStart(sx, sy, ex, ey, color, 1, callback);
+}
+
+/**
+ * @Description 查询DMA是否正在向GRAM传输数据
+ * @return u8   1:正在传输 0:空闲
+ */
+u8 Lcd_DmaBusy(void)
+{
+        return lcd_dma_busy;
+}
+
+/**
+ * @Description 等待DMA传输完成
+ * @notice      不能在优先级高于LCD DMA中断的中断中调用，否则会一直等待
+ */
+void Lcd_DmaWait(void)
+{
+        while(lcd_dma_busy)
+        {
+        }
+}
+
+#if LCD_USE_FB
+/**
+ * @Description 开启或关闭帧缓冲
+ * @param NewState ENABLE:之后的绘图都画到帧缓冲中，调用Lcd_Flush()后才显示 DISABLE:直接画到GRAM
+ * @notice         开启前要先调用Sram_Init()初始化外部SRAM，开启后要先清屏，让帧缓冲与屏幕内容一致，
+ *                 切换显示方向后帧缓冲的行宽改变，也要重新清屏
+ */
+void Lcd_FrameBufferCmd(FunctionalState NewState)
+{
+        if(NewState != DISABLE)
         {
-                incx = -1;
-                delta_x = -delta_x;
+                lcd_dirty_num = 0;
+                lcd_fb_enable = 1;
         }
-        if(delta_y > 0)
-                incy = 1;
-        else if(delta_y == 0)
-                incy = 0;
         else
         {
-                incy = -1;
-                delta_y = -delta_y;
+                /* 关闭前把还没有显示的内容写入GRAM */
+                Lcd_Flush();
+                lcd_fb_enable = 0;
+        }
+}
+
+/**
+ * @Description 把帧缓冲中的脏矩形写入GRAM
+ * @notice      整行宽的矩形在帧缓冲中是连续的，用DMA一次传完，其他矩形设置一次窗口后逐行写入
+ */
+void Lcd_Flush(void)
+{
+        LCD_RectTypeDef *r;
+        const u16 *src;
+        u16 i, j, width;
+
+        while(lcd_dirty_num)
+        {
+                r = &lcd_dirty[--lcd_dirty_num];
+                width = r->ex - r->sx + 1;
+                src = LCD_FB + (u32)r->sy * lcddev.width + r->sx;
+
+                if(width == lcddev.width)
+                {
+                        Lcd_DmaStart(r->sx, r->sy, r->ex, r->ey, src, 1, NULL);
+                }
+                else
+                {
+                        Lcd_SetWindow(r->sx, r->sy, width, r->ey - r->sy + 1);
+                        Lcd_WriteRamPrepare();
+                        for(i = r->sy; i <= r->ey; i++)
+                        {
+                                for(j = 0; j < width; j++)
+                                {
+                                        LCD_WR_DATA(src[j]);
+                                }
+                                src += lcddev.width;
+                        }
+                        Lcd_SetWindow(0, 0, lcddev.width, lcddev.height);
+                }
+        }
+
+        /* 传输完成前不能修改帧缓冲 */
+        Lcd_DmaWait();
+}
+#endif /* LCD_USE_FB */
+
+/**
+ * @Description LCD DMA中断服务函数，一段传输完成后接着传输下一段，全部完成后恢复全屏窗口并调用回调函数
+ */
+void LCD_DMA_IRQHandler(void)
+{
+        if(DMA_GetITStatus(LCD_DMA_STREAM, LCD_DMA_IT_TC) != RESET)
+        {
+                DMA_ClearITPendingBit(LCD_DMA_STREAM, LCD_DMA_IT_TC);
+
+                if(lcd_dma_remain)
+                {
+                        Lcd_DmaNext();
+                }
+                else
+                {
+                        /* 先清除忙标志，Lcd_SetWindow()内部会等待DMA完成 */
+                        lcd_dma_busy = 0;
+                        if(!lcd_dma_keepwin)
+                        {
+                                Lcd_SetWindow(0, 0, lcddev.width, lcddev.height);
+                        }
+
+                        if(lcd_dma_callback)
+                        {
+                                lcd_dma_callback();
+                        }
+                }
+        }
+}
+
+/**
+ * @Description 开始按顺序写入一块区域，用于边读边显示的图片，不需要整帧的缓冲区
+ * @param x,y   左上角坐标
+ * @param width,height 区域大小，超出屏幕的部分在写入时丢弃
+ * @param bottomup 1:按从下到上的顺序写入各行(BMP图片) 0:从上到下
+ * @notice      整块区域只设置一次窗口，从下到上时临时把扫描方向改为L2R_D2U，
+ *              在Lcd_BlitEnd()之前不能调用其他绘图函数
+ */
+void Lcd_BlitBegin(u16 x, u16 y, u16 width, u16 height, u8 bottomup)
+{
+        lcd_blit_x = x;
+        lcd_blit_y = y;
+        lcd_blit_width = width;
+        lcd_blit_height = height;
+        lcd_blit_col = 0;
+        lcd_blit_row = 0;
+        lcd_blit_bottomup = bottomup;
+
+        if(width == 0 || height == 0 || x >= lcddev.width || y >= lcddev.height)
+        {
+                lcd_blit_vwidth = 0;
+                return;
+        }
+
+        lcd_blit_vwidth = (width > lcddev.width - x) ? lcddev.width - x : width;
+        lcd_blit_vheight = (height > lcddev.height - y) ? lcddev.height - y : height;
+
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                Lcd_FbMark(x, y, x + lcd_blit_vwidth - 1, y + lcd_blit_vheight - 1);
+                return;
+        }
+#endif
+
+        if(bottomup)
+        {
+                /* 行地址反向后，窗口的纵坐标也要按反向后的坐标计算 */
+                Lcd_DmaWait();
+                Lcd_ScanDir(L2R_D2U);
+                Lcd_SetWindow(x, lcddev.height - y - lcd_blit_vheight, lcd_blit_vwidth, lcd_blit_vheight);
         }
-        if(delta_x > delta_y)
-                distance = delta_x;
         else
-                distance = delta_y;
-        for(t = 0; t <= distance + 1; t++)
         {
-                Lcd_DrawPoint(uRow, uCol);
-                xerr += delta_x;
-                yerr += delta_y;
-                if(xerr > distance)
+                Lcd_SetWindow(x, y, lcd_blit_vwidth, lcd_blit_vheight);
+        }
+        Lcd_WriteRamPrepare();
+}
+
+/**
+ * @Description 接着上一次的位置写入n个点，超过一行时自动换到下一行
+ * @param color 颜色值
+ * @param n     点数
+ * @param inc   1:color为n个点的颜色 0:n个点都是*color
+ * @notice      整块区域都在屏幕内时窗口内的点是连续的，超过LCD_BLIT_DMA_MIN的纯色段
+ *              交给DMA填充，不等待完成就返回，CPU可以同时准备后面的数据
+ */
+void Lcd_BlitPixels(const u16 *color, u32 n, u8 inc)
+{
+        u32 count;
+        u16 i, end;
+        u8 visible;
+
+        if(lcd_blit_vwidth == 0)
+        {
+                return;
+        }
+
+#if LCD_USE_FB
+        if(!lcd_fb_enable)
+#endif
+        {
+                if(!inc && n >= LCD_BLIT_DMA_MIN &&
+                   lcd_blit_vwidth == lcd_blit_width && lcd_blit_vheight == lcd_blit_height)
+                {
+                        /* 上一次传输可能还在使用lcd_dma_color */
+                        Lcd_DmaWait();
+
+                        lcd_dma_color = *color;
+                        lcd_dma_src = &lcd_dma_color;
+                        lcd_dma_srcinc = 0;
+                        lcd_dma_remain = n;
+                        lcd_dma_callback = NULL;
+                        lcd_dma_keepwin = 1;
+                        lcd_dma_busy = 1;
+#if LCD_BUS_STAT
+                        lcd_bus_stat.wdata += n;
+#endif
+                        Lcd_DmaNext();
+
+                        count = lcd_blit_col + n;
+                        lcd_blit_row += count / lcd_blit_width;
+                        lcd_blit_col = count % lcd_blit_width;
+                        return;
+                }
+        }
+
+        while(n)
+        {
+                count = lcd_blit_width - lcd_blit_col;
+                if(count > n)
+                {
+                        count = n;
+                }
+
+                /* 从下到上写入时，最先收到的是超出屏幕底部的行 */
+                if(lcd_blit_bottomup)
                 {
-                        xerr -= distance;
-                        uRow += incx;
+                        visible = (lcd_blit_row >= lcd_blit_height - lcd_blit_vheight);
                 }
-                if(yerr > distance)
+                else
+                {
+                        visible = (lcd_blit_row < lcd_blit_vheight);
+                }
+
+                if(visible && lcd_blit_col < lcd_blit_vwidth)
+                {
+                        end = (lcd_blit_col + count > lcd_blit_vwidth) ? lcd_blit_vwidth : lcd_blit_col + count;
+
+#if LCD_USE_FB
+                        if(lcd_fb_enable)
+                        {
+                                u16 *dst = LCD_FB + (u32)(lcd_blit_y + (lcd_blit_bottomup ? lcd_blit_height - 1 - lcd_blit_row : lcd_blit_row)) * lcddev.width + lcd_blit_x;
+                                for(i = lcd_blit_col; i < end; i++)
+                                {
+                                        dst[i] = inc ? color[i - lcd_blit_col] : *color;
+                                }
+                        }
+                        else
+#endif
+                        {
+                                Lcd_DmaWait();
+                                for(i = lcd_blit_col; i < end; i++)
+                                {
+                                        LCD_WR_DATA(inc ? color[i - lcd_blit_col] : *color);
+                                }
+                        }
+                }
+
+                if(inc)
                 {
-                        yerr -= distance;
-                        uCol += incy;
+                        color += count;
                 }
+                n -= count;
+                lcd_blit_col += count;
+                if(lcd_blit_col == lcd_blit_width)
+                {
+                        lcd_blit_col = 0;
+                        lcd_blit_row++;
+                }
+        }
+}
+
+/**
+ * @Description 写入一行，行内的点从左到右排列
+ * @param color 一行的颜色值，个数为Lcd_BlitBegin()中的width
+ */
+void Lcd_BlitRow(const u16 *color)
+{
+        Lcd_BlitPixels(color, lcd_blit_width, 1);
+}
+
+/**
+ * @Description 结束写入，等待DMA完成后恢复扫描方向和全屏窗口
+ */
+void Lcd_BlitEnd(void)
+{
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                return;
+        }
+#endif
+
+        if(lcd_blit_vwidth == 0)
+        {
+                return;
         }
+
+        Lcd_DmaWait();
+        if(lcd_blit_bottomup)
+        {
+                Lcd_ScanDir(DFT_SCAN_DIR);
+        }
+        Lcd_SetWindow(0, 0, lcddev.width, lcddev.height);
+}
+
+/**
+ * @Description 根据起始坐标绘制一条线段
+ * @param x1,y1 起点坐标
+ * @param x2,y2 终点坐标
+ */
+void Lcd_DrawLine(u16 x1, u16 y1, u16 x2, u16 y2)
+{
+        Draw_Line(x1, y1, x2, y2);
 }
 
 /**
@@ -506,10 +1131,7 @@ void Lcd_DrawLine(u16 x1, u16 y1, u16 x2, u16 y2)
  */
 void Lcd_DrawRectangle(u16 x1, u16 y1, u16 x2, u16 y2)
 {
-        Lcd_DrawLine(x1, y1, x2, y1);
-        Lcd_DrawLine(x1, y1, x1, y2);
-        Lcd_DrawLine(x1, y2, x2, y2);
-        Lcd_DrawLine(x2, y1, x2, y2);
+        Draw_Rect(x1, y1, x2, y2);
 }
 
 /**
@@ -519,33 +1141,33 @@ void Lcd_DrawRectangle(u16 x1, u16 y1, u16 x2, u16 y2)
  */
 void Lcd_DrawCircle(u16 x0, u16 y0, u8 r)
 {
-        int a, b;
-        int di;
-        a = 0;
-        b = r;
-        di = 3 - (r << 1);
-        while(a <= b)
+        Draw_Circle(x0, y0, r);
+}
+
+/**
+ * @Description 取得字符对应的字模
+ * @param num   字符在字库中的偏移(字符 - ' ')
+ * @param size  字体大小 12/16/24
+ * @return u8*  字模首地址，没有对应的字库时返回NULL
+ */
+static const u8 *Lcd_GetGlyph(u8 num, u8 size)
+{
+        /* 字库只有95个字符 */
+        if(num >= 95)
         {
-                Lcd_DrawPoint(x0 + a, y0 - b);
-                Lcd_DrawPoint(x0 + b, y0 - a);
-                Lcd_DrawPoint(x0 + b, y0 + a);
-                Lcd_DrawPoint(x0 + a, y0 + b);
-                Lcd_DrawPoint(x0 - a, y0 + b);
-                Lcd_DrawPoint(x0 - b, y0 + a);
-                Lcd_DrawPoint(x0 - a, y0 - b);
-                Lcd_DrawPoint(x0 - b, y0 - a);
-                a++;
-
-                /* 使用Bresenham算法画圆 */
-                if(di < 0)
-                {
-                        di += 4 * a + 6;
-                }
-                else
-                {
-                        di += 10 + 4 * (a - b);
-                        b--;
-                }
+                return NULL;
+        }
+
+        switch(size)
+        {
+        case 12:/* 调用1206字体 */
+                return asc2_1206[num];
+        case 16:/* 调用1608字体 */
+                return asc2_1608[num];
+        case 24:/* 调用2412字体 */
+                return asc2_2412[num];
+        default:/* 没有字库 */
+                return NULL;
         }
 }
 
@@ -558,121 +1180,220 @@ void Lcd_DrawCircle(u16 x0, u16 y0, u8 r)
  */
 void Lcd_ShowChar(u16 x, u16 y, u8 num, u8 size, u8 mode)
 {
-        u8 temp, t1, t;
+        /* 得到偏移后的值(ASCII字库是从空格开始取模，所以-' '就是对应字符的字库) */
+        const u8 *glyph = Lcd_GetGlyph(num - ' ', size);
 
-        u16 y0 = y;
+        /* 没有字库则直接返回 */
+        if(glyph == NULL)
+        {
+                return;
+        }
 
-        /* 得到当前设置的字体一个字符对应点阵集所占的字节数 */
-        u8 csize = (size / 8 + ((size % 8) ? 1 : 0)) * (size / 2);
+        /* ASCII字符宽度为字高的一半 */
+        Lcd_ShowGlyph(x, y, glyph, size / 2, size, mode);
+}
 
-        /* 得到偏移后的值(ASCII字库是从空格开始取模，所以-' '就是对应字符的字库) */
-        num = num - ' ';
+/**
+ * @Description 在指定位置显示一个点阵字模
+ * @param x,y   起始坐标
+ * @param glyph 字模，逐列式，每列从上到下高位在前，与ASCII字库取模方式相同
+ * @param w,h   字模的宽度和高度
+ * @param mode  叠加方式(DRAW_DIRECT)，非叠加方式(DRAW_REDRAW)
+ * @notice      非叠加方式下开一个与字符大小相同的窗口，按行连续写入整个字符的点，
+ *              叠加方式下按行找出连续的笔画段，每段只设置一次光标，
+ *              不再对每个点单独设置光标(24号字从约3500次总线写入降到约320次)
+ */
+void Lcd_ShowGlyph(u16 x, u16 y, const u8 *glyph, u8 w, u8 h, u8 mode)
+{
+        const u8 *p;
+        u8 mask;
+#if LCD_USE_FB
+        u16 *dst;
+#endif
+        u16 row, col, start;
+        u16 width, height;
+
+        /* 得到字模一列所占的字节数 */
+        u8 csize = h / 8 + ((h % 8) ? 1 : 0);
+
+        /* 超出了屏幕范围，则直接返回 */
+        if(x >= lcddev.width || y >= lcddev.height)
+        {
+                return;
+        }
 
-        for(t = 0; t < csize; t++)
+        /* 字符超出屏幕的部分不显示 */
+        width = w;
+        height = h;
+        if(x + width > lcddev.width)
         {
-                switch(size)
-                {
-                case 12:/* 调用1206字体 */
-                        temp = asc2_1206[num][t];
-                        break;
-                case 16:/* 调用1608字体 */
-                        temp = asc2_1608[num][t];
-                        break;
-                case 24:/* 调用2412字体 */
-                        temp = asc2_2412[num][t];
-                        break;
-                default:/* 没有字库，则直接返回 */
-                        return;
-                }
+                width = lcddev.width - x;
+        }
+        if(y + height > lcddev.height)
+        {
+                height = lcddev.height - y;
+        }
 
-                for(t1 = 0; t1 < 8; t1++)
+#if LCD_USE_FB
+        if(lcd_fb_enable)
+        {
+                /* 画到帧缓冲中，叠加方式下只写有笔画的点 */
+                for(row = 0; row < height; row++)
                 {
-                        if(temp & 0x80)
+                        p = glyph + row / 8;
+                        mask = 0x80 >> (row % 8);
+                        dst = LCD_FB + (u32)(y + row) * lcddev.width + x;
+                        for(col = 0; col < width; col++)
                         {
-                                /* 判断最高位是是否为1，如果为1，则画点 */
-                                Lcd_FastDrawPoint(x, y, POINT_COLOR);
-                        }
-                        else if(mode == DRAW_REDRAW)
-                        {
-                                /* 最高位为0，且为非叠加方式的情况下，重新绘制空的点 */
-                                Lcd_FastDrawPoint(x, y, BACK_COLOR);
+                                if(p[col * csize] & mask)
+                                {
+                                        dst[col] = POINT_COLOR;
+                                }
+                                else if(mode == DRAW_REDRAW)
+                                {
+                                        dst[col] = BACK_COLOR;
+                                }
                         }
+                }
+                Lcd_FbMark(x, y, x + width - 1, y + height - 1);
+                return;
+        }
+#endif
 
-                        /* 将下一位移至最高位，循环操作 */
-                        temp <<= 1;
-
-                        y++;
+        if(mode == DRAW_REDRAW)
+        {
+                /* 窗口设置为字符大小，写GRAM时LCD会在窗口内自动换行 */
+                Lcd_SetWindow(x, y, width, height);
+                Lcd_WriteRamPrepare();
 
-                        /* 如果超出了屏幕范围，则直接返回 */
-                        if(y >= lcddev.height)
+                /* 扫描方向为L2R_U2D，按行展开逐列式的字模 */
+                for(row = 0; row < height; row++)
+                {
+                        p = glyph + row / 8;
+                        mask = 0x80 >> (row % 8);
+                        for(col = 0; col < width; col++)
                         {
-                                return;
+                                LCD_WR_DATA((p[col * csize] & mask) ? POINT_COLOR : BACK_COLOR);
                         }
+                }
 
-                        /* 如果绘完了当前这一列 */
-                        if((y - y0) == size)
+                /* 恢复全屏窗口，其他绘图函数只设置光标 */
+                Lcd_SetWindow(0, 0, lcddev.width, lcddev.height);
+        }
+        else
+        {
+                for(row = 0; row < height; row++)
+                {
+                        p = glyph + row / 8;
+                        mask = 0x80 >> (row % 8);
+                        col = 0;
+                        while(col < width)
                         {
-                                /* y坐标回归初始值，开始绘制下一列 */
-                                y = y0;
+                                /* 跳过空的点 */
+                                while(col < width && !(p[col * csize] & mask))
+                                {
+                                        col++;
+                                }
 
-                                /* 横坐标加1，即下一列 */
-                                x++;
+                                /* 找出一段连续的笔画 */
+                                start = col;
+                                while(col < width && (p[col * csize] & mask))
+                                {
+                                        col++;
+                                }
 
-                                /* 如果超出了屏幕范围，则直接返回 */
-                                if(x >= lcddev.width)
+                                /* 整段只设置一次光标 */
+                                if(col > start)
                                 {
-                                        return;
+                                        Lcd_SetCursor(x + start, y + row);
+                                        Lcd_WriteRamPrepare();
+                                        for(; start < col; start++)
+                                        {
+                                                LCD_WR_DATA(POINT_COLOR);
+                                        }
                                 }
-                                break;
                         }
                 }
         }
 }
 
 /**
- * @Description 显示数字
- * @param x,y   起始坐标
- * @param num   数值(0~4294967295)
- * @param size  字体大小 12/16/24
- * @return u8   占用屏幕的长度
- * @notice      高位为0表示8进制数
+ * @Description 整数除以10，用乘以倒数代替除法，对所有32位无符号数结果都是精确的
+ * @param n     被除数
+ * @param rem   返回余数
+ * @return u32  商
  */
-u8 Lcd_ShowInt(u16 x, u16 y, u32 num, u8 size)
+static u32 Lcd_Div10(u32 n, u32 *rem)
 {
-        /* for循环使用到的变量 */
-        int i = 0;
-
-        /* 记录整数位数的变量，位数 = t+1 */
-        u8 t = 0;
+        u32 q = (u32)(((uint64_t)n * 0xCCCCCCCDu) >> 35);
+        *rem = n - q * 10;
+        return q;
+}
 
-        /* 记录整数每一位数值的数组 */
-        u8 temp[10];
+/**
+ * @Description 把无符号整数或定点小数转换为字符串，不使用除法
+ * @param buf   字符串缓冲区，至少12字节
+ * @param num   数值，定点小数时为放大10^frac倍后的值
+ * @param frac  小数位数，0表示整数，最大LCD_FRAC_MAX
+ * @return u8   字符串长度，frac超过LCD_FRAC_MAX时返回0并得到空字符串
+ * @notice      例如num=1234，frac=3时得到"1.234"，num=5，frac=2时得到"0.05"
+ */
+u8 Lcd_FormatNum(char *buf, u32 num, u8 frac)
+{
+        char temp[LCD_FRAC_MAX + 1];
+        u32 rem;
+        u8 n = 0, len = 0;
 
-        /* 从高位向低位依次取出每一位的数值，存入temp数组中 */
-        for(i = 9; i >= 0; i--)
+        /* 最多frac + 1位数字，超过LCD_FRAC_MAX时会超出temp和buf */
+        if(frac > LCD_FRAC_MAX)
         {
-                temp[i] = num / Lcd_Pow(10, i);
-                num = num % Lcd_Pow(10, i);
+                buf[0] = '\0';
+                return 0;
         }
 
-        /* 从最高位开始，找出第一个不为0的数值 */
-        for(i = 9; i >= 0; i--)
+        /* 从低位向高位依次取出每一位，至少保留小数位数加一位整数 */
+        do
         {
-                if(temp[i] != 0 || i == 0)
-                        break;
+                num = Lcd_Div10(num, &rem);
+                temp[n++] = '0' + rem;
+        } while(num != 0 || n <= frac);
+
+        while(n > 0)
+        {
+                if(n == frac)
+                {
+                        buf[len++] = '.';
+                }
+                buf[len++] = temp[--n];
         }
+        buf[len] = '\0';
+
+        return len;
+}
+
+/**
+ * @Description 显示数字
+ * @param x,y   起始坐标
+ * @param num   数值(0~4294967295)
+ * @param size  字体大小 12/16/24
+ * @return u8   占用屏幕的长度
+ */
+u8 Lcd_ShowInt(u16 x, u16 y, u32 num, u8 size)
+{
+        char temp[12];
+        u8 i, length;
 
-        /* 记录位数 */
-        t = i;
+        /* 转换为字符串，不再对每一位做除法和取余 */
+        length = Lcd_FormatNum(temp, num, 0);
 
         /* 在屏幕上绘制 */
-        for(i = 0; i <= t; i++)
+        for(i = 0; i < length; i++)
         {
-                Lcd_ShowChar(x + size / 2 * i, y, temp[t - i] + 48, size, DRAW_DIRECT);
+                Lcd_ShowChar(x + size / 2 * i, y, temp[i], size, DRAW_DIRECT);
         }
 
         /* 返回位数 */
-        return (t + 1);
+        return length;
 }
 
 /**
@@ -724,31 +1445,42 @@ u8 Lcd_ShowFloat(u16 x, u16 y, float num, u8 size)
 }
 
 /**
- * @Description 显示字符串
+ * @Description 显示字符串，支持中文，多字节字符的编码由Text_SetEncoding()设置(默认UTF-8)
  * @param x,y           起点坐标
  * @param width,height  区域大小
- * @param size          字体大小
+ * @param size          字体大小，ASCII字符12/16/24，中文字符12/16/24/32
  * @param *p            字符串起始地址
  */
 void Lcd_ShowString(u16 x, u16 y, u16 width, u16 height, u8 size, char *p)
 {
-        u8 x0 = x;
+        const u8 *s = (const u8 *)p;
+        u16 x0 = x;
+        u16 w;
+        u32 code;
+
         width += x;
         height += y;
 
-        /* 判断是不是非法字符! */
-        while((*p <= '~') && (*p >= ' '))
+        while(1)
         {
-                if(x >= width)
+                code = Text_Decode(&s);
+
+                /* 字符串结束或者非法字符! */
+                if(code < ' ' || code == 0x7F)
+                {
+                        break;
+                }
+
+                /* 中文字符宽度为size，ASCII字符为size/2，放不下时换行 */
+                w = (code < 0x80) ? size / 2 : size;
+                if(x + w > width)
                 {
                         x = x0;
                         y += size;
                 }
                 if(y >= height)
                         break;
-                Lcd_ShowChar(x, y, *p, size, 0);
-                x += size / 2;
-                p++;
+                x += Text_ShowChar(x, y, code, size, DRAW_REDRAW);
         }
 }
 
@@ -760,8 +1492,7 @@ void Lcd_ShowString(u16 x, u16 y, u16 width, u16 height, u8 size, char *p)
  */
 void Lcd_CenterShowString(u16 y, char *p, u8 size)
 {
-        u8 length = strlen(p);
-        u32 temp = length * size / 2;
+        u16 temp = Text_StringWidth(p, size);
         Lcd_ShowString((lcddev.width - temp) / 2, y, temp, size, size, p);
 }
 
@@ -780,6 +1511,42 @@ u32 Lcd_Pow(u8 m, u8 n)
         return result;
 }
 
+#if LCD_BUS_STAT
+/**
+ * @Description 清零总线访问统计，在要统计的绘图函数前调用，之后读取lcd_bus_stat
+ */
+void Lcd_BusStatReset(void)
+{
+        lcd_bus_stat.cmd = 0;
+        lcd_bus_stat.wdata = 0;
+        lcd_bus_stat.rdata = 0;
+}
+#endif
+
+/**
+ * @Description 初始化LCD使用的DMA，由Lcd_Init()调用
+ */
+void Lcd_DmaInit(void)
+{
+        NVIC_InitTypeDef NVIC_InitStructure;
+
+        /* 第一步：使能DMA时钟 */
+        RCC_AHB1PeriphClockCmd(LCD_DMA_CLK, ENABLE);
+
+        /* 第二步：复位数据流，等待数据流可以配置 */
+        DMA_DeInit(LCD_DMA_STREAM);
+        while(DMA_GetCmdStatus(LCD_DMA_STREAM) != DISABLE)
+        {
+        }
+
+        /* 第三步：配置DMA中断 */
+        NVIC_InitStructure.NVIC_IRQChannel = LCD_DMA_IRQ;
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+}
+
 /**
  * @Description 初始化LCD，仅仅支持4.3寸屏，驱动IC为NT55330
  */
@@ -1390,6 +2157,9 @@ void Lcd_Init(void)
         delay_us(120);
         Lcd_WriteCmd(0x2900);
 
+        /* 初始化向GRAM搬运数据的DMA */
+        Lcd_DmaInit();
+
         /* 默认开机为竖屏 */
         Lcd_DisplayDir(0);
 
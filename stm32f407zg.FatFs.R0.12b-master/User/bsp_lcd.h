@@ -4,6 +4,7 @@
 #include "stm32f4xx.h"
 #include "bsp_usart.h"
 #include "bsp_systick.h"
+#include "bsp_sram.h"
 #include "stdlib.h"
 #include "string.h"
 
@@ -31,6 +32,12 @@ extern LCD_InfoTypeDef lcddev;
 #define DRAW_DIRECT 1
 #define DRAW_REDRAW 0
 
+/* NT35510垂直滚动方向的GRAM总行数，即竖屏时的高度 */
+#define LCD_SCROLL_LINES        800
+
+/* Lcd_FormatNum()最多的小数位数，u32最多10位数字，加上小数点和结束符共12字节 */
+#define LCD_FRAC_MAX            9
+
 /* LCD的画笔颜色和背景色 */
 extern u16 POINT_COLOR;
 extern u16 BACK_COLOR;
@@ -49,6 +56,57 @@ typedef struct
 #define LCD_BASE ((u32)(0x6C000000 | 0x0000007E))
 #define LCD ((LCD_TypeDef*) LCD_BASE)
 
+/* 总线访问统计，1:统计写命令、写数据、读数据的次数，用于比较各绘图函数的总线开销 0:不统计 */
+#define LCD_BUS_STAT            0
+
+#if LCD_BUS_STAT
+typedef struct
+{
+        u32 cmd;                                        // 写命令次数
+        u32 wdata;                                      // 写数据次数，包括DMA写入的点数
+        u32 rdata;                                      // 读数据次数
+} LCD_BusStatTypeDef;
+
+extern LCD_BusStatTypeDef lcd_bus_stat;
+#endif /* LCD_BUS_STAT */
+
+/* 总线访问宏，上位机模拟器Tools/lcdsim.c在编译时预先定义这三个宏，把总线访问交给NT35510模型 */
+#ifndef LCD_WR_REG
+#if LCD_BUS_STAT
+#define LCD_WR_REG(reg)         (lcd_bus_stat.cmd++, LCD->LCD_REG = (reg))
+#define LCD_WR_DATA(data)       (lcd_bus_stat.wdata++, LCD->LCD_RAM = (data))
+#define LCD_RD_DATA()           (lcd_bus_stat.rdata++, LCD->LCD_RAM)
+#else
+#define LCD_WR_REG(reg)         (LCD->LCD_REG = (reg))
+#define LCD_WR_DATA(data)       (LCD->LCD_RAM = (data))
+#define LCD_RD_DATA()           (LCD->LCD_RAM)
+#endif /* LCD_BUS_STAT */
+#endif /* LCD_WR_REG */
+
+/* 向GRAM搬运数据的DMA，只有DMA2支持存储器到存储器传输，这里使用DMA2数据流6通道0 */
+#define LCD_DMA_CLK             RCC_AHB1Periph_DMA2
+#define LCD_DMA_STREAM          DMA2_Stream6
+#define LCD_DMA_CHANNEL         DMA_Channel_0
+#define LCD_DMA_IT_TC           DMA_IT_TCIF6
+#define LCD_DMA_IRQ             DMA2_Stream6_IRQn
+#define LCD_DMA_IRQHandler      DMA2_Stream6_IRQHandler
+#define LCD_DMA_MAX             0xFFFF                  // DMA一次最多传输的点数
+#define LCD_BLIT_DMA_MIN        256                     // Lcd_BlitPixels()中超过该点数的纯色段使用DMA填充
+
+/* 帧缓冲，绘图函数先画到外部SRAM中的影子缓冲，再由Lcd_Flush()只把变化的区域写入GRAM，避免闪烁 */
+#define LCD_USE_FB              1                       // 1:编译帧缓冲功能 0:不编译
+#define LCD_FB_ADDR             Bank1_SRAM3_ADDR        // 帧缓冲地址，RGB565格式，800*480*2=768000字节
+#define LCD_FB_DIRTY_MAX        8                       // 最多记录的脏矩形个数，超出后合并为一个
+
+/* 矩形区域 */
+typedef struct
+{
+        u16 sx;
+        u16 sy;
+        u16 ex;
+        u16 ey;
+} LCD_RectTypeDef;
+
 /* 扫描方向定义 L:Left R:Right U:Up D:Down 2:to */
 #define L2R_U2D  0
 #define L2R_D2U  1
@@ -79,6 +137,8 @@ void Lcd_WriteRamPrepare(void);
 void Lcd_WriteRam(u16 color);
 void Lcd_DisplayOn(void);
 void Lcd_DisplayOff(void);
+void Lcd_ScrollArea(u16 top, u16 height);
+void Lcd_ScrollStart(u16 line);
 void Lcd_Delay(u8 i);
 
 u16 Lcd_ReadPoint(u16 x, u16 y);
@@ -91,11 +151,22 @@ void Lcd_SetWindow(u16 sx, u16 sy, u16 width, u16 height);
 
 void Lcd_ClearScreen(u16 color);
 void Lcd_Fill(u16 sx, u16 sy, u16 ex, u16 ey, u16 color);
+void Lcd_FillRect(u16 x, u16 y, u16 width, u16 height, u16 color);
 void Lcd_ColorFill(u16 sx, u16 sy, u16 ex, u16 ey, u16 *color);
+void Lcd_DmaFill(u16 sx, u16 sy, u16 ex, u16 ey, u16 color, void (*callback)(void));
+void Lcd_DmaColorFill(u16 sx, u16 sy, u16 ex, u16 ey, const u16 *color, void (*callback)(void));
+void Lcd_BlitBegin(u16 x, u16 y, u16 width, u16 height, u8 bottomup);
+void Lcd_BlitPixels(const u16 *color, u32 n, u8 inc);
+void Lcd_BlitRow(const u16 *color);
+void Lcd_BlitEnd(void);
+u8 Lcd_DmaBusy(void);
+void Lcd_DmaWait(void);
 void Lcd_DrawLine(u16 x1, u16 y1, u16 x2, u16 y2);
 void Lcd_DrawRectangle(u16 x1, u16 y1, u16 x2, u16 y2);
 void Lcd_DrawCircle(u16 x0, u16 y0, u8 r);
 void Lcd_ShowChar(u16 x, u16 y, u8 num, u8 size, u8 mode);
+void Lcd_ShowGlyph(u16 x, u16 y, const u8 *glyph, u8 w, u8 h, u8 mode);
+u8 Lcd_FormatNum(char *buf, u32 num, u8 frac);
 u8 Lcd_ShowInt(u16 x, u16 y, u32 num, u8 size);
 u8 Lcd_ShowFloat(u16 x, u16 y, float num, u8 size);
 void Lcd_ShowString(u16 x, u16 y, u16 width, u16 height, u8 size, char *p);
@@ -103,6 +174,14 @@ void Lcd_CenterShowString(u16 y, char *p, u8 size);
 
 u32 Lcd_Pow(u8 m, u8 n);
 
+void Lcd_FrameBufferCmd(FunctionalState NewState);
+void Lcd_Flush(void);
+
+#if LCD_BUS_STAT
+void Lcd_BusStatReset(void);
+#endif
+
+void Lcd_DmaInit(void);
 void Lcd_Init(void);
 
 #endif /* __BSP_LCD_H */
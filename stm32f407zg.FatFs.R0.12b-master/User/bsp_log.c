@@ -0,0 +1,155 @@
+#include "bsp_log.h"
+#include "bsp_telemetry.h"
+#if LOG_BENCH
+#include "bsp_systick.h"
+#endif
+
+/* 驱动版本号：bsp_log v1.0 */
+
+/* 一条日志编码后的最大长度：记录头、格式地址、时间戳、参数、校验，COBS和前后的0x00 */
+#define LOG_FRAME_MAX           (TELEMETRY_HEAD_SIZE + (2 + LOG_ARG_MAX) * 4 + 4 + 3)
+
+u32 log_lost = 0;                                               // 缓冲满时丢弃的日志条数
+
+static u32 log_buf[LOG_BUF_WORDS];                              // 日志环形缓冲
+static volatile u32 log_head = 0;                               // 写入位置，关中断后修改
+static volatile u32 log_tail = 0;                               // 读出位置，只在Log_Drain()中修改
+
+/**
+ * @Description 初始化日志，开启DWT周期计数器作为时间戳，发送前还要调用Telemetry_Init()
+ */
+void Log_Init(void)
+{
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @Description 写入一条日志，由LOG0()~LOG4()调用，可以在中断中调用
+ * @param fmt   格式字符串常量
+ * @param n     参数个数
+ * @param a0~a3 参数，多余的忽略
+ * @notice      只关中断写入几个字，缓冲满时丢弃这一条并计入log_lost
+ */
+void Log_Write(const char *fmt, u32 n, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+        u32 primask = __get_PRIMASK();
+        u32 head;
+
+        __disable_irq();
+
+        head = log_head;
+        if(LOG_BUF_WORDS - (head - log_tail) < n + 2)
+        {
+                log_lost++;
+                __set_PRIMASK(primask);
+                return;
+        }
+
+        log_buf[head++ & (LOG_BUF_WORDS - 1)] = (u32)fmt | (n << 28);
+        log_buf[head++ & (LOG_BUF_WORDS - 1)] = DWT->CYCCNT;
+        if(n > 0)
+        {
+                log_buf[head++ & (LOG_BUF_WORDS - 1)] = a0;
+        }
+        if(n > 1)
+        {
+                log_buf[head++ & (LOG_BUF_WORDS - 1)] = a1;
+        }
+        if(n > 2)
+        {
+                log_buf[head++ & (LOG_BUF_WORDS - 1)] = a2;
+        }
+        if(n > 3)
+        {
+                log_buf[head++ & (LOG_BUF_WORDS - 1)] = a3;
+        }
+        log_head = head;
+
+        __set_PRIMASK(primask);
+}
+
+/**
+ * @Description 把float参数按位转换为u32，上位机按float还原
+ * @param f     参数
+ * @return u32  float的二进制表示
+ */
+u32 Log_Float(float f)
+{
+        union
+        {
+                float f;
+                u32 u;
+        } v;
+
+        v.f = f;
+        return v.u;
+}
+
+/**
+ * @Description 把缓冲中的日志作为遥测记录发送，在主循环中调用
+ * @notice      串口发送缓冲放不下一条日志时停止，剩下的下次再发送，不会阻塞主循环；
+ *              有日志因缓冲满被丢弃时，发送一条记录丢弃条数的日志
+ */
+void Log_Drain(void)
+{
+        u32 entry[2 + LOG_ARG_MAX];
+        u32 tail, n, i, lost;
+
+        while(log_tail != log_head && Usart_TxFree() >= LOG_FRAME_MAX)
+        {
+                tail = log_tail;
+                n = log_buf[tail & (LOG_BUF_WORDS - 1)] >> 28;
+                for(i = 0; i < n + 2; i++)
+                {
+                        entry[i] = log_buf[(tail + i) & (LOG_BUF_WORDS - 1)];
+                }
+                log_tail = tail + n + 2;
+
+                /* 参数个数由记录长度得到，上位机只需要地址 */
+                entry[0] &= 0x0FFFFFFF;
+                Telemetry_Send(LOG_TELEMETRY_ID, TELEMETRY_U32, entry, n + 2);
+        }
+
+        if(log_lost != 0)
+        {
+                __disable_irq();
+                lost = log_lost;
+                log_lost = 0;
+                __enable_irq();
+
+                LOG1("bsp_log:\t%u entries lost\r\n", lost);
+        }
+}
+
+#if LOG_BENCH
+/**
+ * @Description 比较一条带两个整数参数的日志，延迟格式化与printf的耗时，结果通过串口输出
+ * @notice      使用DWT周期计数器计时，各调用16次取平均，printf只写入串口发送缓冲，不包括发送时间
+ */
+void Log_Benchmark(void)
+{
+        u32 start, deferred, direct;
+        u8 i;
+
+        Log_Init();
+
+        start = DWT->CYCCNT;
+        for(i = 0; i < 16; i++)
+        {
+                Log_Write("bsp_log:\tbench i = %d, tick = %u\r\n", 2, i, start, 0, 0);
+        }
+        deferred = (DWT->CYCCNT - start) / 16;
+
+        Usart_Flush();
+        start = DWT->CYCCNT;
+        for(i = 0; i < 16; i++)
+        {
+                printf("bsp_log:\tbench i = %d, tick = %u\r\n", i, start);
+        }
+        direct = (DWT->CYCCNT - start) / 16;
+
+        Usart_Flush();
+        printf("bsp_log:\tcycles per call: deferred = %u, printf = %u\r\n", deferred, direct);
+}
+#endif /* LOG_BENCH */
@@ -0,0 +1,50 @@
+#ifndef __BSP_LOG_H
+#define __BSP_LOG_H
+
+#include "stm32f4xx.h"
+#include "bsp_usart.h"
+
+/**
+ * 延迟格式化的日志，LOGx()只把格式字符串的地址、时间戳和参数原样写入RAM中的环形缓冲，
+ * 主循环调用Log_Drain()时作为遥测记录(见bsp_telemetry.h)发送，由上位机工具Tools/logdec.c
+ * 从编译生成的axf文件中取出格式字符串后再格式化，开发板上不做任何字符串处理，可以在中断中使用。
+ *      一条日志                (格式字符串地址 | 参数个数 << 28)(u32) DWT时间戳(u32) 参数(u32)...
+ * 格式字符串必须是Flash中的字符串常量(地址小于0x10000000)，整数和指针参数直接传入，
+ * float参数用LOG_FLOAT()转换，%s只能用于Flash中的字符串常量
+ */
+#define LOG_DEFERRED            1                       // 1:延迟格式化 0:LOGx()直接调用printf
+#define LOG_BUF_WORDS           512                     // 环形缓冲的字数，必须为2的幂
+#define LOG_ARG_MAX             4                       // 一条日志最多的参数个数
+#define LOG_TELEMETRY_ID        0xFF                    // 日志使用的遥测记录编号
+
+/* 1:编译耗时测试函数Log_Benchmark() 0:不编译 */
+#define LOG_BENCH               0
+
+#if LOG_DEFERRED
+#define LOG0(fmt)               Log_Write(fmt, 0, 0, 0, 0, 0)
+#define LOG1(fmt, a)            Log_Write(fmt, 1, (u32)(a), 0, 0, 0)
+#define LOG2(fmt, a, b)         Log_Write(fmt, 2, (u32)(a), (u32)(b), 0, 0)
+#define LOG3(fmt, a, b, c)      Log_Write(fmt, 3, (u32)(a), (u32)(b), (u32)(c), 0)
+#define LOG4(fmt, a, b, c, d)   Log_Write(fmt, 4, (u32)(a), (u32)(b), (u32)(c), (u32)(d))
+#define LOG_FLOAT(x)            Log_Float(x)
+#else
+#define LOG0(fmt)               printf(fmt)
+#define LOG1(fmt, a)            printf(fmt, a)
+#define LOG2(fmt, a, b)         printf(fmt, a, b)
+#define LOG3(fmt, a, b, c)      printf(fmt, a, b, c)
+#define LOG4(fmt, a, b, c, d)   printf(fmt, a, b, c, d)
+#define LOG_FLOAT(x)            ((double)(x))
+#endif /* LOG_DEFERRED */
+
+extern u32 log_lost;                                    // 缓冲满时丢弃的日志条数
+
+void Log_Init(void);
+void Log_Write(const char *fmt, u32 n, u32 a0, u32 a1, u32 a2, u32 a3);
+u32 Log_Float(float f);
+void Log_Drain(void);
+
+#if LOG_BENCH
+void Log_Benchmark(void);
+#endif
+
+#endif /* __BSP_LOG_H */
@@ -0,0 +1,15 @@
+#ifndef __BSP_SRAM_H
+#define __BSP_SRAM_H
+
+#include "stm32f4xx.h"
+
+/* 使用NOR/SRAM的 Bank1.sector3,地址位HADDR[27,26]=10 */
+/* 对IS61LV25616/IS62WV25616,地址线范围为A0~A17 */
+/* 对IS61LV51216/IS62WV51216,地址线范围为A0~A18 */
+#define Bank1_SRAM3_ADDR ((u32)(0x68000000))
+
+void Sram_Init(void);
+void Sram_WriteBuffer(u8* pBuffer, u32 WriteAddr, u32 num);
+void Sram_ReadBuffer(u8* pBuffer, u32 ReadAddr, u32 num);
+
+#endif /* __BSP_SRAM_H */
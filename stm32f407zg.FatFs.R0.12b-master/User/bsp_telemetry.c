@@ -0,0 +1,179 @@
+#include "bsp_telemetry.h"
+#include "string.h"
+#if TELEMETRY_BENCH
+#include "bsp_systick.h"
+#endif
+
+/* 驱动版本号：bsp_telemetry v1.0 */
+
+/* 记录加校验的最大长度，以及COBS编码后加前后两个0x00的最大长度 */
+#define TELEMETRY_RECORD_MAX    (TELEMETRY_HEAD_SIZE + TELEMETRY_VALUE_MAX + 4)
+#define TELEMETRY_FRAME_MAX     (TELEMETRY_RECORD_MAX + TELEMETRY_RECORD_MAX / 254 + 3)
+
+/* 各数值类型的字节数，下标为数值类型 */
+static const u8 telemetry_size[] = { 0, 1, 2, 2, 4, 4, 4 };
+
+static u16 telemetry_seq = 0;                                           // 下一条记录的序号
+static u32 telemetry_record[(TELEMETRY_RECORD_MAX + 3) / 4];            // 记录，CRC单元按字计算，要求按字对齐
+static u8 telemetry_frame[TELEMETRY_FRAME_MAX];                         // 编码后的帧
+
+/**
+ * @Description 初始化遥测输出，使能CRC单元的时钟，串口由Usart_Init()初始化
+ */
+void Telemetry_Init(void)
+{
+        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_CRC, ENABLE);
+        telemetry_seq = 0;
+}
+
+/**
+ * @Description 用CRC单元计算一段数据的CRC-32，每个字只需要一次写入
+ * @param data  数据，按字对齐
+ * @param words 字数
+ * @return u32  CRC-32
+ */
+static u32 Telemetry_Crc(const u32 *data, u16 words)
+{
+        CRC->CR = CRC_CR_RESET;
+        while(words--)
+        {
+                CRC->DR = *data++;
+        }
+
+        return CRC->DR;
+}
+
+/**
+ * @Description COBS编码，编码后的数据中没有0x00，最后加上0x00作为帧结束符
+ * @param src   原始数据
+ * @param len   原始数据字节数
+ * @param dst   编码后的数据，大小至少为len+len/254+2
+ * @return u16  编码后的字节数，包括结束符
+ */
+u16 Telemetry_Encode(const u8 *src, u16 len, u8 *dst)
+{
+        u8 *start = dst;
+        u8 *code = dst++;                               // 当前这一段的长度字节
+        u8 n = 1;
+
+        while(len--)
+        {
+                if(*src == 0)
+                {
+                        *code = n;
+                        code = dst++;
+                        n = 1;
+                }
+                else
+                {
+                        *dst++ = *src;
+                        n++;
+
+                        /* 一段最多254个非零字节 */
+                        if(n == 0xFF)
+                        {
+                                *code = n;
+                                code = dst++;
+                                n = 1;
+                        }
+                }
+                src++;
+        }
+        *code = n;
+        *dst++ = 0;
+
+        return dst - start;
+}
+
+/**
+ * @Description 发送一条遥测记录，编码后写入串口发送缓冲立即返回
+ * @param id    记录编号，由应用定义，上位机原样输出到CSV的第一列
+ * @param format 数值类型 TELEMETRY_U8 ~ TELEMETRY_FLOAT
+ * @param value 数值数组
+ * @param count 数值个数，总字节数不超过TELEMETRY_VALUE_MAX
+ * @return u8   0:成功 1:参数错误
+ * @notice      使用静态缓冲区，不能同时在中断和主循环中调用；
+ *              发送缓冲满时按USART_TX_POLICY处理，序号照常增加，上位机会统计为丢失
+ */
+u8 Telemetry_Send(u8 id, u8 format, const void *value, u8 count)
+{
+        u8 *record = (u8 *)telemetry_record;
+        u16 len, n;
+        u32 crc;
+
+        if(format == 0 || format >= sizeof(telemetry_size) || (u16)count * telemetry_size[format] > TELEMETRY_VALUE_MAX)
+        {
+                return 1;
+        }
+
+        record[0] = id;
+        record[1] = format;
+        record[2] = telemetry_seq & 0xFF;
+        record[3] = telemetry_seq >> 8;
+        len = TELEMETRY_HEAD_SIZE + count * telemetry_size[format];
+        memcpy(record + TELEMETRY_HEAD_SIZE, value, len - TELEMETRY_HEAD_SIZE);
+
+        /* 不足一个字的部分补0后计算校验，校验写在记录后面，覆盖补的0 */
+        memset(record + len, 0, 3);
+        crc = Telemetry_Crc(telemetry_record, (len + 3) / 4);
+        record[len++] = crc & 0xFF;
+        record[len++] = (crc >> 8) & 0xFF;
+        record[len++] = (crc >> 16) & 0xFF;
+        record[len++] = crc >> 24;
+
+        /* 帧前面也加一个0x00，前面有printf输出的文本时，文本单独成为一个错误的帧，不会连累这一帧 */
+        telemetry_frame[0] = 0;
+        n = Telemetry_Encode(record, len, telemetry_frame + 1) + 1;
+        Usart_Write(telemetry_frame, n);
+        telemetry_seq++;
+
+        return 0;
+}
+
+#if TELEMETRY_BENCH
+/**
+ * @Description 比较发送16个ADC采样值时，遥测记录与printf浮点数两种方式的耗时和字节数，结果通过串口输出
+ * @notice      使用DWT周期计数器计时，只统计格式化和写入发送缓冲的时间；
+ *              每秒采样数按串口每字节10位计算，测试时串口上会出现一帧二进制数据，上位机解码时会丢弃
+ */
+void Telemetry_Benchmark(void)
+{
+        u16 sample[16];
+        u32 start, bin_cycles, txt_cycles, bin_bytes, txt_bytes = 0;
+        u8 i;
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        for(i = 0; i < 16; i++)
+        {
+                sample[i] = (i * 257 + 123) & 0x0FFF;
+        }
+
+        /* 二进制记录 */
+        Usart_Flush();
+        start = DWT->CYCCNT;
+        Telemetry_Send(0, TELEMETRY_U16, sample, 16);
+        bin_cycles = DWT->CYCCNT - start;
+
+        /* 记录还在缓冲区中，重新编码一次得到帧的长度 */
+        bin_bytes = Telemetry_Encode((u8 *)telemetry_record, TELEMETRY_HEAD_SIZE + 16 * 2 + 4, telemetry_frame + 1) + 1;
+
+        /* 原来的方式：换算成电压后用printf输出 */
+        Usart_Flush();
+        printf("\r\n");
+        start = DWT->CYCCNT;
+        for(i = 0; i < 16; i++)
+        {
+                txt_bytes += printf("%.3f ", sample[i] * 3.3f / 4096);
+        }
+        txt_bytes += printf("\r\n");
+        txt_cycles = DWT->CYCCNT - start;
+
+        Usart_Flush();
+        printf("bsp_telemetry:\tbinary %u bytes, %u cycles per 16 samples\r\n", bin_bytes, bin_cycles);
+        printf("bsp_telemetry:\tprintf %u bytes, %u cycles per 16 samples\r\n", txt_bytes, txt_cycles);
+        printf("bsp_telemetry:\tsamples/s at 115200: binary %u, printf %u; at 921600: binary %u, printf %u\r\n",
+               11520 * 16 / bin_bytes, 11520 * 16 / txt_bytes, 92160 * 16 / bin_bytes, 92160 * 16 / txt_bytes);
+}
+#endif /* TELEMETRY_BENCH */
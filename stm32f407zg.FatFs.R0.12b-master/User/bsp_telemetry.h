@@ -0,0 +1,37 @@
+#ifndef __BSP_TELEMETRY_H
+#define __BSP_TELEMETRY_H
+
+#include "stm32f4xx.h"
+#include "bsp_usart.h"
+
+/**
+ * 二进制遥测数据，代替printf输出传感器数值，由上位机工具Tools/telrec.c解码为CSV(小端)：
+ *      记录                    id(u8) format(u8) seq(u16) 数值...
+ *      校验                    CRC-32(u32)，使用STM32的CRC单元计算(多项式0x04C11DB7，初值0xFFFFFFFF，
+ *                              不反转，不异或输出)，记录按u32小端分组，最后不足4字节的部分补0
+ *      帧                      记录和校验经COBS编码，前后各加一个0x00，传输中出错或混入文本时下一帧可以重新同步
+ * seq每发送一条记录加1，上位机据此统计丢失的记录数
+ */
+#define TELEMETRY_VALUE_MAX     64                      // 一条记录最多的数值字节数
+#define TELEMETRY_HEAD_SIZE     4                       // 记录头字节数
+
+/* 数值类型 */
+#define TELEMETRY_U8            1
+#define TELEMETRY_S16           2
+#define TELEMETRY_U16           3
+#define TELEMETRY_S32           4
+#define TELEMETRY_U32           5
+#define TELEMETRY_FLOAT         6
+
+/* 1:编译耗时测试函数Telemetry_Benchmark() 0:不编译 */
+#define TELEMETRY_BENCH         0
+
+void Telemetry_Init(void);
+u16 Telemetry_Encode(const u8 *src, u16 len, u8 *dst);
+u8 Telemetry_Send(u8 id, u8 format, const void *value, u8 count);
+
+#if TELEMETRY_BENCH
+void Telemetry_Benchmark(void);
+#endif
+
+#endif /* __BSP_TELEMETRY_H */
@@ -0,0 +1,449 @@
+#include "bsp_text.h"
+#include "ff.h"
+
+/* 驱动版本号：bsp_text v1.1 */
+
+/**
+ * 中文字模从SPI Flash中读取，一个24号字模72字节，读取一次约需要15us，
+ * 最近用过的字模保存在内存中的缓存里，界面刷新时重复出现的字不再访问Flash
+ */
+
+TEXT_CacheStatTypeDef text_cache_stat;                          // 字形缓存的统计信息
+
+static TEXT_HeaderTypeDef text_header;                          // 字库文件头，count为0表示没有字库
+static u8 text_encoding = TEXT_ENC_UTF8;                        // 多字节字符的编码
+
+static u32 text_cache_key[TEXT_CACHE_NUM];                      // (字号 << 24) | 字符编码，0表示空闲
+static u32 text_cache_used[TEXT_CACHE_NUM];                     // 最近一次使用的时间，越小越久没有使用
+static u32 text_cache_clock;                                    // 时间计数，每访问一次缓存加1
+static u8 text_cache_data[TEXT_CACHE_NUM][TEXT_GLYPH_MAX];      // 缓存的字模
+
+/**
+ * @Description 查找字号对应的字库
+ * @param size  字号
+ * @return      字库描述，没有该字号时返回NULL
+ */
+static const TEXT_FontTypeDef *Text_FindFont(u8 size)
+{
+        u8 i;
+
+        for(i = 0; i < text_header.count; i++)
+        {
+                if(text_header.font[i].size == size)
+                {
+                        return &text_header.font[i];
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * @Description 计算GBK字符在字库中的序号
+ * @param gbk   GBK编码，高字节0x81~0xFE，低字节0x40~0xFE(不含0x7F)
+ * @return u32  字模序号，编码非法时返回TEXT_GLYPH_NUM
+ */
+static u32 Text_GbkIndex(u32 gbk)
+{
+        u8 hi = gbk >> 8;
+        u8 lo = gbk & 0xFF;
+
+        if(gbk > 0xFFFF || hi < 0x81 || hi > 0xFE || lo < 0x40 || lo == 0x7F || lo > 0xFE)
+        {
+                return TEXT_GLYPH_NUM;
+        }
+
+        /* 每个区190个字符，低字节跳过0x7F */
+        return (hi - 0x81) * 190 + (lo - 0x40) - (lo > 0x7F ? 1 : 0);
+}
+
+/**
+ * @Description 通过Flash中的映射表把Unicode转换为GBK编码
+ * @param uni   Unicode码
+ * @return u32  GBK编码，没有对应的字符时返回0
+ */
+static u32 Text_UniToGbk(u32 uni)
+{
+        u16 gbk;
+
+        if(text_header.uni2gbk == 0 || uni > 0xFFFF)
+        {
+                return 0;
+        }
+
+        W25QXX_Read((u8 *)&gbk, W25QXX_FONT_ADDR + text_header.uni2gbk + uni * 2, 2);
+
+        return gbk;
+}
+
+/**
+ * @Description 取得字符的字模，先查缓存，没有命中时从Flash读入并替换最久没有使用的缓存项
+ * @param code  字符编码，由当前编码方式决定是Unicode还是GBK
+ * @param size  字号
+ * @return u8*  字模首地址，没有字库或者没有该字符时返回NULL
+ */
+static const u8 *Text_GetGlyph(u32 code, u8 size)
+{
+        const TEXT_FontTypeDef *font;
+        u32 key = ((u32)size << 24) | code;
+        u32 index;
+        u8 i, victim = 0;
+
+        for(i = 0; i < TEXT_CACHE_NUM; i++)
+        {
+                if(text_cache_key[i] == key)
+                {
+                        text_cache_used[i] = ++text_cache_clock;
+                        text_cache_stat.hit++;
+                        return text_cache_data[i];
+                }
+
+                /* 顺便找出最久没有使用的缓存项，空闲项的时间为0会被优先使用 */
+                if(text_cache_used[i] < text_cache_used[victim])
+                {
+                        victim = i;
+                }
+        }
+
+        text_cache_stat.miss++;
+
+        font = Text_FindFont(size);
+        if(font == NULL)
+        {
+                return NULL;
+        }
+
+        index = Text_GbkIndex(text_encoding == TEXT_ENC_UTF8 ? Text_UniToGbk(code) : code);
+        if(index >= TEXT_GLYPH_NUM)
+        {
+                return NULL;
+        }
+
+        W25QXX_Read(text_cache_data[victim], W25QXX_FONT_ADDR + font->offset + index * font->bytes, font->bytes);
+        text_cache_key[victim] = key;
+        text_cache_used[victim] = ++text_cache_clock;
+
+        return text_cache_data[victim];
+}
+
+/**
+ * @Description 初始化字库，读取并检查Flash中的字库文件头
+ * @return u8   0:成功 1:没有字库或者字库格式错误
+ */
+u8 Text_Init(void)
+{
+        u8 i;
+
+        W25QXX_Init();
+        W25QXX_Read((u8 *)&text_header, W25QXX_FONT_ADDR, sizeof(text_header));
+        Text_CacheFlush();
+
+        if(text_header.magic != TEXT_MAGIC || text_header.version != TEXT_VERSION ||
+           text_header.count > TEXT_FONT_MAX || text_header.total > W25QXX_FONT_SIZE)
+        {
+                text_header.count = 0;
+                text_header.uni2gbk = 0;
+                return 1;
+        }
+
+        for(i = 0; i < text_header.count; i++)
+        {
+                if(text_header.font[i].bytes > TEXT_GLYPH_MAX ||
+                   text_header.font[i].offset + (u32)TEXT_GLYPH_NUM * text_header.font[i].bytes > text_header.total)
+                {
+                        text_header.count = 0;
+                        text_header.uni2gbk = 0;
+                        return 1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * @Description 从文件系统中读取字库文件，写入Flash的字库区域
+ * @param path  字库文件路径，如"0:/GBK.FON"
+ * @return u8   0:成功 1:文件读取失败 2:字库格式错误 3:文件系统卷超出W25QXX_FATFS_SIZE，需要重新格式化
+ * @notice      文件头最后写入，中途掉电时字库区域不会被当成有效字库；
+ *              旧固件格式化的16MB卷与字库区域重叠，擦除前检查卷的大小，避免擦掉卷中的数据
+ */
+u8 Text_Update(const char *path)
+{
+        static FIL file;
+        static u8 head[256];
+        static u8 buf[256];
+        const TEXT_HeaderTypeDef *header = (const TEXT_HeaderTypeDef *)head;
+        FATFS *fs;
+        u32 address, block;
+        UINT br;
+        u8 res = 0;
+
+        if(f_open(&file, path, FA_READ) != FR_OK)
+        {
+                return 1;
+        }
+
+        /* 卷的数据区结束扇区必须在文件系统区域内 */
+        fs = file.obj.fs;
+        if(fs->database + (fs->n_fatent - 2) * fs->csize > W25QXX_FATFS_SIZE / 4096)
+        {
+                f_close(&file);
+                return 3;
+        }
+
+        /* 先读出第一页，检查文件头 */
+        if(f_read(&file, head, sizeof(head), &br) != FR_OK || br < sizeof(TEXT_HeaderTypeDef))
+        {
+                f_close(&file);
+                return 1;
+        }
+        if(header->magic != TEXT_MAGIC || header->version != TEXT_VERSION ||
+           header->total != f_size(&file) || header->total > W25QXX_FONT_SIZE)
+        {
+                f_close(&file);
+                return 2;
+        }
+
+        /* 按64KB块擦除字库占用的区域 */
+        for(block = 0; block * 65536 < header->total; block++)
+        {
+                W25QXX_EraseBlock(W25QXX_FONT_ADDR / 65536 + block);
+        }
+
+        /* 从第二页开始写入，最后再写入包含文件头的第一页 */
+        address = W25QXX_FONT_ADDR + sizeof(head);
+        while(1)
+        {
+                if(f_read(&file, buf, sizeof(buf), &br) != FR_OK)
+                {
+                        res = 1;
+                        break;
+                }
+                if(br == 0)
+                {
+                        break;
+                }
+                W25QXX_WriteNoCheck(buf, address, br);
+                address += br;
+        }
+
+        f_close(&file);
+
+        if(res == 0)
+        {
+                W25QXX_WriteNoCheck(head, W25QXX_FONT_ADDR, sizeof(head) < header->total ? sizeof(head) : header->total);
+                if(Text_Init() != 0)
+                {
+                        res = 2;
+                }
+        }
+
+        return res;
+}
+
+/**
+ * @Description 设置字符串中多字节字符的编码
+ * @param encoding TEXT_ENC_UTF8或TEXT_ENC_GBK
+ * @notice      缓存以字符编码为索引，切换编码时清空缓存
+ */
+void Text_SetEncoding(u8 encoding)
+{
+        if(encoding != text_encoding)
+        {
+                text_encoding = encoding;
+                Text_CacheFlush();
+        }
+}
+
+/**
+ * @Description 从字符串中取出一个字符
+ * @param s     字符串指针的地址，返回时指向下一个字符
+ * @return u32  ASCII字符直接返回，多字节字符按当前编码返回Unicode或GBK码，
+ *              编码错误时返回'?'，字符串结束时返回0
+ */
+u32 Text_Decode(const u8 **s)
+{
+        const u8 *p = *s;
+        u32 code = *p;
+        u8 i, len;
+
+        if(code == 0)
+        {
+                return 0;
+        }
+        p++;
+
+        if(code >= 0x80)
+        {
+                if(text_encoding == TEXT_ENC_GBK)
+                {
+                        /* GBK为双字节编码，低字节不能为0x7F和0xFF */
+                        if(code >= 0x81 && code <= 0xFE && *p >= 0x40 && *p != 0x7F && *p != 0xFF)
+                        {
+                                code = (code << 8) | *p++;
+                        }
+                        else
+                        {
+                                code = '?';
+                        }
+                }
+                else
+                {
+                        /* UTF-8由首字节得到长度，后续字节均为10xxxxxx */
+                        if(code >= 0xF0 && code <= 0xF4)
+                        {
+                                len = 3;
+                                code &= 0x07;
+                        }
+                        else if(code >= 0xE0 && code <= 0xEF)
+                        {
+                                len = 2;
+                                code &= 0x0F;
+                        }
+                        else if(code >= 0xC2 && code <= 0xDF)
+                        {
+                                len = 1;
+                                code &= 0x1F;
+                        }
+                        else
+                        {
+                                len = 0;
+                        }
+
+                        for(i = 0; i < len && (p[i] & 0xC0) == 0x80; i++)
+                        {
+                                code = (code << 6) | (p[i] & 0x3F);
+                        }
+
+                        if(len == 0 || i < len)
+                        {
+                                /* 非法首字节或者后续字节不完整，只跳过首字节 */
+                                code = '?';
+                        }
+                        else
+                        {
+                                p += len;
+                        }
+                }
+        }
+
+        *s = p;
+        return code;
+}
+
+/**
+ * @Description 在指定位置显示一个字符，ASCII字符使用内部字库，其他字符使用Flash中的GBK字库
+ * @param x,y   起始坐标
+ * @param code  Text_Decode()返回的字符编码
+ * @param size  字号 12/16/24/32，ASCII字符只支持12/16/24
+ * @param mode  叠加方式(DRAW_DIRECT)，非叠加方式(DRAW_REDRAW)
+ * @return u16  字符宽度，ASCII字符为size/2，其他字符为size
+ * @notice      字库中没有的字符在非叠加方式下显示为背景色
+ */
+u16 Text_ShowChar(u16 x, u16 y, u32 code, u8 size, u8 mode)
+{
+        const u8 *glyph;
+
+        if(code < 0x80)
+        {
+                Lcd_ShowChar(x, y, code, size, mode);
+                return size / 2;
+        }
+
+        glyph = Text_GetGlyph(code, size);
+        if(glyph != NULL)
+        {
+                Lcd_ShowGlyph(x, y, glyph, size, size, mode);
+        }
+        else if(mode == DRAW_REDRAW)
+        {
+                Lcd_FillRect(x, y, size, size, BACK_COLOR);
+        }
+
+        return size;
+}
+
+/**
+ * @Description 计算字符串显示的宽度
+ * @param *p    字符串起始地址
+ * @param size  字号
+ * @return u16  宽度
+ */
+u16 Text_StringWidth(const char *p, u8 size)
+{
+        const u8 *s = (const u8 *)p;
+        u32 code;
+        u16 width = 0;
+
+        while((code = Text_Decode(&s)) != 0)
+        {
+                width += (code < 0x80) ? size / 2 : size;
+        }
+
+        return width;
+}
+
+/**
+ * @Description 清空字形缓存
+ */
+void Text_CacheFlush(void)
+{
+        u8 i;
+
+        for(i = 0; i < TEXT_CACHE_NUM; i++)
+        {
+                text_cache_key[i] = 0;
+                text_cache_used[i] = 0;
+        }
+        text_cache_clock = 0;
+}
+
+#if TEXT_BENCH
+/**
+ * @Description 测试显示一个中文字符的耗时，分别统计缓存未命中(冷)和命中(热)的情况，结果通过串口输出
+ * @param size  字号
+ * @notice      使用DWT周期计数器计时，测试字符为GBK第一个汉字区(0xB0A1开始)的前TEXT_CACHE_NUM个字
+ */
+void Text_Benchmark(u8 size)
+{
+        u32 start, cold = 0, warm = 0;
+        u32 code;
+        u8 encoding = text_encoding;
+        u8 i;
+
+        if(Text_FindFont(size) == NULL)
+        {
+                printf("bsp_text:\tno %d font\r\n", size);
+                return;
+        }
+
+        /* 打开DWT周期计数器 */
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        /* 测试字符直接使用GBK编码 */
+        Text_SetEncoding(TEXT_ENC_GBK);
+        Text_CacheFlush();
+
+        /* 第一遍全部未命中，第二遍全部命中 */
+        for(i = 0; i < TEXT_CACHE_NUM; i++)
+        {
+                code = 0xB0A1 + i;
+                start = DWT->CYCCNT;
+                Text_ShowChar(0, 0, code, size, DRAW_REDRAW);
+                cold += DWT->CYCCNT - start;
+        }
+        for(i = 0; i < TEXT_CACHE_NUM; i++)
+        {
+                code = 0xB0A1 + i;
+                start = DWT->CYCCNT;
+                Text_ShowChar(0, 0, code, size, DRAW_REDRAW);
+                warm += DWT->CYCCNT - start;
+        }
+
+        Text_SetEncoding(encoding);
+
+        printf("bsp_text:\tsize %d, cold %u us/glyph, warm %u us/glyph\r\n", size,
+               cold / TEXT_CACHE_NUM / SYSTEM_CLOCK, warm / TEXT_CACHE_NUM / SYSTEM_CLOCK);
+}
+#endif /* TEXT_BENCH */
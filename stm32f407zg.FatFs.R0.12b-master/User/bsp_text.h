@@ -0,0 +1,72 @@
+#ifndef __BSP_TEXT_H
+#define __BSP_TEXT_H
+
+#include "stm32f4xx.h"
+#include "bsp_lcd.h"
+#include "bsp_w25qxx.h"
+
+/**
+ * GBK字库存放在W25Q128的保留区域(W25QXX_FONT_ADDR开始的6MB)，由上位机工具Tools/fontpack.c生成，
+ * 字库文件格式(小端)：
+ *      TEXT_HeaderTypeDef      文件头
+ *      字模数据                每种字号23940个字模，按GBK码顺序排列，取模方式与ASCII字库相同
+ *      Unicode->GBK映射表      65536个u16，下标为Unicode码，0表示没有对应的GBK字符
+ */
+#define TEXT_MAGIC              0x464B4247              // "GBKF"
+#define TEXT_VERSION            1
+#define TEXT_FONT_MAX           4                       // 最多支持的字号数 12/16/24/32
+#define TEXT_GLYPH_NUM          23940                   // GBK字符个数 126*190
+#define TEXT_GLYPH_MAX          128                     // 最大字模字节数，32号字32*32/8
+
+/* 字形缓存，按最近最少使用(LRU)替换 */
+#define TEXT_CACHE_NUM          32                      // 缓存的字模个数，占用32*128=4KB内存
+
+/* 1:编译字形显示耗时测试函数Text_Benchmark() 0:不编译 */
+#define TEXT_BENCH              0
+
+/* 多字节字符的编码 */
+#define TEXT_ENC_UTF8           0
+#define TEXT_ENC_GBK            1
+
+/* 一种字号的描述 */
+typedef struct
+{
+        u8 size;                                        // 字号，字模宽高均为size
+        u8 reserved;
+        u16 bytes;                                      // 每个字模的字节数
+        u32 offset;                                     // 字模数据相对字库起始地址的偏移
+} TEXT_FontTypeDef;
+
+/* 字库文件头 */
+typedef struct
+{
+        u32 magic;                                      // TEXT_MAGIC
+        u16 version;                                    // TEXT_VERSION
+        u16 count;                                      // 字号个数
+        u32 uni2gbk;                                    // Unicode->GBK映射表的偏移，0表示没有映射表
+        u32 total;                                      // 整个字库文件的大小
+        TEXT_FontTypeDef font[TEXT_FONT_MAX];
+} TEXT_HeaderTypeDef;
+
+/* 字形缓存的统计信息 */
+typedef struct
+{
+        u32 hit;                                        // 命中次数
+        u32 miss;                                       // 未命中次数，每次需要从Flash读取一个字模
+} TEXT_CacheStatTypeDef;
+
+extern TEXT_CacheStatTypeDef text_cache_stat;
+
+u8 Text_Init(void);
+u8 Text_Update(const char *path);
+void Text_SetEncoding(u8 encoding);
+u32 Text_Decode(const u8 **s);
+u16 Text_ShowChar(u16 x, u16 y, u32 code, u8 size, u8 mode);
+u16 Text_StringWidth(const char *p, u8 size);
+void Text_CacheFlush(void);
+
+#if TEXT_BENCH
+void Text_Benchmark(u8 size);
+#endif
+
+#endif /* __BSP_TEXT_H */
@@ -0,0 +1,375 @@
+#include "bsp_timer.h"
+#include "string.h"
+#if TIMER_BENCH
+#include "bsp_usart.h"
+#endif
+
+/* 驱动版本号：bsp_timer v1.0 */
+
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SIZE - 1)
+
+TIMER_StatTypeDef timer_stat;                                   // 到期统计
+
+static TIMER_ListTypeDef timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];     // 各层的槽
+static volatile u32 timer_ticks = 0;                            // 滴答数，只在滴答中断中修改
+static u32 timer_time = 0;                                      // 时间轮下一个要处理的滴答
+
+/**
+ * @Description 初始化链表头，空链表指向自己
+ */
+static void Timer_ListInit(TIMER_ListTypeDef *head)
+{
+        head->next = head;
+        head->prev = head;
+}
+
+/**
+ * @Description 把节点加到链表的末尾
+ */
+static void Timer_ListAdd(TIMER_ListTypeDef *head, TIMER_ListTypeDef *node)
+{
+        node->next = head;
+        node->prev = head->prev;
+        head->prev->next = node;
+        head->prev = node;
+}
+
+/**
+ * @Description 把节点从所在的链表中取下，取下后next为0表示不在时间轮中
+ */
+static void Timer_ListDel(TIMER_ListTypeDef *node)
+{
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->next = 0;
+}
+
+/**
+ * @Description 把head上的所有节点整体移到空链表to上，head变为空链表
+ */
+static void Timer_ListMove(TIMER_ListTypeDef *head, TIMER_ListTypeDef *to)
+{
+        if(head->next == head)
+        {
+                Timer_ListInit(to);
+                return;
+        }
+
+        to->next = head->next;
+        to->prev = head->prev;
+        to->next->prev = to;
+        to->prev->next = to;
+        Timer_ListInit(head);
+}
+
+/**
+ * @Description 按到期时间把定时器放入时间轮，调用时要关中断
+ * @param timer 定时器
+ * @notice      距离到期不足2^(6*(n+1))个滴答的放在第n层，已经过期的放在下一个要处理的槽；
+ *              超过最长定时时间的先放在最上层最远的槽，转到时再按实际的到期时间重新放入
+ */
+static void Timer_Add(TIMER_TypeDef *timer)
+{
+        u32 expires = timer->expires;
+        u32 delta = expires - timer_time;
+        u32 level = 0;
+
+        if((s32)delta < 0)
+        {
+                Timer_ListAdd(&timer_wheel[0][timer_time & TIMER_WHEEL_MASK], &timer->node);
+                return;
+        }
+
+        if(delta > TIMER_DELAY_MAX)
+        {
+                delta = TIMER_DELAY_MAX;
+                expires = timer_time + TIMER_DELAY_MAX;
+        }
+        while(delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1))))
+        {
+                level++;
+        }
+
+        Timer_ListAdd(&timer_wheel[level][(expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK], &timer->node);
+}
+
+/**
+ * @Description 把上层一个槽中的定时器按到期时间重新放入下层
+ * @param head  槽的链表头
+ * @notice      每移动一个定时器关一次中断，槽中的定时器再多也不会长时间关中断
+ */
+static void Timer_Cascade(TIMER_ListTypeDef *head)
+{
+        TIMER_ListTypeDef list, *node;
+
+        __disable_irq();
+        Timer_ListMove(head, &list);
+        __enable_irq();
+
+        while(1)
+        {
+                __disable_irq();
+                node = list.next;
+                if(node == &list)
+                {
+                        __enable_irq();
+                        break;
+                }
+                Timer_ListDel(node);
+                Timer_Add((TIMER_TypeDef *)node);
+                timer_stat.cascaded++;
+                __enable_irq();
+        }
+}
+
+/**
+ * @Description 滴答中断中调用，只增加滴答数
+ */
+static void Timer_Tick(void)
+{
+        timer_ticks++;
+}
+
+/**
+ * @Description 初始化时间轮，使用滴答中断计时，要先调用Systick_Init()
+ */
+void Timer_Init(void)
+{
+        u32 level, i;
+
+        for(level = 0; level < TIMER_WHEEL_LEVELS; level++)
+        {
+                for(i = 0; i < TIMER_WHEEL_SIZE; i++)
+                {
+                        Timer_ListInit(&timer_wheel[level][i]);
+                }
+        }
+        memset(&timer_stat, 0, sizeof(timer_stat));
+        timer_time = timer_ticks;
+
+        Systick_SetTickHandler(Timer_Tick);
+}
+
+/**
+ * @Description 初始化到期时调用回调函数的定时器
+ * @param timer    定时器
+ * @param callback 回调函数，在Timer_Process()中调用
+ * @param arg      回调函数的参数
+ */
+void Timer_Create(TIMER_TypeDef *timer, void (*callback)(void *arg), void *arg)
+{
+        timer->node.next = 0;
+        timer->period = 0;
+        timer->callback = callback;
+        timer->arg = arg;
+        timer->flags = 0;
+        timer->event = 0;
+}
+
+/**
+ * @Description 初始化到期时置位事件标志的定时器，主循环或调度器查询标志后自行清除
+ * @param timer 定时器
+ * @param flags 事件标志
+ * @param event 到期时置位的位
+ */
+void Timer_CreateEvent(TIMER_TypeDef *timer, volatile u32 *flags, u32 event)
+{
+        Timer_Create(timer, 0, 0);
+        timer->flags = flags;
+        timer->event = event;
+}
+
+/**
+ * @Description 启动定时器，正在运行的定时器重新开始计时，可以在中断和回调函数中调用
+ * @param timer  定时器
+ * @param delay  第一次到期的时间，单位ms，0和1都在下一个滴答到期，最大TIMER_DELAY_MAX
+ * @param period 之后每次到期的周期，单位ms，0表示只执行一次
+ * @notice       周期定时器按上一次的到期时间加上周期计算下一次，处理推迟时不会累积误差
+ */
+void Timer_Start(TIMER_TypeDef *timer, u32 delay, u32 period)
+{
+        u32 primask = __get_PRIMASK();
+
+        if(delay > TIMER_DELAY_MAX)
+        {
+                delay = TIMER_DELAY_MAX;
+        }
+        if(period > TIMER_DELAY_MAX)
+        {
+                period = TIMER_DELAY_MAX;
+        }
+
+        __disable_irq();
+        if(timer->node.next != 0)
+        {
+                Timer_ListDel(&timer->node);
+        }
+        else
+        {
+                timer_stat.active++;
+        }
+        timer->expires = timer_ticks + delay;
+        timer->period = period;
+        Timer_Add(timer);
+        __set_PRIMASK(primask);
+}
+
+/**
+ * @Description 停止定时器，可以在中断和回调函数中调用，定时器没有运行时不做任何操作
+ * @param timer 定时器
+ */
+void Timer_Stop(TIMER_TypeDef *timer)
+{
+        u32 primask = __get_PRIMASK();
+
+        __disable_irq();
+        if(timer->node.next != 0)
+        {
+                Timer_ListDel(&timer->node);
+                timer_stat.active--;
+        }
+        __set_PRIMASK(primask);
+}
+
+/**
+ * @Description 查询定时器是否正在运行
+ * @param timer 定时器
+ * @return u8   1:正在运行 0:已停止或单次定时器已到期
+ */
+u8 Timer_IsActive(TIMER_TypeDef *timer)
+{
+        return timer->node.next != 0;
+}
+
+/**
+ * @Description 读取Timer_Init()以来的滴答数
+ * @return u32  滴答数，单位ms
+ */
+u32 Timer_Ticks(void)
+{
+        return timer_ticks;
+}
+
+/**
+ * @Description 处理到期的定时器，在主循环中调用
+ * @notice      每个滴答先把转到的上层槽移到下层，再取出第0层当前槽中的定时器依次执行，
+ *              上次调用以来经过的滴答全部处理完才返回，回调函数执行时中断是打开的
+ */
+void Timer_Process(void)
+{
+        TIMER_ListTypeDef pending, *node;
+        TIMER_TypeDef *timer;
+        void (*callback)(void *arg);
+        void *arg;
+        u32 index, level, late;
+
+        while((s32)(timer_ticks - timer_time) >= 0)
+        {
+                /* 第0层转完一圈时级联上一层，上一层也转完一圈时继续级联更上一层 */
+                index = timer_time & TIMER_WHEEL_MASK;
+                for(level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++)
+                {
+                        index = (timer_time >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+                        Timer_Cascade(&timer_wheel[level][index]);
+                }
+
+                /* 先取下当前槽再前进，回调中重新启动的定时器不会在这个滴答中再次执行 */
+                __disable_irq();
+                Timer_ListMove(&timer_wheel[0][timer_time & TIMER_WHEEL_MASK], &pending);
+                timer_time++;
+                __enable_irq();
+
+                while(1)
+                {
+                        __disable_irq();
+                        node = pending.next;
+                        if(node == &pending)
+                        {
+                                __enable_irq();
+                                break;
+                        }
+                        Timer_ListDel(node);
+
+                        timer = (TIMER_TypeDef *)node;
+                        late = timer_ticks - timer->expires;
+                        if(timer->period != 0)
+                        {
+                                timer->expires += timer->period;
+                                Timer_Add(timer);
+                        }
+                        else
+                        {
+                                timer_stat.active--;
+                        }
+
+                        callback = timer->callback;
+                        arg = timer->arg;
+                        if(callback == 0 && timer->flags != 0)
+                        {
+                                *timer->flags |= timer->event;
+                        }
+                        __enable_irq();
+
+                        timer_stat.fired++;
+                        timer_stat.late_total += late;
+                        if(late > timer_stat.late_max)
+                        {
+                                timer_stat.late_max = late;
+                        }
+
+                        if(callback != 0)
+                        {
+                                callback(arg);
+                        }
+                }
+        }
+}
+
+#if TIMER_BENCH
+/**
+ * @Description 启动TIMER_BENCH_NUM个随机周期的定时器运行2秒，测试启动、停止和到期处理的耗时，结果通过串口输出
+ * @notice      使用DWT周期计数器计时，到期处理为主循环中连续调用Timer_Process()时单次调用的最长时间
+ */
+void Timer_Benchmark(void)
+{
+        static TIMER_TypeDef bench[TIMER_BENCH_NUM];
+        static volatile u32 bench_flags;
+        u32 start, start_cyc, stop_cyc, process_max = 0, fired, end, rand = 1, i;
+
+        for(i = 0; i < TIMER_BENCH_NUM; i++)
+        {
+                Timer_CreateEvent(&bench[i], &bench_flags, 1);
+        }
+        fired = timer_stat.fired;
+
+        start = SYSTICK_CYCCNT();
+        for(i = 0; i < TIMER_BENCH_NUM; i++)
+        {
+                rand = rand * 1103515245 + 12345;
+                Timer_Start(&bench[i], 1 + (rand >> 16) % 2000, 1 + (rand >> 8) % 500);
+        }
+        start_cyc = (SYSTICK_CYCCNT() - start) / TIMER_BENCH_NUM;
+
+        end = Timer_Ticks() + 2000;
+        while((s32)(Timer_Ticks() - end) < 0)
+        {
+                start = SYSTICK_CYCCNT();
+                Timer_Process();
+                start = SYSTICK_CYCCNT() - start;
+                if(start > process_max)
+                {
+                        process_max = start;
+                }
+        }
+
+        start = SYSTICK_CYCCNT();
+        for(i = 0; i < TIMER_BENCH_NUM; i++)
+        {
+                Timer_Stop(&bench[i]);
+        }
+        stop_cyc = (SYSTICK_CYCCNT() - start) / TIMER_BENCH_NUM;
+
+        printf("bsp_timer:\t%u timers, start = %u, stop = %u, process max = %u cycles, fired = %u, late max = %u ms\r\n",
+               TIMER_BENCH_NUM, start_cyc, stop_cyc, process_max, timer_stat.fired - fired, timer_stat.late_max);
+}
+#endif /* TIMER_BENCH */
@@ -0,0 +1,68 @@
+#ifndef __BSP_TIMER_H
+#define __BSP_TIMER_H
+
+#include "stm32f4xx.h"
+#include "bsp_systick.h"
+
+/**
+ * 软件定时器，使用分层时间轮管理，启动和停止只修改一个链表节点，与定时器的个数无关。
+ * 时间轮共TIMER_WHEEL_LEVELS层，每层64个槽，第0层每个槽为1个滴答(1ms)，上一层每个槽是下一层的64倍，
+ * 到期时间较远的定时器放在上层，所在的槽转到时再整体移到下层(级联)，每个定时器最多被移动TIMER_WHEEL_LEVELS-1次。
+ * 滴答中断只把计数加1，到期处理和回调都在主循环调用Timer_Process()时执行，可以在回调中访问Flash、串口等外设；
+ * 主循环被阻塞时到期的定时器在下一次Timer_Process()中依次补上，推迟的时间计入timer_stat。
+ * Timer_Start()和Timer_Stop()可以在中断中调用，定时器控制块由调用者分配，不使用动态内存。
+ */
+#define TIMER_WHEEL_BITS        6                       // 每层的槽数为2^TIMER_WHEEL_BITS
+#define TIMER_WHEEL_SIZE        (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS      5                       // 层数，最长定时时间为2^30ms(约12天)
+#define TIMER_DELAY_MAX         ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+/* 1:编译耗时测试函数Timer_Benchmark() 0:不编译 */
+#define TIMER_BENCH             0
+#define TIMER_BENCH_NUM         1000                    // 测试使用的定时器个数
+
+/* 双向链表节点，时间轮中每个槽的链表头也使用这个结构 */
+typedef struct TIMER_ListTypeDef
+{
+        struct TIMER_ListTypeDef *next;                 // 不在时间轮中时为0
+        struct TIMER_ListTypeDef *prev;
+} TIMER_ListTypeDef;
+
+/* 定时器控制块 */
+typedef struct
+{
+        TIMER_ListTypeDef node;                         // 必须为第一个成员
+        u32 expires;                                    // 到期的滴答数
+        u32 period;                                     // 周期，0表示只执行一次
+        void (*callback)(void *arg);                    // 到期时调用的函数，为0时设置事件标志
+        void *arg;                                      // 回调函数的参数
+        volatile u32 *flags;                            // 到期时置位的事件标志
+        u32 event;                                      // 要置位的事件
+} TIMER_TypeDef;
+
+/* 到期统计，推迟时间为实际处理时的滴答数减去到期的滴答数 */
+typedef struct
+{
+        u32 active;                                     // 正在运行的定时器个数
+        u32 fired;                                      // 到期次数
+        u32 cascaded;                                   // 从上层移到下层的次数
+        u32 late_total;                                 // 推迟时间的总和，单位ms
+        u32 late_max;                                   // 最长推迟时间，单位ms
+} TIMER_StatTypeDef;
+
+extern TIMER_StatTypeDef timer_stat;
+
+void Timer_Init(void);
+void Timer_Create(TIMER_TypeDef *timer, void (*callback)(void *arg), void *arg);
+void Timer_CreateEvent(TIMER_TypeDef *timer, volatile u32 *flags, u32 event);
+void Timer_Start(TIMER_TypeDef *timer, u32 delay, u32 period);
+void Timer_Stop(TIMER_TypeDef *timer);
+u8 Timer_IsActive(TIMER_TypeDef *timer);
+u32 Timer_Ticks(void);
+void Timer_Process(void);
+
+#if TIMER_BENCH
+void Timer_Benchmark(void);
+#endif
+
+#endif /* __BSP_TIMER_H */
@@ -1,17 +1,90 @@
 #include "bsp_usart.h"
+#include "string.h"
+#if USART_CONSOLE_MIRROR
+#include "bsp_console.h"
+#endif
+#if USART_BENCH
+#include "bsp_systick.h"
+#endif
 
-/* 驱动版本号：bsp_usart v1.2 */
+/* 驱动版本号：bsp_usart v1.8 */
 
+u32 usart_rx_drop = 0;                                          // 接收缓冲满时丢弃的字节数
+u32 usart_tx_drop = 0;                                          // 发送缓冲满时丢弃的字节数
+
+static u8 usart_rx_dma_buf[USART_RX_DMA_SIZE];                  // DMA循环接收缓冲
+static u32 usart_rx_dma_pos = 0;                                // DMA缓冲中已经取走的位置
+static u8 usart_rx_buf[USART_RX_BUF_SIZE];                      // 接收环形缓冲
+static volatile u32 usart_rx_head = 0;                          // 写入位置，只在中断中修改
+static volatile u32 usart_rx_tail = 0;                          // 读出位置，只在主循环中修改
+static u32 usart_rx_scan = 0;                                   // Usart_ReadLine()已经查找过换行符的位置
+static volatile u32 usart_rx_frame[USART_RX_FRAME_NUM];         // 帧边界，即每帧结束时的写入位置
+static volatile u32 usart_rx_frame_head = 0;                    // 帧边界写入序号，只在中断中修改
+static volatile u32 usart_rx_frame_tail = 0;                    // 帧边界读出序号，只在主循环中修改
+static void (*usart_rx_handler)(const u8 *data, u16 len) = 0;   // 接收处理函数，不为0时收到的数据不进入接收缓冲
+
+static u8 usart_tx_buf[USART_TX_BUF_SIZE];                      // 发送环形缓冲
+static volatile u32 usart_tx_head = 0;                          // 写入位置，只增不减，取模后为下标
+static volatile u32 usart_tx_tail = 0;                          // DMA正在发送的一段的起始位置
+static volatile u16 usart_tx_dma = 0;                           // DMA正在发送的字节数，0表示空闲
+static u8 usart_tx_ready = 0;                                   // DMA是否已经初始化，之前写入的数据在初始化后发送
+
+/**
+ * @Description DMA空闲时启动发送缓冲中下一段连续的数据，在关中断或DMA中断中调用
+ */
+static void Usart_TxStart(void)
+{
+        u32 index, len;
+
+        if(!usart_tx_ready || usart_tx_dma != 0 || usart_tx_head == usart_tx_tail)
+        {
+                return;
+        }
+
+        /* 只发送到缓冲区末尾，绕回的部分在下一次传输中发送 */
+        index = usart_tx_tail & (USART_TX_BUF_SIZE - 1);
+        len = usart_tx_head - usart_tx_tail;
+        if(len > USART_TX_BUF_SIZE - index)
+        {
+                len = USART_TX_BUF_SIZE - index;
+        }
+
+        usart_tx_dma = len;
+        DMA_MemoryTargetConfig(USART_TX_DMA_STREAM, (u32)&usart_tx_buf[index], DMA_Memory_0);
+        DMA_SetCurrDataCounter(USART_TX_DMA_STREAM, len);
+        DMA_Cmd(USART_TX_DMA_STREAM, ENABLE);
+}
+
+#if USART_TX_POLICY == USART_TX_OVERWRITE
 /**
- * USART_RX_STA：软件虚拟的寄存器，用于控制字节流的接收
- * USART_RX_STA[15]：接收完成标志
- * USART_RX_STA[14]：接收到0x0d
- * USART_RX_STA[13:0]：接收到的有效字节数目
+ * @Description 丢弃最旧的n个还没有发送的字节，在关中断时调用
+ * @notice      最旧的数据可能正在由DMA发送，先停止DMA，按剩余的传输数算出已经发送的字节数
  */
-u16 USART_RX_STA = 0;
+static void Usart_TxDiscard(u32 n)
+{
+        u32 sent;
+
+        if(usart_tx_dma != 0)
+        {
+                DMA_Cmd(USART_TX_DMA_STREAM, DISABLE);
+                while(DMA_GetCmdStatus(USART_TX_DMA_STREAM) != DISABLE)
+                {
+                }
+                sent = usart_tx_dma - DMA_GetCurrDataCounter(USART_TX_DMA_STREAM);
+                DMA_ClearITPendingBit(USART_TX_DMA_STREAM, USART_TX_DMA_IT_TC);
 
-/* 接收缓冲数组，最大接收USART_REC_LEN个字节 */
-u8 USART_RX_BUF[USART_REC_LEN];
+                usart_tx_tail += sent;
+                usart_tx_dma = 0;
+        }
+
+        if(n > usart_tx_head - usart_tx_tail)
+        {
+                n = usart_tx_head - usart_tx_tail;
+        }
+        usart_tx_tail += n;
+        usart_tx_drop += n;
+}
+#endif
 
 /**
  * @Description 初始化串口
@@ -21,6 +94,7 @@ void Usart_Init(void)
         GPIO_InitTypeDef GPIO_InitStructure;
         USART_InitTypeDef USART_InitStructure;
         NVIC_InitTypeDef NVIC_InitStructure;
+        DMA_InitTypeDef DMA_InitStructure;
 
         /* 第一步：使能外设时钟 */
         RCC_AHB1PeriphClockCmd(USART_TX_GPIO_CLK, ENABLE);
@@ -61,69 +135,434 @@ void Usart_Init(void)
         NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
         NVIC_Init(&NVIC_InitStructure);
 
-        /* 第七步：开启串口中断 */
-        USART_ITConfig(USART, USART_IT_RXNE, ENABLE);
+        /* 第七步：开启总线空闲中断，接收的数据由DMA搬运 */
+        USART_ITConfig(USART, USART_IT_IDLE, ENABLE);
+
+        /* 第八步：配置发送DMA，每段数据的地址和长度在启动传输时设置 */
+        RCC_AHB1PeriphClockCmd(USART_TX_DMA_CLK, ENABLE);
+        DMA_DeInit(USART_TX_DMA_STREAM);
+        while(DMA_GetCmdStatus(USART_TX_DMA_STREAM) != DISABLE)
+        {
+        }
+
+        DMA_InitStructure.DMA_Channel = USART_TX_DMA_CHANNEL;
+        DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&USART->DR;
+        DMA_InitStructure.DMA_Memory0BaseAddr = (u32)usart_tx_buf;
+        DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+        DMA_InitStructure.DMA_BufferSize = 1;
+        DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+        DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+        DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+        DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+        DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+        DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+        DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_Full;
+        DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+        DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+        DMA_Init(USART_TX_DMA_STREAM, &DMA_InitStructure);
+        DMA_ITConfig(USART_TX_DMA_STREAM, DMA_IT_TC, ENABLE);
+        USART_DMACmd(USART, USART_DMAReq_Tx, ENABLE);
+
+        NVIC_InitStructure.NVIC_IRQChannel = USART_TX_DMA_IRQ;
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+
+        /* 第九步：配置接收DMA，循环模式，半满和全满时产生中断 */
+        RCC_AHB1PeriphClockCmd(USART_RX_DMA_CLK, ENABLE);
+        DMA_DeInit(USART_RX_DMA_STREAM);
+        while(DMA_GetCmdStatus(USART_RX_DMA_STREAM) != DISABLE)
+        {
+        }
+
+        DMA_InitStructure.DMA_Channel = USART_RX_DMA_CHANNEL;
+        DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&USART->DR;
+        DMA_InitStructure.DMA_Memory0BaseAddr = (u32)usart_rx_dma_buf;
+        DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+        DMA_InitStructure.DMA_BufferSize = USART_RX_DMA_SIZE;
+        DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+        DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+        DMA_Init(USART_RX_DMA_STREAM, &DMA_InitStructure);
+        DMA_ITConfig(USART_RX_DMA_STREAM, DMA_IT_HT | DMA_IT_TC, ENABLE);
+        USART_DMACmd(USART, USART_DMAReq_Rx, ENABLE);
+        DMA_Cmd(USART_RX_DMA_STREAM, ENABLE);
+
+        /* 与串口中断同一优先级，两个中断不会互相打断 */
+        NVIC_InitStructure.NVIC_IRQChannel = USART_RX_DMA_IRQ;
+        NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+        NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+        NVIC_Init(&NVIC_InitStructure);
+
+        /* 发送初始化之前已经写入缓冲的数据 */
+        __disable_irq();
+        usart_tx_ready = 1;
+        Usart_TxStart();
+        __enable_irq();
 }
 
 /**
- * @Description 串口中断服务函数，每有接收一个字节，申请一次中断，中断函数里面接收，直到接收到换行停止接收
+ * @Description 发送DMA中断服务函数，一段传输完成后释放缓冲并启动下一段
  */
-void USART_IRQHandler(void)
+void USART_TX_DMA_IRQHandler(void)
 {
-        /* 用于保存本次串口接收到的字节 */
-        u8 Res;
+        if(DMA_GetITStatus(USART_TX_DMA_STREAM, USART_TX_DMA_IT_TC) != RESET)
+        {
+                DMA_ClearITPendingBit(USART_TX_DMA_STREAM, USART_TX_DMA_IT_TC);
 
-        /* 判断是不是接收中断，如果是接收中断，执行if里面的代码 */
-        if(USART_GetITStatus(USART, USART_IT_RXNE) != RESET)
+                usart_tx_tail += usart_tx_dma;
+                usart_tx_dma = 0;
+                Usart_TxStart();
+        }
+}
+
+/**
+ * @Description 把数据写入发送缓冲，由DMA在后台发送，可以在中断中调用
+ * @param data  数据
+ * @param len   字节数
+ * @return u16  写入缓冲的字节数，缓冲满时的处理方式由USART_TX_POLICY决定
+ * @notice      写入缓冲时短暂关中断，保证主循环和中断中的输出不会交错在一个字节中间
+ */
+u16 Usart_Write(const u8 *data, u16 len)
+{
+        u32 primask, space, index, n;
+        u16 done = 0;
+
+        while(done < len)
         {
-                /* 读取串口1接收到的数据 */
-                Res = USART_ReceiveData(USART);
+                primask = __get_PRIMASK();
+                __disable_irq();
 
-                /* 接收未完成，这里接收的是一大串字节 */
-                if((USART_RX_STA & 0x8000) == 0)
+                space = USART_TX_BUF_SIZE - (usart_tx_head - usart_tx_tail);
+                n = len - done;
+                if(n > space)
                 {
-                        /* 判断前一个接收的是不是0x0d */
-                        if(USART_RX_STA & 0x4000)
+#if USART_TX_POLICY == USART_TX_OVERWRITE
+                        /* 比整个缓冲还长时只保留最后的部分 */
+                        if(n > USART_TX_BUF_SIZE)
                         {
-                                /* 如果前一个字节收到0x0d的话，再接收一个字节 */
-                                if(Res != 0x0a)
-                                {
-                                        /* 如果在接收的不是到0x0a，接收错误，重新开始 */
-                                        USART_RX_STA = 0;
-                                }
-                                else
-                                {
-                                        /* 如果再接收到0x0a，就把USART_RX_STA中接收完成标志置位，表示接收完成了 */
-                                        USART_RX_STA |= 0x8000;
-                                }
+                                usart_tx_drop += n - USART_TX_BUF_SIZE;
+                                done += n - USART_TX_BUF_SIZE;
+                                n = USART_TX_BUF_SIZE;
                         }
-                        else
+                        Usart_TxDiscard(n - space);
+#elif USART_TX_POLICY == USART_TX_BLOCK
+                        /* 中断中或关中断时等不到DMA完成，只能丢弃 */
+                        if(primask || __get_IPSR() != 0)
+                        {
+                                usart_tx_drop += n - space;
+                                len = done + space;
+                        }
+                        n = space;
+#else
+                        usart_tx_drop += n - space;
+                        len = done + space;
+                        n = space;
+#endif
+                }
+
+                /* 写到缓冲区末尾后绕回开头 */
+                index = usart_tx_head & (USART_TX_BUF_SIZE - 1);
+                if(n > USART_TX_BUF_SIZE - index)
+                {
+                        memcpy(&usart_tx_buf[index], data + done, USART_TX_BUF_SIZE - index);
+                        memcpy(usart_tx_buf, data + done + USART_TX_BUF_SIZE - index, n - (USART_TX_BUF_SIZE - index));
+                }
+                else
+                {
+                        memcpy(&usart_tx_buf[index], data + done, n);
+                }
+                usart_tx_head += n;
+                done += n;
+
+                Usart_TxStart();
+                __set_PRIMASK(primask);
+        }
+
+        return done;
+}
+
+/**
+ * @Description 查询发送缓冲中的空闲字节数，用于在不阻塞的前提下决定是否输出
+ * @return u16  空闲字节数
+ */
+u16 Usart_TxFree(void)
+{
+        return USART_TX_BUF_SIZE - (usart_tx_head - usart_tx_tail);
+}
+
+/**
+ * @Description 等待发送缓冲中的数据全部发送完毕，包括最后一个字节移出移位寄存器
+ * @notice      不能在中断中或关中断时调用，否则DMA中断得不到执行，会一直等待
+ */
+void Usart_Flush(void)
+{
+        while(usart_tx_head != usart_tx_tail)
+        {
+        }
+        while((USART->SR & 0x40) == 0)
+        {
+        }
+}
+
+/**
+ * @Description 把DMA缓冲中新收到的数据复制到接收环形缓冲，在串口中断和接收DMA中断中调用
+ * @notice      接收缓冲放不下的部分丢弃，并计入usart_rx_drop
+ */
+static void Usart_RxPoll(void)
+{
+        u32 pos, n, free, index, part;
+
+        pos = USART_RX_DMA_SIZE - DMA_GetCurrDataCounter(USART_RX_DMA_STREAM);
+        if(pos >= USART_RX_DMA_SIZE)
+        {
+                pos = 0;
+        }
+
+        while(usart_rx_dma_pos != pos)
+        {
+                /* DMA缓冲中连续的一段，绕回的部分下一次循环处理 */
+                n = (pos > usart_rx_dma_pos) ? pos - usart_rx_dma_pos : USART_RX_DMA_SIZE - usart_rx_dma_pos;
+
+                /* 设置了接收处理函数时直接在DMA缓冲中处理 */
+                if(usart_rx_handler != 0)
+                {
+                        usart_rx_handler(&usart_rx_dma_buf[usart_rx_dma_pos], n);
+                        usart_rx_dma_pos += n;
+                        if(usart_rx_dma_pos >= USART_RX_DMA_SIZE)
                         {
-                                /* 如果前一个字节还没收到0x0d的话，就接着接收下一个字节 */
-                                if(Res == 0x0d)
-                                {
-                                        /* 如果当前接收到的是0x0d的话 */
-                                        /* 则置位接收到0x0d的标志位 USART_RX_STA[14] */
-                                        USART_RX_STA |= 0x4000;
-                                }
-                                else
-                                {
-                                        /* 将当前接收到的值存入缓存数组中 */
-                                        USART_RX_BUF[USART_RX_STA & 0X3FFF] = Res;
-
-                                        /* 接收到的字节个数加一 */
-                                        USART_RX_STA++;
-
-                                        /* 判断接收到的数据有没有超过最开始设置的缓存区长度 */
-                                        if(USART_RX_STA > (USART_REC_LEN - 1))
-                                        {
-                                                /* 如果超出范围，表明接收数据错误，重新开始接收 */
-                                                USART_RX_STA = 0;
-                                        }
-                                }
+                                usart_rx_dma_pos = 0;
                         }
+                        continue;
+                }
+
+                free = USART_RX_BUF_SIZE - (usart_rx_head - usart_rx_tail);
+                if(n > free)
+                {
+                        usart_rx_drop += n - free;
+                }
+
+                part = (n > free) ? free : n;
+                index = usart_rx_head & (USART_RX_BUF_SIZE - 1);
+                if(part > USART_RX_BUF_SIZE - index)
+                {
+                        memcpy(&usart_rx_buf[index], &usart_rx_dma_buf[usart_rx_dma_pos], USART_RX_BUF_SIZE - index);
+                        memcpy(usart_rx_buf, &usart_rx_dma_buf[usart_rx_dma_pos + USART_RX_BUF_SIZE - index], part - (USART_RX_BUF_SIZE - index));
+                }
+                else
+                {
+                        memcpy(&usart_rx_buf[index], &usart_rx_dma_buf[usart_rx_dma_pos], part);
+                }
+                usart_rx_head += part;
+
+                usart_rx_dma_pos += n;
+                if(usart_rx_dma_pos >= USART_RX_DMA_SIZE)
+                {
+                        usart_rx_dma_pos = 0;
+                }
+        }
+}
+
+/**
+ * @Description 串口中断服务函数，总线空闲时取走DMA缓冲中剩余的数据，并记录一个帧边界
+ */
+void USART_IRQHandler(void)
+{
+        u32 last;
+
+        if(USART_GetITStatus(USART, USART_IT_IDLE) != RESET)
+        {
+                /* 先读SR再读DR清除IDLE标志 */
+                (void)USART->SR;
+                (void)USART->DR;
+
+                Usart_RxPoll();
+
+                /* 与上一个边界相同说明这段时间没有收到数据，帧边界记录满了则与下一帧合并 */
+                last = (usart_rx_frame_head != usart_rx_frame_tail) ?
+                       usart_rx_frame[(usart_rx_frame_head - 1) & (USART_RX_FRAME_NUM - 1)] : usart_rx_tail;
+                if(usart_rx_head != last && usart_rx_frame_head - usart_rx_frame_tail < USART_RX_FRAME_NUM)
+                {
+                        usart_rx_frame[usart_rx_frame_head & (USART_RX_FRAME_NUM - 1)] = usart_rx_head;
+                        usart_rx_frame_head++;
+                }
+        }
+}
+
+/**
+ * @Description 接收DMA中断服务函数，DMA缓冲半满或全满时取走数据，连续接收时不用等到总线空闲
+ */
+void USART_RX_DMA_IRQHandler(void)
+{
+        if(DMA_GetITStatus(USART_RX_DMA_STREAM, USART_RX_DMA_IT_HT) != RESET)
+        {
+                DMA_ClearITPendingBit(USART_RX_DMA_STREAM, USART_RX_DMA_IT_HT);
+                Usart_RxPoll();
+        }
+        if(DMA_GetITStatus(USART_RX_DMA_STREAM, USART_RX_DMA_IT_TC) != RESET)
+        {
+                DMA_ClearITPendingBit(USART_RX_DMA_STREAM, USART_RX_DMA_IT_TC);
+                Usart_RxPoll();
+        }
+}
+
+/**
+ * @Description 修改波特率，先等待发送缓冲中的数据以原来的波特率发送完毕
+ * @param baudrate 波特率，USART2在APB1(42MHz)上，最高约2.6Mbps
+ */
+void Usart_SetBaudrate(u32 baudrate)
+{
+        USART_InitTypeDef USART_InitStructure;
+
+        Usart_Flush();
+        USART_Cmd(USART, DISABLE);
+
+        USART_InitStructure.USART_BaudRate = baudrate;
+        USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+        USART_InitStructure.USART_StopBits = USART_StopBits_1;
+        USART_InitStructure.USART_Parity = USART_Parity_No;
+        USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+        USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
+        USART_Init(USART, &USART_InitStructure);
+
+        USART_Cmd(USART, ENABLE);
+}
+
+/**
+ * @Description 设置接收处理函数，协议解析等需要尽快响应的处理可以直接在接收中断中完成
+ * @param handler 接收处理函数，在串口中断或接收DMA中断中调用，参数为DMA缓冲中新收到的一段数据；
+ *                为0时恢复写入接收缓冲
+ * @notice      设置处理函数之前已经在接收缓冲中的数据不受影响，仍然可以读出
+ */
+void Usart_SetRxHandler(void (*handler)(const u8 *data, u16 len))
+{
+        NVIC_DisableIRQ(USART_IRQ);
+        NVIC_DisableIRQ(USART_RX_DMA_IRQ);
+        usart_rx_handler = handler;
+        NVIC_EnableIRQ(USART_RX_DMA_IRQ);
+        NVIC_EnableIRQ(USART_IRQ);
+}
+
+/**
+ * @Description 查询接收缓冲中的字节数
+ * @return u16  字节数
+ */
+u16 Usart_Available(void)
+{
+        return usart_rx_head - usart_rx_tail;
+}
+
+/**
+ * @Description 从接收缓冲中按原样读出数据，不处理换行符，适合二进制数据
+ * @param buf   读出的数据
+ * @param len   最多读出的字节数
+ * @return u16  读出的字节数
+ */
+u16 Usart_Read(u8 *buf, u16 len)
+{
+        u32 n = usart_rx_head - usart_rx_tail;
+        u32 index = usart_rx_tail & (USART_RX_BUF_SIZE - 1);
+
+        if(n > len)
+        {
+                n = len;
+        }
+
+        if(n > USART_RX_BUF_SIZE - index)
+        {
+                memcpy(buf, &usart_rx_buf[index], USART_RX_BUF_SIZE - index);
+                memcpy(buf + USART_RX_BUF_SIZE - index, usart_rx_buf, n - (USART_RX_BUF_SIZE - index));
+        }
+        else
+        {
+                memcpy(buf, &usart_rx_buf[index], n);
+        }
+        usart_rx_tail += n;
+
+        return n;
+}
+
+/**
+ * @Description 从接收缓冲中读出一行，以\n结束，行尾的\r\n或\n不包括在读出的内容中
+ * @param line  读出的一行，以'\0'结尾
+ * @param size  line的大小
+ * @return s16  读出的长度，还没有收到完整的一行时返回-1
+ * @notice      超过size-1个字节还没有换行时把前size-1个字节作为一行返回，不会因为一直没有换行而卡住；
+ *              已经查找过的位置会记住，没有收到新数据时不会重复查找
+ */
+s16 Usart_ReadLine(char *line, u16 size)
+{
+        u32 head = usart_rx_head;
+        u32 len, n;
+
+        if(usart_rx_scan - usart_rx_tail > USART_RX_BUF_SIZE)
+        {
+                /* 其他读出函数取走了数据 */
+                usart_rx_scan = usart_rx_tail;
+        }
+
+        while(usart_rx_scan != head && usart_rx_buf[usart_rx_scan & (USART_RX_BUF_SIZE - 1)] != '\n')
+        {
+                usart_rx_scan++;
+        }
+
+        len = usart_rx_scan - usart_rx_tail;
+        if(usart_rx_scan == head)
+        {
+                if(len < size - 1)
+                {
+                        return -1;
+                }
+
+                /* 太长，截断 */
+                n = Usart_Read((u8 *)line, size - 1);
+                line[n] = '\0';
+                return n;
+        }
+
+        /* 读出换行符之前的内容，超出size的部分丢弃，再跳过换行符 */
+        n = Usart_Read((u8 *)line, (len < size - 1) ? len : size - 1);
+        usart_rx_tail += len - n + 1;
+        usart_rx_scan = usart_rx_tail;
+        if(n == len && n > 0 && line[n - 1] == '\r')
+        {
+                n--;
+        }
+        line[n] = '\0';
+
+        return n;
+}
+
+/**
+ * @Description 从接收缓冲中读出一帧，帧以总线空闲为界，内容按原样读出
+ * @param buf   读出的数据
+ * @param size  buf的大小，帧比size长时超出的部分丢弃
+ * @return u16  帧的长度(不超过size)，还没有完整的帧时返回0
+ */
+u16 Usart_ReadFrame(u8 *buf, u16 size)
+{
+        u32 end, len, n;
+
+        while(usart_rx_frame_tail != usart_rx_frame_head)
+        {
+                end = usart_rx_frame[usart_rx_frame_tail & (USART_RX_FRAME_NUM - 1)];
+                usart_rx_frame_tail++;
+
+                /* 边界之前的数据可能已经被按字节或按行读走了 */
+                len = end - usart_rx_tail;
+                if(len == 0 || len > USART_RX_BUF_SIZE)
+                {
+                        continue;
                 }
+
+                n = Usart_Read(buf, (len < size) ? len : size);
+                usart_rx_tail += len - n;
+                return n;
         }
+
+        return 0;
 }
 
 /* 加入以下代码，支持printf函数，而不需要选择use MicroLIB */
@@ -146,17 +585,128 @@ void _sys_exit(int x)
 }
 
 /**
- * @Description 重定义fputc函数
+ * @Description 重定义fputc函数，只写入发送缓冲，不等待发送
  */
 int fputc(int ch, FILE *f)
 {
-        /* 循环发送,直到发送完毕 */
-        while((USART->SR & 0x40) == 0)
+        u8 c = ch;
+
+        Usart_Write(&c, 1);
+
+#if USART_CONSOLE_MIRROR
+        Console_PutChar(ch);
+#endif
+
+        return ch;
+}
+
+#if USART_BENCH
+/**
+ * @Description 比较每行printf占用CPU的时间，逐字节等待发送的方式与写入发送缓冲的方式，结果通过串口输出
+ * @notice      使用DWT周期计数器计时，每行60个字符，115200波特率下逐字节等待约5.2ms
+ */
+void Usart_Benchmark(void)
+{
+        static const char line[] = "usart benchmark 0123456789 abcdefghijklmnopqrstuvwxyz ABCD\r\n";
+        u32 start, poll, dma;
+        u8 i;
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        /* 原来的方式：格式化后每个字节等待发送完成 */
+        Usart_Flush();
+        start = DWT->CYCCNT;
+        for(i = 0; line[i] != '\0'; i++)
         {
+                while((USART->SR & 0x40) == 0)
+                {
+                }
+                USART->DR = (u8)line[i];
         }
+        poll = DWT->CYCCNT - start;
 
-        /* 装载要发送的数据 */
-        USART->DR = (u8) ch;
+        /* 写入发送缓冲后立即返回 */
+        Usart_Flush();
+        start = DWT->CYCCNT;
+        printf("%s", line);
+        dma = DWT->CYCCNT - start;
 
-        return ch;
+        Usart_Flush();
+        printf("bsp_usart:\tprintf %u bytes, poll = %u us, dma = %u us (%u cycles)\r\n",
+               (u32)sizeof(line) - 1, poll / SYSTEM_CLOCK, dma / SYSTEM_CLOCK, dma);
+}
+#endif /* USART_BENCH */
+
+#if USART_BENCH
+/**
+ * @Description 接收吞吐量测试，以指定的波特率自发自收，检查收到的数据是否连续，结果通过串口输出
+ * @param baudrate 测试时使用的波特率，例如921600、2000000
+ * @param bytes 发送的字节数
+ * @notice      测试前用跳线短接TX和RX(USART2为PA2和PA3)，测试结束后恢复为USART_BAUDRATE，
+ *              发送的数据为递增的字节，丢失或出错时重新同步后继续计数
+ */
+void Usart_RxBenchmark(u32 baudrate, u32 bytes)
+{
+        static u8 buf[256];
+        u32 sent = 0, recv = 0, error = 0, drop, start, last, cycles;
+        u16 n, i;
+        u8 expect = 0;
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        Usart_SetBaudrate(baudrate);
+
+        /* 丢掉之前收到的数据 */
+        while(Usart_Read(buf, sizeof(buf)) != 0)
+        {
+        }
+        while(Usart_ReadFrame(buf, sizeof(buf)) != 0)
+        {
+        }
+        drop = usart_rx_drop;
+
+        start = DWT->CYCCNT;
+        last = start;
+        while(recv < bytes)
+        {
+                /* 每次发送64字节，发送缓冲满时Usart_Write()按USART_TX_POLICY处理 */
+                if(sent < bytes)
+                {
+                        n = (bytes - sent > 64) ? 64 : bytes - sent;
+                        for(i = 0; i < n; i++)
+                        {
+                                buf[i] = (u8)(sent + i);
+                        }
+                        sent += Usart_Write(buf, n);
+                }
+
+                n = Usart_Read(buf, sizeof(buf));
+                for(i = 0; i < n; i++)
+                {
+                        if(buf[i] != expect)
+                        {
+                                error++;
+                        }
+                        expect = buf[i] + 1;
+                }
+                recv += n;
+
+                /* 10ms没有收到数据，认为发送完毕或没有短接 */
+                if(n != 0)
+                {
+                        last = DWT->CYCCNT;
+                }
+                else if(DWT->CYCCNT - last > SYSTEM_CLOCK * 10000)
+                {
+                        break;
+                }
+        }
+        cycles = last - start;
+
+        Usart_SetBaudrate(USART_BAUDRATE);
+        printf("bsp_usart:\trx %u baud, %u/%u bytes, %u errors, %u dropped, %u bytes/s\r\n", baudrate, recv, bytes, error,
+               usart_rx_drop - drop, cycles ? (u32)((uint64_t)recv * SYSTEM_CLOCK * 1000000 / cycles) : 0);
 }
+#endif /* USART_BENCH */
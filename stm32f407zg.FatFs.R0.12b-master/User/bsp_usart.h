@@ -26,6 +26,23 @@
 
 #define USART_IRQHandler        USART1_IRQHandler
 #define USART_IRQ               USART1_IRQn
+
+/* USART1_TX使用DMA2数据流7通道4 */
+#define USART_TX_DMA_CLK        RCC_AHB1Periph_DMA2
+#define USART_TX_DMA_STREAM     DMA2_Stream7
+#define USART_TX_DMA_CHANNEL    DMA_Channel_4
+#define USART_TX_DMA_IT_TC      DMA_IT_TCIF7
+#define USART_TX_DMA_IRQ        DMA2_Stream7_IRQn
+#define USART_TX_DMA_IRQHandler DMA2_Stream7_IRQHandler
+
+/* USART1_RX使用DMA2数据流5通道4 */
+#define USART_RX_DMA_CLK        RCC_AHB1Periph_DMA2
+#define USART_RX_DMA_STREAM     DMA2_Stream5
+#define USART_RX_DMA_CHANNEL    DMA_Channel_4
+#define USART_RX_DMA_IT_HT      DMA_IT_HTIF5
+#define USART_RX_DMA_IT_TC      DMA_IT_TCIF5
+#define USART_RX_DMA_IRQ        DMA2_Stream5_IRQn
+#define USART_RX_DMA_IRQHandler DMA2_Stream5_IRQHandler
 #endif /* USING_USART1 */
 
 /* 使用USART2 PA2-TX PA3-RX */
@@ -48,14 +65,74 @@
 
 #define USART_IRQHandler        USART2_IRQHandler
 #define USART_IRQ               USART2_IRQn
+
+/* USART2_TX使用DMA1数据流6通道4 */
+#define USART_TX_DMA_CLK        RCC_AHB1Periph_DMA1
+#define USART_TX_DMA_STREAM     DMA1_Stream6
+#define USART_TX_DMA_CHANNEL    DMA_Channel_4
+#define USART_TX_DMA_IT_TC      DMA_IT_TCIF6
+#define USART_TX_DMA_IRQ        DMA1_Stream6_IRQn
+#define USART_TX_DMA_IRQHandler DMA1_Stream6_IRQHandler
+
+/* USART2_RX使用DMA1数据流5通道4 */
+#define USART_RX_DMA_CLK        RCC_AHB1Periph_DMA1
+#define USART_RX_DMA_STREAM     DMA1_Stream5
+#define USART_RX_DMA_CHANNEL    DMA_Channel_4
+#define USART_RX_DMA_IT_HT      DMA_IT_HTIF5
+#define USART_RX_DMA_IT_TC      DMA_IT_TCIF5
+#define USART_RX_DMA_IRQ        DMA1_Stream5_IRQn
+#define USART_RX_DMA_IRQHandler DMA1_Stream5_IRQHandler
 #endif /* USING_USART2 */
 
 #define USART_BAUDRATE          115200                  // 串口波特率
-#define USART_REC_LEN           200                     // 定义最大接收字节数
 
-extern u8 USART_RX_BUF[USART_REC_LEN];                  // 接收缓冲数组
-extern u16 USART_RX_STA;                                // 接收状态标记
+/**
+ * 接收使用循环模式的DMA，DMA半满、全满和总线空闲(IDLE)时在中断中把新收到的数据复制到接收环形缓冲，
+ * 中断只写入位置、主循环只写读出位置，不需要关中断。每次总线空闲记录一个帧边界，
+ * 可以按行(Usart_ReadLine)、按帧(Usart_ReadFrame)或按字节(Usart_Read)读出，读出方式可以混用
+ */
+#define USART_RX_DMA_SIZE       256                     // DMA循环缓冲大小，半满时就会取走，最长可以容忍半个缓冲时间的中断延迟
+#define USART_RX_BUF_SIZE       2048                    // 接收环形缓冲大小，必须为2的幂
+#define USART_RX_FRAME_NUM      16                      // 最多记录的帧边界个数，必须为2的幂
+
+/**
+ * 发送缓冲，printf只把数据写入环形缓冲后立即返回，由DMA在后台发送，
+ * 一次DMA传输发送缓冲中连续的一段，传输完成中断中接着启动下一段
+ */
+#define USART_TX_BUF_SIZE       1024                    // 发送缓冲大小，必须为2的幂
+
+/* 发送缓冲满时的处理方式 */
+#define USART_TX_DROP           0                       // 丢弃放不下的新数据
+#define USART_TX_BLOCK          1                       // 等待缓冲有空位，在中断中或关中断时调用则丢弃
+#define USART_TX_OVERWRITE      2                       // 丢弃最旧的还没有发送的数据，给新数据腾出位置
+#ifndef USART_TX_POLICY                                 // 可以在编译选项中指定，上位机测试程序Tools/usartsim.c分别测试三种方式
+#define USART_TX_POLICY         USART_TX_BLOCK
+#endif
+
+/* 1:编译printf耗时测试函数Usart_Benchmark()和接收测试函数Usart_RxBenchmark() 0:不编译 */
+#define USART_BENCH             0
+
+/* 1:printf的输出同时显示到LCD终端上(需要先调用Console_Init()) 0:只从串口输出
+ * 注意开启后不能在中断中调用printf，否则可能打断主循环中正在进行的LCD绘图 */
+#define USART_CONSOLE_MIRROR    0
+
+extern u32 usart_rx_drop;                               // 接收缓冲满时丢弃的字节数
+extern u32 usart_tx_drop;                               // 发送缓冲满时丢弃的字节数
 
 void Usart_Init(void);                                  // 串口初始化函数
+u16 Usart_Write(const u8 *data, u16 len);               // 把数据写入发送缓冲，不等待发送
+u16 Usart_TxFree(void);                                 // 发送缓冲中的空闲字节数
+void Usart_Flush(void);                                 // 等待发送缓冲中的数据全部发送完毕
+void Usart_SetBaudrate(u32 baudrate);                   // 修改波特率
+u16 Usart_Available(void);                              // 接收缓冲中的字节数
+u16 Usart_Read(u8 *buf, u16 len);                       // 按字节读出
+s16 Usart_ReadLine(char *line, u16 size);               // 读出一行
+u16 Usart_ReadFrame(u8 *buf, u16 size);                 // 读出一帧
+void Usart_SetRxHandler(void (*handler)(const u8 *data, u16 len));      // 设置接收处理函数
+
+#if USART_BENCH
+void Usart_Benchmark(void);
+void Usart_RxBenchmark(u32 baudrate, u32 bytes);
+#endif
 
 #endif /* __BSP_USART_H */
@@ -1,6 +1,7 @@
 #include "bsp_w25qxx.h"
+#include "bsp_log.h"
 
-/* 驱动版本号：bsp_w25qxx v1.4 */
+/* 驱动版本号：bsp_w25qxx v1.6 */
 
 u16 W25QXX_TYPE = 0;
 
@@ -49,11 +50,11 @@ void W25QXX_Init(void)
 
         /* 读取FLASH ID */
         W25QXX_TYPE = W25QXX_ReadID();
-        printf("bsp_w25qxx:\tFlash ID = %x \r\n", W25QXX_TYPE);
+        LOG1("bsp_w25qxx:\tFlash ID = %x \r\n", W25QXX_TYPE);
 
         if(W25QXX_TYPE == W25Q128)
         {
-                printf("bsp_w25qxx:\tFlash Chip Type is W25Q128\r\n\r\n");
+                LOG0("bsp_w25qxx:\tFlash Chip Type is W25Q128\r\n\r\n");
         }
 }
 
@@ -386,6 +387,25 @@ void W25QXX_EraseSector(u32 Dst_Addr)
         W25QXX_WaitBusy();
 }
 
+/**
+ * @Description 擦除一个块(64KB)
+ * @param Dst_Addr 块地址 0~255
+ * @note 擦除一个块的典型时间150ms，远小于逐个擦除16个扇区的时间
+ */
+void W25QXX_EraseBlock(u32 Dst_Addr)
+{
+        Dst_Addr *= 65536;
+        W25QXX_WriteEnable();
+        W25QXX_WaitBusy();
+        W25QXX_CS = 0;
+        Spi_ReadWriteByte(W25X_BlockErase);
+        Spi_ReadWriteByte((u8)((Dst_Addr) >> 16));
+        Spi_ReadWriteByte((u8)((Dst_Addr) >> 8));
+        Spi_ReadWriteByte((u8) Dst_Addr);
+        W25QXX_CS = 1;
+        W25QXX_WaitBusy();
+}
+
 /**
  * @Description 等待空闲
  */
@@ -19,6 +19,11 @@ extern u16 W25QXX_TYPE;
 /* W25QXX的片选信号，其实就是SPI的片选信号 */
 #define	W25QXX_CS PBout(14)
 
+/* W25Q128空间划分：前10MB为FatFs卷，后6MB保留给GBK字库(见bsp_text.c)，两者都按64KB块对齐 */
+#define W25QXX_FATFS_SIZE       (10 * 1024 * 1024)
+#define W25QXX_FONT_ADDR        W25QXX_FATFS_SIZE
+#define W25QXX_FONT_SIZE        (6 * 1024 * 1024)
+
 /* W25Q128指令表 */
 #define W25X_WriteEnable	0x06
 #define W25X_WriteDisable	0x04
@@ -48,6 +53,7 @@ void W25QXX_Read(u8* pBuffer, u32 address, u16 length);                 // 读
 void W25QXX_Write(u8* pBuffer, u32 address, u16 length);                // 写入flash(带擦除)
 void W25QXX_EraseChip(void);                                            // 整片擦除
 void W25QXX_EraseSector(u32 Dst_Addr);                                  // 扇区擦除
+void W25QXX_EraseBlock(u32 Dst_Addr);                                   // 块擦除(64KB)
 void W25QXX_WaitBusy(void);                                             // 等待空闲
 void W25QXX_PowerDown(void);                                            // 进入掉电模式
 void W25QXX_WakeUp(void);                                               // 唤醒
@@ -0,0 +1,257 @@
+#include "bsp_widget.h"
+#include "bsp_draw.h"
+#include "bsp_text.h"
+
+/* 驱动版本号：bsp_widget v1.0 */
+
+/**
+ * @Description 初始化文本控件，此时还不会在屏幕上绘制，第一次调用Widget_LabelSet()时画出全部字符格
+ * @param label 控件
+ * @param x,y   左上角坐标
+ * @param size  字号 12/16/24
+ * @param len   字符格数，最大WIDGET_TEXT_MAX
+ * @param color 文字颜色
+ * @param back  背景颜色
+ */
+void Widget_LabelInit(WIDGET_LabelTypeDef *label, u16 x, u16 y, u8 size, u8 len, u16 color, u16 back)
+{
+        label->x = x;
+        label->y = y;
+        label->size = size;
+        label->len = (len > WIDGET_TEXT_MAX) ? WIDGET_TEXT_MAX : len;
+        label->color = color;
+        label->back = back;
+
+        /* 内容清为0，与任何可显示字符都不同，保证第一次更新时所有字符格都会重画 */
+        memset(label->text, 0, sizeof(label->text));
+}
+
+/**
+ * @Description 更新文本控件的内容，只重画与屏幕上不同的字符格
+ * @param label 控件
+ * @param text  新的内容，超出字符格数的部分不显示
+ * @notice      含有中文时字符格与字符不再一一对应，内容变化时整个控件重画
+ */
+void Widget_LabelSet(WIDGET_LabelTypeDef *label, const char *text)
+{
+        char cell[WIDGET_TEXT_MAX + 1];
+        u16 point = POINT_COLOR;
+        u16 back = BACK_COLOR;
+        u16 width, used;
+        u8 i, ascii = 1;
+
+        /* 内容不足时补空格，空格在非叠加方式下会清除原来的字符 */
+        for(i = 0; i < label->len; i++)
+        {
+                cell[i] = (*text != '\0') ? *text++ : ' ';
+                if((u8)cell[i] >= 0x80)
+                {
+                        ascii = 0;
+                }
+        }
+        cell[i] = '\0';
+
+        /* 原来显示的是中文而新内容只有ASCII字符时，字符格与字符对不上，全部重画；
+           新内容也含中文时保留原来的内容，下面用strcmp()判断是否需要重画 */
+        for(i = 0; ascii && i < label->len; i++)
+        {
+                if((u8)label->text[i] >= 0x80)
+                {
+                        memset(label->text, 0, sizeof(label->text));
+                        break;
+                }
+        }
+
+        POINT_COLOR = label->color;
+        BACK_COLOR = label->back;
+
+        if(ascii)
+        {
+                for(i = 0; i < label->len; i++)
+                {
+                        if(cell[i] != label->text[i])
+                        {
+                                Lcd_ShowChar(label->x + i * (label->size / 2), label->y, cell[i], label->size, DRAW_REDRAW);
+                        }
+                }
+        }
+        else if(strcmp(cell, label->text) != 0)
+        {
+                width = label->len * (label->size / 2);
+                Lcd_ShowString(label->x, label->y, width, label->size, label->size, cell);
+
+                /* UTF-8中文3个字节只占2个字符格，清除多出来的部分 */
+                used = Text_StringWidth(cell, label->size);
+                if(used < width)
+                {
+                        Lcd_FillRect(label->x + used, label->y, width - used, label->size, label->back);
+                }
+        }
+
+        memcpy(label->text, cell, sizeof(cell));
+
+        POINT_COLOR = point;
+        BACK_COLOR = back;
+}
+
+/**
+ * @Description 初始化数值控件，颜色使用当前的POINT_COLOR和BACK_COLOR
+ * @param number 控件
+ * @param x,y   左上角坐标
+ * @param size  字号 12/16/24
+ * @param len   字符格数，包括符号、小数点和单位
+ * @param frac  小数位数，数值放大10^frac倍后以整数传入，超过LCD_FRAC_MAX时按LCD_FRAC_MAX处理
+ * @param unit  单位字符串，NULL表示没有单位
+ */
+void Widget_NumberInit(WIDGET_NumberTypeDef *number, u16 x, u16 y, u8 size, u8 len, u8 frac, const char *unit)
+{
+        Widget_LabelInit(&number->label, x, y, size, len, POINT_COLOR, BACK_COLOR);
+        number->value = 0;
+        number->frac = (frac > LCD_FRAC_MAX) ? LCD_FRAC_MAX : frac;
+        number->valid = 0;
+        number->unit = unit;
+}
+
+/**
+ * @Description 更新数值控件，数值没有变化时直接返回，否则只重画变化的数字
+ * @param number 控件
+ * @param value 数值，放大了10^frac倍，例如frac=3时1234表示1.234
+ * @notice      格式化不使用除法，放不下时显示为'#'
+ */
+void Widget_NumberSet(WIDGET_NumberTypeDef *number, s32 value)
+{
+        char text[WIDGET_TEXT_MAX + 1];
+        char digit[12];
+        const char *unit = number->unit;
+        u8 len, n, i = 0;
+
+        if(number->valid && number->value == value)
+        {
+                return;
+        }
+
+        /* 数字部分 */
+        n = Lcd_FormatNum(digit, (value < 0) ? -(u32)value : (u32)value, number->frac);
+        len = n + (value < 0 ? 1 : 0);
+        while(unit != NULL && unit[i] != '\0')
+        {
+                i++;
+        }
+        len += i;
+
+        if(len > number->label.len)
+        {
+                /* 放不下 */
+                memset(text, '#', number->label.len);
+                text[number->label.len] = '\0';
+        }
+        else
+        {
+                /* 右对齐，左边补空格 */
+                i = number->label.len - len;
+                memset(text, ' ', i);
+                if(value < 0)
+                {
+                        text[i++] = '-';
+                }
+                memcpy(text + i, digit, n);
+                i += n;
+                while(unit != NULL && *unit != '\0')
+                {
+                        text[i++] = *unit++;
+                }
+                text[i] = '\0';
+        }
+
+        Widget_LabelSet(&number->label, text);
+        number->value = value;
+        number->valid = 1;
+}
+
+/**
+ * @Description 初始化进度条，并画出空的进度条，颜色使用当前的POINT_COLOR和BACK_COLOR
+ * @param bar   控件
+ * @param x,y   左上角坐标
+ * @param width,height 大小
+ * @param max   满量程对应的数值
+ * @notice      像素比例在初始化时算好，更新时只做乘法和移位
+ */
+void Widget_BarInit(WIDGET_BarTypeDef *bar, u16 x, u16 y, u16 width, u16 height, u32 max)
+{
+        bar->x = x;
+        bar->y = y;
+        bar->width = width;
+        bar->height = height;
+        bar->color = POINT_COLOR;
+        bar->back = BACK_COLOR;
+        bar->scale = ((u32)width << 16) / (max ? max : 1);
+        bar->fill = 0;
+
+        Lcd_FillRect(x, y, width, height, bar->back);
+}
+
+/**
+ * @Description 更新进度条，只重画增加或减少的那一段
+ * @param bar   控件
+ * @param value 数值，超过满量程时按满量程显示
+ */
+void Widget_BarSet(WIDGET_BarTypeDef *bar, u32 value)
+{
+        u32 fill = ((uint64_t)value * bar->scale + 0x8000) >> 16;
+
+        if(fill > bar->width)
+        {
+                fill = bar->width;
+        }
+
+        if(fill > bar->fill)
+        {
+                Lcd_FillRect(bar->x + bar->fill, bar->y, fill - bar->fill, bar->height, bar->color);
+        }
+        else if(fill < bar->fill)
+        {
+                Lcd_FillRect(bar->x + fill, bar->y, bar->fill - fill, bar->height, bar->back);
+        }
+
+        bar->fill = fill;
+}
+
+/**
+ * @Description 初始化指示灯，此时还不会在屏幕上绘制
+ * @param led   控件
+ * @param x,y   圆心坐标
+ * @param r     半径
+ * @param on    点亮时的颜色
+ * @param off   熄灭时的颜色
+ */
+void Widget_LedInit(WIDGET_LedTypeDef *led, u16 x, u16 y, u16 r, u16 on, u16 off)
+{
+        led->x = x;
+        led->y = y;
+        led->r = r;
+        led->on = on;
+        led->off = off;
+        led->state = 0xFF;
+}
+
+/**
+ * @Description 更新指示灯，状态没有变化时不重画
+ * @param led   控件
+ * @param state 0:熄灭 其他:点亮
+ */
+void Widget_LedSet(WIDGET_LedTypeDef *led, u8 state)
+{
+        u16 point = POINT_COLOR;
+
+        state = (state != 0);
+        if(state == led->state)
+        {
+                return;
+        }
+
+        POINT_COLOR = state ? led->on : led->off;
+        Draw_FillCircle(led->x, led->y, led->r);
+        POINT_COLOR = point;
+
+        led->state = state;
+}
@@ -0,0 +1,64 @@
+#ifndef __BSP_WIDGET_H
+#define __BSP_WIDGET_H
+
+#include "stm32f4xx.h"
+#include "bsp_lcd.h"
+
+/**
+ * 保留模式控件，每个控件记住屏幕上当前显示的内容，更新时只重画发生变化的字符格或像素，
+ * 不需要先用Lcd_Fill()清除整行，数值没有变化时不访问LCD
+ */
+#define WIDGET_TEXT_MAX         32                      // 文本控件最多显示的字符格数
+
+/* 文本控件，固定宽度len个字符格，内容不足时补空格 */
+typedef struct
+{
+        u16 x, y;                                       // 左上角坐标
+        u8 size;                                        // 字号 12/16/24
+        u8 len;                                         // 字符格数
+        u16 color;                                      // 文字颜色
+        u16 back;                                       // 背景颜色
+        char text[WIDGET_TEXT_MAX + 1];                 // 屏幕上当前显示的内容
+} WIDGET_LabelTypeDef;
+
+/* 数值控件，右对齐显示定点数和单位 */
+typedef struct
+{
+        WIDGET_LabelTypeDef label;
+        s32 value;                                      // 当前显示的数值，放大了10^frac倍
+        u8 frac;                                        // 小数位数
+        u8 valid;                                       // value是否已经显示过
+        const char *unit;                               // 单位，NULL表示没有单位
+} WIDGET_NumberTypeDef;
+
+/* 水平进度条 */
+typedef struct
+{
+        u16 x, y;                                       // 左上角坐标
+        u16 width, height;                              // 大小
+        u16 color;                                      // 进度颜色
+        u16 back;                                       // 背景颜色
+        u32 scale;                                      // 每单位数值对应的像素数，Q16定点数
+        u16 fill;                                       // 屏幕上当前的进度长度
+} WIDGET_BarTypeDef;
+
+/* 圆形指示灯 */
+typedef struct
+{
+        u16 x, y;                                       // 圆心坐标
+        u16 r;                                          // 半径
+        u16 on;                                         // 点亮时的颜色
+        u16 off;                                        // 熄灭时的颜色
+        u8 state;                                       // 屏幕上当前的状态，0xFF表示还没有画过
+} WIDGET_LedTypeDef;
+
+void Widget_LabelInit(WIDGET_LabelTypeDef *label, u16 x, u16 y, u8 size, u8 len, u16 color, u16 back);
+void Widget_LabelSet(WIDGET_LabelTypeDef *label, const char *text);
+void Widget_NumberInit(WIDGET_NumberTypeDef *number, u16 x, u16 y, u8 size, u8 len, u8 frac, const char *unit);
+void Widget_NumberSet(WIDGET_NumberTypeDef *number, s32 value);
+void Widget_BarInit(WIDGET_BarTypeDef *bar, u16 x, u16 y, u16 width, u16 height, u32 max);
+void Widget_BarSet(WIDGET_BarTypeDef *bar, u32 value);
+void Widget_LedInit(WIDGET_LedTypeDef *led, u16 x, u16 y, u16 r, u16 on, u16 off);
+void Widget_LedSet(WIDGET_LedTypeDef *led, u8 state);
+
+#endif /* __BSP_WIDGET_H */
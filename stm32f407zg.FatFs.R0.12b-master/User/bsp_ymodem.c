@@ -0,0 +1,489 @@
+#include "bsp_ymodem.h"
+#include "bsp_systick.h"
+#include "string.h"
+#include "ff.h"
+
+/* 驱动版本号：bsp_ymodem v1.1 */
+
+/* 协议控制字符 */
+#define YMODEM_SOH              0x01                    // 128字节数据包
+#define YMODEM_STX              0x02                    // 1024字节数据包
+#define YMODEM_EOT              0x04                    // 文件结束
+#define YMODEM_ACK              0x06
+#define YMODEM_NAK              0x15
+#define YMODEM_CAN              0x18                    // 取消传输
+#define YMODEM_CRC16            'C'                     // 请求发送方使用CRC-16校验
+
+/* 接收中断交给主循环处理的事件，处理完之前中断丢弃收到的数据 */
+#define YMODEM_EVT_NONE         0
+#define YMODEM_EVT_HEADER       1                       // 收到文件头(序号0的数据包)
+#define YMODEM_EVT_EOT          2                       // 文件结束
+#define YMODEM_EVT_CANCEL       3                       // 发送方取消
+#define YMODEM_EVT_ERROR        4                       // 数据包序号错误
+
+/* CRC-16/XMODEM(多项式0x1021，初值0)的4位查找表 */
+static const u16 ymodem_crc_table[16] =
+{
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static u8 ymodem_packet[3 + 1024 + 2];                  // 包头、序号、序号反码、数据和CRC
+static u16 ymodem_packet_len = 0;                       // 已经收到的字节数
+static u16 ymodem_packet_size = 0;                      // 整个数据包的字节数，0表示等待包头
+static u16 ymodem_data_size = 0;                        // 数据包中的数据字节数
+static u8 ymodem_header = 1;                            // 1:等待文件头 0:接收文件数据
+static u8 ymodem_block = 0;                             // 期望的下一个数据包序号
+static u8 ymodem_eot = 0;                               // 已经收到的EOT个数，第一个回复NAK，第二个才结束文件
+static volatile u8 ymodem_event = YMODEM_EVT_NONE;      // 等待主循环处理的事件
+static volatile u8 ymodem_held = 0;                     // 数据包等待空闲的缓冲，还没有应答
+static volatile u32 ymodem_rx_bytes = 0;                // 收到的字节数，主循环据此判断超时
+
+static u8 ymodem_chunk[2][YMODEM_CHUNK_SIZE];           // 乒乓缓冲
+static u16 ymodem_fill = 0;                             // 正在填充的缓冲中的字节数
+static u8 ymodem_cur = 0;                               // 正在填充的缓冲
+static volatile u8 ymodem_full[2] = {0, 0};             // 缓冲已满，等待主循环写入
+
+/* 统计 */
+static u32 ymodem_crc_error = 0;                        // 校验错误的数据包个数
+static u32 ymodem_hold = 0;                             // 两个缓冲都没有写完而推迟应答的次数
+static u32 ymodem_write_max = 0;                        // 一次f_write的最长时间，单位为时钟周期
+static u32 ymodem_size = 0;                             // 文件头中的文件大小，0表示未知
+static u32 ymodem_written = 0;                          // 当前文件已经写入的字节数
+
+/**
+ * @Description 发送一个控制字符，可以在中断中调用
+ */
+static void Ymodem_Reply(u8 c)
+{
+        Usart_Write(&c, 1);
+}
+
+/**
+ * @Description 发送取消传输的控制字符
+ */
+static void Ymodem_Cancel(void)
+{
+        static const u8 cancel[] = {YMODEM_CAN, YMODEM_CAN, YMODEM_CAN};
+
+        Usart_Write(cancel, sizeof(cancel));
+}
+
+/**
+ * @Description 计算CRC-16/XMODEM，对数据和附在后面的CRC一起计算时结果为0
+ */
+static u16 Ymodem_Crc(const u8 *data, u16 len)
+{
+        u16 crc = 0;
+
+        while(len--)
+        {
+                crc = (crc << 4) ^ ymodem_crc_table[(crc >> 12) ^ (*data >> 4)];
+                crc = (crc << 4) ^ ymodem_crc_table[(crc >> 12) ^ (*data & 0x0F)];
+                data++;
+        }
+
+        return crc;
+}
+
+/**
+ * @Description 把数据包中的数据复制到乒乓缓冲并应答，在接收中断中或关中断时调用
+ * @notice      数据会填满当前缓冲而另一个缓冲还没有写完时不复制，也不应答，
+ *              由主循环写完后再调用一次，发送方在收到应答之前不会发送下一个数据包
+ */
+static void Ymodem_Store(void)
+{
+        const u8 *data = &ymodem_packet[3];
+        u16 n;
+
+        if(ymodem_fill + ymodem_data_size >= YMODEM_CHUNK_SIZE && ymodem_full[ymodem_cur ^ 1])
+        {
+                if(!ymodem_held)
+                {
+                        ymodem_held = 1;
+                        ymodem_hold++;
+                }
+                return;
+        }
+
+        n = YMODEM_CHUNK_SIZE - ymodem_fill;
+        if(n > ymodem_data_size)
+        {
+                n = ymodem_data_size;
+        }
+        memcpy(&ymodem_chunk[ymodem_cur][ymodem_fill], data, n);
+        ymodem_fill += n;
+
+        /* 当前缓冲满，交给主循环写入，剩下的数据放到另一个缓冲的开头 */
+        if(ymodem_fill == YMODEM_CHUNK_SIZE)
+        {
+                ymodem_full[ymodem_cur] = 1;
+                ymodem_cur ^= 1;
+                ymodem_fill = ymodem_data_size - n;
+                memcpy(ymodem_chunk[ymodem_cur], data + n, ymodem_fill);
+        }
+
+        ymodem_block++;
+        ymodem_held = 0;
+        Ymodem_Reply(YMODEM_ACK);
+}
+
+/**
+ * @Description 处理一个接收完整的数据包，在接收中断中调用
+ */
+static void Ymodem_Packet(void)
+{
+        u8 block = ymodem_packet[1];
+
+        if(block != (u8)~ymodem_packet[2] || Ymodem_Crc(&ymodem_packet[3], ymodem_data_size + 2) != 0)
+        {
+                ymodem_crc_error++;
+                Ymodem_Reply(YMODEM_NAK);
+                return;
+        }
+
+        if(ymodem_header)
+        {
+                /* 上一个文件最后的应答丢失时发送方会重发，再应答一次 */
+                if(block == 0)
+                {
+                        ymodem_event = YMODEM_EVT_HEADER;
+                }
+                else
+                {
+                        Ymodem_Reply(YMODEM_ACK);
+                }
+        }
+        else if(block == ymodem_block)
+        {
+                Ymodem_Store();
+        }
+        else if(block == (u8)(ymodem_block - 1))
+        {
+                /* 应答丢失后重发的数据包 */
+                Ymodem_Reply(YMODEM_ACK);
+        }
+        else
+        {
+                ymodem_event = YMODEM_EVT_ERROR;
+        }
+}
+
+/**
+ * @Description 接收处理函数，由串口接收中断直接调用，解析数据包
+ * @param data  DMA缓冲中新收到的数据
+ * @param len   字节数
+ */
+static void Ymodem_RxHandler(const u8 *data, u16 len)
+{
+        u16 n;
+
+        ymodem_rx_bytes += len;
+
+        while(len > 0)
+        {
+                /* 等待主循环时发送方不会发送新的数据包，收到的只能是超时重发的数据 */
+                if(ymodem_event != YMODEM_EVT_NONE || ymodem_held)
+                {
+                        return;
+                }
+
+                if(ymodem_packet_size == 0)
+                {
+                        switch(*data)
+                        {
+                        case YMODEM_SOH:
+                                ymodem_data_size = 128;
+                                break;
+                        case YMODEM_STX:
+                                ymodem_data_size = 1024;
+                                break;
+                        case YMODEM_EOT:
+                                if(ymodem_header)
+                                {
+                                        Ymodem_Reply(YMODEM_ACK);
+                                }
+                                else if(ymodem_eot++ == 0)
+                                {
+                                        Ymodem_Reply(YMODEM_NAK);
+                                }
+                                else
+                                {
+                                        ymodem_event = YMODEM_EVT_EOT;
+                                }
+                                data++;
+                                len--;
+                                continue;
+                        case YMODEM_CAN:
+                                ymodem_event = YMODEM_EVT_CANCEL;
+                                return;
+                        default:
+                                /* 数据包之间的杂散字节 */
+                                data++;
+                                len--;
+                                continue;
+                        }
+
+                        ymodem_packet[0] = *data++;
+                        len--;
+                        ymodem_packet_len = 1;
+                        ymodem_packet_size = 3 + ymodem_data_size + 2;
+                        continue;
+                }
+
+                n = ymodem_packet_size - ymodem_packet_len;
+                if(n > len)
+                {
+                        n = len;
+                }
+                memcpy(&ymodem_packet[ymodem_packet_len], data, n);
+                ymodem_packet_len += n;
+                data += n;
+                len -= n;
+
+                if(ymodem_packet_len == ymodem_packet_size)
+                {
+                        ymodem_packet_size = 0;
+                        Ymodem_Packet();
+                }
+        }
+}
+
+/**
+ * @Description 把缓冲中的数据写入文件，超出文件头中文件大小的填充字节不写入
+ * @return FRESULT FatFs的返回值，磁盘满时返回FR_DENIED
+ */
+static FRESULT Ymodem_Write(FIL *fil, const u8 *buf, u32 len)
+{
+        FRESULT res;
+        UINT bw;
+        u32 start;
+
+        if(ymodem_size != 0 && ymodem_written + len > ymodem_size)
+        {
+                len = ymodem_size - ymodem_written;
+        }
+        if(len == 0)
+        {
+                return FR_OK;
+        }
+
+        start = DWT->CYCCNT;
+        res = f_write(fil, buf, len, &bw);
+        start = DWT->CYCCNT - start;
+        if(start > ymodem_write_max)
+        {
+                ymodem_write_max = start;
+        }
+
+        ymodem_written += bw;
+        if(res == FR_OK && bw != len)
+        {
+                res = FR_DENIED;
+        }
+
+        return res;
+}
+
+/**
+ * @Description 取出文件头中的文件名和大小，打开要写入的文件
+ * @param dir   保存文件的目录，以'/'结尾，例如"0:/"
+ */
+static FRESULT Ymodem_Open(FIL *fil, const char *dir)
+{
+        char path[YMODEM_PATH_MAX];
+        const char *p;
+
+        /* 文件名后是十进制的文件大小，后面可能还有修改时间等，用空格分隔 */
+        ymodem_packet[3 + ymodem_data_size - 1] = '\0';
+        p = (const char *)&ymodem_packet[3];
+        ymodem_size = 0;
+        for(p += strlen(p) + 1; *p >= '0' && *p <= '9'; p++)
+        {
+                ymodem_size = ymodem_size * 10 + (*p - '0');
+        }
+        ymodem_written = 0;
+
+        path[0] = '\0';
+        strncat(path, dir, sizeof(path) - 1);
+        strncat(path, (const char *)&ymodem_packet[3], sizeof(path) - 1 - strlen(path));
+
+        return f_open(fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+}
+
+/**
+ * @Description 通过串口接收文件，保存到指定目录，一次可以接收多个文件，同名文件被覆盖
+ * @param dir   保存文件的目录，以'/'结尾，例如"0:/"
+ * @return u8   YMODEM_OK等接收结果
+ * @notice      传输结束后通过串口输出文件个数、吞吐率、最长写入时间和推迟应答的次数；
+ *              没有开启长文件名，文件名必须符合8.3格式，否则取消传输
+ */
+u8 Ymodem_Receive(const char *dir)
+{
+        static FIL fil;                                 // 文件对象包含一个扇区的缓冲，不放在栈中
+        u32 last_bytes, last_ms, now, start = 0, elapsed = 0, total = 0, usart_drop;
+        u8 result, event, retry = 0, files = 0, open = 0, i;
+        FRESULT res;
+
+        ymodem_packet_size = 0;
+        ymodem_header = 1;
+        ymodem_block = 0;
+        ymodem_eot = 0;
+        ymodem_event = YMODEM_EVT_NONE;
+        ymodem_held = 0;
+        ymodem_fill = 0;
+        ymodem_cur = 0;
+        ymodem_full[0] = ymodem_full[1] = 0;
+        ymodem_crc_error = ymodem_hold = ymodem_write_max = 0;
+        usart_drop = usart_rx_drop;
+
+        Usart_SetRxHandler(Ymodem_RxHandler);
+        Ymodem_Reply(YMODEM_CRC16);
+        last_bytes = ymodem_rx_bytes;
+        last_ms = millis();
+
+        while(1)
+        {
+                /* 写入已满的缓冲，写完后如果有推迟的数据包，复制到这个缓冲中并应答 */
+                for(i = 0; i < 2; i++)
+                {
+                        if(ymodem_full[i])
+                        {
+                                res = Ymodem_Write(&fil, ymodem_chunk[i], YMODEM_CHUNK_SIZE);
+                                __disable_irq();
+                                ymodem_full[i] = 0;
+                                if(ymodem_held)
+                                {
+                                        Ymodem_Store();
+                                }
+                                __enable_irq();
+                                last_ms = millis();
+
+                                if(res != FR_OK)
+                                {
+                                        break;
+                                }
+                        }
+                }
+                if(i < 2)
+                {
+                        result = YMODEM_FS_ERROR;
+                        break;
+                }
+
+                event = ymodem_event;
+                if(event == YMODEM_EVT_HEADER)
+                {
+                        /* 文件名为空表示没有更多的文件 */
+                        if(ymodem_packet[3] == '\0')
+                        {
+                                Ymodem_Reply(YMODEM_ACK);
+                                result = YMODEM_OK;
+                                break;
+                        }
+
+                        if(Ymodem_Open(&fil, dir) != FR_OK)
+                        {
+                                result = YMODEM_FS_ERROR;
+                                break;
+                        }
+                        open = 1;
+                        start = millis();
+
+                        __disable_irq();
+                        ymodem_header = 0;
+                        ymodem_block = 1;
+                        ymodem_eot = 0;
+                        ymodem_fill = 0;
+                        ymodem_cur = 0;
+                        ymodem_event = YMODEM_EVT_NONE;
+                        __enable_irq();
+
+                        Ymodem_Reply(YMODEM_ACK);
+                        Ymodem_Reply(YMODEM_CRC16);
+                }
+                else if(event == YMODEM_EVT_EOT && !ymodem_full[0] && !ymodem_full[1])
+                {
+                        /* 所有已满的缓冲都已写完，写入最后不满的部分 */
+                        res = Ymodem_Write(&fil, ymodem_chunk[ymodem_cur], ymodem_fill);
+                        if(res == FR_OK)
+                        {
+                                res = f_close(&fil);
+                        }
+                        open = 0;
+                        if(res != FR_OK)
+                        {
+                                result = YMODEM_FS_ERROR;
+                                break;
+                        }
+                        files++;
+                        total += ymodem_written;
+                        elapsed += millis() - start;
+
+                        __disable_irq();
+                        ymodem_header = 1;
+                        ymodem_block = 0;
+                        ymodem_event = YMODEM_EVT_NONE;
+                        __enable_irq();
+
+                        Ymodem_Reply(YMODEM_ACK);
+                        Ymodem_Reply(YMODEM_CRC16);
+                }
+                else if(event == YMODEM_EVT_CANCEL)
+                {
+                        result = YMODEM_CANCEL;
+                        break;
+                }
+                else if(event == YMODEM_EVT_ERROR)
+                {
+                        result = YMODEM_ERROR;
+                        break;
+                }
+
+                /* 超时：等待文件头时重发'C'，接收数据时丢弃不完整的数据包并请求重发 */
+                now = millis();
+                if(ymodem_rx_bytes != last_bytes)
+                {
+                        last_bytes = ymodem_rx_bytes;
+                        last_ms = now;
+                        retry = 0;
+                }
+                else if(now - last_ms >= YMODEM_PACKET_TIMEOUT)
+                {
+                        last_ms = now;
+                        retry++;
+                        if(retry > ((files == 0 && ymodem_header) ? YMODEM_START_TIMEOUT : YMODEM_RETRY_MAX))
+                        {
+                                result = YMODEM_TIMEOUT;
+                                break;
+                        }
+
+                        __disable_irq();
+                        ymodem_packet_size = 0;
+                        __enable_irq();
+                        Ymodem_Reply(ymodem_header ? YMODEM_CRC16 : YMODEM_NAK);
+                }
+        }
+
+        if(result != YMODEM_OK && result != YMODEM_CANCEL)
+        {
+                Ymodem_Cancel();
+        }
+        if(open)
+        {
+                f_close(&fil);
+        }
+        Usart_SetRxHandler(0);
+
+        usart_drop = usart_rx_drop - usart_drop;
+
+        printf("bsp_ymodem:\tresult = %d, files = %d, bytes = %u, time = %u ms", result, files, total, elapsed);
+        if(elapsed != 0)
+        {
+                printf(", %u.%02u KB/s", (total / 1024) * 1000 / elapsed, (total / 1024) * 100000 / elapsed % 100);
+        }
+        printf("\r\nbsp_ymodem:\tmax f_write = %u us, ack delayed = %u, crc errors = %u, rx drop = %u\r\n",
+               ymodem_write_max / SYSTEM_CLOCK, ymodem_hold, ymodem_crc_error, usart_drop);
+
+        return result;
+}
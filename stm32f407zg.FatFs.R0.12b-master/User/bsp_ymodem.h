@@ -0,0 +1,30 @@
+#ifndef __BSP_YMODEM_H
+#define __BSP_YMODEM_H
+
+#include "stm32f4xx.h"
+#include "bsp_usart.h"
+
+/**
+ * 通过串口用YMODEM-1K协议接收文件并写入FatFs，上位机可以使用Tools/ysend.c或其他支持YMODEM的终端软件。
+ * 数据包在接收中断中解析和校验，正确的数据复制到两个4KB的乒乓缓冲中并立即应答，
+ * 主循环中每次用f_write写入一个完整的缓冲(与Flash扇区和FatFs扇区对齐)，
+ * Flash擦除和编程的同时中断继续接收下一个缓冲的数据。
+ * 只有两个缓冲都没有写完时才推迟应答，推迟的次数作为接收等待Flash的次数统计。
+ * 传输过程中串口被协议占用，不能调用printf和Log_Drain()，结果在传输结束后输出。
+ */
+#define YMODEM_CHUNK_SIZE       4096                    // 乒乓缓冲大小，与Flash扇区相同
+#define YMODEM_START_TIMEOUT    60                      // 等待发送方开始的时间，单位秒，每秒发送一次'C'
+#define YMODEM_PACKET_TIMEOUT   1000                    // 一个数据包中间停止接收的超时时间，单位毫秒
+#define YMODEM_RETRY_MAX        10                      // 连续出错的最大次数，超过后取消传输
+#define YMODEM_PATH_MAX         64                      // 保存路径的最大长度
+
+/* 接收结果 */
+#define YMODEM_OK               0                       // 所有文件接收完成
+#define YMODEM_TIMEOUT          1                       // 超时
+#define YMODEM_CANCEL           2                       // 发送方取消
+#define YMODEM_ERROR            3                       // 重试次数过多或数据包序号错误
+#define YMODEM_FS_ERROR         4                       // 文件创建或写入失败
+
+u8 Ymodem_Receive(const char *dir);
+
+#endif /* __BSP_YMODEM_H */
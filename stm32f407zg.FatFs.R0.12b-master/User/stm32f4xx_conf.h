@@ -8,6 +8,7 @@
 #include "stm32f4xx_usart.h"
 #include "stm32f4xx_fsmc.h"
 #include "stm32f4xx_spi.h"
+#include "stm32f4xx_dma.h"
 
 #ifdef USE_FULL_ASSERT
 #define assert_param(expr) ((expr) ? (void)0 : assert_failed((uint8_t *)__FILE__, __LINE__))
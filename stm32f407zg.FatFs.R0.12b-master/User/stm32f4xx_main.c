@@ -5,38 +5,106 @@
 #include "bsp_lcd.h"
 #include "bsp_key.h"
 #include "bsp_spi.h"
+#include "bsp_sram.h"
+#include "bsp_text.h"
+#include "bsp_widget.h"
+#include "bsp_telemetry.h"
+#include "bsp_log.h"
+#include "bsp_ymodem.h"
+#include "bsp_timer.h"
 #include "ff.h"
+#include "string.h"
 
 const char wData[] = "wo shi ni de yan";
 char rData[4096] = "";
 
 FATFS fs;
 FIL fil;
-BYTE work[_MAX_SS];
+DWORD work[_MAX_SS * 2 / 4];           //f_mkfs()和f_check()的工作缓冲区，f_check()要求按字对齐，其中放一个FAT扇区和簇位图
+CHKINFO chk;
 
 UINT bw;
 UINT br;
+DWORD fre_clust;
+char cmd[16];                           // 串口收到的命令
+
+WIDGET_NumberTypeDef free_num;          // 剩余空间，单位KB
+WIDGET_BarTypeDef used_bar;             // 已用空间比例
+WIDGET_LedTypeDef scan_led;             // 正在统计空闲簇时点亮
+TIMER_TypeDef blink_timer;              // 运行指示灯闪烁
+
+/**
+ * @Description 运行指示灯闪烁，由blink_timer每500ms在Timer_Process()中调用
+ */
+static void Led_Blink(void *arg)
+{
+        LED0 = !LED0;
+}
 
 int main(void)
 {
         FRESULT res;
+        u8 mounted;
 
         NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
         Systick_Init();
+        Timer_Init();
         Usart_Init();
         Led_Init();
         Lcd_Init();
         Key_Init();
+        Sram_Init();
+
+        /* 使用外部SRAM中的帧缓冲，画完一屏后调用Lcd_Flush()只刷新变化的区域 */
+        Lcd_FrameBufferCmd(ENABLE);
 
         POINT_COLOR = RED;
         BACK_COLOR = WHITE;
         Lcd_ClearScreen(BACK_COLOR);
         Lcd_CenterShowString(50, "FatFs Project", 24);
+        Lcd_Flush();
+
+#if USART_BENCH
+        Usart_Benchmark();
+#endif
+
+        Telemetry_Init();
+#if TELEMETRY_BENCH
+        Telemetry_Benchmark();
+#endif
+
+        /* 驱动中的诊断信息用LOGx()记录，在主循环中由Log_Drain()发送 */
+        Log_Init();
+#if LOG_BENCH
+        Log_Benchmark();
+#endif
+#if TIMER_BENCH
+        Timer_Benchmark();
+#endif
 
         res = f_mount(&fs, "0:", 1);
+        mounted = (res == FR_OK);
 
         printf("stm32f4xx_main:\tf_mount function return = %d\r\n", res);
 
+        /* 上电检查一次卷，修复掉电遗留的丢失簇、交叉链接和文件大小错误 */
+        if(res == FR_OK)
+        {
+                res = f_check("0:", FCK_REPAIR, work, sizeof(work), &chk);
+                printf("stm32f4xx_main:\tf_check function return = %d, lost = %lu, fixed = %lu\r\n", res, chk.n_lost, chk.n_fixed);
+        }
+
+        /* Flash中还没有字库时，从文件系统中的字库文件更新 */
+        if(Text_Init() != 0)
+        {
+                printf("stm32f4xx_main:\tText_Update function return = %d\r\n", Text_Update("0:/GBK.FON"));
+        }
+        Lcd_CenterShowString(90, "文件系统", 24);
+        Lcd_Flush();
+#if TEXT_BENCH
+        Text_Benchmark(24);
+#endif
+
 //        if(res == FR_NO_FILESYSTEM)
 //        {
 //                printf("\r\nf_mkfs res =%d", res);
@@ -69,8 +137,50 @@ int main(void)
 
 //        }
 
+        /* 状态栏，控件只在数值变化时重画变化的部分 */
+        POINT_COLOR = BLUE;
+        Lcd_ShowString(30, 140, 120, 24, 24, "Free:");
+        Widget_NumberInit(&free_num, 102, 140, 24, 10, 0, "KB");
+        Widget_BarInit(&used_bar, 30, 170, 420, 16, fs.n_fatent - 2);
+        Widget_LedInit(&scan_led, 440, 152, 8, GREEN, WHITE);
+        POINT_COLOR = RED;
+
+        Timer_Create(&blink_timer, Led_Blink, 0);
+        Timer_Start(&blink_timer, 500, 500);
+
         while(1)
         {
-
+#if LCD_BUS_STAT
+                Lcd_BusStatReset();
+#endif
+
+                /* 空闲时分步统计空闲簇，每次只检查64个FAT表项，统计完成后f_getfree()可立即返回；挂载失败时不统计 */
+                if(mounted && f_scanfree("0:", 64, &fre_clust) == FR_OK)
+                {
+                        Widget_LedSet(&scan_led, fre_clust == 0xFFFFFFFF);
+                        if(fre_clust != 0xFFFFFFFF)
+                        {
+                                /* 扇区大小为4KB */
+                                Widget_NumberSet(&free_num, fre_clust * fs.csize * (_MAX_SS / 1024));
+                                Widget_BarSet(&used_bar, fs.n_fatent - 2 - fre_clust);
+                        }
+                }
+                Lcd_Flush();
+                Log_Drain();
+                Timer_Process();
+
+                /* 收到"rz"命令时通过YMODEM接收文件，保存到文件系统的根目录，上位机使用Tools/ysend.c发送 */
+                if(Usart_ReadLine(cmd, sizeof(cmd)) >= 0 && strcmp(cmd, "rz") == 0)
+                {
+                        Ymodem_Receive("0:/");
+                }
+
+#if LCD_BUS_STAT
+                /* 数值没有变化时控件不访问LCD，只统计有刷新的循环 */
+                if(lcd_bus_stat.cmd + lcd_bus_stat.wdata != 0)
+                {
+                        printf("stm32f4xx_main:\tupdate bus writes = %u\r\n", lcd_bus_stat.cmd + lcd_bus_stat.wdata);
+                }
+#endif
         }
 }
@@ -1,99 +1,134 @@
 #include "bsp_systick.h"
 
-/* 驱动版本号：bsp_systick v1.1 */
+/* 驱动版本号：bsp_systick v1.2 */
 
-/* 保存延时1us/1ms滴答定时器的计数个数 */
-static u8 fac_us = 0;
-static u16 fac_ms = 0;
+static volatile u32 systick_cyc_high = 0;                       // 64位周期数的高32位
+static volatile u32 systick_cyc_last = 0;                       // 上次滴答中断时周期计数器的值
+static void (*systick_handler)(void) = 0;                       // 滴答中断中调用的处理函数
 
 /**
- * @Description 初始化滴答定时器
+ * @Description 初始化DWT周期计数器和滴答定时器，滴答定时器使用系统时钟，每1ms中断一次
+ * @notice      滴答中断为最低优先级，周期计数器每2^32 / (SYSTEM_CLOCK * 10^6)秒(约25秒)溢出一次，
+ *              只要滴答中断在这段时间内执行过一次，64位周期数就是连续的
  */
 void Systick_Init(void)
 {
-        /* 设置滴答定时器的时钟为系统时钟的8分频 */
-        SysTick->CTRL &= SysTick_CLKSource_HCLK_Div8;
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        systick_cyc_last = SYSTICK_CYCCNT();
 
-        /* 系统时钟为SYSTEM_CLOCK，滴答定时器的时钟为((SYSTEM_CLOCK * 10^6) / 8) */
-        /* 可以算出，一个计数值的时间是 (8 / (SYSTEM_CLOCK * 10^6)) */
-        /* 那么定时1us的计数值就是 ((10^-6 * (SYSTEM_CLOCK * 10^6))/ 8) = (SYSTEM_CLOCK / 8) */
-        fac_us = SYSTEM_CLOCK / 8;
+        SysTick_Config(SYSTEM_CLOCK * 1000000 / SYSTICK_RATE);
+}
 
-        /* 定时1ms的计数值肯定就是1us的1000倍了 */
-        fac_ms = (u16) fac_us * 1000;
+/**
+ * @Description 设置滴答中断中调用的处理函数
+ * @param handler 处理函数，为0时不调用
+ */
+void Systick_SetTickHandler(void (*handler)(void))
+{
+        systick_handler = handler;
 }
 
 /**
- * @Description 延时nus微秒
- * @param nus 延时时间 nus <= 798915us(最大值即2^24 / fac_us@fac_us = 21)
+ * @Description 滴答中断服务函数，记录周期计数器的溢出
  */
-void delay_us(u32 nus)
+void SysTick_Handler(void)
 {
-        /* 记录读取的滴答定时器控制寄存器CTRL数据的临时变量 */
-        u32 temp;
+        u32 now;
 
-        /* 设置定时器的重装载值为 nus * fac_us */
-        /* 根据定时的时间给滴答定时器加载重装载值 */
-        SysTick->LOAD = nus * fac_us;
+        /* 高32位和上次的值一起更新，被其他中断打断时cycles()不会重复计入溢出 */
+        __disable_irq();
+        now = SYSTICK_CYCCNT();
+        if(now < systick_cyc_last)
+        {
+                systick_cyc_high++;
+        }
+        systick_cyc_last = now;
+        __enable_irq();
 
-        /* 设置滴答定时器的计数值为0，清空滴答定时器 */
-        SysTick->VAL = 0;
+        if(systick_handler != 0)
+        {
+                systick_handler();
+        }
+}
 
-        /* 开启滴答定时器，此刻滴答定时器已经默默的在后台开始计时了 */
-        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+/**
+ * @Description 读取64位周期数，可以在中断中调用
+ * @return uint64_t 上电以来的周期数
+ * @notice      在更高优先级的中断中或关中断时，周期计数器可能已经溢出而滴答中断还没有执行，
+ *              比较上次滴答中断时的值就能发现，不会出现时间倒退
+ */
+uint64_t cycles(void)
+{
+        u32 primask = __get_PRIMASK();
+        u32 high, now;
 
-        /* 持续的读取滴答定时器COUNTFLAG(CTRL的位16)，判断定时是否到达 */
-        /* 定时时间没有到达之前程序一直停在这个死循环里面 */
-        do
+        __disable_irq();
+        now = SYSTICK_CYCCNT();
+        high = systick_cyc_high;
+        if(now < systick_cyc_last)
         {
-                temp = SysTick->CTRL;
-        } while((temp & 0x01) && !(temp & (1 << 16)));
+                high++;
+        }
+        __set_PRIMASK(primask);
 
-        /* 关闭滴答定时器 */
-        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        return ((uint64_t) high << 32) | now;
+}
 
-        /* 设置滴答定时器的计数值为0，清空滴答定时器 */
-        SysTick->VAL = 0;
+/**
+ * @Description 读取上电以来的微秒数
+ * @return u32  微秒数
+ */
+u32 micros(void)
+{
+        return (u32) (cycles() / SYSTEM_CLOCK);
 }
 
 /**
- * @Description 延时nms毫秒
- * @param nms 延时时间 nms <= 798ms 算法同上一个函数
+ * @Description 读取上电以来的毫秒数
+ * @return u32  毫秒数
  */
-void delay_xms(u16 nms)
+u32 millis(void)
 {
-        u32 temp;
-        SysTick->LOAD = (u32) nms * fac_ms;
-        SysTick->VAL = 0x00;
-        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
-        do
-        {
-                temp = SysTick->CTRL;
-        } while((temp & 0x01) && !(temp & (1 << 16)));
-        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
-        SysTick->VAL = 0X00;
+        return (u32) (cycles() / (SYSTEM_CLOCK * 1000));
 }
 
 /**
- * @Description 延时nms毫秒
- * @param nms 延时时间 nms <= 65535
+ * @Description 延时nus微秒
+ * @param nus 延时时间
+ * @notice    只读取周期计数器，可以在中断中调用，也可以被中断中的延时打断
  */
-void delay_ms(u16 nms)
+void delay_us(u32 nus)
 {
-        /* 这个函数其实就是将nms分解开来，分解成为多个 540ms * repeat + remain */
-        /* 然后分别延时，因为上面的延时函数组最多只可以延时798ms */
-        u8 repeat = nms / 540;
-        u16 remain = nms % 540;
+        u32 start = SYSTICK_CYCCNT();
+        u32 n;
 
-        while(repeat)
+        /* 每次最多等待1秒，周期数不会超过32位 */
+        while(nus > 0)
         {
-                delay_xms(540);
-                repeat--;
+                n = (nus > 1000000) ? 1000000 : nus;
+                while(SYSTICK_CYCCNT() - start < n * SYSTEM_CLOCK)
+                {
+                }
+                start += n * SYSTEM_CLOCK;
+                nus -= n;
         }
+}
 
-        if(remain)
-        {
-                delay_xms(remain);
-        }
+/**
+ * @Description 延时nms毫秒
+ * @param nms 延时时间 nms <= 65535
+ */
+void delay_xms(u16 nms)
+{
+        delay_us((u32) nms * 1000);
 }
 
+/**
+ * @Description 延时nms毫秒
+ * @param nms 延时时间 nms <= 65535
+ */
+void delay_ms(u16 nms)
+{
+        delay_us((u32) nms * 1000);
+}